@@ -0,0 +1,224 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#include "common/bigint-native.h"
+
+#include "td/utils/int_types.h"
+
+namespace td {
+
+#if TD_HAVE_INT128
+
+namespace {
+
+using u128 = unsigned __int128;
+
+// sign and absolute value; x*y+w and all quotients and remainders computed below fit into 128 bits
+struct Native {
+  u128 abs;
+  bool neg;
+};
+
+Native from_int64(long long x) {
+  return Native{x < 0 ? 0 - static_cast<uint64>(x) : static_cast<uint64>(x), x < 0};
+}
+
+bool fits_int64(const Native& x) {
+  return x.abs <= (x.neg ? static_cast<u128>(1) << 63 : (static_cast<u128>(1) << 63) - 1);
+}
+
+bool to_int64(const Native& quot, const Native& rem, long long* q, long long* r) {
+  if ((q && !fits_int64(quot)) || (r && !fits_int64(rem))) {
+    return false;
+  }
+  if (q) {
+    *q = static_cast<long long>(quot.neg ? 0 - static_cast<uint64>(quot.abs) : static_cast<uint64>(quot.abs));
+  }
+  if (r) {
+    *r = static_cast<long long>(rem.neg ? 0 - static_cast<uint64>(rem.abs) : static_cast<uint64>(rem.abs));
+  }
+  return true;
+}
+
+// BigInt256 of absolute value less than 2^64; such numbers take at most two words if normalized
+bool load(const BigInt256& x, Native& res) {
+  auto v = x.as_any_int();
+  int size = v.size();
+  if (size <= 0 || size > 2) {
+    return false;
+  }
+  __int128 t = v.digits[0];
+  if (size == 2) {
+    t += static_cast<__int128>(v.digits[1]) * BigIntInfo::Base;
+  }
+  res.neg = t < 0;
+  res.abs = res.neg ? 0 - static_cast<u128>(t) : static_cast<u128>(t);
+  return !(res.abs >> 64);
+}
+
+// produces normalized words, as BigInt256::normalize() would
+void store(BigInt256& res, const Native& x) {
+  auto v = res.as_any_int();
+  long long carry = 0;
+  int size = 1;
+  for (int i = 0; i < 3; i++) {
+    long long t = static_cast<long long>((x.abs >> (i * BigIntInfo::word_shift)) & (BigIntInfo::Base - 1));
+    t = (x.neg ? -t : t) + carry;
+    if (t >= BigIntInfo::Half) {
+      t -= BigIntInfo::Base;
+      carry = 1;
+    } else if (t < -BigIntInfo::Half) {
+      t += BigIntInfo::Base;
+      carry = -1;
+    } else {
+      carry = 0;
+    }
+    v.digits[i] = t;
+    if (t) {
+      size = i + 1;
+    }
+  }
+  v.set_size(size);
+}
+
+// x * y + w for |x|, |y|, |w| < 2^64, which is less than 2^128 by absolute value
+Native mul_add(const Native& x, const Native& y, const Native& w) {
+  Native res{x.abs * y.abs, x.neg != y.neg};
+  if (!res.abs) {
+    return w;
+  }
+  if (res.neg == w.neg) {
+    res.abs += w.abs;
+  } else if (res.abs >= w.abs) {
+    res.abs -= w.abs;
+  } else {
+    res = Native{w.abs - res.abs, w.neg};
+  }
+  return res;
+}
+
+// (hi * 2^64 + lo) / d for hi < d, so that the quotient fits into 64 bits
+uint64 div128(uint64 hi, uint64 lo, uint64 d, uint64* rem) {
+#if defined(__x86_64__)
+  uint64 q;
+  __asm__("divq %4" : "=a"(q), "=d"(*rem) : "a"(lo), "d"(hi), "rm"(d));
+  return q;
+#else
+  u128 t = (static_cast<u128>(hi) << 64) | lo;
+  *rem = static_cast<uint64>(t % d);
+  return static_cast<uint64>(t / d);
+#endif
+}
+
+// given |n| = q0 * |d| + r0 with 0 <= r0 < |d|, computes the rounded quotient n / d and the remainder
+void round_quotient(const Native& n, u128 d, bool d_neg, u128 q0, u128 r0, int round_mode, Native& q, Native& r) {
+  bool q_neg = n.neg != d_neg, inc = false;
+  if (r0) {
+    if (round_mode < 0) {
+      inc = q_neg;
+    } else if (round_mode > 0) {
+      inc = !q_neg;
+    } else {
+      // r0 < 2^64 for division and r0 < 2^127 for shifts, so 2 * r0 does not overflow
+      inc = q_neg ? 2 * r0 > d : 2 * r0 >= d;
+    }
+  }
+  q = Native{q0 + inc, q_neg};
+  r = Native{inc ? d - r0 : r0, n.neg != inc};
+}
+
+bool divmod(const Native& n, const Native& d, int round_mode, Native& q, Native& r) {
+  if (!d.abs) {
+    return false;
+  }
+  uint64 y = static_cast<uint64>(d.abs), hi = static_cast<uint64>(n.abs >> 64), r0;
+  uint64 q_lo = div128(hi % y, static_cast<uint64>(n.abs), y, &r0);
+  round_quotient(n, d.abs, d.neg, (static_cast<u128>(hi / y) << 64) | q_lo, r0, round_mode, q, r);
+  return true;
+}
+
+bool shrmod(const Native& n, int s, int round_mode, Native& q, Native& r) {
+  if (s < 0 || s >= 128) {
+    return false;
+  }
+  u128 d = static_cast<u128>(1) << s;
+  round_quotient(n, d, false, n.abs >> s, n.abs & (d - 1), round_mode, q, r);
+  return true;
+}
+
+}  // namespace
+
+bool muldivmod_int64(long long x, long long y, long long w, long long z, int round_mode, long long* q, long long* r) {
+  Native quot, rem;
+  return divmod(mul_add(from_int64(x), from_int64(y), from_int64(w)), from_int64(z), round_mode, quot, rem) &&
+         to_int64(quot, rem, q, r);
+}
+
+bool mulshrmod_int64(long long x, long long y, long long w, int s, int round_mode, long long* q, long long* r) {
+  Native quot, rem;
+  return shrmod(mul_add(from_int64(x), from_int64(y), from_int64(w)), s, round_mode, quot, rem) &&
+         to_int64(quot, rem, q, r);
+}
+
+bool mul_native(const BigInt256& x, const BigInt256& y, BigInt256& res) {
+  Native a, b;
+  if (!load(x, a) || !load(y, b)) {
+    return false;
+  }
+  store(res, mul_add(a, b, Native{0, false}));
+  return true;
+}
+
+bool muldivmod_native(const BigInt256& x, const BigInt256& y, const BigInt256& z, int round_mode, BigInt256* q,
+                      BigInt256* r) {
+  Native a, b, c, quot, rem;
+  if (!load(x, a) || !load(y, b) || !load(z, c) ||
+      !divmod(mul_add(a, b, Native{0, false}), c, round_mode, quot, rem)) {
+    return false;
+  }
+  if (q) {
+    store(*q, quot);
+  }
+  if (r) {
+    store(*r, rem);
+  }
+  return true;
+}
+
+#else
+
+bool muldivmod_int64(long long x, long long y, long long w, long long z, int round_mode, long long* q, long long* r) {
+  return false;
+}
+
+bool mulshrmod_int64(long long x, long long y, long long w, int s, int round_mode, long long* q, long long* r) {
+  return false;
+}
+
+bool mul_native(const BigInt256& x, const BigInt256& y, BigInt256& res) {
+  return false;
+}
+
+bool muldivmod_native(const BigInt256& x, const BigInt256& y, const BigInt256& z, int round_mode, BigInt256* q,
+                      BigInt256* r) {
+  return false;
+}
+
+#endif
+
+}  // namespace td
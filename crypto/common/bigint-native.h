@@ -0,0 +1,45 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#pragma once
+
+#include "common/bigint.hpp"
+
+namespace td {
+
+/*
+ *
+ *   Fast paths for x*y, (x*y+w)/z and (x*y+w)>>s with 64-bit operands, computed on native 128-bit integers
+ *
+ *   round_mode is -1 (floor), 0 (nearest, ties towards +infinity) or 1 (ceil), as in BigInt256::mod_div().
+ *   The remainder is always x*y+w - q*z (resp. x*y+w - q*2^s); q and r may be null if not needed.
+ *   Each function returns false without touching its outputs if the fast path is not applicable: an operand
+ *   does not fit into 64 bits, division by zero, s >= 128, or a requested result does not fit into the output.
+ *   The caller then falls back to the generic BigInt256 code, which produces exactly the same results.
+ *
+ */
+
+bool muldivmod_int64(long long x, long long y, long long w, long long z, int round_mode, long long* q, long long* r);
+bool mulshrmod_int64(long long x, long long y, long long w, int s, int round_mode, long long* q, long long* r);
+
+// same for BigInt256 operands of absolute value less than 2^64; the results always fit
+bool mul_native(const BigInt256& x, const BigInt256& y, BigInt256& res);
+bool muldivmod_native(const BigInt256& x, const BigInt256& y, const BigInt256& z, int round_mode, BigInt256* q,
+                      BigInt256* r);
+
+}  // namespace td
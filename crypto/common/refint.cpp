@@ -17,6 +17,7 @@
     Copyright 2017-2020 Telegram Systems LLP
 */
 #include "common/refint.h"
+#include "common/bigint-native.h"
 #include <utility>
 #include <iostream>
 
@@ -70,7 +71,9 @@ RefInt256 operator~(RefInt256 x) {
 
 RefInt256 operator*(RefInt256 x, RefInt256 y) {
   RefInt256 z{true, 0};
-  z.write().add_mul(*x, *y).normalize();
+  if (!mul_native(*x, *y, z.write())) {
+    z.write().add_mul(*x, *y).normalize();
+  }
   return z;
 }
 
@@ -81,7 +84,9 @@ RefInt256 operator*(RefInt256 x, long long y) {
 
 RefInt256 operator*(RefInt256 x, const BigInt256& y) {
   RefInt256 z{true, 0};
-  z.write().add_mul(*x, y).normalize();
+  if (!mul_native(*x, y, z.write())) {
+    z.write().add_mul(*x, y).normalize();
+  }
   return z;
 }
 
@@ -119,19 +124,27 @@ std::pair<RefInt256, RefInt256> divmod(RefInt256 x, RefInt256 y, int round_mode)
 }
 
 RefInt256 muldiv(RefInt256 x, RefInt256 y, RefInt256 z, int round_mode) {
+  RefInt256 quot{true};
+  if (muldivmod_native(*x, *y, *z, round_mode, &quot.unique_write(), nullptr)) {
+    return quot;
+  }
   typename td::BigInt256::DoubleInt tmp{0};
   tmp.add_mul(*x, *y);
-  RefInt256 quot{true};
   tmp.mod_div(*z, quot.unique_write(), round_mode);
   quot.write().normalize();
   return quot;
 }
 
 std::pair<RefInt256, RefInt256> muldivmod(RefInt256 x, RefInt256 y, RefInt256 z, int round_mode) {
-  typename td::BigInt256::DoubleInt tmp{0}, quot;
-  tmp.add_mul(*x, *y);
-  tmp.mod_div(*z, quot, round_mode);
-  return std::make_pair(td::make_refint(quot.normalize()), td::make_refint(tmp));
+  RefInt256 q{true}, r{true};
+  if (!muldivmod_native(*x, *y, *z, round_mode, &q.unique_write(), &r.unique_write())) {
+    typename td::BigInt256::DoubleInt tmp{0}, quot;
+    tmp.add_mul(*x, *y);
+    tmp.mod_div(*z, quot, round_mode);
+    q.unique_write() = quot.normalize();
+    r.unique_write() = tmp;
+  }
+  return std::make_pair(std::move(q), std::move(r));
 }
 
 RefInt256 operator&(RefInt256 x, RefInt256 y) {
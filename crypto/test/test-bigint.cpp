@@ -25,8 +25,10 @@
 #include "common/refcnt.hpp"
 #include "common/bigint.hpp"
 #include "common/refint.h"
+#include "common/bigint-native.h"
 #include "modbigint.cpp"
 
+#include "td/utils/benchmark.h"
 #include "td/utils/tests.h"
 
 int mkint_chk_mode = -1, res_chk_mode = 0;
@@ -214,6 +216,14 @@ int randexp(int max = 63, int min = 0) {
   return min + td::count_leading_zeroes64(Random() | (1ULL << (63 - max + min)));
 }
 
+// random 64-bit integer of random bit length, including the extreme values
+long long rand_int64() {
+  if (!rand_int(0, 15)) {
+    return coin() ? ll_min : ll_max;
+  }
+  return (long long)Random() >> rand_int(0, 63);
+}
+
 void bin_add_small(unsigned char bin[64], long long val, int shift = 0) {
   val *= (1 << (shift & 7));
   for (int i = 63 - (shift >> 3); i >= 0 && val; --i) {
@@ -834,17 +844,98 @@ void check_random_ops() {
   }
 }
 
+// (x * y + w) / z, or (x * y + w) >> shift if shift >= 0, by the native fast paths and by the generic code
+void check_native_muldivmod_on(long long x, long long y, long long w, long long z, int shift, int rmode) {
+  long long ql, rl;
+  if (shift < 0 && !z) {
+    CHECK(!td::muldivmod_int64(x, y, w, z, rmode, &ql, &rl));
+    return;
+  }
+  typename td::BigInt256::DoubleInt tmp{w}, quot;
+  tmp.add_mul(*td::make_refint(x), *td::make_refint(y)).normalize();
+  if (shift >= 0) {
+    quot = tmp;
+    quot.rshift(shift, rmode).normalize();
+    tmp.mod_pow2(shift, rmode).normalize();
+  } else {
+    tmp.mod_div(*td::make_refint(z), quot, rmode);
+    quot.normalize();
+  }
+  auto q = td::make_refint(quot), r = td::make_refint(tmp);
+  bool ok = shift >= 0 ? td::mulshrmod_int64(x, y, w, shift, rmode, &ql, &rl)
+                       : td::muldivmod_int64(x, y, w, z, rmode, &ql, &rl);
+  // the fast path may decline only shifts out of range and results not fitting into 64 bits
+  if (!ok) {
+    CHECK(shift >= 128 || !q->signed_fits_bits(64) || !r->signed_fits_bits(64));
+  } else {
+    CHECK_EQ(q, ql);
+    CHECK_EQ(r, rl);
+  }
+  if (shift < 0 && !w) {
+    td::BigInt256 qn, rn;
+    CHECK(td::muldivmod_native(*td::make_refint(x), *td::make_refint(y), *td::make_refint(z), rmode, &qn, &rn));
+    CHECK_EQ(td::make_refint(qn), q);
+    CHECK_EQ(td::make_refint(rn), r);
+  }
+}
+
+void check_native_ops() {
+  std::cerr << "check native muldivmod (" << iterations << " iterations)" << std::endl;
+  for (cur_iteration = 0; cur_iteration < iterations; cur_iteration++) {
+    long long x = rand_int64(), y = rand_int64(), w = coin() ? rand_int64() : 0, z = rand_int64();
+    int rmode = rand_int(-1, 1);
+    check_native_muldivmod_on(x, y, w, z, -1, rmode);
+    check_native_muldivmod_on(x, y, w, z, rand_int(0, 130), rmode);
+  }
+}
+
 void check_special() {
   std::cerr << "run special tests" << std::endl;
   check_divmod((td::make_refint(-1) << 207) - 1, BInt::negpow2(207) - 1, ll_min, (td::make_refint(1) << 207) - 1,
                BInt::pow2(207) - 1, ll_min);
 }
 
+// MULDIVMOD on random operands fitting into 64 bits, with and without the native fast path
+class BenchMulDivMod : public td::Benchmark {
+ public:
+  explicit BenchMulDivMod(bool native) : native_(native) {
+    for (auto& x : values_) {
+      x = td::make_refint(rand_int64());
+    }
+  }
+  std::string get_description() const override {
+    return PSTRING() << "BenchMulDivMod " << (native_ ? "native" : "generic");
+  }
+
+  void run(int n) override {
+    for (int i = 0; i < n; i++) {
+      auto& x = values_[i % 1024], &y = values_[(i + 1) % 1024], &z = values_[(i + 2) % 1024];
+      td::RefInt256 q{true}, r{true};
+      if (!native_ || !td::muldivmod_native(*x, *y, *z, -1, &q.unique_write(), &r.unique_write())) {
+        typename td::BigInt256::DoubleInt tmp{0}, quot;
+        tmp.add_mul(*x, *y);
+        tmp.mod_div(*z, quot, -1);
+        q.unique_write() = quot.normalize();
+        r.unique_write() = tmp;
+      }
+      sum_ += r->sgn();
+    }
+  }
+
+ private:
+  bool native_;
+  std::array<td::RefInt256, 1024> values_;
+  long long sum_ = 0;
+};
+
 int main(int argc, char* const argv[]) {
-  bool do_check_shift_ops = false;
+  bool do_check_shift_ops = false, do_bench = false;
   int i;
-  while ((i = getopt(argc, argv, "hSs:i:")) != -1) {
+  while ((i = getopt(argc, argv, "hBSs:i:")) != -1) {
     switch (i) {
+      case 'B':
+        do_bench = true;
+        break;
       case 'S':
         do_check_shift_ops = true;
         break;
@@ -858,7 +949,7 @@ int main(int argc, char* const argv[]) {
         std::cerr << "unknown option: " << (char)i << std::endl;
         // fall through
       case 'h':
-        std::cerr << "usage:\t" << argv[0] << " [-S] [-i<random-op-iterations>] [-s<random-seed>]" << std::endl;
+        std::cerr << "usage:\t" << argv[0] << " [-B] [-S] [-i<random-op-iterations>] [-s<random-seed>]" << std::endl;
         return 2;
     }
   }
@@ -871,6 +962,11 @@ int main(int argc, char* const argv[]) {
     check_shift_ops();
   }
   check_special();
+  check_native_ops();
   check_random_ops();
+  if (do_bench) {
+    td::bench(BenchMulDivMod(false));
+    td::bench(BenchMulDivMod(true));
+  }
   return 0;
 }
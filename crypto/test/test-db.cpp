@@ -20,6 +20,7 @@
 #include "vm/cellslice.h"
 #include "vm/cells.h"
 #include "common/AtomicRef.h"
+#include "vm/cells/CellArena.h"
 #include "vm/cells/CellString.h"
 #include "vm/cells/MerkleProof.h"
 #include "vm/cells/MerkleUpdate.h"
@@ -32,6 +33,7 @@
 #include "td/utils/benchmark.h"
 #include "td/utils/crypto.h"
 #include "td/utils/Random.h"
+#include "td/utils/Sha256Batch.h"
 #include "td/utils/Slice.h"
 #include "td/utils/Span.h"
 #include "td/utils/Status.h"
@@ -325,6 +327,44 @@ TEST(Cell, sha_benchmark_threaded) {
   }
 }
 
+class BenchSha256Batch : public BenchSha {
+ public:
+  BenchSha256Batch(size_t n, td::Sha256Batch::Kernel kernel)
+      : BenchSha(n), kernel_(kernel), messages_(batch_size, str_), digests_(batch_size, std::string(32, '\0')) {
+  }
+
+  std::string get_name() const override {
+    return PSTRING() << "SHA256 batch of " << batch_size << " " << td::Sha256Batch::kernel_name(kernel_);
+  }
+
+  void run(int n) override {
+    int res = 0;
+    std::vector<td::MutableSlice> digests(digests_.begin(), digests_.end());
+    for (int i = 0; i < n; i += batch_size) {
+      td::Sha256Batch::hash(messages_, digests, kernel_);
+      res += digests[0][0];
+    }
+    td::do_not_optimize_away(res);
+  }
+
+ private:
+  static constexpr size_t batch_size = 256;
+  td::Sha256Batch::Kernel kernel_;
+  std::vector<td::Slice> messages_;
+  std::vector<std::string> digests_;
+};
+TEST(Cell, sha_batch_benchmark) {
+  for (size_t n : {4, 64, 128, 256}) {
+    bench(BenchSha256Reuse(n));
+    for (auto kernel :
+         {td::Sha256Batch::Kernel::Single, td::Sha256Batch::Kernel::Avx2, td::Sha256Batch::Kernel::Avx512}) {
+      if (td::Sha256Batch::is_supported(kernel)) {
+        bench(BenchSha256Batch(n, kernel));
+      }
+    }
+  }
+}
+
 std::string serialize_boc(Ref<Cell> cell, int mode = 31) {
   CHECK(cell.not_null());
   vm::BagOfCells boc;
@@ -854,6 +894,364 @@ TEST(TonDb, BenchCellBuilder3) {
   td::bench(BenchCellBuilder3());
 }
 
+// all data cells of the tree, children before parents
+std::vector<Ref<DataCell>> collect_data_cells(const Ref<Cell> &root) {
+  std::vector<Ref<DataCell>> res;
+  std::set<CellHash> visited;
+  auto dfs = [&](auto &&self, const Ref<Cell> &cell) -> void {
+    if (!visited.insert(cell->get_hash()).second) {
+      return;
+    }
+    auto data_cell = cell->load_cell().move_as_ok().data_cell;
+    for (unsigned i = 0; i < data_cell->size_refs(); i++) {
+      self(self, data_cell->get_ref(i));
+    }
+    res.push_back(std::move(data_cell));
+  };
+  dfs(dfs, root);
+  return res;
+}
+
+Ref<DataCell> copy_data_cell(const DataCell &cell, bool unhashed) {
+  CellBuilder cb;
+  cb.store_bits(cell.get_data(), cell.get_bits());
+  for (unsigned i = 0; i < cell.size_refs(); i++) {
+    cb.store_ref(cell.get_ref(i));
+  }
+  return (unhashed ? cb.finalize_unhashed_novm_nothrow(cell.is_special()) : cb.finalize_novm_nothrow(cell.is_special()))
+      .move_as_ok();
+}
+
+TEST(Cell, FinalizeHashes) {
+  td::Random::Xorshift128plus rnd{123};
+  for (int t = 0; t < 100; t++) {
+    auto cells = collect_data_cells(gen_random_cell(rnd.fast(1, 1000), rnd));
+    // children are already hashed, so all copies may be hashed at once
+    std::vector<Ref<DataCell>> copies;
+    for (auto &cell : cells) {
+      copies.push_back(copy_data_cell(*cell, true));
+    }
+    DataCell::finalize_hashes(copies);
+    for (size_t i = 0; i < cells.size(); i++) {
+      for (unsigned level = 0; level <= Cell::max_level; level++) {
+        ASSERT_EQ(cells[i]->get_hash(level), copies[i]->get_hash(level));
+        ASSERT_EQ(cells[i]->get_depth(level), copies[i]->get_depth(level));
+      }
+    }
+  }
+}
+
+class BenchCellHashing : public td::Benchmark {
+ public:
+  explicit BenchCellHashing(bool batch) : batch_(batch) {
+    td::Random::Xorshift128plus rnd(123);
+    cells_ = collect_data_cells(gen_random_cell(1000, rnd, false));
+  }
+  std::string get_description() const override {
+    return PSTRING() << "BenchCellHashing " << (batch_ ? "batch" : "one by one") << " cells=" << cells_.size();
+  }
+
+  void run(int n) override {
+    std::vector<Ref<DataCell>> copies;
+    copies.reserve(cells_.size());
+    for (int i = 0; i < n; i += static_cast<int>(cells_.size())) {
+      copies.clear();
+      for (auto &cell : cells_) {
+        copies.push_back(copy_data_cell(*cell, batch_));
+      }
+      if (batch_) {
+        DataCell::finalize_hashes(copies);
+      }
+    }
+  }
+
+ private:
+  bool batch_;
+  std::vector<Ref<DataCell>> cells_;
+};
+
+class BenchBocDeserialize : public td::Benchmark {
+ public:
+  explicit BenchBocDeserialize(bool by_waves) : by_waves_(by_waves) {
+    td::Random::Xorshift128plus rnd(123);
+    serialized_ = serialize_boc(gen_random_cell(10000, rnd, false), 0);
+  }
+  std::string get_description() const override {
+    return PSTRING() << "BenchBocDeserialize " << (by_waves_ ? "by waves" : "one by one");
+  }
+
+  void run(int n) override {
+    for (int i = 0; i < n; i++) {
+      BagOfCells boc;
+      boc.set_deserialize_by_waves(by_waves_);
+      boc.deserialize(serialized_).ensure();
+    }
+  }
+
+ private:
+  bool by_waves_;
+  std::string serialized_;
+};
+TEST(TonDb, BenchCellHashing) {
+  td::bench(BenchCellHashing(false));
+  td::bench(BenchCellHashing(true));
+  td::bench(BenchBocDeserialize(false));
+  td::bench(BenchBocDeserialize(true));
+}
+
+Ref<Cell> copy_cell_tree(const Ref<Cell> &root, std::map<CellHash, Ref<Cell>> &copies) {
+  auto it = copies.find(root->get_hash());
+  if (it != copies.end()) {
+    return it->second;
+  }
+  auto cell = root->load_cell().move_as_ok().data_cell;
+  CellBuilder cb;
+  cb.store_bits(cell->get_data(), cell->get_bits());
+  for (unsigned i = 0; i < cell->size_refs(); i++) {
+    cb.store_ref(copy_cell_tree(cell->get_ref(i), copies));
+  }
+  auto copy = cb.finalize_novm(cell->is_special());
+  copies.emplace(root->get_hash(), copy);
+  return copy;
+}
+
+TEST(Cell, LazyHashes) {
+  td::Random::Xorshift128plus rnd{123};
+  for (int t = 0; t < 100; t++) {
+    auto root = gen_random_cell(rnd.fast(1, 1000), rnd);
+    auto stats = DataCell::get_lazy_hash_stats();
+    std::map<CellHash, Ref<Cell>> copies;
+    Ref<Cell> copy;
+    {
+      DataCell::LazyHashGuard guard;
+      copy = copy_cell_tree(root, copies);
+    }
+    auto mode = t % 3;
+    std::atomic<td::int64> other_threads_hashed{0};
+    if (mode == 1) {
+      DataCell::finalize_lazy_hashes(copy);
+      ASSERT_TRUE(DataCell::get_lazy_hash_stats().batch_hashed > stats.batch_hashed);
+    } else if (mode == 2) {
+      // the same pending cells are hashed from several threads at once
+      std::vector<td::thread> threads;
+      for (int i = 0; i < 4; i++) {
+        threads.emplace_back([&] {
+          ASSERT_EQ(root->get_hash(), copy->get_hash());
+          other_threads_hashed += DataCell::get_lazy_hash_stats().hashed;
+        });
+      }
+      for (auto &thread : threads) {
+        thread.join();
+      }
+    }
+    auto cells = collect_data_cells(root);
+    auto copied_cells = collect_data_cells(copy);
+    ASSERT_EQ(cells.size(), copied_cells.size());
+    for (size_t i = 0; i < cells.size(); i++) {
+      for (unsigned level = 0; level <= Cell::max_level; level++) {
+        ASSERT_EQ(cells[i]->get_hash(level), copied_cells[i]->get_hash(level));
+        ASSERT_EQ(cells[i]->get_depth(level), copied_cells[i]->get_depth(level));
+      }
+    }
+    auto new_stats = DataCell::get_lazy_hash_stats();
+    ASSERT_EQ(static_cast<td::int64>(copies.size()), new_stats.created - stats.created);
+    // stats are per thread: cells hashed by other threads count as not hashed by this one
+    ASSERT_EQ(other_threads_hashed.load(), new_stats.not_hashed() - stats.not_hashed());
+  }
+  // cells created outside of the guard are hashed at once
+  auto stats = DataCell::get_lazy_hash_stats();
+  CellBuilder().store_long(1, 32).finalize_novm();
+  ASSERT_EQ(stats.created, DataCell::get_lazy_hash_stats().created);
+}
+
+TEST(Cell, CellArena) {
+  td::Random::Xorshift128plus rnd{123};
+  std::vector<Ref<DataCell>> cells;
+  for (int i = 0; i < 20000; i++) {
+    CellBuilder cb;
+    cb.store_long(rnd(), 64);
+    for (int j = rnd.fast(0, 2); j > 0 && !cells.empty(); j--) {
+      cb.store_ref(cells[rnd.fast(0, static_cast<int>(cells.size()) - 1)]);
+    }
+    cells.push_back(cb.finalize_novm());
+  }
+  std::vector<Ref<DataCell>> copies;
+  {
+    CellArena arena;
+    {
+      CellArena::Guard guard{arena};
+      for (auto &cell : cells) {
+        copies.push_back(copy_data_cell(*cell, false));
+      }
+    }
+    ASSERT_EQ(copies.size(), arena.get_stats().allocations);
+    ASSERT_TRUE(arena.get_stats().chunks > 1);
+    ASSERT_TRUE(CellArena::current() == nullptr);
+    // cells created outside of the guard are allocated on the heap
+    copy_data_cell(*cells[0], false);
+    ASSERT_EQ(copies.size(), arena.get_stats().allocations);
+    // so are cells loaded from a cell db
+    {
+      CellArena::Guard guard{arena};
+      struct NoExtCells : public ExtCellCreator {
+        td::Result<Ref<Cell>> ext_cell(Cell::LevelMask, td::Slice, td::Slice) override {
+          return td::Status::Error("unexpected ext cell");
+        }
+      } ext_cell_creator;
+      auto value = CellStorer::serialize_value(1, cells[0], false);
+      auto loaded = CellLoader::load(cells[0]->get_hash().as_slice(), value, true, ext_cell_creator).move_as_ok();
+      ASSERT_EQ(cells[0]->get_hash(), loaded.cell()->get_hash());
+      {
+        CellArena::Suspend no_arena;
+        copy_data_cell(*cells[0], false);
+      }
+      ASSERT_EQ(copies.size(), arena.get_stats().allocations);
+    }
+  }
+  // some cells die, the others outlive the arena
+  for (size_t i = 0; i < copies.size(); i++) {
+    if (rnd.fast(0, 1)) {
+      copies[i].clear();
+    }
+  }
+  for (size_t i = 0; i < copies.size(); i++) {
+    if (copies[i].not_null()) {
+      ASSERT_EQ(cells[i]->get_hash(), copies[i]->get_hash());
+      ASSERT_EQ(cells[i]->get_bits(), copies[i]->get_bits());
+    }
+  }
+}
+
+namespace {
+// extra of a node is the sum of the 32-bit values of its leaves
+struct SumAugmentation : dict::AugmentationData {
+  bool skip_extra(CellSlice &cs) const override {
+    return cs.advance(64);
+  }
+  bool eval_leaf(CellBuilder &cb, CellSlice &val_cs) const override {
+    return cb.store_long_bool(val_cs.prefetch_ulong(32), 64);
+  }
+  bool eval_fork(CellBuilder &cb, CellSlice &left_cs, CellSlice &right_cs) const override {
+    return cb.store_long_bool(left_cs.prefetch_ulong(64) + right_cs.prefetch_ulong(64), 64);
+  }
+  bool eval_empty(CellBuilder &cb) const override {
+    return cb.store_long_bool(0, 64);
+  }
+};
+
+struct DictBatch {
+  std::vector<td::BitArray<32>> keys;
+  std::vector<DictionaryFixed::BatchOp> ops;
+};
+
+DictBatch gen_dict_batch(td::Random::Xorshift128plus &rnd, int size, td::uint32 key_mask, int delete_prob) {
+  std::set<td::uint32> keys;
+  while ((int)keys.size() < size) {
+    keys.insert(static_cast<td::uint32>(rnd()) & key_mask);
+  }
+  DictBatch batch;
+  batch.keys.reserve(keys.size());
+  for (auto key : keys) {
+    batch.keys.emplace_back();
+    batch.keys.back().store_ulong(key);
+    Ref<CellSlice> value;
+    if (rnd.fast(0, 99) >= delete_prob) {
+      value = load_cell_slice_ref(CellBuilder().store_long(rnd.fast(0, 1000000), 32).finalize());
+    }
+    batch.ops.push_back({batch.keys.back().cbits(), std::move(value)});
+  }
+  return batch;
+}
+
+void apply_one_by_one(DictionaryFixed &dict, const DictBatch &batch) {
+  for (auto &op : batch.ops) {
+    if (op.value.is_null()) {
+      dict.lookup_delete(op.key, 32);
+    } else if (auto *aug_dict = dynamic_cast<AugmentedDictionary *>(&dict)) {
+      aug_dict->set(op.key, 32, op.value);
+    } else {
+      static_cast<Dictionary &>(dict).set(op.key, 32, op.value);
+    }
+  }
+}
+}  // namespace
+
+TEST(Cell, DictionaryBatch) {
+  td::Random::Xorshift128plus rnd{123};
+  SumAugmentation aug;
+  for (int t = 0; t < 100; t++) {
+    // small key spaces make batches hit existing keys and remove whole subtrees
+    td::uint32 key_mask = rnd.fast(0, 1) ? 0xff00ff : 0xffffffff;
+    int size = rnd.fast(1, 1 << rnd.fast(0, 10));
+    Dictionary dict1{32}, dict2{32};
+    AugmentedDictionary aug_dict1{32, aug}, aug_dict2{32, aug};
+    for (int step = 0; step < 5; step++) {
+      auto batch = gen_dict_batch(rnd, size, key_mask, step == 0 ? 0 : rnd.fast(0, 100));
+      ASSERT_TRUE(dict1.apply_batch(batch.ops));
+      ASSERT_TRUE(aug_dict1.apply_batch(batch.ops));
+      apply_one_by_one(dict2, batch);
+      apply_one_by_one(aug_dict2, batch);
+      ASSERT_EQ(dict2.is_empty(), dict1.is_empty());
+      if (!dict1.is_empty()) {
+        ASSERT_EQ(dict2.get_root_cell()->get_hash(), dict1.get_root_cell()->get_hash());
+        ASSERT_EQ(aug_dict2.get_root_cell()->get_hash(), aug_dict1.get_root_cell()->get_hash());
+      }
+      ASSERT_TRUE(aug_dict1.get_root_extra()->prefetch_ulong(64) == aug_dict2.get_root_extra()->prefetch_ulong(64));
+    }
+  }
+  // keys must be strictly increasing
+  auto batch = gen_dict_batch(rnd, 10, 0xffffffff, 0);
+  std::swap(batch.ops[3], batch.ops[4]);
+  Dictionary dict{32};
+  ASSERT_TRUE(!dict.apply_batch(batch.ops));
+  ASSERT_TRUE(dict.is_empty());
+}
+
+namespace {
+using DictDiffs = std::vector<std::tuple<std::string, long long, long long>>;
+
+DictionaryFixed::scan_diff_func_t collect_dict_diffs(DictDiffs &diffs, std::size_t limit) {
+  return [&diffs, limit](td::ConstBitPtr key, int key_len, Ref<CellSlice> value1, Ref<CellSlice> value2) {
+    diffs.emplace_back(key.to_hex(key_len), value1.is_null() ? -1 : (long long)value1->prefetch_ulong(32),
+                       value2.is_null() ? -1 : (long long)value2->prefetch_ulong(32));
+    return diffs.size() < limit;
+  };
+}
+
+void check_scan_diff_parallel(DictionaryFixed &dict1, DictionaryFixed &dict2, int check_augm, std::size_t limit) {
+  DictDiffs diffs, parallel_diffs;
+  bool res = dict1.scan_diff(dict2, collect_dict_diffs(diffs, limit), check_augm);
+  bool parallel_res = dict1.scan_diff_parallel(dict2, collect_dict_diffs(parallel_diffs, limit), check_augm, 4);
+  ASSERT_EQ(res, parallel_res);
+  ASSERT_TRUE(diffs == parallel_diffs);
+}
+
+}  // namespace
+
+TEST(Cell, DictionaryParallel) {
+  td::Random::Xorshift128plus rnd{123};
+  SumAugmentation aug;
+  for (int t = 0; t < 100; t++) {
+    td::uint32 key_mask = rnd.fast(0, 1) ? 0xff00ff : 0xffffffff;
+    Dictionary plain1{32}, plain2{32};
+    AugmentedDictionary dict1{32, aug}, dict2{32, aug};
+    auto batch1 = gen_dict_batch(rnd, rnd.fast(0, 1 << rnd.fast(0, 12)), key_mask, 0);
+    plain1.apply_batch(batch1.ops);
+    dict1.apply_batch(batch1.ops);
+    if (rnd.fast(0, 3)) {
+      // mostly shared subtrees with a few differences
+      plain2.apply_batch(batch1.ops);
+      dict2.apply_batch(batch1.ops);
+    }
+    auto batch2 = gen_dict_batch(rnd, rnd.fast(1, 1 << rnd.fast(0, 10)), key_mask, rnd.fast(0, 100));
+    plain2.apply_batch(batch2.ops);
+    dict2.apply_batch(batch2.ops);
+    check_scan_diff_parallel(dict1, dict2, 3, std::numeric_limits<std::size_t>::max());
+    check_scan_diff_parallel(plain1, plain2, 0, std::numeric_limits<std::size_t>::max());
+    check_scan_diff_parallel(plain2, plain1, 0, rnd.fast(1, 100));
+  }
+}
+
 TEST(TonDb, BocFuzz) {
   vm::std_boc_deserialize(td::base64_decode("te6ccgEBAQEAAgAoAAA=").move_as_ok()).ensure_error();
   vm::std_boc_deserialize(td::base64_decode("te6ccgQBQQdQAAAAAAEAte6ccgQBB1BBAAAAAAEAAAAAAP/"
@@ -922,6 +1320,146 @@ TEST(TonDb, BocMultipleRoots) {
   }
 };
 
+TEST(TonDb, CompactCellStorage) {
+  td::Random::Xorshift128plus rnd{123};
+  auto kv = std::make_shared<td::MemoryKeyValue>();
+  auto dboc = DynamicBagOfCellsDb::create();
+  dboc->set_loader(std::make_unique<CellLoader>(kv));
+  CellLoader loader(kv);
+  size_t plain_size = 0;
+  size_t compact_size = 0;
+  for (int t = 0; t < 100; t++) {
+    auto root = gen_random_cell(rnd.fast(1, 1000), rnd);
+    std::map<CellHash, Ref<Cell>> cells;
+    copy_cell_tree(root, cells);
+    for (auto &it : cells) {
+      auto cell = it.second->load_cell().move_as_ok().data_cell;
+      td::int32 refcnt = rnd.fast(0, 3) == 0 ? rnd.fast(1, 1 << 20) : rnd.fast(1, 3);
+      bool compact = rnd.fast(0, 1) == 1;
+      plain_size += CellStorer::serialize_value(refcnt, cell, false).size();
+      compact_size += CellStorer::serialize_value(refcnt, cell, false, true).size();
+      CellStorer(*kv, compact).set(refcnt, cell, false).ensure();
+
+      auto res = loader.load(cell->get_hash().as_slice(), true, dboc->as_ext_cell_creator()).move_as_ok();
+      ASSERT_EQ(compact, res.stored_compact_);
+      ASSERT_EQ(refcnt, res.refcnt());
+      ASSERT_EQ(cell->get_hash(), res.cell()->get_hash());
+      ASSERT_EQ(cell->get_depth(), res.cell()->get_depth());
+      ASSERT_EQ(refcnt, loader.load_refcnt(cell->get_hash().as_slice()).move_as_ok().refcnt());
+    }
+    auto loaded = dboc->load_cell(root->get_hash().as_slice()).move_as_ok();
+    ASSERT_EQ(serialize_boc(root), serialize_boc(loaded));
+  }
+  LOG(INFO) << "Plain values: " << plain_size << " bytes, compact values: " << compact_size << " bytes";
+  ASSERT_TRUE(compact_size < plain_size);
+
+  // an inlined child is never larger than a reference to it
+  auto compact_size_with_child = [](unsigned bits) {
+    CellBuilder child;
+    child.store_zeroes(bits);
+    CellBuilder parent;
+    parent.store_ref(child.finalize());
+    return CellStorer::serialize_value(1, parent.finalize(), false, true).size();
+  };
+  auto ref_size = compact_size_with_child(Cell::max_bits);
+  for (unsigned bits = 0; bits <= Cell::max_bits; bits++) {
+    ASSERT_TRUE(compact_size_with_child(bits) <= ref_size);
+  }
+}
+
+struct TestCellInfo {
+  td::int32 refcnt{0};
+  Ref<Cell> cell;
+};
+CellHash as_cell_hash(const TestCellInfo &info) {
+  return info.cell->get_hash();
+}
+
+TEST(Cell, ConcurrentCellHashTable) {
+  td::Random::Xorshift128plus rnd{123};
+  std::vector<Ref<Cell>> cells;
+  for (int i = 0; i < 2000; i++) {
+    cells.push_back(CellBuilder().store_long(i, 32).finalize());
+  }
+  auto set_refcnt = [](auto &table, const Ref<Cell> &cell, td::int32 refcnt) {
+    table.apply(cell->get_hash(), [&](TestCellInfo &info) {
+      if (info.cell.is_null()) {
+        info.cell = cell;
+      }
+      info.refcnt = refcnt;
+    });
+  };
+
+  // few stripes, so that they grow and shrink a lot
+  ConcurrentCellHashTable<TestCellInfo, 4> table;
+  std::map<CellHash, td::int32> expected;
+  for (int t = 0; t < 100000; t++) {
+    auto &cell = cells[rnd.fast(0, static_cast<int>(cells.size()) - 1)];
+    if (rnd.fast(0, 2) == 0) {
+      ASSERT_EQ(expected.erase(cell->get_hash()) != 0, table.erase(cell->get_hash()));
+    } else {
+      auto refcnt = rnd.fast(1, 100);
+      set_refcnt(table, cell, refcnt);
+      expected[cell->get_hash()] = refcnt;
+    }
+    ASSERT_EQ(expected.size(), table.size());
+  }
+  for (auto &cell : cells) {
+    auto info = table.get(cell->get_hash());
+    auto it = expected.find(cell->get_hash());
+    ASSERT_EQ(it != expected.end(), info.has_value());
+    if (info) {
+      ASSERT_EQ(it->second, info->refcnt);
+    }
+  }
+  size_t visited = 0;
+  for (size_t i = 0; i < table.stripe_count(); i++) {
+    table.for_each_in_stripe(i, [&](TestCellInfo &info) {
+      ASSERT_EQ(expected.at(as_cell_hash(info)), info.refcnt);
+      visited++;
+    });
+  }
+  ASSERT_EQ(expected.size(), visited);
+
+  // writers own disjoint sets of cells, readers look up all of them at the same time
+  ConcurrentCellHashTable<TestCellInfo> shared;
+  const size_t writers_n = 4;
+  std::atomic<size_t> writers_done{0};
+  std::vector<td::thread> threads;
+  for (size_t w = 0; w < writers_n; w++) {
+    threads.emplace_back([&, w] {
+      for (size_t i = w; i < cells.size(); i += writers_n) {
+        set_refcnt(shared, cells[i], static_cast<td::int32>(i));
+      }
+      for (size_t i = w; i < cells.size(); i += writers_n) {
+        if (i % 3 == 0) {
+          CHECK(shared.erase(cells[i]->get_hash()));
+        }
+      }
+      writers_done++;
+    });
+  }
+  for (td::uint64 r = 0; r < 2; r++) {
+    threads.emplace_back([&, r] {
+      td::Random::Xorshift128plus rnd{r};
+      while (writers_done.load() != writers_n) {
+        auto i = rnd.fast(0, static_cast<int>(cells.size()) - 1);
+        if (auto info = shared.get(cells[i]->get_hash())) {
+          CHECK(info->refcnt == i);
+          CHECK(info->cell.get() == cells[i].get());
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  for (size_t i = 0; i < cells.size(); i++) {
+    ASSERT_EQ(i % 3 != 0, shared.get(cells[i]->get_hash()).has_value());
+  }
+  ASSERT_EQ(cells.size() - (cells.size() + 2) / 3, shared.size());
+}
+
 TEST(TonDb, InMemoryDynamicBocSimple) {
   auto counter = [] { return td::NamedThreadSafeCounter::get_default().get_counter("DataCell").sum(); };
   auto before = counter();
@@ -448,3 +448,84 @@ RETALT
 )A";
   test_run_vm(fift::compile_asm(test1).move_as_ok());
 }
+
+TEST(VM, small_int_arith) {
+  vm::init_vm().ensure();
+  // integers pushed by push_smallint take the inline fast paths, the same values as BigInt256 take the generic ones
+  auto run = [](const std::vector<unsigned> &code, const std::vector<long long> &args, bool small, int version = 0) {
+    vm::CellBuilder cb;
+    for (auto byte : code) {
+      cb.store_long(byte, 8);
+    }
+    vm::Stack stack;
+    for (auto arg : args) {
+      if (small) {
+        stack.push_smallint(arg);
+      } else {
+        stack.push_int(td::make_refint(arg));
+      }
+    }
+    vm::GasLimits gas_limit(1000, 1000);
+    int exit_code = vm::run_vm_code(vm::load_cell_slice_ref(cb.finalize()), stack, 0, nullptr, {}, nullptr, &gas_limit,
+                                    {}, {}, nullptr, version);
+    td::StringBuilder sb;
+    sb << exit_code << " gas=" << gas_limit.gas_consumed() << " stack=";
+    for (int i = stack.depth() - 1; i >= 0; i--) {
+      sb << stack[i].to_string() << " ";
+    }
+    return sb.as_cslice().str();
+  };
+
+  std::vector<std::vector<unsigned>> unary_ops{{0xa3},       {0xa4},       {0xa5},       {0xa6, 0x7f}, {0xa6, 0x80},
+                                               {0xa7, 0x7f}, {0xa7, 0x80}, {0xb8},       {0xc0, 0x05}, {0xc1, 0xfb},
+                                               {0xc2, 0x00}, {0xc3, 0x01}, {0xb7, 0xa3}, {0xb7, 0xa4}, {0xb7, 0xa5}};
+  std::vector<std::vector<unsigned>> binary_ops{{0xa0}, {0xa1}, {0xa2}, {0xa8}, {0xb9}, {0xba}, {0xbb},
+                                                {0xbc}, {0xbd}, {0xbe}, {0xbf}, {0xb7, 0xa0}, {0xb7, 0xa1},
+                                                {0xb7, 0xa8}, {0xb7, 0xbf}};
+  using Limits = std::numeric_limits<long long>;
+  std::vector<long long> numbers{0,           1,           -1,          2,          100,        -100,
+                                 1 << 30,     -(1 << 30),  1LL << 31,   -(1LL << 31), 1LL << 32, 3037000499,
+                                 -3037000500, Limits::max(), Limits::min(), Limits::max() - 1, Limits::min() + 1};
+  for (auto &op : unary_ops) {
+    for (auto x : numbers) {
+      ASSERT_EQ(run(op, {x}, false), run(op, {x}, true));
+    }
+  }
+  for (auto &op : binary_ops) {
+    for (auto x : numbers) {
+      for (auto y : numbers) {
+        ASSERT_EQ(run(op, {x, y}, false), run(op, {x, y}, true));
+      }
+    }
+  }
+
+  // MULDIV, MULMOD, MULDIVMOD, MULRSHIFT and their rounding, quiet and MULADD variants
+  std::vector<std::vector<unsigned>> muldiv_ops{
+      {0xa9, 0x84}, {0xa9, 0x85}, {0xa9, 0x86}, {0xa9, 0x88}, {0xa9, 0x89}, {0xa9, 0x8a}, {0xa9, 0x8c},
+      {0xa9, 0x8d}, {0xa9, 0x8e}, {0xa9, 0xa4}, {0xa9, 0xa9}, {0xa9, 0xae}, {0xb7, 0xa9, 0x84}, {0xb7, 0xa9, 0x8c}};
+  std::vector<std::vector<unsigned>> muladd_ops{{0xa9, 0x80}, {0xa9, 0x81}, {0xa9, 0x82}, {0xa9, 0xa0}, {0xa9, 0xa1}};
+  std::vector<std::vector<unsigned>> mulshr_imm_ops{{0xa9, 0xb4, 0x00}, {0xa9, 0xb5, 0x1f}, {0xa9, 0xb6, 0x3f},
+                                                    {0xa9, 0xb9, 0x3f}, {0xa9, 0xbc, 0x5f}, {0xa9, 0xbd, 0xff}};
+  std::vector<long long> operands{0, 1, -1, 7, -100, 1LL << 32, 3037000499, Limits::max(), Limits::min()};
+  std::vector<long long> divisors{0, 1, -1, 2, 3, -7, 1LL << 32, Limits::max(), Limits::min()};
+  std::vector<long long> shifts{0, 1, 3, 32, 63, 64, 127, 128, 256};
+  for (auto x : operands) {
+    for (auto y : operands) {
+      for (auto &op : muldiv_ops) {
+        for (auto z : op[op.size() - 1] >= 0xa0 ? shifts : divisors) {
+          ASSERT_EQ(run(op, {x, y, z}, false), run(op, {x, y, z}, true));
+        }
+      }
+      for (auto &op : muladd_ops) {
+        for (auto w : operands) {
+          for (auto z : op[1] >= 0xa0 ? shifts : divisors) {
+            ASSERT_EQ(run(op, {x, y, w, z}, false, 4), run(op, {x, y, w, z}, true, 4));
+          }
+        }
+      }
+      for (auto &op : mulshr_imm_ops) {
+        ASSERT_EQ(run(op, {x, y}, false), run(op, {x, y}, true));
+      }
+    }
+  }
+}
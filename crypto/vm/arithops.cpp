@@ -17,6 +17,7 @@
     Copyright 2017-2020 Telegram Systems LLP
 */
 #include <functional>
+#include <limits>
 #include "vm/arithops.h"
 #include "vm/log.h"
 #include "vm/opctable.h"
@@ -24,6 +25,7 @@
 #include "vm/excno.hpp"
 #include "vm/vm.h"
 #include "common/bigint.hpp"
+#include "common/bigint-native.h"
 #include "common/refint.h"
 
 namespace vm {
@@ -159,10 +161,71 @@ void register_int_const_ops(OpcodeTable& cp0) {
       .insert(OpcodeInstr::mkfixed(0x85, 8, 8, instr::dump_1c_l_add(1, "PUSHNEGPOW2 "), exec_push_negpow2));
 }
 
+// Fast paths for integers stored inline in stack entries (see StackEntry::make_small_int).
+// They return false if an operand is not a small integer or the result doesn't fit into 64 bits,
+// then the operation is computed by the generic BigInt256 code with the same result.
+static bool small_add(long long x, long long y, long long& res) {
+  if ((y > 0 && x > std::numeric_limits<long long>::max() - y) ||
+      (y < 0 && x < std::numeric_limits<long long>::min() - y)) {
+    return false;
+  }
+  res = x + y;
+  return true;
+}
+
+static bool small_sub(long long x, long long y, long long& res) {
+  if ((y < 0 && x > std::numeric_limits<long long>::max() + y) ||
+      (y > 0 && x < std::numeric_limits<long long>::min() + y)) {
+    return false;
+  }
+  res = x - y;
+  return true;
+}
+
+static bool small_mul(long long x, long long y, long long& res) {
+#if defined(__GNUC__) || defined(__clang__)
+  return !__builtin_mul_overflow(x, y, &res);
+#else
+  if (x > 0 ? (y > 0 ? x > std::numeric_limits<long long>::max() / y : y < std::numeric_limits<long long>::min() / x)
+            : (y > 0 ? x < std::numeric_limits<long long>::min() / y
+                     : (x != 0 && y < std::numeric_limits<long long>::max() / x))) {
+    return false;
+  }
+  res = x * y;
+  return true;
+#endif
+}
+
+template <class F>
+static bool exec_small_binary(Stack& stack, F&& f) {
+  long long res;
+  if (!stack[0].is_small_int() || !stack[1].is_small_int() ||
+      !f(stack[1].get_small_int(), stack[0].get_small_int(), res)) {
+    return false;
+  }
+  stack.pop_many(2);
+  stack.push_smallint(res);
+  return true;
+}
+
+template <class F>
+static bool exec_small_unary(Stack& stack, F&& f) {
+  long long res;
+  if (!stack[0].is_small_int() || !f(stack[0].get_small_int(), res)) {
+    return false;
+  }
+  stack.pop_many(1);
+  stack.push_smallint(res);
+  return true;
+}
+
 int exec_add(VmState* st, bool quiet) {
   Stack& stack = st->get_stack();
   VM_LOG(st) << "execute ADD";
   stack.check_underflow(2);
+  if (exec_small_binary(stack, small_add)) {
+    return 0;
+  }
   auto y = stack.pop_int();
   stack.push_int_quiet(stack.pop_int() + std::move(y), quiet);
   return 0;
@@ -172,6 +235,9 @@ int exec_sub(VmState* st, bool quiet) {
   Stack& stack = st->get_stack();
   VM_LOG(st) << "execute SUB";
   stack.check_underflow(2);
+  if (exec_small_binary(stack, small_sub)) {
+    return 0;
+  }
   auto y = stack.pop_int();
   stack.push_int_quiet(stack.pop_int() - std::move(y), quiet);
   return 0;
@@ -181,6 +247,9 @@ int exec_subr(VmState* st, bool quiet) {
   Stack& stack = st->get_stack();
   VM_LOG(st) << "execute SUBR";
   stack.check_underflow(2);
+  if (exec_small_binary(stack, [](long long x, long long y, long long& res) { return small_sub(y, x, res); })) {
+    return 0;
+  }
   auto y = stack.pop_int();
   stack.push_int_quiet(std::move(y) - stack.pop_int(), quiet);
   return 0;
@@ -190,6 +259,9 @@ int exec_negate(VmState* st, bool quiet) {
   Stack& stack = st->get_stack();
   VM_LOG(st) << "execute NEGATE";
   stack.check_underflow(1);
+  if (exec_small_unary(stack, [](long long x, long long& res) { return small_sub(0, x, res); })) {
+    return 0;
+  }
   stack.push_int_quiet(-stack.pop_int(), quiet);
   return 0;
 }
@@ -198,6 +270,9 @@ int exec_inc(VmState* st, bool quiet) {
   Stack& stack = st->get_stack();
   VM_LOG(st) << "execute INC";
   stack.check_underflow(1);
+  if (exec_small_unary(stack, [](long long x, long long& res) { return small_add(x, 1, res); })) {
+    return 0;
+  }
   stack.push_int_quiet(stack.pop_int() + 1, quiet);
   return 0;
 }
@@ -206,6 +281,9 @@ int exec_dec(VmState* st, bool quiet) {
   Stack& stack = st->get_stack();
   VM_LOG(st) << "execute DEC";
   stack.check_underflow(1);
+  if (exec_small_unary(stack, [](long long x, long long& res) { return small_sub(x, 1, res); })) {
+    return 0;
+  }
   stack.push_int_quiet(stack.pop_int() - 1, quiet);
   return 0;
 }
@@ -215,6 +293,9 @@ int exec_add_tinyint8(VmState* st, unsigned args, bool quiet) {
   Stack& stack = st->get_stack();
   VM_LOG(st) << "execute ADDINT " << x;
   stack.check_underflow(1);
+  if (exec_small_unary(stack, [x](long long y, long long& res) { return small_add(y, x, res); })) {
+    return 0;
+  }
   stack.push_int_quiet(stack.pop_int() + x, quiet);
   return 0;
 }
@@ -224,6 +305,9 @@ int exec_mul_tinyint8(VmState* st, unsigned args, bool quiet) {
   Stack& stack = st->get_stack();
   VM_LOG(st) << "execute MULINT " << x;
   stack.check_underflow(1);
+  if (exec_small_unary(stack, [x](long long y, long long& res) { return small_mul(y, x, res); })) {
+    return 0;
+  }
   stack.push_int_quiet(stack.pop_int() * x, quiet);
   return 0;
 }
@@ -232,6 +316,9 @@ int exec_mul(VmState* st, bool quiet) {
   Stack& stack = st->get_stack();
   VM_LOG(st) << "execute MUL";
   stack.check_underflow(2);
+  if (exec_small_binary(stack, small_mul)) {
+    return 0;
+  }
   auto y = stack.pop_int();
   stack.push_int_quiet(stack.pop_int() * std::move(y), quiet);
   return 0;
@@ -431,6 +518,32 @@ std::string dump_shrmod(CellSlice&, unsigned args, int mode) {
   return os.str();
 }
 
+// (x*y+w)/z, or (x*y+w)>>shift if shift >= 0, for small integers (see exec_small_binary);
+// pushes the quotient if d & 1 and the remainder if d & 2, unless one of them doesn't fit into 64 bits
+static bool exec_small_muldivmod(Stack& stack, bool add, unsigned d, int round_mode, int shift = -1) {
+  int z_cnt = shift < 0 ? 1 : 0, cnt = z_cnt + (add ? 3 : 2);
+  for (int i = 0; i < cnt; i++) {
+    if (!stack[i].is_small_int()) {
+      return false;
+    }
+  }
+  long long z = z_cnt ? stack[0].get_small_int() : 0, w = add ? stack[z_cnt].get_small_int() : 0;
+  long long y = stack[cnt - 2].get_small_int(), x = stack[cnt - 1].get_small_int(), q, r;
+  long long *q_ptr = (d & 1) ? &q : nullptr, *r_ptr = (d & 2) ? &r : nullptr;
+  if (!(shift < 0 ? td::muldivmod_int64(x, y, w, z, round_mode, q_ptr, r_ptr)
+                  : td::mulshrmod_int64(x, y, w, shift, round_mode, q_ptr, r_ptr))) {
+    return false;
+  }
+  stack.pop_many(cnt);
+  if (d & 1) {
+    stack.push_smallint(q);
+  }
+  if (d & 2) {
+    stack.push_smallint(r);
+  }
+  return true;
+}
+
 int exec_muldivmod(VmState* st, unsigned args, int quiet) {
   int round_mode = (int)(args & 3) - 1;
   unsigned d = (args >> 2) & 3;
@@ -445,6 +558,9 @@ int exec_muldivmod(VmState* st, unsigned args, int quiet) {
   Stack& stack = st->get_stack();
   VM_LOG(st) << "execute MULDIV/MOD " << (args & 15);
   stack.check_underflow(add ? 4 : 3);
+  if (exec_small_muldivmod(stack, add, d, round_mode)) {
+    return 0;
+  }
   auto z = stack.pop_int();
   auto w = add ? stack.pop_int() : td::RefInt256{};
   auto y = stack.pop_int();
@@ -521,6 +637,9 @@ int exec_mulshrmod(VmState* st, unsigned args, int mode) {
   if (!z) {
     round_mode = -1;
   }
+  if (exec_small_muldivmod(stack, add, d, round_mode, z)) {
+    return 0;
+  }
   auto w = add ? stack.pop_int() : td::RefInt256{};
   auto y = stack.pop_int();
   auto x = stack.pop_int();
@@ -962,6 +1081,12 @@ int exec_sgn(VmState* st, int mode, bool quiet, const char* name) {
   Stack& stack = st->get_stack();
   VM_LOG(st) << "execute " << name;
   stack.check_underflow(1);
+  if (stack[0].is_small_int()) {
+    long long x = stack.pop().get_small_int();
+    int y = (x > 0) - (x < 0);
+    stack.push_smallint(((mode >> (4 + y * 4)) & 15) - 8);
+    return 0;
+  }
   auto x = stack.pop_int();
   if (!x->is_valid()) {
     stack.push_int_quiet(std::move(x), quiet);
@@ -976,6 +1101,13 @@ int exec_cmp(VmState* st, int mode, bool quiet, const char* name) {
   Stack& stack = st->get_stack();
   VM_LOG(st) << "execute " << name;
   stack.check_underflow(2);
+  if (stack[0].is_small_int() && stack[1].is_small_int()) {
+    long long y = stack.pop().get_small_int();
+    long long x = stack.pop().get_small_int();
+    int z = (x > y) - (x < y);
+    stack.push_smallint(((mode >> (4 + z * 4)) & 15) - 8);
+    return 0;
+  }
   auto y = stack.pop_int();
   auto x = stack.pop_int();
   if (!x->is_valid() || !y->is_valid()) {
@@ -994,6 +1126,12 @@ int exec_cmp_int(VmState* st, unsigned args, int mode, bool quiet, const char* n
   Stack& stack = st->get_stack();
   VM_LOG(st) << "execute " << name << "INT " << y;
   stack.check_underflow(1);
+  if (stack[0].is_small_int()) {
+    long long x = stack.pop().get_small_int();
+    int z = (x > y) - (x < y);
+    stack.push_smallint(((mode >> (4 + z * 4)) & 15) - 8);
+    return 0;
+  }
   auto x = stack.pop_int();
   if (!x->is_valid()) {
     stack.push_int_quiet(std::move(x), quiet);
@@ -89,6 +89,18 @@ td::Result<int> CellSerializationInfo::get_bits(td::Slice cell) const {
 // TODO: check usage when result is empty
 td::Result<Ref<DataCell>> CellSerializationInfo::create_data_cell(td::Slice cell_slice,
                                                                   td::Span<Ref<Cell>> refs) const {
+  TRY_RESULT(res, do_create_data_cell(cell_slice, refs, false));
+  TRY_STATUS(check_hashes(cell_slice, *res));
+  return std::move(res);
+}
+
+td::Result<Ref<DataCell>> CellSerializationInfo::create_unhashed_data_cell(td::Slice cell_slice,
+                                                                           td::Span<Ref<Cell>> refs) const {
+  return do_create_data_cell(cell_slice, refs, true);
+}
+
+td::Result<Ref<DataCell>> CellSerializationInfo::do_create_data_cell(td::Slice cell_slice, td::Span<Ref<Cell>> refs,
+                                                                     bool unhashed) const {
   CellBuilder cb;
   TRY_RESULT(bits, get_bits(cell_slice));
   cb.store_bits(cell_slice.ubegin() + data_offset, bits);
@@ -96,7 +108,7 @@ td::Result<Ref<DataCell>> CellSerializationInfo::create_data_cell(td::Slice cell
   for (int k = 0; k < refs_cnt; k++) {
     cb.store_ref(std::move(refs[k]));
   }
-  TRY_RESULT(res, cb.finalize_novm_nothrow(special));
+  TRY_RESULT(res, unhashed ? cb.finalize_unhashed_novm_nothrow(special) : cb.finalize_novm_nothrow(special));
   CHECK(!res.is_null());
   if (res->is_special() != special) {
     return td::Status::Error("is_special mismatch");
@@ -104,14 +116,17 @@ td::Result<Ref<DataCell>> CellSerializationInfo::create_data_cell(td::Slice cell
   if (res->get_level_mask() != level_mask) {
     return td::Status::Error("level mask mismatch");
   }
-  //return res;
+  return std::move(res);
+}
+
+td::Status CellSerializationInfo::check_hashes(td::Slice cell_slice, const DataCell& cell) const {
   if (with_hashes) {
     auto hash_n = level_mask.get_hashes_count();
-    if (res->get_hash().as_slice() !=
+    if (cell.get_hash().as_slice() !=
         cell_slice.substr(hashes_offset + Cell::hash_bytes * (hash_n - 1), Cell::hash_bytes)) {
       return td::Status::Error("representation hash mismatch");
     }
-    if (res->get_depth() !=
+    if (cell.get_depth() !=
         DataCell::load_depth(
             cell_slice.substr(depth_offset + Cell::depth_bytes * (hash_n - 1), Cell::depth_bytes).ubegin())) {
       return td::Status::Error("depth mismatch");
@@ -124,11 +139,11 @@ td::Result<Ref<DataCell>> CellSerializationInfo::create_data_cell(td::Slice cell
         continue;
       }
       if (cell_slice.substr(hashes_offset + Cell::hash_bytes * hash_i, Cell::hash_bytes) !=
-          res->get_hash(level_i).as_slice()) {
+          cell.get_hash(level_i).as_slice()) {
         // hash mismatch
         return td::Status::Error("lower hash mismatch");
       }
-      if (res->get_depth(level_i) !=
+      if (cell.get_depth(level_i) !=
           DataCell::load_depth(
               cell_slice.substr(depth_offset + Cell::depth_bytes * hash_i, Cell::depth_bytes).ubegin())) {
         return td::Status::Error("lower depth mismatch");
@@ -136,7 +151,7 @@ td::Result<Ref<DataCell>> CellSerializationInfo::create_data_cell(td::Slice cell
       hash_i++;
     }
   }
-  return res;
+  return td::Status::OK();
 }
 
 void BagOfCells::clear() {
@@ -766,7 +781,8 @@ td::Result<td::Slice> BagOfCells::get_cell_slice(int idx, td::Slice data) {
 
 td::Result<td::Ref<vm::DataCell>> BagOfCells::deserialize_cell(int idx, td::Slice cells_slice,
                                                                td::Span<td::Ref<DataCell>> cells_span,
-                                                               std::vector<td::uint8>* cell_should_cache) {
+                                                               std::vector<td::uint8>* cell_should_cache,
+                                                               bool unhashed) {
   TRY_RESULT(cell_slice, get_cell_slice(idx, cells_slice));
   std::array<td::Ref<Cell>, 4> refs_buf;
 
@@ -797,9 +813,84 @@ td::Result<td::Ref<vm::DataCell>> BagOfCells::deserialize_cell(int idx, td::Slic
     }
   }
 
+  if (unhashed) {
+    return cell_info.create_unhashed_data_cell(cell_slice, refs);
+  }
   return cell_info.create_data_cell(cell_slice, refs);
 }
 
+td::Status BagOfCells::deserialize_cells_by_waves(td::Slice cells_slice, std::vector<Ref<DataCell>>& cell_list,
+                                                  std::vector<td::uint8>* cell_should_cache) {
+  // a cell may be hashed once all of its children are, so cells are grouped into waves by their height
+  // and each wave is hashed at once with DataCell::finalize_hashes
+  // malformed cells are left in the first wave, deserialize_cell reports the error for them
+  std::vector<int> waves(cell_count, 0);
+  std::vector<int> wave_sizes(1, 0);
+  for (int idx = cell_count - 1; idx >= 0; idx--) {
+    int wave = 0;
+    auto r_cell_slice = get_cell_slice(idx, cells_slice);
+    CellSerializationInfo cell_info;
+    if (r_cell_slice.is_ok() && cell_info.init(r_cell_slice.ok(), info.ref_byte_size).is_ok()) {
+      for (int k = 0; k < cell_info.refs_cnt; k++) {
+        int ref_idx =
+            (int)info.read_ref(r_cell_slice.ok().ubegin() + cell_info.refs_offset + k * info.ref_byte_size);
+        if (ref_idx > idx && ref_idx < cell_count) {
+          wave = td::max(wave, waves[ref_idx] + 1);
+        }
+      }
+    }
+    waves[idx] = wave;
+    if (wave >= (int)wave_sizes.size()) {
+      wave_sizes.resize(wave + 1, 0);
+    }
+    wave_sizes[wave]++;
+  }
+
+  // cells of a wave in decreasing order of their indices, as they are deserialized one by one
+  std::vector<int> wave_begin(wave_sizes.size() + 1, 0);
+  for (size_t wave = 0; wave < wave_sizes.size(); wave++) {
+    wave_begin[wave + 1] = wave_begin[wave] + wave_sizes[wave];
+  }
+  std::vector<int> order(cell_count);
+  auto wave_pos = wave_begin;
+  for (int idx = cell_count - 1; idx >= 0; idx--) {
+    order[wave_pos[waves[idx]]++] = idx;
+  }
+
+  cell_list.clear();
+  cell_list.resize(cell_count);
+  std::vector<Ref<DataCell>> wave_cells;
+  for (size_t wave = 0; wave < wave_sizes.size(); wave++) {
+    wave_cells.clear();
+    for (int pos = wave_begin[wave]; pos < wave_begin[wave + 1]; pos++) {
+      int idx = order[pos];
+      auto r_cell = deserialize_cell(idx, cells_slice, cell_list, cell_should_cache, true);
+      if (r_cell.is_error()) {
+        return td::Status::Error(PSLICE() << "invalid bag-of-cells failed to deserialize cell #" << idx << " "
+                                          << r_cell.error());
+      }
+      wave_cells.push_back(r_cell.move_as_ok());
+    }
+    DataCell::finalize_hashes(wave_cells);
+    for (int pos = wave_begin[wave]; pos < wave_begin[wave + 1]; pos++) {
+      int idx = order[pos];
+      auto& cell = wave_cells[pos - wave_begin[wave]];
+      auto cell_slice = get_cell_slice(idx, cells_slice).move_as_ok();
+      CellSerializationInfo cell_info;
+      auto status = cell_info.init(cell_slice, info.ref_byte_size);
+      if (status.is_ok()) {
+        status = cell_info.check_hashes(cell_slice, *cell);
+      }
+      if (status.is_error()) {
+        return td::Status::Error(PSLICE() << "invalid bag-of-cells failed to deserialize cell #" << idx << " "
+                                          << status.error());
+      }
+      cell_list[cell_count - 1 - idx] = std::move(cell);
+    }
+  }
+  return td::Status::OK();
+}
+
 td::Result<long long> BagOfCells::deserialize(const td::Slice& data, int max_roots) {
   clear();
   long long size_est = info.parse_serialized_header(data);
@@ -883,18 +974,22 @@ td::Result<long long> BagOfCells::deserialize(const td::Slice& data, int max_roo
   }
   auto cells_slice = data.substr(info.data_offset, info.data_size);
   std::vector<Ref<DataCell>> cell_list;
-  cell_list.reserve(cell_count);
-  std::array<td::Ref<Cell>, 4> refs_buf;
-  for (int i = 0; i < cell_count; i++) {
-    // reconstruct cell with index cell_count - 1 - i
-    int idx = cell_count - 1 - i;
-    auto r_cell = deserialize_cell(idx, cells_slice, cell_list, info.has_cache_bits ? &cell_should_cache : nullptr);
-    if (r_cell.is_error()) {
-      return td::Status::Error(PSLICE() << "invalid bag-of-cells failed to deserialize cell #" << idx << " "
-                                        << r_cell.error());
+  if (deserialize_by_waves_ && cell_count >= min_cells_to_deserialize_by_waves) {
+    TRY_STATUS(deserialize_cells_by_waves(cells_slice, cell_list, info.has_cache_bits ? &cell_should_cache : nullptr));
+  } else {
+    cell_list.reserve(cell_count);
+    std::array<td::Ref<Cell>, 4> refs_buf;
+    for (int i = 0; i < cell_count; i++) {
+      // reconstruct cell with index cell_count - 1 - i
+      int idx = cell_count - 1 - i;
+      auto r_cell = deserialize_cell(idx, cells_slice, cell_list, info.has_cache_bits ? &cell_should_cache : nullptr);
+      if (r_cell.is_error()) {
+        return td::Status::Error(PSLICE() << "invalid bag-of-cells failed to deserialize cell #" << idx << " "
+                                          << r_cell.error());
+      }
+      cell_list.push_back(r_cell.move_as_ok());
+      DCHECK(cell_list.back().not_null());
     }
-    cell_list.push_back(r_cell.move_as_ok());
-    DCHECK(cell_list.back().not_null());
   }
   if (info.has_cache_bits) {
     for (int idx = 0; idx < cell_count; idx++) {
@@ -199,6 +199,12 @@ struct CellSerializationInfo {
   td::Result<int> get_bits(td::Slice cell) const;
 
   td::Result<Ref<DataCell>> create_data_cell(td::Slice data, td::Span<Ref<Cell>> refs) const;
+  // the cell must be passed to DataCell::finalize_hashes and then to check_hashes
+  td::Result<Ref<DataCell>> create_unhashed_data_cell(td::Slice data, td::Span<Ref<Cell>> refs) const;
+  td::Status check_hashes(td::Slice data, const DataCell& cell) const;
+
+ private:
+  td::Result<Ref<DataCell>> do_create_data_cell(td::Slice data, td::Span<Ref<Cell>> refs, bool unhashed) const;
 };
 
 class BagOfCellsLogger {
@@ -243,6 +249,8 @@ class BagOfCells {
   enum { hash_bytes = vm::Cell::hash_bytes, default_max_roots = 16384 };
   enum Mode { WithIndex = 1, WithCRC32C = 2, WithTopHash = 4, WithIntHashes = 8, WithCacheBits = 16, max = 31 };
   enum { max_cell_whs = 64 };
+  // smaller bags are deserialized one cell at a time
+  enum { min_cells_to_deserialize_by_waves = 64 };
   using Hash = Cell::Hash;
   struct Info {
     enum : td::uint32 { boc_idx = 0x68ff65f3, boc_idx_crc32c = 0xacc3a728, boc_generic = 0xb5ee9c72 };
@@ -323,6 +331,7 @@ class BagOfCells {
   const unsigned char* data_ptr{nullptr};
   std::vector<unsigned long long> custom_index;
   BagOfCellsLogger* logger_ptr_{nullptr};
+  bool deserialize_by_waves_{true};
 
  public:
   void clear();
@@ -335,6 +344,10 @@ class BagOfCells {
   void set_logger(BagOfCellsLogger* logger_ptr) {
     logger_ptr_ = logger_ptr;
   }
+  // cells of big bags are hashed in waves (see deserialize_cells_by_waves); false hashes them one by one
+  void set_deserialize_by_waves(bool by_waves) {
+    deserialize_by_waves_ = by_waves;
+  }
   std::size_t estimate_serialized_size(int mode = 0);
   td::Status serialize(int mode = 0);
   td::string serialize_to_string(int mode = 0);
@@ -378,7 +391,9 @@ class BagOfCells {
   bool get_cache_entry(int index);
   td::Result<td::Slice> get_cell_slice(int index, td::Slice data);
   td::Result<td::Ref<vm::DataCell>> deserialize_cell(int index, td::Slice data, td::Span<td::Ref<DataCell>> cells,
-                                                     std::vector<td::uint8>* cell_should_cache);
+                                                     std::vector<td::uint8>* cell_should_cache, bool unhashed = false);
+  td::Status deserialize_cells_by_waves(td::Slice data, std::vector<Ref<DataCell>>& cell_list,
+                                        std::vector<td::uint8>* cell_should_cache);
 };
 
 td::Result<Ref<Cell>> std_boc_deserialize(td::Slice data, bool can_be_empty = false, bool allow_nonzero_level = false);
@@ -0,0 +1,75 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#include "vm/cells/CellArena.h"
+
+#include "td/utils/logging.h"
+
+#include <new>
+
+namespace vm {
+thread_local CellArena* CellArena::current_ = nullptr;
+
+CellArena::~CellArena() {
+  CHECK(current_ != this);
+  if (chunk_) {
+    release_chunk(chunk_);
+  }
+}
+
+void* CellArena::allocate(size_t size) {
+  auto aligned_size = sizeof(Header) + (size + alignment - 1) / alignment * alignment;
+  CHECK(aligned_size <= chunk_size - sizeof(Chunk) - alignment);
+  if (static_cast<size_t>(end_ - pos_) < aligned_size) {
+    new_chunk();
+  }
+  auto* header = reinterpret_cast<Header*>(pos_);
+  header->chunk = chunk_;
+  chunk_->refcnt.fetch_add(1, std::memory_order_relaxed);
+  pos_ += aligned_size;
+  stats_.allocations++;
+  stats_.allocated_bytes += aligned_size;
+  return header + 1;
+}
+
+void CellArena::deallocate(void* ptr) {
+  if (ptr != nullptr) {
+    release_chunk((static_cast<Header*>(ptr) - 1)->chunk);
+  }
+}
+
+void CellArena::release_chunk(Chunk* chunk) {
+  if (chunk->refcnt.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    chunk->~Chunk();
+    ::operator delete(static_cast<void*>(chunk));
+  }
+}
+
+void CellArena::new_chunk() {
+  if (chunk_) {
+    release_chunk(chunk_);
+  }
+  auto* memory = static_cast<char*>(::operator new(chunk_size));
+  chunk_ = new (memory) Chunk();
+  // the first Header starts right after the Chunk, both are aligned by alignment
+  pos_ = memory + (sizeof(Chunk) + alignment - 1) / alignment * alignment;
+  end_ = memory + chunk_size;
+  stats_.chunks++;
+}
+
+}  // namespace vm
@@ -0,0 +1,121 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#pragma once
+
+#include "td/utils/common.h"
+
+#include <atomic>
+
+namespace vm {
+
+// Bump allocator for DataCells created during one task (collation or validation of a block).
+// While a CellArena::Guard is alive, DataCell::create_empty_data_cell places new cells into the arena of the current
+// thread. Memory is given back chunk by chunk: a chunk is freed when the arena has moved past it (or is destroyed) and
+// all cells allocated in it are destroyed. A cell that outlives the arena stays valid, but keeps its whole chunk
+// allocated, so cells which may be cached beyond the task (cells loaded from cell dbs) are created under
+// CellArena::Suspend and go to the heap.
+// allocate() must be called only by the thread holding the guard; deallocate() may be called from any thread.
+class CellArena {
+ public:
+  struct Stats {
+    td::uint64 chunks{0};
+    td::uint64 allocations{0};
+    td::uint64 allocated_bytes{0};
+  };
+
+  class Guard {
+   public:
+    explicit Guard(CellArena& arena) : prev_(current_) {
+      current_ = &arena;
+    }
+    Guard(const Guard&) = delete;
+    Guard& operator=(const Guard&) = delete;
+    ~Guard() {
+      current_ = prev_;
+    }
+
+   private:
+    CellArena* prev_;
+  };
+
+  class Suspend {
+   public:
+    Suspend() : prev_(current_) {
+      current_ = nullptr;
+    }
+    Suspend(const Suspend&) = delete;
+    Suspend& operator=(const Suspend&) = delete;
+    ~Suspend() {
+      current_ = prev_;
+    }
+
+   private:
+    CellArena* prev_;
+  };
+
+  CellArena() = default;
+  CellArena(const CellArena&) = delete;
+  CellArena& operator=(const CellArena&) = delete;
+  ~CellArena();
+
+  static CellArena* current() {
+    return current_;
+  }
+
+  void* allocate(size_t size);
+  static void deallocate(void* ptr);
+
+  const Stats& get_stats() const {
+    return stats_;
+  }
+
+  static constexpr size_t chunk_size = 1 << 20;
+  static constexpr size_t alignment = 8;
+
+ private:
+  struct Chunk {
+    // one reference is held by the arena itself while the chunk is being filled
+    std::atomic<size_t> refcnt{1};
+  };
+  struct alignas(alignment) Header {
+    Chunk* chunk;
+  };
+
+  Chunk* chunk_{nullptr};
+  char* pos_{nullptr};
+  char* end_{nullptr};
+  Stats stats_;
+
+  static thread_local CellArena* current_;
+
+  static void release_chunk(Chunk* chunk);
+  void new_chunk();
+};
+
+// A cell allocated in a CellArena; deleting it returns the memory to the arena chunk instead of the heap
+template <class CellT>
+class ArenaCell final : public CellT {
+ public:
+  using CellT::CellT;
+  static void operator delete(void* ptr) {
+    CellArena::deallocate(ptr);
+  }
+};
+
+}  // namespace vm
@@ -73,6 +73,12 @@ td::Result<Ref<DataCell>> CellBuilder::finalize_novm_nothrow(bool special) {
   return res;
 }
 
+td::Result<Ref<DataCell>> CellBuilder::finalize_unhashed_novm_nothrow(bool special) {
+  auto res = DataCell::create_unhashed(data, size(), td::mutable_span(refs.data(), size_refs()), special);
+  bits = refs_cnt = 0;
+  return res;
+}
+
 Ref<DataCell> CellBuilder::finalize_novm(bool special) {
   auto res = finalize_novm_nothrow(special);
   if (res.is_error()) {
@@ -178,6 +178,8 @@ class CellBuilder : public td::CntObject {
   Ref<DataCell> finalize(bool special = false);
   Ref<DataCell> finalize_novm(bool special = false);
   td::Result<Ref<DataCell>> finalize_novm_nothrow(bool special = false);
+  // the cell must be passed to DataCell::finalize_hashes before use
+  td::Result<Ref<DataCell>> finalize_unhashed_novm_nothrow(bool special = false);
   bool finalize_to(Ref<Cell>& res, bool special = false) {
     return (res = finalize(special)).not_null();
   }
@@ -21,11 +21,18 @@
 #include "openssl/digest.hpp"
 
 #include "td/utils/ScopeGuard.h"
+#include "td/utils/Sha256Batch.h"
+#include "td/utils/port/thread.h"
 
+#include "vm/cells/CellArena.h"
 #include "vm/cells/CellWithStorage.h"
 
+#include <unordered_map>
+
 namespace vm {
 thread_local bool DataCell::use_arena = false;
+thread_local bool DataCell::lazy_hashes_ = false;
+thread_local DataCell::LazyHashStats DataCell::thread_lazy_hash_stats_;
 
 namespace {
 template <class CellT>
@@ -53,6 +60,16 @@ private:
     return res;
   }
 };
+
+struct CellArenaAllocator {
+  CellArena& arena;
+  template <class T, class... ArgsT>
+  std::unique_ptr<DataCell> make_unique(ArgsT&&... args) {
+    static_assert(alignof(ArenaCell<T>) <= CellArena::alignment, "");
+    auto* ptr = arena.allocate(sizeof(ArenaCell<T>));
+    return std::unique_ptr<DataCell>(::new (ptr) ArenaCell<T>(std::forward<ArgsT>(args)...));
+  }
+};
 }
 std::unique_ptr<DataCell> DataCell::create_empty_data_cell(Info info) {
   if (use_arena) {
@@ -62,6 +79,9 @@ std::unique_ptr<DataCell> DataCell::create_empty_data_cell(Info info) {
     Ref<DataCell>(res.get()).release();
     return res;
   }
+  if (auto* arena = CellArena::current()) {
+    return detail::CellWithArrayStorage<DataCell>::create(CellArenaAllocator{*arena}, info.get_storage_size(), info);
+  }
 
   return detail::CellWithUniquePtrStorage<DataCell>::create(info.get_storage_size(), info);
 }
@@ -97,8 +117,8 @@ DataCell::SpecialType DataCell::special_type() const {
   return SpecialType::Ordinary;
 }
 
-td::Result<Ref<DataCell>> DataCell::create(td::ConstBitPtr data, unsigned bits, td::MutableSpan<Ref<Cell>> refs,
-                                           bool special) {
+td::Result<Ref<DataCell>> DataCell::create_unhashed(td::ConstBitPtr data, unsigned bits,
+                                                    td::MutableSpan<Ref<Cell>> refs, bool special) {
   for (auto& ref : refs) {
     if (ref.is_null()) {
       return td::Status::Error("Has null cell reference");
@@ -247,9 +267,9 @@ td::Result<Ref<DataCell>> DataCell::create(td::ConstBitPtr data, unsigned bits,
     refs_ptr[i] = refs[i].release();
   }
 
-  // init hashes and depth
-  auto* hashes_ptr = info.get_hashes(storage);
+  // init depth; hashes are filled by finalize_hashes
   auto* depth_ptr = info.get_depth(storage);
+  bool is_merkle = type == SpecialType::MerkleProof || type == SpecialType::MerkleUpdate;
 
   // NB: be careful with special cells
   auto total_hash_count = level_mask.get_hashes_count();
@@ -264,42 +284,9 @@ td::Result<Ref<DataCell>> DataCell::create(td::ConstBitPtr data, unsigned bits,
     if (hash_i < hash_i_offset) {
       continue;
     }
-    unsigned char tmp[2];
-    tmp[0] = info.d1(level_mask.apply(level_i));
-    tmp[1] = info.d2();
-
-    static TD_THREAD_LOCAL digest::SHA256* hasher;
-    td::init_thread_local<digest::SHA256>(hasher);
-    hasher->reset();
-
-    hasher->feed(td::Slice(tmp, 2));
-
-    if (hash_i == hash_i_offset) {
-      DCHECK(level_i == 0 || type == SpecialType::PrunnedBranch);
-      hasher->feed(td::Slice(data_ptr, (bits + 7) >> 3));
-    } else {
-      DCHECK(level_i != 0 && type != SpecialType::PrunnedBranch);
-      hasher->feed(hashes_ptr[hash_i - hash_i_offset - 1].as_slice());
-    }
-
-    auto dest_i = hash_i - hash_i_offset;
-
-    // calc depth
     td::uint16 depth = 0;
     for (int i = 0; i < info.refs_count_; i++) {
-      td::uint16 child_depth = 0;
-      if (type == SpecialType::MerkleProof || type == SpecialType::MerkleUpdate) {
-        child_depth = refs_ptr[i]->get_depth(level_i + 1);
-      } else {
-        child_depth = refs_ptr[i]->get_depth(level_i);
-      }
-
-      // add depth into hash
-      td::uint8 child_depth_buf[depth_bytes];
-      store_depth(child_depth_buf, child_depth);
-      hasher->feed(td::Slice(child_depth_buf, depth_bytes));
-
-      depth = std::max(depth, child_depth);
+      depth = std::max(depth, refs_ptr[i]->get_depth(is_merkle ? level_i + 1 : level_i));
     }
     if (info.refs_count_ != 0) {
       if (depth >= max_depth) {
@@ -307,24 +294,201 @@ td::Result<Ref<DataCell>> DataCell::create(td::ConstBitPtr data, unsigned bits,
       }
       depth++;
     }
-    depth_ptr[dest_i] = depth;
+    depth_ptr[hash_i - hash_i_offset] = depth;
+  }
 
-    // children hash
-    for (int i = 0; i < info.refs_count_; i++) {
-      if (type == SpecialType::MerkleProof || type == SpecialType::MerkleUpdate) {
-        hasher->feed(refs_ptr[i]->get_hash(level_i + 1).as_slice());
-      } else {
-        hasher->feed(refs_ptr[i]->get_hash(level_i).as_slice());
-      }
-    }
+  return Ref<DataCell>(data_cell.release(), Ref<DataCell>::acquire_t{});
+}
+
+td::Result<Ref<DataCell>> DataCell::create(td::ConstBitPtr data, unsigned bits, td::MutableSpan<Ref<Cell>> refs,
+                                           bool special) {
+  TRY_RESULT(cell, create_unhashed(std::move(data), bits, refs, special));
+  if (lazy_hashes_) {
+    cell->hash_state_.store(hash_pending, std::memory_order_relaxed);
+    get_lazy_counter().add(1);
+    thread_lazy_hash_stats_.created++;
+    return std::move(cell);
+  }
+  cell->compute_hashes();
+  return std::move(cell);
+}
+
+void DataCell::compute_hashes() const {
+  auto* hashes_ptr = info_.get_hashes(const_cast<DataCell*>(this)->get_storage());
+  static TD_THREAD_LOCAL digest::SHA256* hasher;
+  td::init_thread_local<digest::SHA256>(hasher);
+  unsigned char preimage[max_hash_preimage_bytes];
+  for (td::uint32 dest_i = 0; dest_i < info_.hash_count_; dest_i++) {
+    // the preimage is built first: it may compute deferred hashes of the children, which use the same hasher
+    auto preimage_size = build_hash_preimage(dest_i, preimage);
+    hasher->reset();
+    hasher->feed(td::Slice(preimage, preimage_size));
     auto extracted_size = hasher->extract(hashes_ptr[dest_i].as_slice());
     DCHECK(extracted_size == hash_bytes);
   }
+}
 
-  return Ref<DataCell>(data_cell.release(), Ref<DataCell>::acquire_t{});
+void DataCell::compute_lazy_hashes() const {
+  auto state = static_cast<td::uint8>(hash_pending);
+  if (hash_state_.compare_exchange_strong(state, hash_computing, std::memory_order_acquire)) {
+    compute_hashes();
+    hash_state_.store(hash_ready, std::memory_order_release);
+    get_lazy_hashed_counter().add(1);
+    thread_lazy_hash_stats_.hashed++;
+    return;
+  }
+  // another thread is computing the hashes right now
+  while (hash_state_.load(std::memory_order_acquire) != hash_ready) {
+    td::this_thread::yield();
+  }
+}
+
+DataCell::LazyHashStats DataCell::get_lazy_hash_stats() {
+  return thread_lazy_hash_stats_;
+}
+
+void DataCell::finalize_lazy_hashes(const Ref<Cell>& root) {
+  // only cells with pending hashes are visited: a cell with ready hashes has all its descendants hashed as well;
+  // a cell gets into wave 1 + (max wave of its pending children), so every wave depends on the previous ones only
+  auto as_pending = [](const Cell* cell) -> const DataCell* {
+    auto* data_cell = dynamic_cast<const DataCell*>(cell);
+    return data_cell && data_cell->hash_state_.load(std::memory_order_acquire) == hash_pending ? data_cell : nullptr;
+  };
+  auto* root_cell = as_pending(root.get());
+  if (!root_cell) {
+    return;
+  }
+  std::unordered_map<const Cell*, int> waves;
+  std::vector<std::vector<Ref<DataCell>>> wave_cells;
+  std::vector<std::pair<const DataCell*, unsigned>> stack;
+  waves.emplace(root_cell, -1);
+  stack.emplace_back(root_cell, 0);
+  while (!stack.empty()) {
+    auto& [cell, ref_i] = stack.back();
+    if (ref_i < cell->get_refs_cnt()) {
+      auto* child = as_pending(cell->get_ref_raw_ptr(ref_i++));
+      if (child && waves.emplace(child, -1).second) {
+        stack.emplace_back(child, 0);
+      }
+      continue;
+    }
+    int wave = 0;
+    for (unsigned i = 0; i < cell->get_refs_cnt(); i++) {
+      auto it = waves.find(cell->get_ref_raw_ptr(i));
+      if (it != waves.end()) {
+        wave = td::max(wave, it->second + 1);
+      }
+    }
+    waves[cell] = wave;
+    if (wave >= (int)wave_cells.size()) {
+      wave_cells.resize(wave + 1);
+    }
+    wave_cells[wave].emplace_back(cell);
+    stack.pop_back();
+  }
+
+  std::vector<Ref<DataCell>> claimed;
+  for (auto& cells : wave_cells) {
+    claimed.clear();
+    for (auto& cell : cells) {
+      // cells hashed concurrently by other threads are left to them, get_hash() of their parents waits if needed
+      auto state = static_cast<td::uint8>(hash_pending);
+      if (cell->hash_state_.compare_exchange_strong(state, hash_computing, std::memory_order_acquire)) {
+        claimed.push_back(std::move(cell));
+      }
+    }
+    finalize_hashes(claimed);
+    for (auto& cell : claimed) {
+      cell->hash_state_.store(hash_ready, std::memory_order_release);
+    }
+    get_lazy_batch_hashed_counter().add(static_cast<td::int64>(claimed.size()));
+    thread_lazy_hash_stats_.batch_hashed += static_cast<td::int64>(claimed.size());
+  }
+}
+
+void DataCell::finalize_hashes(td::Span<Ref<DataCell>> cells) {
+  // hashes of one cell depend on each other, so every round computes the next stored hash of all cells at once
+  constexpr size_t chunk_size = 256;
+  static TD_THREAD_LOCAL std::vector<unsigned char>* preimages;
+  td::init_thread_local<std::vector<unsigned char>>(preimages, chunk_size * max_hash_preimage_bytes);
+  std::vector<td::Slice> messages;
+  std::vector<td::MutableSlice> digests;
+  messages.reserve(chunk_size);
+  digests.reserve(chunk_size);
+
+  for (size_t begin = 0; begin < cells.size(); begin += chunk_size) {
+    auto chunk = cells.substr(begin, td::min(chunk_size, cells.size() - begin));
+    for (td::uint32 dest_i = 0; dest_i <= max_level; dest_i++) {
+      messages.clear();
+      digests.clear();
+      for (auto& cell : chunk) {
+        if (dest_i >= cell->info_.hash_count_) {
+          continue;
+        }
+        auto* preimage = preimages->data() + messages.size() * max_hash_preimage_bytes;
+        messages.emplace_back(preimage, cell->build_hash_preimage(dest_i, preimage));
+        auto* storage = const_cast<DataCell*>(cell.get())->get_storage();
+        digests.push_back(cell->info_.get_hashes(storage)[dest_i].as_slice());
+      }
+      if (messages.empty()) {
+        break;
+      }
+      td::Sha256Batch::hash(messages, digests);
+    }
+  }
+}
+
+td::uint32 DataCell::get_stored_hash_level(td::uint32 dest_i) const {
+  auto level_mask = get_level_mask();
+  auto hash_i = level_mask.get_hashes_count() - info_.hash_count_ + dest_i;
+  for (td::uint32 level_i = 0, level = level_mask.get_level(); level_i <= level; level_i++) {
+    if (!level_mask.is_significant(level_i)) {
+      continue;
+    }
+    if (hash_i == 0) {
+      return level_i;
+    }
+    hash_i--;
+  }
+  UNREACHABLE();
+}
+
+size_t DataCell::build_hash_preimage(td::uint32 dest_i, unsigned char* dest) const {
+  auto level_i = get_stored_hash_level(dest_i);
+  auto type = special_type();
+  auto child_level_i = type == SpecialType::MerkleProof || type == SpecialType::MerkleUpdate ? level_i + 1 : level_i;
+  auto* storage = get_storage();
+  auto* refs_ptr = info_.get_refs(storage);
+
+  unsigned char* ptr = dest;
+  *ptr++ = info_.d1(get_level_mask().apply(level_i));
+  *ptr++ = info_.d2();
+  if (dest_i == 0) {
+    DCHECK(level_i == 0 || type == SpecialType::PrunnedBranch);
+    auto data_size = (get_bits() + 7) >> 3;
+    std::memcpy(ptr, info_.get_data(storage), data_size);
+    ptr += data_size;
+  } else {
+    DCHECK(level_i != 0 && type != SpecialType::PrunnedBranch);
+    std::memcpy(ptr, info_.get_hashes(storage)[dest_i - 1].as_slice().ubegin(), hash_bytes);
+    ptr += hash_bytes;
+  }
+  for (int i = 0; i < info_.refs_count_; i++) {
+    store_depth(ptr, refs_ptr[i]->get_depth(child_level_i));
+    ptr += depth_bytes;
+  }
+  for (int i = 0; i < info_.refs_count_; i++) {
+    std::memcpy(ptr, refs_ptr[i]->get_hash(child_level_i).as_slice().ubegin(), hash_bytes);
+    ptr += hash_bytes;
+  }
+  DCHECK(static_cast<size_t>(ptr - dest) <= max_hash_preimage_bytes);
+  return ptr - dest;
 }
 
 const DataCell::Hash DataCell::do_get_hash(td::uint32 level) const {
+  if (td::unlikely(hash_state_.load(std::memory_order_acquire) != hash_ready)) {
+    compute_lazy_hashes();
+  }
   auto hash_i = get_level_mask().apply(level).get_hash_i();
   if (special_type() == SpecialType::PrunnedBranch) {
     auto this_hash_i = get_level_mask().get_hash_i();
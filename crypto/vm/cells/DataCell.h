@@ -23,6 +23,8 @@
 
 #include "td/utils/ThreadSafeCounter.h"
 
+#include <atomic>
+
 namespace vm {
 
 class DataCell : public Cell {
@@ -40,6 +42,42 @@ class DataCell : public Cell {
     return td::bitstring::bits_load_ulong(src, depth_bits) & 0xffff;
   }
 
+  // Computes hashes of cells created by create_unhashed (see CellBuilder::finalize_unhashed_novm_nothrow).
+  // Cells are hashed side by side with Sha256Batch, so all their children must already be hashed
+  static void finalize_hashes(td::Span<Ref<DataCell>> cells);
+
+  // While a LazyHashGuard is alive, cells created by the current thread are returned with their hashes not computed
+  // yet: the hashes are computed on the first get_hash() or by finalize_lazy_hashes, so cells that are dropped
+  // before anybody asks for their hash are never hashed at all
+  class LazyHashGuard {
+   public:
+    LazyHashGuard() : prev_(lazy_hashes_) {
+      lazy_hashes_ = true;
+    }
+    LazyHashGuard(const LazyHashGuard&) = delete;
+    LazyHashGuard& operator=(const LazyHashGuard&) = delete;
+    ~LazyHashGuard() {
+      lazy_hashes_ = prev_;
+    }
+
+   private:
+    bool prev_;
+  };
+  struct LazyHashStats {
+    td::int64 created{0};       // cells created with deferred hashes
+    td::int64 hashed{0};        // ... hashed one by one on the first get_hash()
+    td::int64 batch_hashed{0};  // ... hashed by finalize_lazy_hashes
+    td::int64 not_hashed() const {
+      return created - hashed - batch_hashed;
+    }
+  };
+  // totals of the current thread (cells it created, hashed on demand or in batches), so the difference of two
+  // snapshots taken by the same thread shows how many hashes it saved in between, whatever other threads do;
+  // process-wide totals are kept by the DataCell.lazy* named counters
+  static LazyHashStats get_lazy_hash_stats();
+  // Computes the deferred hashes of all cells reachable from root, in waves of cells hashed with finalize_hashes
+  static void finalize_lazy_hashes(const Ref<Cell>& root);
+
  protected:
   struct Info {
     unsigned bits_;
@@ -117,6 +155,8 @@ class DataCell : public Cell {
   };
 
   Info info_;
+  enum : td::uint8 { hash_ready = 0, hash_pending = 1, hash_computing = 2 };
+  mutable std::atomic<td::uint8> hash_state_{hash_ready};
   virtual char* get_storage() = 0;
   virtual const char* get_storage() const = 0;
   // TODO: we may also save three different pointers
@@ -205,18 +245,42 @@ class DataCell : public Cell {
 
  protected:
   static constexpr auto max_storage_size = max_refs * sizeof(void*) + (max_level + 1) * hash_bytes + max_bytes;
+  // d1, d2, data or previous hash, then depths and hashes of children
+  static constexpr size_t max_hash_preimage_bytes = 2 + max_bytes + max_refs * (depth_bytes + hash_bytes);
 
  private:
   static td::NamedThreadSafeCounter::CounterRef get_thread_safe_counter() {
     static auto res = td::NamedThreadSafeCounter::get_default().get_counter("DataCell");
     return res;
   }
+  static td::NamedThreadSafeCounter::CounterRef get_lazy_counter() {
+    static auto res = td::NamedThreadSafeCounter::get_default().get_counter("DataCell.lazy");
+    return res;
+  }
+  static td::NamedThreadSafeCounter::CounterRef get_lazy_hashed_counter() {
+    static auto res = td::NamedThreadSafeCounter::get_default().get_counter("DataCell.lazy_hashed");
+    return res;
+  }
+  static td::NamedThreadSafeCounter::CounterRef get_lazy_batch_hashed_counter() {
+    static auto res = td::NamedThreadSafeCounter::get_default().get_counter("DataCell.lazy_batch_hashed");
+    return res;
+  }
+  static thread_local bool lazy_hashes_;
+  static thread_local LazyHashStats thread_lazy_hash_stats_;
   static std::unique_ptr<DataCell> create_empty_data_cell(Info info);
 
   const Hash do_get_hash(td::uint32 level) const override;
   td::uint16 do_get_depth(td::uint32 level) const override;
 
+  td::uint32 get_stored_hash_level(td::uint32 dest_i) const;
+  size_t build_hash_preimage(td::uint32 dest_i, unsigned char* dest) const;
+  void compute_hashes() const;
+  void compute_lazy_hashes() const;
+
   friend class CellBuilder;
+  // validates the cell and computes its depths, but leaves hashes uninitialized until finalize_hashes
+  static td::Result<Ref<DataCell>> create_unhashed(td::ConstBitPtr data, unsigned bits, td::MutableSpan<Ref<Cell>> refs,
+                                                   bool special);
   static td::Result<Ref<DataCell>> create(td::ConstBitPtr data, unsigned bits, td::Span<Ref<Cell>> refs, bool special);
   static td::Result<Ref<DataCell>> create(td::ConstBitPtr data, unsigned bits, td::MutableSpan<Ref<Cell>> refs,
                                           bool special);
@@ -20,7 +20,16 @@
 
 #include "td/utils/Slice.h"
 #include "td/utils/HashSet.h"
+#include "td/utils/misc.h"
+#include "td/utils/port/RwMutex.h"
+#include "vm/cells/CellHash.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <optional>
 #include <set>
+#include <vector>
 
 namespace vm {
 template <class InfoT>
@@ -75,4 +84,209 @@ class CellHashTable {
  private:
   td::NodeHashSet<InfoT, typename InfoT::Hash, typename InfoT::Eq> set_;
 };
+
+// Cell table which may be shared between threads.
+// Cells are split into StripesN stripes by the first byte of the hash (the same way keys are grouped in the db),
+// each stripe is an open-addressing table with linear probing guarded by its own rw-lock. Readers of different
+// stripes never touch the same cache lines, and infos (e.g. refcnts) are updated in place under the stripe lock.
+// InfoT must be default constructible and movable, as_cell_hash(const InfoT &) must return its hash.
+template <class InfoT, size_t StripesN = 256>
+class ConcurrentCellHashTable {
+ public:
+  static constexpr size_t stripe_count() {
+    return StripesN;
+  }
+  static size_t get_stripe_id(const CellHash &hash) {
+    return hash.as_array()[0] % StripesN;
+  }
+
+  std::optional<InfoT> get(const CellHash &hash) const {
+    auto &stripe = get_stripe(hash);
+    auto lock = stripe.mutex_.lock_read().move_as_ok();
+    if (auto *info = stripe.find(hash)) {
+      return *info;
+    }
+    return {};
+  }
+
+  // f(InfoT &) is called under the write lock of the stripe; a default constructed info is inserted if there is none,
+  // f must make it an info with the given hash, otherwise the slot would be unreachable from its probe sequence
+  template <class F>
+  void apply(const CellHash &hash, F &&f) {
+    auto &stripe = get_stripe(hash);
+    auto lock = stripe.mutex_.lock_write().move_as_ok();
+    auto &info = stripe.find_or_insert(hash);
+    f(info);
+    CHECK(as_cell_hash(info) == hash);
+  }
+
+  bool erase(const CellHash &hash) {
+    auto &stripe = get_stripe(hash);
+    auto lock = stripe.mutex_.lock_write().move_as_ok();
+    return stripe.erase(hash);
+  }
+
+  size_t size() const {
+    size_t res = 0;
+    for (auto &stripe : stripes_) {
+      res += stripe.size_.load(std::memory_order_relaxed);
+    }
+    return res;
+  }
+  size_t capacity() const {
+    size_t res = 0;
+    for (auto &stripe : stripes_) {
+      res += stripe.capacity_.load(std::memory_order_relaxed);
+    }
+    return res;
+  }
+  size_t stripe_size(size_t stripe_id) const {
+    return stripes_.at(stripe_id).size_.load(std::memory_order_relaxed);
+  }
+
+  // f(InfoT &) is called for each info of the stripe under its write lock
+  template <class F>
+  void for_each_in_stripe(size_t stripe_id, F &&f) {
+    auto &stripe = stripes_.at(stripe_id);
+    auto lock = stripe.mutex_.lock_write().move_as_ok();
+    stripe.for_each(f);
+  }
+  void clear_stripe(size_t stripe_id) {
+    auto &stripe = stripes_.at(stripe_id);
+    auto lock = stripe.mutex_.lock_write().move_as_ok();
+    stripe.reset(0);
+  }
+
+  // Methods below take no locks. They are meant for building the table, when each stripe is filled
+  // by one thread and other threads only read the stripes which are already built.
+  template <class Iterator>
+  void init_stripe(size_t stripe_id, Iterator begin, Iterator end) {
+    auto &stripe = stripes_.at(stripe_id);
+    auto size = static_cast<size_t>(std::distance(begin, end));
+    stripe.reset(size + size / 2);
+    for (auto it = begin; it != end; ++it) {
+      stripe.insert_new(std::move(*it));
+    }
+  }
+  const InfoT *find_unlocked(const CellHash &hash) const {
+    return get_stripe(hash).find(hash);
+  }
+
+ private:
+  struct Stripe {
+    mutable td::RwMutex mutex_;
+    // 0 for an empty slot, 0x80 | top 7 bits of the slot hash otherwise
+    std::vector<td::uint8> ctrl_;
+    std::vector<InfoT> slots_;
+    std::atomic<size_t> size_{0};
+    std::atomic<size_t> capacity_{0};
+    [[maybe_unused]] char pad_[TD_CONCURRENCY_PAD];
+
+    static size_t slot_hash(const CellHash &hash) {
+      return cell_hash_slice_hash(hash.as_slice());
+    }
+    static td::uint8 slot_ctrl(size_t h) {
+      return static_cast<td::uint8>(0x80 | (h >> (sizeof(size_t) * 8 - 7)));
+    }
+    size_t next(size_t i) const {
+      return i + 1 == slots_.size() ? 0 : i + 1;
+    }
+
+    const InfoT *find(const CellHash &hash) const {
+      if (slots_.empty()) {
+        return nullptr;
+      }
+      auto h = slot_hash(hash);
+      auto ctrl = slot_ctrl(h);
+      for (size_t i = h % slots_.size(); ctrl_[i] != 0; i = next(i)) {
+        if (ctrl_[i] == ctrl && as_cell_hash(slots_[i]) == hash) {
+          return &slots_[i];
+        }
+      }
+      return nullptr;
+    }
+    InfoT &find_or_insert(const CellHash &hash) {
+      if (auto *info = find(hash)) {
+        return const_cast<InfoT &>(*info);
+      }
+      // linear probing degrades quickly above 3/4 load
+      if ((size_ + 1) * 4 > slots_.size() * 3) {
+        rehash(std::max<size_t>(16, slots_.size() * 3 / 2));
+      }
+      return insert_at(slot_hash(hash), InfoT{});
+    }
+    void insert_new(InfoT info) {
+      auto h = slot_hash(as_cell_hash(info));
+      insert_at(h, std::move(info));
+    }
+    InfoT &insert_at(size_t h, InfoT info) {
+      auto i = h % slots_.size();
+      while (ctrl_[i] != 0) {
+        i = next(i);
+      }
+      ctrl_[i] = slot_ctrl(h);
+      slots_[i] = std::move(info);
+      size_++;
+      return slots_[i];
+    }
+    bool erase(const CellHash &hash) {
+      auto *info = find(hash);
+      if (!info) {
+        return false;
+      }
+      // backward shift deletion: no tombstones, so probe sequences stay as short as after the insertions
+      auto i = static_cast<size_t>(info - slots_.data());
+      for (auto j = next(i); ctrl_[j] != 0; j = next(j)) {
+        auto home = slot_hash(as_cell_hash(slots_[j])) % slots_.size();
+        bool stays = i <= j ? (i < home && home <= j) : (i < home || home <= j);
+        if (!stays) {
+          slots_[i] = std::move(slots_[j]);
+          ctrl_[i] = ctrl_[j];
+          i = j;
+        }
+      }
+      ctrl_[i] = 0;
+      slots_[i] = InfoT{};
+      size_--;
+      return true;
+    }
+    void rehash(size_t new_capacity) {
+      auto old_ctrl = std::move(ctrl_);
+      auto old_slots = std::move(slots_);
+      reset(new_capacity);
+      for (size_t i = 0; i < old_slots.size(); i++) {
+        if (old_ctrl[i] != 0) {
+          insert_new(std::move(old_slots[i]));
+        }
+      }
+    }
+    void reset(size_t new_capacity) {
+      td::reset_to_empty(ctrl_);
+      td::reset_to_empty(slots_);
+      if (new_capacity != 0) {
+        new_capacity = std::max<size_t>(new_capacity, 16);
+        ctrl_.resize(new_capacity, 0);
+        slots_.resize(new_capacity);
+      }
+      size_ = 0;
+      capacity_ = new_capacity;
+    }
+    template <class F>
+    void for_each(F &f) {
+      for (size_t i = 0; i < slots_.size(); i++) {
+        if (ctrl_[i] != 0) {
+          f(slots_[i]);
+        }
+      }
+    }
+  };
+  std::array<Stripe, StripesN> stripes_{};
+
+  Stripe &get_stripe(const CellHash &hash) {
+    return stripes_[get_stripe_id(hash)];
+  }
+  const Stripe &get_stripe(const CellHash &hash) const {
+    return stripes_[get_stripe_id(hash)];
+  }
+};
 }  // namespace vm
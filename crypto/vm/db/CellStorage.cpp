@@ -19,10 +19,14 @@
 #include "vm/db/CellStorage.h"
 #include "vm/db/DynamicBagOfCellsDb.h"
 #include "vm/boc.h"
+#include "vm/cells/CellArena.h"
 #include "td/utils/base64.h"
 #include "td/utils/tl_parsers.h"
 #include "td/utils/tl_helpers.h"
 
+#include <array>
+#include <cstring>
+
 namespace vm {
 namespace {
 class RefcntCellStorer {
@@ -143,6 +147,169 @@ class RefcntCellParser {
  private:
   bool need_data_;
 };
+
+// Compact cell value (CellStorer::compact_tag):
+//   int32 tag = -2, varuint refcnt,
+//   d1 d2 data (as in a bag of cells),
+//   one nibble per reference (low nibble first): level mask in bits 0..2, bit 3 set if the child is stored inline,
+//   hashes of the children which are not inline, hash_bytes each,
+//   depths of the same children, varuint each,
+//   d1 d2 data of each inline child (a small ordinary cell without references)
+void store_varuint(std::string &dest, td::uint32 x) {
+  while (x >= 0x80) {
+    dest.push_back(static_cast<char>((x & 0x7f) | 0x80));
+    x >>= 7;
+  }
+  dest.push_back(static_cast<char>(x));
+}
+
+td::Result<td::uint32> fetch_varuint(td::Slice &data) {
+  td::uint32 x = 0;
+  for (int shift = 0; shift < 35; shift += 7) {
+    if (data.empty()) {
+      return td::Status::Error("Not enough data");
+    }
+    td::uint8 byte = data.ubegin()[0];
+    data.remove_prefix(1);
+    x |= static_cast<td::uint32>(byte & 0x7f) << shift;
+    if (!(byte & 0x80)) {
+      return x;
+    }
+  }
+  return td::Status::Error("Invalid varuint");
+}
+
+Ref<DataCell> get_inline_child(const Ref<Cell> &cell) {
+  if (!cell->is_loaded()) {
+    return {};
+  }
+  auto r_loaded_cell = cell->load_cell();
+  if (r_loaded_cell.is_error()) {
+    return {};
+  }
+  auto data_cell = r_loaded_cell.move_as_ok().data_cell;
+  if (data_cell->is_special() || data_cell->size_refs() != 0 ||
+      data_cell->get_bits() > CellStorer::max_inline_child_bits) {
+    return {};
+  }
+  return data_cell;
+}
+
+std::string serialize_compact(td::int32 refcnt, const td::Ref<DataCell> &cell) {
+  TD_PERF_COUNTER(cell_store);
+  CHECK(refcnt >= 0);
+  std::string res;
+  res.reserve(16 + cell->get_serialized_size() + cell->size_refs() * (Cell::hash_bytes + Cell::depth_bytes));
+  td::int32 tag = CellStorer::compact_tag;
+  res.append(reinterpret_cast<const char *>(&tag), sizeof(tag));
+  store_varuint(res, static_cast<td::uint32>(refcnt));
+  res += cell->serialize();
+
+  unsigned refs_cnt = cell->size_refs();
+  std::array<Ref<Cell>, Cell::max_refs> refs;
+  std::array<Ref<DataCell>, Cell::max_refs> inline_refs;
+  td::uint8 desc[(Cell::max_refs + 1) / 2] = {};
+  for (unsigned i = 0; i < refs_cnt; i++) {
+    refs[i] = cell->get_ref(i);
+    inline_refs[i] = get_inline_child(refs[i]);
+    auto nibble = static_cast<td::uint8>(refs[i]->get_level_mask().get_mask() | (inline_refs[i].not_null() << 3));
+    desc[i / 2] |= static_cast<td::uint8>(nibble << (i % 2 * 4));
+  }
+  res.append(reinterpret_cast<const char *>(desc), (refs_cnt + 1) / 2);
+  for (unsigned i = 0; i < refs_cnt; i++) {
+    if (inline_refs[i].is_null()) {
+      auto level_mask = refs[i]->get_level_mask();
+      for (unsigned level_i = 0; level_i <= level_mask.get_level(); level_i++) {
+        if (level_mask.is_significant(level_i)) {
+          res += refs[i]->get_hash(level_i).as_slice().str();
+        }
+      }
+    }
+  }
+  for (unsigned i = 0; i < refs_cnt; i++) {
+    if (inline_refs[i].is_null()) {
+      auto level_mask = refs[i]->get_level_mask();
+      for (unsigned level_i = 0; level_i <= level_mask.get_level(); level_i++) {
+        if (level_mask.is_significant(level_i)) {
+          store_varuint(res, refs[i]->get_depth(level_i));
+        }
+      }
+    }
+  }
+  for (unsigned i = 0; i < refs_cnt; i++) {
+    if (inline_refs[i].not_null()) {
+      res += inline_refs[i]->serialize();
+    }
+  }
+  return res;
+}
+
+td::Result<Ref<DataCell>> parse_compact(td::Slice data, ExtCellCreator &ext_cell_creator) {
+  CellSerializationInfo info;
+  auto cell_data = data;
+  TRY_STATUS(info.init(cell_data, 0 /*ref_byte_size*/));
+  data.remove_prefix(info.end_offset);
+  size_t desc_size = (info.refs_cnt + 1) / 2;
+  if (data.size() < desc_size) {
+    return td::Status::Error("Not enough data");
+  }
+  auto desc = data.ubegin();
+  data.remove_prefix(desc_size);
+  auto get_nibble = [&](int i) {
+    return static_cast<td::uint8>((desc[i / 2] >> (i % 2 * 4)) & 15);
+  };
+
+  size_t hashes_cnt = 0;
+  for (int i = 0; i < info.refs_cnt; i++) {
+    if (!(get_nibble(i) & 8)) {
+      hashes_cnt += Cell::LevelMask(get_nibble(i) & 7).get_hashes_count();
+    }
+  }
+  if (data.size() < hashes_cnt * Cell::hash_bytes) {
+    return td::Status::Error("Not enough data");
+  }
+  auto hashes = data.substr(0, hashes_cnt * Cell::hash_bytes);
+  data.remove_prefix(hashes.size());
+
+  Ref<Cell> refs[Cell::max_refs];
+  for (int i = 0; i < info.refs_cnt; i++) {
+    if (get_nibble(i) & 8) {
+      continue;
+    }
+    Cell::LevelMask level_mask(get_nibble(i) & 7);
+    auto n = level_mask.get_hashes_count();
+    td::uint8 depths[(Cell::max_level + 1) * Cell::depth_bytes];
+    for (unsigned j = 0; j < n; j++) {
+      TRY_RESULT(depth, fetch_varuint(data));
+      if (depth > Cell::max_depth) {
+        return td::Status::Error("Depth is too big");
+      }
+      DataCell::store_depth(depths + j * Cell::depth_bytes, static_cast<td::uint16>(depth));
+    }
+    TRY_RESULT(ext_cell, ext_cell_creator.ext_cell(level_mask, hashes.substr(0, n * Cell::hash_bytes),
+                                                   td::Slice(depths, n * Cell::depth_bytes)));
+    refs[i] = std::move(ext_cell);
+    CHECK(refs[i]->get_level() == level_mask.get_level());
+    hashes.remove_prefix(n * Cell::hash_bytes);
+  }
+  for (int i = 0; i < info.refs_cnt; i++) {
+    if (!(get_nibble(i) & 8)) {
+      continue;
+    }
+    CellSerializationInfo child_info;
+    TRY_STATUS(child_info.init(data, 0 /*ref_byte_size*/));
+    if (child_info.refs_cnt != 0 || child_info.special) {
+      return td::Status::Error("Invalid inline child cell");
+    }
+    TRY_RESULT(child, child_info.create_data_cell(data.substr(0, child_info.end_offset), {}));
+    refs[i] = std::move(child);
+    data.remove_prefix(child_info.end_offset);
+  }
+  if (!data.empty()) {
+    return td::Status::Error("Too much data");
+  }
+  return info.create_data_cell(cell_data, td::Span<Ref<Cell>>(refs, info.refs_cnt));
+}
 }  // namespace
 
 CellLoader::CellLoader(std::shared_ptr<KeyValueReader> reader, std::function<void(const LoadResult &)> on_load_callback)
@@ -153,13 +320,16 @@ CellLoader::CellLoader(std::shared_ptr<KeyValueReader> reader, std::function<voi
 td::Result<CellLoader::LoadResult> CellLoader::load(td::Slice hash, bool need_data, ExtCellCreator &ext_cell_creator) {
   //LOG(ERROR) << "Storage: load cell " << hash.size() << " " << td::base64_encode(hash);
   TD_PERF_COUNTER(cell_load);
-  std::string serialized;
-  TRY_RESULT(get_status, reader_->get(hash, serialized));
+  LoadResult res;
+  // the cell is built right from the value kept by the storage, without copying it
+  TRY_RESULT(get_status, reader_->get_view(hash, [&](td::Slice value) -> td::Status {
+    TRY_RESULT_ASSIGN(res, load(hash, value, need_data, ext_cell_creator));
+    return td::Status::OK();
+  }));
   if (get_status != KeyValue::GetStatus::Ok) {
     DCHECK(get_status == KeyValue::GetStatus::NotFound);
     return LoadResult{};
   }
-  TRY_RESULT(res, load(hash, serialized, need_data, ext_cell_creator));
   if (on_load_callback_) {
     on_load_callback_(res);
   }
@@ -168,9 +338,26 @@ td::Result<CellLoader::LoadResult> CellLoader::load(td::Slice hash, bool need_da
 
 td::Result<CellLoader::LoadResult> CellLoader::load(td::Slice hash, td::Slice value, bool need_data,
                                                     ExtCellCreator &ext_cell_creator) {
+  // loaded cells may stay in a cache much longer than the task that loads them
+  CellArena::Suspend no_arena;
   LoadResult res;
   res.status = LoadResult::Ok;
 
+  td::int32 tag = 0;
+  if (value.size() >= sizeof(tag)) {
+    std::memcpy(&tag, value.data(), sizeof(tag));
+  }
+  if (tag == CellStorer::compact_tag) {
+    value.remove_prefix(sizeof(tag));
+    TRY_RESULT(refcnt, fetch_varuint(value));
+    res.refcnt_ = static_cast<td::int32>(refcnt);
+    res.stored_compact_ = true;
+    if (need_data) {
+      TRY_RESULT_ASSIGN(res.cell_, parse_compact(value, ext_cell_creator));
+    }
+    return res;
+  }
+
   RefcntCellParser refcnt_cell(need_data);
   td::TlParser parser(value);
   refcnt_cell.parse(parser, ext_cell_creator);
@@ -186,34 +373,43 @@ td::Result<CellLoader::LoadResult> CellLoader::load(td::Slice hash, td::Slice va
 
 td::Result<CellLoader::LoadResult> CellLoader::load_refcnt(td::Slice hash) {
   LoadResult res;
-  std::string serialized;
-  TRY_RESULT(get_status, reader_->get(hash, serialized));
+  TRY_RESULT(get_status, reader_->get_view(hash, [&](td::Slice value) -> td::Status {
+    td::TlParser parser(value);
+    td::parse(res.refcnt_, parser);
+    if (res.refcnt_ == -1) {
+      parse(res.refcnt_, parser);
+    } else if (res.refcnt_ == CellStorer::compact_tag) {
+      TRY_STATUS(parser.get_status());
+      auto rest = value.substr(sizeof(td::int32));
+      TRY_RESULT(refcnt, fetch_varuint(rest));
+      res.refcnt_ = static_cast<td::int32>(refcnt);
+      return td::Status::OK();
+    }
+    return parser.get_status();
+  }));
   if (get_status != KeyValue::GetStatus::Ok) {
     DCHECK(get_status == KeyValue::GetStatus::NotFound);
     return res;
   }
   res.status = LoadResult::Ok;
-  td::TlParser parser(serialized);
-  td::parse(res.refcnt_, parser);
-  if (res.refcnt_ == -1) {
-    parse(res.refcnt_, parser);
-  }
-  TRY_STATUS(parser.get_status());
   return res;
 }
 
-CellStorer::CellStorer(KeyValue &kv) : kv_(kv) {
+CellStorer::CellStorer(KeyValue &kv, bool compact) : kv_(kv), compact_(compact) {
 }
 
 td::Status CellStorer::erase(td::Slice hash) {
   return kv_.erase(hash);
 }
 
-std::string CellStorer::serialize_value(td::int32 refcnt, const td::Ref<DataCell> &cell, bool as_boc) {
+std::string CellStorer::serialize_value(td::int32 refcnt, const td::Ref<DataCell> &cell, bool as_boc, bool compact) {
+  if (compact && !as_boc) {
+    return serialize_compact(refcnt, cell);
+  }
   return td::serialize(RefcntCellStorer(refcnt, cell, as_boc));
 }
 
 td::Status CellStorer::set(td::int32 refcnt, const td::Ref<DataCell> &cell, bool as_boc) {
-  return kv_.set(cell->get_hash().as_slice(), serialize_value(refcnt, cell, as_boc));
+  return kv_.set(cell->get_hash().as_slice(), serialize_value(refcnt, cell, as_boc, compact_));
 }
 }  // namespace vm
@@ -46,6 +46,7 @@ class CellLoader {
     Ref<DataCell> cell_;
     td::int32 refcnt_{0};
     bool stored_boc_{false};
+    bool stored_compact_{false};
   };
   CellLoader(std::shared_ptr<KeyValueReader> reader, std::function<void(const LoadResult &)> on_load_callback = {});
   td::Result<LoadResult> load(td::Slice hash, bool need_data, ExtCellCreator &ext_cell_creator);
@@ -59,12 +60,24 @@ class CellLoader {
 
 class CellStorer {
  public:
-  CellStorer(KeyValue &kv);
+  // compact = true: cells which are not stored as a bag of cells are written in the compact format
+  // (see serialize_compact in CellStorage.cpp); CellLoader reads both formats
+  explicit CellStorer(KeyValue &kv, bool compact = false);
   td::Status erase(td::Slice hash);
   td::Status set(td::int32 refcnt, const td::Ref<DataCell> &cell, bool as_boc);
-  static std::string serialize_value(td::int32 refcnt, const td::Ref<DataCell> &cell, bool as_boc);
+  static std::string serialize_value(td::int32 refcnt, const td::Ref<DataCell> &cell, bool as_boc,
+                                     bool compact = false);
+
+  // first int32 of a value: refcnt for the original format, -1 for a cell stored as a bag of cells,
+  // compact_tag for the compact format
+  static constexpr td::int32 compact_tag = -2;
+  // children without references and with at most that many bits are stored inline in the compact format;
+  // such a child takes 2 descriptor bytes and at most hash_bytes - 2 data bytes, which is less than its hash
+  // and depth (hash_bytes + 1 bytes, the depth of a child without references is 0)
+  static constexpr unsigned max_inline_child_bits = 8 * (Cell::hash_bytes - 2);
 
  private:
   KeyValue &kv_;
+  bool compact_;
 };
 }  // namespace vm
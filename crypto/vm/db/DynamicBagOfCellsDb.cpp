@@ -27,7 +27,7 @@
 #include "td/utils/ThreadSafeCounter.h"
 
 #include "vm/cellslice.h"
-#include <queue>
+#include <algorithm>
 #include "td/actor/actor.h"
 #include "common/delay.h"
 
@@ -135,12 +135,7 @@ class DynamicBagOfCellsDbImpl : public DynamicBagOfCellsDb, private ExtCellCreat
             db->hash_table_.apply(hash.as_slice(), [&](CellInfo &info) {
               db->update_cell_info_loaded(info, hash.as_slice(), std::move(res));
             });
-            for (auto &ext_cell : ext_cell_creator.get_created_cells()) {
-              auto ext_cell_hash = ext_cell->get_hash();
-              db->hash_table_.apply(ext_cell_hash.as_slice(), [&](CellInfo &info) {
-                db->update_cell_info_created_ext(info, std::move(ext_cell));
-              });
-            }
+            db->add_created_ext_cells(ext_cell_creator);
           });
           promise->set_result(std::move(cell));
         });
@@ -281,6 +276,15 @@ class DynamicBagOfCellsDbImpl : public DynamicBagOfCellsDb, private ExtCellCreat
     std::shared_ptr<CellDbReader> cell_db_reader_;
   };
 
+  void add_created_ext_cells(SimpleExtCellCreator &ext_cell_creator) {
+    for (auto &ext_cell : ext_cell_creator.get_created_cells()) {
+      auto ext_cell_hash = ext_cell->get_hash();
+      hash_table_.apply(ext_cell_hash.as_slice(),
+                        [&](CellInfo &info) { update_cell_info_created_ext(info, std::move(ext_cell)); });
+    }
+    ext_cell_creator.get_created_cells().clear();
+  }
+
   class CellDbReaderImpl : public CellDbReader,
                            private ExtCellCreator,
                            public std::enable_shared_from_this<CellDbReaderImpl> {
@@ -431,6 +435,9 @@ class DynamicBagOfCellsDbImpl : public DynamicBagOfCellsDb, private ExtCellCreat
   }
 
   void save_diff(CellStorer &storer) {
+    // keys are written in order, which is cheaper for the write batch and the memtable
+    std::sort(visited_.begin(), visited_.end(),
+              [](const CellInfo *a, const CellInfo *b) { return a->key() < b->key(); });
     for (auto info_ptr : visited_) {
       save_cell(*info_ptr, storer);
     }
@@ -644,7 +651,10 @@ class DynamicBagOfCellsDbImpl : public DynamicBagOfCellsDb, private ExtCellCreat
 
     CellHashTable<CellInfo2> cells_;
 
-    std::queue<CellInfo2*> load_queue_;
+    // Cells waiting to be loaded: new cells need only refcnt, old cells are loaded entirely.
+    // Each batch of loads is sorted by hash and split into contiguous ranges, one async task per range.
+    std::vector<CellInfo2 *> refcnt_queue_;
+    std::vector<CellInfo *> cell_queue_;
     td::uint32 active_load_ = 0;
     td::uint32 max_parallel_load_ = 4;
   };
@@ -674,6 +684,8 @@ class DynamicBagOfCellsDbImpl : public DynamicBagOfCellsDb, private ExtCellCreat
     });
     if (pca_state_->remaining_ == 0) {
       prepare_commit_async_cont();
+    } else {
+      pca_flush_loads();
     }
   }
 
@@ -702,28 +714,89 @@ class DynamicBagOfCellsDbImpl : public DynamicBagOfCellsDb, private ExtCellCreat
   }
 
   void pca_load_from_db(PrepareCommitAsyncState::CellInfo2 *info) {
+    pca_state_->refcnt_queue_.push_back(info);
+  }
+
+  template <class T>
+  std::vector<std::vector<T *>> pca_split_loads(std::vector<T *> &queue) {
+    std::sort(queue.begin(), queue.end(), [](const T *a, const T *b) { return a->key() < b->key(); });
+    size_t parts = std::min<size_t>(queue.size(), pca_state_->max_parallel_load_ - pca_state_->active_load_);
+    std::vector<std::vector<T *>> res(parts);
+    for (size_t i = 0; i < parts; i++) {
+      res[i].assign(queue.begin() + queue.size() * i / parts, queue.begin() + queue.size() * (i + 1) / parts);
+    }
+    queue.clear();
+    return res;
+  }
+
+  void pca_flush_loads() {
     if (pca_state_->active_load_ >= pca_state_->max_parallel_load_) {
-      pca_state_->load_queue_.push(info);
       return;
     }
+    if (!pca_state_->refcnt_queue_.empty()) {
+      for (auto &batch : pca_split_loads(pca_state_->refcnt_queue_)) {
+        pca_load_refcnts(std::move(batch));
+      }
+    } else if (!pca_state_->cell_queue_.empty()) {
+      for (auto &batch : pca_split_loads(pca_state_->cell_queue_)) {
+        pca_load_cells(std::move(batch));
+      }
+    }
+  }
+
+  void pca_load_refcnts(std::vector<PrepareCommitAsyncState::CellInfo2 *> batch) {
     ++pca_state_->active_load_;
     pca_state_->executor_->execute_async(
-        [db = this, info, executor = pca_state_->executor_, loader = *loader_]() mutable {
-          auto res = loader.load_refcnt(info->info->cell->get_hash().as_slice()).move_as_ok();
-          executor->execute_sync([db, info, res = std::move(res)]() {
+        [db = this, batch = std::move(batch), executor = pca_state_->executor_, loader = *loader_]() mutable {
+          std::vector<CellLoader::LoadResult> results;
+          results.reserve(batch.size());
+          for (auto *info : batch) {
+            results.push_back(loader.load_refcnt(info->info->cell->get_hash().as_slice()).move_as_ok());
+          }
+          executor->execute_sync([db, batch = std::move(batch), results = std::move(results)]() mutable {
             --db->pca_state_->active_load_;
-            db->pca_process_load_queue();
-            db->pca_set_in_db(info, std::move(res));
+            for (size_t i = 0; i < batch.size(); i++) {
+              db->pca_set_in_db(batch[i], std::move(results[i]));
+            }
+            if (db->pca_state_) {
+              db->pca_flush_loads();
+            }
           });
         });
   }
 
-  void pca_process_load_queue() {
-    while (pca_state_->active_load_ < pca_state_->max_parallel_load_ && !pca_state_->load_queue_.empty()) {
-      PrepareCommitAsyncState::CellInfo2 *info = pca_state_->load_queue_.front();
-      pca_state_->load_queue_.pop();
-      pca_load_from_db(info);
-    }
+  void pca_load_cells(std::vector<CellInfo *> batch) {
+    ++pca_state_->active_load_;
+    pca_state_->executor_->execute_async([db = this, batch = std::move(batch), executor = pca_state_->executor_,
+                                          loader = *loader_,
+                                          ext_cell_creator = SimpleExtCellCreator(cell_db_reader_)]() mutable {
+      std::vector<CellLoader::LoadResult> results;
+      results.reserve(batch.size());
+      for (auto *info : batch) {
+        auto res = loader.load(info->cell->get_hash().as_slice(), true, ext_cell_creator).move_as_ok();
+        LOG_CHECK(res.status == CellLoader::LoadResult::Ok) << "cell not found";
+        results.push_back(std::move(res));
+      }
+      executor->execute_sync([db, batch = std::move(batch), results = std::move(results),
+                              ext_cell_creator = std::move(ext_cell_creator)]() mutable {
+        --db->pca_state_->active_load_;
+        for (size_t i = 0; i < batch.size(); i++) {
+          db->update_cell_info_loaded(*batch[i], batch[i]->cell->get_hash().as_slice(), std::move(results[i]));
+        }
+        db->add_created_ext_cells(ext_cell_creator);
+        for (auto *info : batch) {
+          CHECK(info->sync_with_db);
+          db->dfs_old_cells_async(*info);
+          CHECK(db->pca_state_->remaining_ != 0);
+          --db->pca_state_->remaining_;
+        }
+        if (db->pca_state_->remaining_ == 0) {
+          db->prepare_commit_async_cont2();
+        } else {
+          db->pca_flush_loads();
+        }
+      });
+    });
   }
 
   void pca_set_in_db(PrepareCommitAsyncState::CellInfo2 *info, CellLoader::LoadResult result) {
@@ -763,6 +836,8 @@ class DynamicBagOfCellsDbImpl : public DynamicBagOfCellsDb, private ExtCellCreat
     }
     if (pca_state_->remaining_ == 0) {
       prepare_commit_async_cont2();
+    } else {
+      pca_flush_loads();
     }
   }
 
@@ -772,18 +847,7 @@ class DynamicBagOfCellsDbImpl : public DynamicBagOfCellsDb, private ExtCellCreat
       visited_.push_back(&info);
       if (!info.sync_with_db) {
         ++pca_state_->remaining_;
-        load_cell_async(
-            info.cell->get_hash().as_slice(), pca_state_->executor_,
-            [executor = pca_state_->executor_, db = this, info = &info](td::Result<td::Ref<vm::DataCell>> R) {
-              R.ensure();
-              executor->execute_sync([db, info]() {
-                CHECK(info->sync_with_db);
-                db->dfs_old_cells_async(*info);
-                if (--db->pca_state_->remaining_ == 0) {
-                  db->prepare_commit_async_cont2();
-                }
-              });
-            });
+        pca_state_->cell_queue_.push_back(&info);
         return;
       }
     }
@@ -86,6 +86,7 @@ class DynamicBagOfCellsDb {
   static std::unique_ptr<DynamicBagOfCellsDb> create();
 
   struct CreateInMemoryOptions {
+    // capped by td::ParallelPool::max_threads()
     size_t extra_threads{std::thread::hardware_concurrency()};
     bool verbose{true};
     // Allocated DataCels will never be deleted
@@ -1,3 +1,4 @@
+#include "CellHashTable.h"
 #include "CellStorage.h"
 #include "DynamicBagOfCellsDb.h"
 #include "td/utils/Timer.h"
@@ -5,6 +6,7 @@
 #include "td/utils/format.h"
 #include "td/utils/int_types.h"
 #include "td/utils/misc.h"
+#include "td/utils/ParallelPool.h"
 #include "td/utils/port/Stat.h"
 #include "vm/cells/CellHash.h"
 #include "vm/cells/CellSlice.h"
@@ -23,33 +25,6 @@
 
 namespace vm {
 namespace {
-constexpr bool use_dense_hash_map = true;
-
-template <class F>
-void parallel_run(size_t n, F &&run_task, size_t extra_threads_n) {
-  std::atomic<size_t> next_task_id{0};
-  auto loop = [&] {
-    while (true) {
-      auto task_id = next_task_id++;
-      if (task_id >= n) {
-        break;
-      }
-      run_task(task_id);
-    }
-  };
-
-  // NB: it could be important that td::thread is used, not std::thread
-  std::vector<td::thread> threads;
-  for (size_t i = 0; i < extra_threads_n; i++) {
-    threads.emplace_back(loop);
-  }
-  loop();
-  for (auto &thread : threads) {
-    thread.join();
-  }
-  threads.clear();
-}
-
 struct UniqueAccess {
   struct Release {
     void operator()(UniqueAccess *access) const {
@@ -191,152 +166,6 @@ CellHash as_cell_hash(const CellInfo &info) {
   return info.cell->get_hash();
 }
 
-struct CellInfoHashTableBaseline {
-  td::HashSet<CellInfo, CellHashF, CellEqF> ht_;
-  const CellInfo *find(CellHash hash) const {
-    if (auto it = ht_.find(hash); it != ht_.end()) {
-      return &*it;
-    }
-    return nullptr;
-  }
-  void erase(CellHash hash) {
-    auto it = ht_.find(hash);
-    CHECK(it != ht_.end());
-    ht_.erase(it);
-  }
-  void insert(CellInfo info) {
-    ht_.insert(std::move(info));
-  }
-  template <class Iterator>
-  void init_from(Iterator begin, Iterator end) {
-    ht_ = td::HashSet<CellInfo, CellHashF, CellEqF>(begin, end);
-  }
-  size_t size() const {
-    return ht_.size();
-  }
-  auto begin() const {
-    return ht_.begin();
-  }
-  auto end() const {
-    return ht_.end();
-  }
-  size_t bucket_count() const {
-    return ht_.bucket_count();
-  }
-  template <class F>
-  auto for_each(F &&f) {
-    for (auto &it : ht_) {
-      f(it);
-    }
-  }
-};
-
-struct CellInfoHashTableDense {
-  size_t dense_ht_size_{0};
-  size_t dense_ht_buckets_{1};
-  std::vector<size_t> dense_ht_offsets_{1};
-  std::vector<CellInfo> dense_ht_values_;
-  td::HashSet<CellInfo, CellHashF, CellEqF> new_ht_;
-  size_t dense_choose_bucket(const CellHash &hash) const {
-    return cell_hash_slice_hash(hash.as_slice()) % dense_ht_buckets_;
-  }
-  const CellInfo *dense_find(CellHash hash) const {
-    auto bucket_i = dense_choose_bucket(hash);
-    auto begin = dense_ht_values_.begin() + dense_ht_offsets_[bucket_i];
-    auto end = dense_ht_values_.begin() + dense_ht_offsets_[bucket_i + 1];
-    for (auto it = begin; it != end; ++it) {
-      if (it->cell.not_null() && it->cell->get_hash() == hash) {
-        return &*it;
-      }
-    }
-    return nullptr;
-  }
-  CellInfo *dense_find_empty(CellHash hash) {
-    auto bucket_i = dense_choose_bucket(hash);
-    auto begin = dense_ht_values_.begin() + dense_ht_offsets_[bucket_i];
-    auto end = dense_ht_values_.begin() + dense_ht_offsets_[bucket_i + 1];
-    for (auto it = begin; it != end; ++it) {
-      if (it->cell.is_null()) {
-        return &*it;
-      }
-    }
-    return nullptr;
-  }
-  const CellInfo *find(CellHash hash) const {
-    if (auto it = new_ht_.find(hash); it != new_ht_.end()) {
-      return &*it;
-    }
-    if (auto it = dense_find(hash)) {
-      return it;
-    }
-    return nullptr;
-  }
-  void erase(CellHash hash) {
-    if (auto it = new_ht_.find(hash); it != new_ht_.end()) {
-      new_ht_.erase(it);
-      return;
-    }
-    auto info = dense_find(hash);
-    CHECK(info && info->db_refcnt > 0);
-    info->db_refcnt = 0;
-    const_cast<CellInfo *>(info)->cell = {};
-    CHECK(dense_ht_size_ > 0);
-    dense_ht_size_--;
-  }
-
-  void insert(CellInfo info) {
-    if (auto dest = dense_find_empty(info.cell->get_hash())) {
-      *dest = std::move(info);
-      dense_ht_size_++;
-      return;
-    }
-    new_ht_.insert(std::move(info));
-  }
-  template <class Iterator>
-  void init_from(Iterator begin, Iterator end) {
-    auto size = td::narrow_cast<size_t>(std::distance(begin, end));
-    dense_ht_buckets_ = std::max(size_t(1), size_t(size / 8));
-
-    std::vector<size_t> offsets(dense_ht_buckets_ + 2);
-    for (auto it = begin; it != end; ++it) {
-      auto bucket_i = dense_choose_bucket(it->cell->get_hash());
-      offsets[bucket_i + 2]++;
-    }
-    for (size_t i = 1; i < offsets.size(); i++) {
-      offsets[i] += offsets[i - 1];
-    }
-    dense_ht_values_.resize(size);
-    for (auto it = begin; it != end; ++it) {
-      auto bucket_i = dense_choose_bucket(it->cell->get_hash());
-      dense_ht_values_[offsets[bucket_i + 1]++] = std::move(*it);
-    }
-    CHECK(offsets[0] == 0);
-    CHECK(offsets[offsets.size() - 1] == size);
-    CHECK(offsets[offsets.size() - 2] == size);
-    dense_ht_offsets_ = std::move(offsets);
-    dense_ht_size_ = size;
-  }
-  size_t size() const {
-    return dense_ht_size_ + new_ht_.size();
-  }
-  template <class F>
-  auto for_each(F &&f) {
-    for (auto &it : dense_ht_values_) {
-      if (it.cell.not_null()) {
-        f(it);
-      }
-    }
-    for (auto &it : new_ht_) {
-      f(it);
-    }
-  }
-  size_t bucket_count() const {
-    return new_ht_.bucket_count() + dense_ht_values_.size();
-  }
-};
-
-using CellInfoHashTable = std::conditional_t<use_dense_hash_map, CellInfoHashTableDense, CellInfoHashTableBaseline>;
-
 class CellStorage {
   struct PrivateTag {};
   struct CellBucket;
@@ -356,14 +185,12 @@ class CellStorage {
   };
   struct CellBucket {
     mutable UniqueAccess access_;
-    CellInfoHashTable infos_;
     std::vector<CellInfo> cells_;
     std::vector<Ref<DataCell>> roots_;
     size_t boc_count_{0};
     [[maybe_unused]] char pad3[TD_CONCURRENCY_PAD];
 
     void clear() {
-      td::reset_to_empty(infos_);
       td::reset_to_empty(cells_);
       td::reset_to_empty(roots_);
     }
@@ -374,14 +201,16 @@ class CellStorage {
                            .bucket = std::unique_ptr<CellBucket, None>(const_cast<CellBucket *>(this))};
     }
   };
-  std::array<CellBucket, 256> buckets_{};
+  // cells are shared with readers from other threads, buckets are only used while the storage is built
+  ConcurrentCellHashTable<CellInfo> infos_;
+  std::array<CellBucket, ConcurrentCellHashTable<CellInfo>::stripe_count()> buckets_{};
   bool inited_{false};
 
   const CellBucket &get_bucket(size_t i) const {
     return buckets_.at(i);
   }
   const CellBucket &get_bucket(const CellHash &hash) const {
-    return get_bucket(hash.as_array()[0]);
+    return get_bucket(infos_.get_stripe_id(hash));
   }
 
   mutable UniqueAccess local_access_;
@@ -393,12 +222,7 @@ class CellStorage {
 
  public:
   std::optional<CellInfo> get_info(const CellHash &hash) const {
-    auto lock = local_access_.lock();
-    auto &bucket = get_bucket(hash);
-    if (auto info_ptr = bucket.infos_.find(hash)) {
-      return *info_ptr;
-    }
-    return {};
+    return infos_.get(hash);
   }
 
   DynamicBagOfCellsDb::Stats get_stats() {
@@ -407,39 +231,11 @@ class CellStorage {
     auto add_stat = [&stats](auto key, auto value) {
       stats.custom_stats.emplace_back(std::move(key), PSTRING() << value);
     };
-    if constexpr (use_dense_hash_map) {
-      size_t dense_ht_capacity = 0;
-      size_t new_ht_capacity = 0;
-      size_t dense_ht_size = 0;
-      size_t new_ht_size = 0;
-      for_each_bucket(0, [&](auto bucket_id, CellBucket &bucket) {
-        dense_ht_capacity += bucket.infos_.dense_ht_values_.size();
-        dense_ht_size += bucket.infos_.dense_ht_size_;
-        new_ht_capacity += bucket.infos_.new_ht_.bucket_count();
-        new_ht_size += bucket.infos_.new_ht_.size();
-      });
-      auto size = new_ht_size + dense_ht_size;
-      auto capacity = new_ht_capacity + dense_ht_capacity;
-      add_stat("ht.capacity", capacity);
-      add_stat("ht.size", size);
-      add_stat("ht.load", double(size) / std::max(1.0, double(capacity)));
-      add_stat("ht.dense_ht_capacity", dense_ht_capacity);
-      add_stat("ht.dense_ht_size", dense_ht_size);
-      add_stat("ht.dense_ht_load", double(dense_ht_size) / std::max(1.0, double(dense_ht_capacity)));
-      add_stat("ht.new_ht_capacity", new_ht_capacity);
-      add_stat("ht.new_ht_size", new_ht_size);
-      add_stat("ht.new_ht_load", double(new_ht_size) / std::max(1.0, double(new_ht_capacity)));
-    } else {
-      size_t capacity = 0;
-      size_t size = 0;
-      for_each_bucket(0, [&](auto bucket_id, CellBucket &bucket) {
-        capacity += bucket.infos_.bucket_count();
-        size += bucket.infos_.size();
-      });
-      add_stat("ht.capacity", capacity);
-      add_stat("ht.size", size);
-      add_stat("ht.load", double(size) / std::max(1.0, double(capacity)));
-    }
+    auto size = infos_.size();
+    auto capacity = infos_.capacity();
+    add_stat("ht.capacity", capacity);
+    add_stat("ht.size", size);
+    add_stat("ht.load", double(size) / std::max(1.0, double(capacity)));
     CHECK(td::narrow_cast<size_t>(stats.roots_total_count) == local_roots_.size());
     return stats;
   }
@@ -447,16 +243,12 @@ class CellStorage {
     auto unique_access = local_access_.lock();
     stats_.apply_diff(diff);
     CHECK(td::narrow_cast<size_t>(stats_.roots_total_count) == local_roots_.size());
-    size_t cells_count{0};
-    for_each_bucket(0, [&](size_t bucket_id, auto &bucket) { cells_count += bucket.infos_.size(); });
-    CHECK(td::narrow_cast<size_t>(stats_.cells_total_count) == cells_count);
+    CHECK(td::narrow_cast<size_t>(stats_.cells_total_count) == infos_.size());
   }
 
   td::Result<Ref<DataCell>> load_cell(const CellHash &hash) const {
-    auto lock = local_access_.lock();
-    auto &bucket = get_bucket(hash);
-    if (auto info_ptr = bucket.infos_.find(hash)) {
-      return info_ptr->cell;
+    if (auto info = infos_.get(hash)) {
+      return std::move(info->cell);
     }
     return td::Status::Error("not found");
   }
@@ -478,8 +270,7 @@ class CellStorage {
 
   void erase(const CellHash &hash) {
     auto lock = local_access_.lock();
-    auto bucket = get_bucket(hash).unique_access();
-    bucket->infos_.erase(hash);
+    CHECK(infos_.erase(hash));
     if (auto local_it = local_roots_.find(hash); local_it != local_roots_.end()) {
       local_roots_.erase(local_it);
       std::lock_guard<std::mutex> root_lock(root_mutex_);
@@ -501,16 +292,15 @@ class CellStorage {
   }
 
   void set(td::int32 refcnt, Ref<DataCell> cell) {
-    auto lock = local_access_.lock();
     //LOG(ERROR) << "setting refcnt to " << refcnt << ", cell " << td::base64_encode(cell->get_hash().as_slice());
-    auto hash = cell->get_hash();
-    auto bucket = get_bucket(hash).unique_access();
-    if (auto info_ptr = bucket->infos_.find(hash)) {
-      CHECK(info_ptr->cell.get() == cell.get());
-      info_ptr->db_refcnt = refcnt;
-    } else {
-      bucket->infos_.insert({.db_refcnt = refcnt, .cell = std::move(cell)});
-    }
+    infos_.apply(cell->get_hash(), [&](CellInfo &info) {
+      if (info.cell.is_null()) {
+        info.cell = std::move(cell);
+      } else {
+        CHECK(info.cell.get() == cell.get());
+      }
+      info.db_refcnt = refcnt;
+    });
   }
 
   template <class F>
@@ -534,8 +324,7 @@ class CellStorage {
     auto verbose = options.verbose;
     td::Slice P = "loading in-memory cell database: ";
     LOG_IF(WARNING, verbose) << P << "start with options use_arena=" << options.use_arena
-                             << " use_less_memory_during_creation=" << options.use_less_memory_during_creation
-                             << " use_dense_hash_map=" << use_dense_hash_map;
+                             << " use_less_memory_during_creation=" << options.use_less_memory_during_creation;
     auto full_timer = td::Timer();
     auto lock = local_access_.lock();
     CHECK(ArenaPrunnedCellCreator::count() == 0);
@@ -562,17 +351,14 @@ class CellStorage {
                              << " prunned_cells_count=" << ArenaPrunnedCellCreator::count();
 
     timer = td::Timer();
-    for_each_bucket(options.extra_threads, [&](size_t bucket_id, auto &bucket) { build_hashtable(bucket); });
+    for_each_bucket(options.extra_threads,
+                    [&](size_t bucket_id, auto &bucket) { build_hashtable(bucket_id, bucket); });
 
-    size_t ht_capacity = 0;
-    size_t ht_size = 0;
-    for_each_bucket(0, [&](size_t bucket_id, auto &bucket) {
-      ht_size += bucket.infos_.size();
-      ht_capacity += bucket.infos_.bucket_count();
-    });
+    size_t ht_capacity = infos_.capacity();
+    size_t ht_size = infos_.size();
     double load_factor = double(ht_size) / std::max(double(ht_capacity), 1.0);
-    LOG_IF(WARNING, verbose) << P << "hashtable created in " << timer.elapsed()
-                             << "s,  hashtables_expected_size=" << td::format::as_size(ht_capacity * sizeof(CellInfo))
+    LOG_IF(WARNING, verbose) << P << "hashtable created in " << timer.elapsed() << "s,  hashtables_expected_size="
+                             << td::format::as_size(ht_capacity * (sizeof(CellInfo) + 1))
                              << " load_factor=" << load_factor;
 
     timer = td::Timer();
@@ -583,7 +369,7 @@ class CellStorage {
       CHECK(new_cell_count == cell_count);
       CHECK(new_desc_count == desc_count);
     } else {
-      for_each_bucket(options.extra_threads, [&](size_t bucket_id, auto &bucket) { reset_refs(bucket); });
+      for_each_bucket(options.extra_threads, [&](size_t bucket_id, auto &bucket) { reset_refs(bucket_id, bucket); });
     }
     LOG_IF(WARNING, verbose) << P << "refs rearranged in " << timer.elapsed() << "s";
 
@@ -592,10 +378,11 @@ class CellStorage {
     std::vector<Stats> bucket_stats(buckets_.size());
     std::atomic<size_t> boc_count{0};
     for_each_bucket(options.extra_threads, [&](size_t bucket_id, auto &bucket) {
-      bucket_stats[bucket_id] = validate_bucket_a(bucket, options.use_arena);
+      bucket_stats[bucket_id] = validate_bucket_a(bucket_id, bucket, options.use_arena);
       boc_count += bucket.boc_count_;
     });
-    for_each_bucket(options.extra_threads, [&](size_t bucket_id, auto &bucket) { validate_bucket_b(bucket); });
+    for_each_bucket(options.extra_threads,
+                    [&](size_t bucket_id, auto &bucket) { validate_bucket_b(bucket_id, bucket); });
     stats_ = {};
     for (auto &bucket_stat : bucket_stats) {
       stats_.apply_diff(bucket_stat);
@@ -639,13 +426,16 @@ class CellStorage {
 
   template <class F>
   void for_each_bucket(size_t extra_threads, F &&f) {
-    parallel_run(
+    td::ParallelPool::run(
         buckets_.size(), [&](auto task_id) { f(task_id, *get_bucket(task_id).unique_access()); }, extra_threads);
   }
 
   void clear() {
     auto unique_access = local_access_.lock();
-    for_each_bucket(td::thread::hardware_concurrency(), [&](size_t bucket_id, auto &bucket) { bucket.clear(); });
+    for_each_bucket(td::thread::hardware_concurrency(), [&](size_t bucket_id, auto &bucket) {
+      infos_.clear_stripe(bucket_id);
+      bucket.clear();
+    });
     local_roots_.clear();
     {
       auto lock = std::lock_guard<std::mutex>(root_mutex_);
@@ -675,15 +465,14 @@ class CellStorage {
   void secondary_set(td::int32 refcnt, Ref<DataCell> cell_copy) {
     CHECK(!inited_);
     auto bucket = get_bucket(cell_copy->get_hash()).unique_access();
-    auto info = bucket->infos_.find(cell_copy->get_hash());
+    auto info = infos_.find_unlocked(cell_copy->get_hash());
     CHECK(info);
     CellSlice cs(NoVm{}, std::move(cell_copy));
     auto &cell = const_cast<DataCell &>(*info->cell);
     CHECK(cs.size_refs() == cell.size_refs());
     for (unsigned i = 0; i < cell.size_refs(); i++) {
       auto prunned_cell_hash = cs.fetch_ref()->get_hash();
-      auto &prunned_cell_bucket = get_bucket(prunned_cell_hash);
-      auto full_cell_ptr = prunned_cell_bucket.infos_.find(prunned_cell_hash);
+      auto full_cell_ptr = infos_.find_unlocked(prunned_cell_hash);
       CHECK(full_cell_ptr);
       auto full_cell = full_cell_ptr->cell;
       auto to_destroy = cell.reset_ref_unsafe(i, std::move(full_cell), false);
@@ -691,22 +480,22 @@ class CellStorage {
     }
   }
 
-  void build_hashtable(CellBucket &bucket) {
-    bucket.infos_.init_from(bucket.cells_.begin(), bucket.cells_.end());
-    LOG_CHECK(bucket.infos_.size() == bucket.cells_.size()) << bucket.infos_.size() << " vs " << bucket.cells_.size();
+  void build_hashtable(size_t bucket_id, CellBucket &bucket) {
+    infos_.init_stripe(bucket_id, bucket.cells_.begin(), bucket.cells_.end());
+    LOG_CHECK(infos_.stripe_size(bucket_id) == bucket.cells_.size())
+        << infos_.stripe_size(bucket_id) << " vs " << bucket.cells_.size();
     td::reset_to_empty(bucket.cells_);
     LOG_CHECK(bucket.cells_.capacity() == 0) << bucket.cells_.capacity();
   }
 
-  void reset_refs(CellBucket &bucket) {
-    bucket.infos_.for_each([&](auto &it) {
+  void reset_refs(size_t bucket_id, CellBucket &bucket) {
+    infos_.for_each_in_stripe(bucket_id, [&](auto &it) {
       // This is generally very dangerous, but should be safe here
       auto &cell = const_cast<DataCell &>(*it.cell);
       for (unsigned i = 0; i < cell.size_refs(); i++) {
         auto prunned_cell = cell.get_ref_raw_ptr(i);
         auto prunned_cell_hash = prunned_cell->get_hash();
-        auto &prunned_cell_bucket = get_bucket(prunned_cell_hash);
-        auto full_cell_ptr = prunned_cell_bucket.infos_.find(prunned_cell_hash);
+        auto full_cell_ptr = infos_.find_unlocked(prunned_cell_hash);
         CHECK(full_cell_ptr);
         auto full_cell = full_cell_ptr->cell;
         auto to_destroy = cell.reset_ref_unsafe(i, std::move(full_cell));
@@ -721,9 +510,9 @@ class CellStorage {
     });
   }
 
-  DynamicBagOfCellsDb::Stats validate_bucket_a(CellBucket &bucket, bool use_arena) {
+  DynamicBagOfCellsDb::Stats validate_bucket_a(size_t bucket_id, CellBucket &bucket, bool use_arena) {
     DynamicBagOfCellsDb::Stats stats;
-    bucket.infos_.for_each([&](auto &it) {
+    infos_.for_each_in_stripe(bucket_id, [&](auto &it) {
       int cell_ref_cnt = it.cell->get_refcnt();
       CHECK(it.db_refcnt + 1 + use_arena >= cell_ref_cnt);
       auto extra_refcnt = it.db_refcnt + 1 + use_arena - cell_ref_cnt;
@@ -736,9 +525,9 @@ class CellStorage {
     });
     return stats;
   }
-  void validate_bucket_b(CellBucket &bucket) {
+  void validate_bucket_b(size_t bucket_id, CellBucket &bucket) {
     // sanity check
-    bucket.infos_.for_each([&](auto &it) {
+    infos_.for_each_in_stripe(bucket_id, [&](auto &it) {
       CellSlice cs(NoVm{}, it.cell);
       while (cs.have_refs()) {
         CHECK(cs.fetch_ref().not_null());
@@ -950,7 +739,7 @@ std::unique_ptr<DynamicBagOfCellsDb> DynamicBagOfCellsDb::create_in_memory(td::K
                                  auto &&f) -> std::pair<td::int64, td::int64> {
     std::atomic<td::int64> cell_count{0};
     std::atomic<td::int64> desc_count{0};
-    parallel_run(
+    td::ParallelPool::run(
         keys.size() - 1,
         [&](auto task_id) {
           td::int64 local_cell_count = 0;
@@ -962,7 +751,7 @@ std::unique_ptr<DynamicBagOfCellsDb> DynamicBagOfCellsDb::create_in_memory(td::K
                 local_desc_count++;
                 return td::Status::OK();
               }
-              auto r_res = CellLoader::load(key, value.str(), true, pc_creator);
+              auto r_res = CellLoader::load(key, value, true, pc_creator);
               if (r_res.is_error()) {
                 LOG(ERROR) << r_res.error() << " at " << td::format::escaped(key);
                 return td::Status::OK();
@@ -20,6 +20,7 @@
 
 #include "vm/cells/CellWithStorage.h"
 #include "vm/boc.h"
+#include "vm/cells/CellArena.h"
 
 #include "vm/cells/ExtCell.h"
 
@@ -504,6 +505,8 @@ class StaticBagOfCellsDbLazyImpl : public StaticBagOfCellsDb {
       refs[k] = std::move(ref);
     }
 
+    // cells of a bag of cells file may be cached for as long as the db is open
+    CellArena::Suspend no_arena;
     TRY_RESULT(data_cell, cell_info.create_data_cell(cell_slice, td::Span<Ref<Cell>>(refs, cell_info.refs_cnt)));
     if (!should_cache) {
       return std::move(data_cell);
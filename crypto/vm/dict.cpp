@@ -24,6 +24,7 @@
 #include "td/utils/Random.h"
 
 #include "td/utils/bits.h"
+#include "td/utils/ParallelPool.h"
 
 namespace vm {
 
@@ -2057,12 +2058,72 @@ static inline bool set_bit(td::BitPtr ptr, bool value = true) {
   return true;
 }
 
+// subtrees recorded by the sequential upper phase of scan_diff_parallel(), to be compared by worker threads
+struct DictionaryFixed::ScanDiffTasks {
+  struct Diff {
+    std::string key;
+    Ref<CellSlice> value1, value2;
+  };
+  struct Task {
+    Ref<Cell> dict1, dict2;  // both null for tasks that only carry diffs found by the upper phase
+    std::string key_prefix;
+    int n{0}, skip1{0}, skip2{0};
+    std::vector<Diff> diffs;
+    std::exception_ptr error;
+  };
+  int min_prefix_len;
+  int key_bytes;
+  std::vector<Task> tasks;
+
+  ScanDiffTasks(int min_prefix_len, int key_len) : min_prefix_len(min_prefix_len), key_bytes((key_len + 7) >> 3) {
+  }
+  void add_task(Ref<Cell> dict1, Ref<Cell> dict2, td::ConstBitPtr key_buffer, int n, int total_key_len, int skip1,
+                int skip2) {
+    Task task;
+    task.dict1 = std::move(dict1);
+    task.dict2 = std::move(dict2);
+    task.key_prefix.resize(key_bytes);
+    td::bitstring::bits_memcpy(td::BitPtr{(unsigned char*)task.key_prefix.data()}, key_buffer - (total_key_len - n),
+                               total_key_len - n);
+    task.n = n;
+    task.skip1 = skip1;
+    task.skip2 = skip2;
+    tasks.push_back(std::move(task));
+  }
+  static bool add_diff(Task& task, int key_bytes, td::ConstBitPtr key, int key_len, Ref<CellSlice> value1,
+                       Ref<CellSlice> value2) {
+    Diff diff{std::string(key_bytes, '\0'), std::move(value1), std::move(value2)};
+    td::bitstring::bits_memcpy(td::BitPtr{(unsigned char*)diff.key.data()}, key, key_len);
+    task.diffs.push_back(std::move(diff));
+    return true;
+  }
+  bool add_diff(td::ConstBitPtr key, int key_len, Ref<CellSlice> value1, Ref<CellSlice> value2) {
+    if (tasks.empty() || tasks.back().dict1.not_null() || tasks.back().dict2.not_null()) {
+      tasks.emplace_back();
+    }
+    return add_diff(tasks.back(), key_bytes, key, key_len, std::move(value1), std::move(value2));
+  }
+};
+
 // mode: +1 = check augmentation of dict1, +2 = ... of dict2
 bool DictionaryFixed::dict_scan_diff(Ref<Cell> dict1, Ref<Cell> dict2, td::BitPtr key_buffer, int n, int total_key_len,
-                                     const scan_diff_func_t& diff_func, int mode, int skip1, int skip2) const {
+                                     const scan_diff_func_t& diff_func, int mode, int skip1, int skip2,
+                                     ScanDiffTasks* tasks) const {
   // skip1: remove that much first bits from all keys in dictionary dict1 (its keys are actually n + skip1 bits long)
   // skip2: similar for dict2
   // pretending to compare subdictionaries with n-bit keys
+  if (tasks && total_key_len - n >= tasks->min_prefix_len) {
+    // deep enough, leave this pair of subdictionaries to a worker thread (see scan_diff_parallel)
+    if (dict1.is_null() && dict2.is_null()) {
+      return true;
+    }
+    if (dict1.not_null() && dict2.not_null() && skip1 == skip2 &&
+        (dict1 == dict2 || dict1->get_hash() == dict2->get_hash())) {
+      return true;
+    }
+    tasks->add_task(std::move(dict1), std::move(dict2), key_buffer, n, total_key_len, skip1, skip2);
+    return true;
+  }
   if (dict1.is_null()) {
     if (dict2.is_null()) {
       return true;  // both dictionaries are empty
@@ -2088,7 +2149,8 @@ bool DictionaryFixed::dict_scan_diff(Ref<Cell> dict1, Ref<Cell> dict2, td::BitPt
     // compare {} with each of children of dict2
     for (unsigned sw = 0; sw < 2; sw++) {
       key_buffer[-1] = (bool)sw;
-      if (!dict_scan_diff({}, label.remainder->prefetch_ref(sw), key_buffer, n, total_key_len, diff_func, mode)) {
+      if (!dict_scan_diff({}, label.remainder->prefetch_ref(sw), key_buffer, n, total_key_len, diff_func, mode, 0, 0,
+                          tasks)) {
         return false;
       }
     }
@@ -2115,7 +2177,8 @@ bool DictionaryFixed::dict_scan_diff(Ref<Cell> dict1, Ref<Cell> dict2, td::BitPt
     // compare each of children of dict1 with {}
     for (unsigned sw = 0; sw < 2; sw++) {
       key_buffer[-1] = (bool)sw;
-      if (!dict_scan_diff(label.remainder->prefetch_ref(sw), {}, key_buffer, n, total_key_len, diff_func, mode)) {
+      if (!dict_scan_diff(label.remainder->prefetch_ref(sw), {}, key_buffer, n, total_key_len, diff_func, mode, 0, 0,
+                          tasks)) {
         return false;
       }
     }
@@ -2138,12 +2201,16 @@ bool DictionaryFixed::dict_scan_diff(Ref<Cell> dict1, Ref<Cell> dict2, td::BitPt
     // the two dictionaries have disjoint keys
     if (!key_buffer[c]) {
       // all keys of dict1 are before dict2
-      return dict_scan_diff(std::move(dict1), {}, key_buffer - skip1, n + skip1, total_key_len, diff_func, mode) &&
-             dict_scan_diff({}, std::move(dict2), key_buffer - skip2, n + skip2, total_key_len, diff_func, mode);
+      return dict_scan_diff(std::move(dict1), {}, key_buffer - skip1, n + skip1, total_key_len, diff_func, mode, 0, 0,
+                            tasks) &&
+             dict_scan_diff({}, std::move(dict2), key_buffer - skip2, n + skip2, total_key_len, diff_func, mode, 0, 0,
+                            tasks);
     } else {
       // all keys of dict2 are before dict1
-      return dict_scan_diff({}, std::move(dict2), key_buffer - skip2, n + skip2, total_key_len, diff_func, mode) &&
-             dict_scan_diff(std::move(dict1), {}, key_buffer - skip1, n + skip1, total_key_len, diff_func, mode);
+      return dict_scan_diff({}, std::move(dict2), key_buffer - skip2, n + skip2, total_key_len, diff_func, mode, 0, 0,
+                            tasks) &&
+             dict_scan_diff(std::move(dict1), {}, key_buffer - skip1, n + skip1, total_key_len, diff_func, mode, 0, 0,
+                            tasks);
     }
   }
   if (c == l1 && c == l2) {
@@ -2176,7 +2243,7 @@ bool DictionaryFixed::dict_scan_diff(Ref<Cell> dict1, Ref<Cell> dict2, td::BitPt
       key_buffer[-1] = (bool)sw;
       // compare left and then right subtrees
       if (!dict_scan_diff(label1.remainder->prefetch_ref(sw), label2.remainder->prefetch_ref(sw), key_buffer, n,
-                          total_key_len, diff_func, mode)) {
+                          total_key_len, diff_func, mode, 0, 0, tasks)) {
         return false;
       }
     }
@@ -2201,15 +2268,15 @@ bool DictionaryFixed::dict_scan_diff(Ref<Cell> dict1, Ref<Cell> dict2, td::BitPt
     if (!sw) {
       // compare c1 with dict2, then c2 with {}
       return dict_scan_diff(std::move(c1), std::move(dict2), key_buffer, n, total_key_len, diff_func, mode, 0,
-                            skip2 + c + 1) &&
+                            skip2 + c + 1, tasks) &&
              set_bit(key_buffer - 1) &&
-             dict_scan_diff(std::move(c2), {}, key_buffer, n, total_key_len, diff_func, mode);
+             dict_scan_diff(std::move(c2), {}, key_buffer, n, total_key_len, diff_func, mode, 0, 0, tasks);
     } else {
       // compare c1 with {}, then c2 with dict2
-      return dict_scan_diff(std::move(c1), {}, key_buffer, n, total_key_len, diff_func, mode) &&
+      return dict_scan_diff(std::move(c1), {}, key_buffer, n, total_key_len, diff_func, mode, 0, 0, tasks) &&
              set_bit(key_buffer - 1) &&
              dict_scan_diff(std::move(c2), std::move(dict2), key_buffer, n, total_key_len, diff_func, mode, 0,
-                            skip2 + c + 1);
+                            skip2 + c + 1, tasks);
     }
   } else {
     assert(c == l2 && c < l1);
@@ -2230,15 +2297,15 @@ bool DictionaryFixed::dict_scan_diff(Ref<Cell> dict1, Ref<Cell> dict2, td::BitPt
     if (!sw) {
       // compare dict1 with c1, then {} with c2
       return dict_scan_diff(std::move(dict1), std::move(c1), key_buffer, n, total_key_len, diff_func, mode,
-                            skip1 + c + 1, 0) &&
+                            skip1 + c + 1, 0, tasks) &&
              set_bit(key_buffer - 1) &&
-             dict_scan_diff({}, std::move(c2), key_buffer, n, total_key_len, diff_func, mode);
+             dict_scan_diff({}, std::move(c2), key_buffer, n, total_key_len, diff_func, mode, 0, 0, tasks);
     } else {
       // compare {} with c1, then dict1 with c2
-      return dict_scan_diff({}, std::move(c1), key_buffer, n, total_key_len, diff_func, mode) &&
+      return dict_scan_diff({}, std::move(c1), key_buffer, n, total_key_len, diff_func, mode, 0, 0, tasks) &&
              set_bit(key_buffer - 1) &&
              dict_scan_diff(std::move(dict1), std::move(c2), key_buffer, n, total_key_len, diff_func, mode,
-                            skip1 + c + 1, 0);
+                            skip1 + c + 1, 0, tasks);
     }
   }
 }
@@ -2259,6 +2326,287 @@ bool DictionaryFixed::scan_diff(DictionaryFixed& dict2, const scan_diff_func_t&
   }
 }
 
+namespace {
+
+int parallel_threads(int threads) {
+  return threads > 0 ? threads : (int)td::ParallelPool::max_threads() + 1;
+}
+
+// number of extra key bits to split on so that each thread gets several subtrees
+int parallel_split_bits(int threads) {
+  return 32 - td::count_leading_zeroes32(threads * 8 - 1);
+}
+
+// length of the common prefix of all keys present in either of the two dictionaries
+int common_prefix_len(DictionaryFixed& dict1, DictionaryFixed& dict2, td::BitPtr buffer, int key_len) {
+  if (dict1.is_empty()) {
+    return dict2.get_common_prefix(buffer, key_len);
+  }
+  int l1 = dict1.get_common_prefix(buffer, key_len);
+  if (dict2.is_empty()) {
+    return l1;
+  }
+  unsigned char buffer2[DictionaryBase::max_key_bytes];
+  int l2 = dict2.get_common_prefix(td::BitPtr{buffer2}, key_len);
+  std::size_t same_upto = 0;
+  td::bitstring::bits_memcmp(buffer, td::ConstBitPtr{buffer2}, std::min(l1, l2), &same_upto);
+  return (int)same_upto;
+}
+
+}  // namespace
+
+bool DictionaryFixed::scan_diff_parallel(DictionaryFixed& dict2, const scan_diff_func_t& diff_func, int check_augm,
+                                         int threads) {
+  threads = parallel_threads(threads);
+  if (threads <= 1) {
+    return scan_diff(dict2, diff_func, check_augm);
+  }
+  force_validate();
+  dict2.force_validate();
+  int key_len = get_key_bits();
+  if (key_len != dict2.get_key_bits()) {
+    throw VmError{Excno::dict_err, "cannot compare dictionaries with different key lengths"};
+  }
+  unsigned char key_buffer[max_key_bytes];
+  int prefix_len = common_prefix_len(*this, dict2, td::BitPtr{key_buffer}, key_len);
+  ScanDiffTasks tasks{std::min(key_len, prefix_len + parallel_split_bits(threads)), key_len};
+  // upper phase: walk both trees down to min_prefix_len, recording differing subtrees and diffs found on the way
+  try {
+    dict_scan_diff(
+        get_root_cell(), dict2.get_root_cell(), td::BitPtr{key_buffer}, key_len, key_len,
+        [&tasks](td::ConstBitPtr key, int key_len, Ref<CellSlice> value1, Ref<CellSlice> value2) {
+          return tasks.add_diff(key, key_len, std::move(value1), std::move(value2));
+        },
+        check_augm, 0, 0, &tasks);
+  } catch (...) {
+    tasks.tasks.emplace_back();
+    tasks.tasks.back().error = std::current_exception();
+  }
+  // lower phase: compare the recorded subtrees concurrently, collecting their diffs
+  td::ParallelPool::run(
+      tasks.tasks.size(),
+      [&](std::size_t task_id) {
+        auto& task = tasks.tasks[task_id];
+        if (task.dict1.is_null() && task.dict2.is_null()) {
+          return;
+        }
+        unsigned char buffer[max_key_bytes];
+        std::memcpy(buffer, task.key_prefix.data(), tasks.key_bytes);
+        try {
+          dict_scan_diff(
+              std::move(task.dict1), std::move(task.dict2), td::BitPtr{buffer} + (key_len - task.n), task.n, key_len,
+              [&task, key_bytes = tasks.key_bytes](td::ConstBitPtr key, int key_len, Ref<CellSlice> value1,
+                                                   Ref<CellSlice> value2) {
+                return ScanDiffTasks::add_diff(task, key_bytes, key, key_len, std::move(value1), std::move(value2));
+              },
+              check_augm, task.skip1, task.skip2);
+        } catch (...) {
+          task.error = std::current_exception();
+        }
+      },
+      std::min<std::size_t>(threads, std::max<std::size_t>(tasks.tasks.size(), 1)) - 1);
+  // replay all diffs on the calling thread in key order
+  try {
+    for (auto& task : tasks.tasks) {
+      for (auto& diff : task.diffs) {
+        if (!diff_func(td::ConstBitPtr{(const unsigned char*)diff.key.data()}, key_len, std::move(diff.value1),
+                       std::move(diff.value2))) {
+          return false;
+        }
+      }
+      if (task.error) {
+        std::rethrow_exception(task.error);
+      }
+    }
+    return true;
+  } catch (CombineError) {
+    return false;
+  }
+}
+
+// builds a subtree with n-bit keys from the set operations of ops (deletions are ignored)
+Ref<Cell> DictionaryFixed::dict_build_batch(int n, td::Span<BatchOp> ops, int offs) const {
+  std::size_t first = 0, last = ops.size();
+  while (first < last && ops[first].value.is_null()) {
+    ++first;
+  }
+  while (first < last && ops[last - 1].value.is_null()) {
+    --last;
+  }
+  if (first == last) {
+    return {};
+  }
+  CellBuilder cb;
+  td::ConstBitPtr key = ops[first].key + offs;
+  if (first + 1 == last) {
+    append_dict_label(cb, key, n, n);
+    return finish_create_leaf(cb, *ops[first].value);
+  }
+  // all keys between the first and the last one share their common prefix, the fork is right after it
+  std::size_t same = 0;
+  td::bitstring::bits_memcmp(key, ops[last - 1].key + offs, n, &same);
+  int pfx_len = (int)same;
+  assert(pfx_len < n);
+  std::size_t mid = first + 1;
+  while (!ops[mid].key[offs + pfx_len]) {
+    ++mid;
+  }
+  auto c1 = dict_build_batch(n - pfx_len - 1, ops.substr(first, mid - first), offs + pfx_len + 1);
+  auto c2 = dict_build_batch(n - pfx_len - 1, ops.substr(mid, last - mid), offs + pfx_len + 1);
+  append_dict_label(cb, key, pfx_len, n);
+  return finish_create_fork(cb, std::move(c1), std::move(c2), n - pfx_len);
+}
+
+// creates a node with label prefix + (label of node without its first node.skip bits) and the payload of node
+Ref<Cell> DictionaryFixed::dict_relabel_batch(BatchNode node, td::ConstBitPtr prefix, int prefix_len, int n) const {
+  if (!prefix_len && !node.skip) {
+    return std::move(node.cell);
+  }
+  LabelParser label{std::move(node.cell), n - prefix_len + node.skip, label_mode()};
+  unsigned char old_label[max_key_bytes];
+  int old_len = label.extract_label_to(td::BitPtr{old_label});
+  assert(old_len >= node.skip);
+  unsigned char buffer[max_key_bytes];
+  td::BitPtr bw{buffer};
+  bw.concat(prefix, prefix_len);
+  bw.concat(td::ConstBitPtr{old_label} + node.skip, old_len - node.skip);
+  CellBuilder cb;
+  append_dict_label(cb, td::ConstBitPtr{buffer}, bw.offs, n);
+  if (!cell_builder_add_slice_bool(cb, *label.remainder)) {
+    throw VmError{Excno::cell_ov, "cannot change label of an old dictionary cell while applying a batch"};
+  }
+  return cb.finalize();
+}
+
+// creates a fork with the given label and children, or merges the label with the only non-empty child
+DictionaryFixed::BatchNode DictionaryFixed::dict_join_batch(td::ConstBitPtr label, int label_len, BatchNode left,
+                                                            BatchNode right, int n) const {
+  if (left.cell.not_null() && right.cell.not_null()) {
+    int m = n - label_len - 1;
+    auto c1 = dict_relabel_batch(std::move(left), td::ConstBitPtr{nullptr}, 0, m);
+    auto c2 = dict_relabel_batch(std::move(right), td::ConstBitPtr{nullptr}, 0, m);
+    CellBuilder cb;
+    append_dict_label(cb, label, label_len, n);
+    return {finish_create_fork(cb, std::move(c1), std::move(c2), n - label_len), 0};
+  }
+  if (left.cell.is_null() && right.cell.is_null()) {
+    return {};
+  }
+  bool sw_bit = left.cell.is_null();
+  unsigned char buffer[max_key_bytes];
+  td::BitPtr bw{buffer};
+  bw.concat(label, label_len);
+  bw.concat_same(sw_bit, 1);
+  return {dict_relabel_batch(sw_bit ? std::move(right) : std::move(left), td::ConstBitPtr{buffer}, bw.offs, n), 0};
+}
+
+// applies ops (all sharing the first offs key bits, which lead to node) to the subtree at node with n-bit keys
+DictionaryFixed::BatchNode DictionaryFixed::dict_apply_batch(BatchNode node, int n, td::Span<BatchOp> ops, int offs,
+                                                             bool& changed) const {
+  if (ops.empty()) {
+    return node;
+  }
+  if (node.cell.is_null()) {
+    auto cell = dict_build_batch(n, ops, offs);
+    changed |= cell.not_null();
+    return {std::move(cell), 0};
+  }
+  LabelParser label{node.cell, n + node.skip, label_mode()};
+  unsigned char label_buffer[max_key_bytes];
+  label.copy_label_prefix_to(td::BitPtr{label_buffer}, label.l_bits);
+  td::ConstBitPtr node_label = td::ConstBitPtr{label_buffer} + node.skip;
+  int l = label.l_bits - node.skip;
+  // ops inside the subtree (matching its whole label) form a contiguous range;
+  // a new key outside of it splits the label at its first mismatching bit
+  std::size_t begin = ops.size(), end = 0;
+  int split = l;
+  for (std::size_t i = 0; i < ops.size(); i++) {
+    std::size_t same = 0;
+    if (!td::bitstring::bits_memcmp(ops[i].key + offs, node_label, l, &same)) {
+      begin = std::min(begin, i);
+      end = i + 1;
+    } else if (ops[i].value.not_null()) {
+      split = std::min(split, (int)same);
+    }
+  }
+  if (split == l) {
+    // only keys inside the subtree are set, keys outside of it are only deleted and thus are absent
+    if (begin >= end) {
+      return node;
+    }
+    ops = ops.substr(begin, end - begin);
+    if (l == n) {
+      // the edge leads to a leaf, which is the only key left in ops
+      assert(ops.size() == 1);
+      changed = true;
+      if (ops[0].value.is_null()) {
+        return {};
+      }
+      CellBuilder cb;
+      append_dict_label(cb, node_label, n, n);
+      return {finish_create_leaf(cb, *ops[0].value), 0};
+    }
+    std::size_t mid = 0;
+    while (mid < ops.size() && !ops[mid].key[offs + l]) {
+      ++mid;
+    }
+    bool changed1 = false, changed2 = false;
+    auto c1 = dict_apply_batch({label.remainder->prefetch_ref(0), 0}, n - l - 1, ops.substr(0, mid), offs + l + 1,
+                               changed1);
+    auto c2 = dict_apply_batch({label.remainder->prefetch_ref(1), 0}, n - l - 1, ops.substr(mid), offs + l + 1,
+                               changed2);
+    if (!changed1 && !changed2) {
+      return node;
+    }
+    changed = true;
+    return dict_join_batch(node_label, l, std::move(c1), std::move(c2), n);
+  }
+  // a new fork is inserted into the edge after its first split bits; the old node continues on the side of its label
+  changed = true;
+  bool sw_bit = node_label[split];
+  std::size_t old_begin = ops.size(), old_end = 0, new_begin = ops.size(), new_end = 0;
+  for (std::size_t i = 0; i < ops.size(); i++) {
+    if (td::bitstring::bits_memcmp(ops[i].key + offs, node_label, split)) {
+      // deletion of a key diverging from the label even earlier
+      continue;
+    }
+    if (ops[i].key[offs + split] == sw_bit) {
+      old_begin = std::min(old_begin, i);
+      old_end = i + 1;
+    } else {
+      new_begin = std::min(new_begin, i);
+      new_end = i + 1;
+    }
+  }
+  bool old_changed = false;
+  auto old_ops = old_begin < old_end ? ops.substr(old_begin, old_end - old_begin) : td::Span<BatchOp>{};
+  auto old_node = dict_apply_batch({std::move(node.cell), node.skip + split + 1}, n - split - 1, old_ops,
+                                   offs + split + 1, old_changed);
+  BatchNode new_node{dict_build_batch(n - split - 1, ops.substr(new_begin, new_end - new_begin), offs + split + 1), 0};
+  if (sw_bit) {
+    return dict_join_batch(node_label, split, std::move(new_node), std::move(old_node), n);
+  } else {
+    return dict_join_batch(node_label, split, std::move(old_node), std::move(new_node), n);
+  }
+}
+
+bool DictionaryFixed::apply_batch(td::Span<BatchOp> ops) {
+  force_validate();
+  int key_len = get_key_bits();
+  for (std::size_t i = 0; i < ops.size(); i++) {
+    if (ops[i].key.ptr == nullptr ||
+        (i > 0 && td::bitstring::bits_memcmp(ops[i - 1].key, ops[i].key, key_len) >= 0)) {
+      return false;
+    }
+  }
+  bool changed = false;
+  auto res = dict_apply_batch({get_root_cell(), 0}, key_len, ops, 0, changed);
+  if (changed) {
+    set_root_cell(dict_relabel_batch(std::move(res), td::ConstBitPtr{nullptr}, 0, key_len));
+  }
+  return true;
+}
+
 bool DictionaryFixed::dict_validate_check(Ref<Cell> dict, td::BitPtr key_buffer, int n, int total_key_len,
                                           const DictionaryFixed::foreach_func_t& foreach_func,
                                           bool invert_first) const {
@@ -229,6 +229,19 @@ class DictionaryFixed : public DictionaryBase {
   bool combine_with(DictionaryFixed& dict2, const simple_combine_func_t& simple_combine_func, int mode = 0);
   bool combine_with(DictionaryFixed& dict2);
   bool scan_diff(DictionaryFixed& dict2, const scan_diff_func_t& diff_func, int check_augm = 0);
+  // same as scan_diff(), but differing subtrees are compared by up to `threads` threads, the calling one and
+  // those of td::ParallelPool (0 = all of them); diff_func is still invoked from the calling thread, in the same
+  // order as by scan_diff()
+  bool scan_diff_parallel(DictionaryFixed& dict2, const scan_diff_func_t& diff_func, int check_augm = 0,
+                          int threads = 0);
+  // one operation of apply_batch(): sets the value of key (key_bits bits long), or deletes key if value is null
+  struct BatchOp {
+    td::ConstBitPtr key;
+    Ref<CellSlice> value;
+  };
+  // applies operations with strictly increasing keys; unlike a sequence of set() / lookup_delete() calls,
+  // each affected node is rebuilt (and its augmentation recomputed) only once
+  bool apply_batch(td::Span<BatchOp> ops);
   bool validate_check(const foreach_func_t& foreach_func, bool invert_first = false);
   bool validate_all();
   DictIterator null_iterator();
@@ -286,6 +299,7 @@ class DictionaryFixed : public DictionaryBase {
   friend class DictIterator;
 
  private:
+  struct ScanDiffTasks;
   std::pair<Ref<CellSlice>, Ref<Cell>> dict_lookup_delete(Ref<Cell> dict, td::ConstBitPtr key, int n) const;
   Ref<CellSlice> dict_lookup_minmax(Ref<Cell> dict, td::BitPtr key_buffer, int n, int mode) const;
   Ref<CellSlice> dict_lookup_nearest(Ref<Cell> dict, td::BitPtr key_buffer, int n, bool allow_eq, int mode) const;
@@ -298,9 +312,19 @@ class DictionaryFixed : public DictionaryBase {
   Ref<Cell> dict_combine_with(Ref<Cell> dict1, Ref<Cell> dict2, td::BitPtr key_buffer, int n, int total_key_len,
                               const combine_func_t& combine_func, int mode = 0, int skip1 = 0, int skip2 = 0) const;
   bool dict_scan_diff(Ref<Cell> dict1, Ref<Cell> dict2, td::BitPtr key_buffer, int n, int total_key_len,
-                      const scan_diff_func_t& diff_func, int mode = 0, int skip1 = 0, int skip2 = 0) const;
+                      const scan_diff_func_t& diff_func, int mode = 0, int skip1 = 0, int skip2 = 0,
+                      ScanDiffTasks* tasks = nullptr) const;
   bool dict_validate_check(Ref<Cell> dict, td::BitPtr key_buffer, int n, int total_key_len,
                            const foreach_func_t& foreach_func, bool invert_first = false) const;
+  // a subtree built by apply_batch(): `cell` with the first `skip` bits of its label removed
+  struct BatchNode {
+    Ref<Cell> cell;
+    int skip{0};
+  };
+  BatchNode dict_apply_batch(BatchNode node, int n, td::Span<BatchOp> ops, int offs, bool& changed) const;
+  Ref<Cell> dict_build_batch(int n, td::Span<BatchOp> ops, int offs) const;
+  BatchNode dict_join_batch(td::ConstBitPtr label, int label_len, BatchNode left, BatchNode right, int n) const;
+  Ref<Cell> dict_relabel_batch(BatchNode node, td::ConstBitPtr prefix, int prefix_len, int n) const;
 };
 
 class DictIterator {
@@ -466,10 +466,18 @@ td::RefInt256 Stack::pop_int_finite() {
 }
 
 bool Stack::pop_bool() {
+  check_underflow(1);
+  if (tos().is_small_int()) {
+    return pop().get_small_int() != 0;
+  }
   return sgn(pop_int_finite()) != 0;
 }
 
 long long Stack::pop_long() {
+  check_underflow(1);
+  if (tos().is_small_int()) {
+    return pop().get_small_int();
+  }
   return pop_int()->to_long();
 }
 
@@ -666,7 +674,7 @@ void Stack::push_builder(Ref<CellBuilder> cb) {
 }
 
 void Stack::push_smallint(long long val) {
-  push(td::make_refint(val));
+  push(StackEntry::make_small_int(val));
 }
 
 void Stack::push_bool(bool val) {
@@ -89,6 +89,9 @@ class StackEntry {
  private:
   RefAny ref;
   Type tp;
+  // integers fitting into 64 bits are kept inline in small_int with a null ref, see make_small_int()
+  bool is_small{false};
+  long long small_int{0};
 
  public:
   StackEntry() : ref(), tp(t_null) {
@@ -116,10 +119,12 @@ class StackEntry {
   StackEntry(const std::vector<StackEntry>& tuple_components);
   StackEntry(std::vector<StackEntry>&& tuple_components);
   StackEntry(Ref<Atom> atom_ref);
-  StackEntry(const StackEntry& se) : ref(se.ref), tp(se.tp) {
+  StackEntry(const StackEntry& se) : ref(se.ref), tp(se.tp), is_small(se.is_small), small_int(se.small_int) {
   }
-  StackEntry(StackEntry&& se) noexcept : ref(std::move(se.ref)), tp(se.tp) {
+  StackEntry(StackEntry&& se) noexcept
+      : ref(std::move(se.ref)), tp(se.tp), is_small(se.is_small), small_int(se.small_int) {
     se.tp = t_null;
+    se.is_small = false;
   }
   template <class T>
   StackEntry(from_object_t, Ref<T> obj_ref) : ref(std::move(obj_ref)), tp(t_object) {
@@ -127,22 +132,42 @@ class StackEntry {
   StackEntry& operator=(const StackEntry& se) {
     ref = se.ref;
     tp = se.tp;
+    is_small = se.is_small;
+    small_int = se.small_int;
     return *this;
   }
   StackEntry& operator=(StackEntry&& se) {
     ref = std::move(se.ref);
     tp = se.tp;
+    is_small = se.is_small;
+    small_int = se.small_int;
     se.tp = t_null;
+    se.is_small = false;
     return *this;
   }
   StackEntry& clear() {
     ref.clear();
     tp = t_null;
+    is_small = false;
     return *this;
   }
   bool set_int(td::RefInt256 value) {
     return set(t_int, std::move(value));
   }
+  // an integer entry without a heap-allocated BigInt256; as_int() allocates one on demand
+  static StackEntry make_small_int(long long value) {
+    StackEntry res;
+    res.tp = t_int;
+    res.is_small = true;
+    res.small_int = value;
+    return res;
+  }
+  bool is_small_int() const {
+    return is_small;
+  }
+  long long get_small_int() const {
+    return small_int;
+  }
   bool empty() const {
     return tp == t_null;
   }
@@ -173,12 +198,14 @@ class StackEntry {
   void swap(StackEntry& se) {
     ref.swap(se.ref);
     std::swap(tp, se.tp);
+    std::swap(is_small, se.is_small);
+    std::swap(small_int, se.small_int);
   }
   bool operator==(const StackEntry& other) const {
-    return tp == other.tp && ref == other.ref;
+    return tp == other.tp && is_small == other.is_small && (is_small ? small_int == other.small_int : ref == other.ref);
   }
   bool operator!=(const StackEntry& other) const {
-    return !(tp == other.tp && ref == other.ref);
+    return !(*this == other);
   }
   Type type() const {
     return tp;
@@ -216,6 +243,7 @@ class StackEntry {
   }
   bool set(Type _tp, RefAny _ref) {
     tp = _tp;
+    is_small = false;
     ref = std::move(_ref);
     return ref.not_null() || tp == t_null;
   }
@@ -236,10 +264,10 @@ class StackEntry {
     }
   }
   td::RefInt256 as_int() const& {
-    return as<td::CntInt256, t_int>();
+    return is_small ? td::make_refint(small_int) : as<td::CntInt256, t_int>();
   }
   td::RefInt256 as_int() && {
-    return move_as<td::CntInt256, t_int>();
+    return is_small ? td::make_refint(small_int) : move_as<td::CntInt256, t_int>();
   }
   Ref<Cell> as_cell() const& {
     return as<Cell, t_cell>();
@@ -119,6 +119,22 @@ QueryInfo get_query_info(const lite_api::Function& f) {
                          info.type = QueryInfo::t_simple;
                        }
                      },
+                     [&](const lite_api::liteServer_getAccountStates& q) {
+                       BlockIdExt block_id = create_block_id(q.id_);
+                       if (!q.accounts_.empty()) {
+                         info.shard_id = extract_addr_prefix(q.workchain_, q.accounts_[0]).as_leaf_shard();
+                       }
+                       // See LiteQuery::perform_getAccountState
+                       if (block_id.id.workchain != masterchainId) {
+                         info.type = QueryInfo::t_seqno;
+                         info.value = block_id.seqno();
+                       } else if (block_id.id.seqno != ~0U) {
+                         info.type = QueryInfo::t_mc_seqno;
+                         info.value = block_id.seqno();
+                       } else {
+                         info.type = QueryInfo::t_simple;
+                       }
+                     },
                      [&](const lite_api::liteServer_getOneTransaction& q) { from_block_id(q.id_); },
                      [&](const lite_api::liteServer_getTransactions& q) {
                        AccountIdPrefixFull acc_id_prefix = extract_addr_prefix(q.account_->workchain_, q.account_->id_);
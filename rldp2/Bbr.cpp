@@ -43,7 +43,7 @@ void Bbr::step(const RttStats &rtt_stats, const BdwStats &bdw_stats, td::uint64
   if (state_ == State::Drain && (double)in_flight < bdw_max_ * rtt_min_) {
     //LOG(ERROR) << "DRAIN -> BPROBE BDW";
     state_ = State::ProbeBdw;
-    probe_bdw_cycle_ = td::Random::fast(1, 5);
+    probe_bdw_cycle_ = rnd_ ? rnd_->fast(1, 5) : td::Random::fast(1, 5);
     probe_bdw_cycle_at_ = now;
   }
 
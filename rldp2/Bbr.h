@@ -19,6 +19,7 @@
 
 #pragma once
 #include "td/utils/int_types.h"
+#include "td/utils/Random.h"
 #include "td/utils/Time.h"
 
 namespace ton {
@@ -33,7 +34,13 @@ struct Bbr {
 
   td::uint32 get_window_size() const;
 
+  // source of the probe cycle phase, td::Random::fast() if not set; used to make simulations reproducible
+  void set_random(td::Random::Xorshift128plus *rnd) {
+    rnd_ = rnd;
+  }
+
  private:
+  td::Random::Xorshift128plus *rnd_{nullptr};
   double bdw_peak_{-1};
   td::uint32 bdw_peak_at_round{0};
   td::uint32 probe_bdw_cycle_{0};
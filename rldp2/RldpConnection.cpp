@@ -102,8 +102,8 @@ void RldpConnection::set_receive_limits(TransferId transfer_id, td::Timestamp ti
   add_limit(timeout, limit);
 }
 
-RldpConnection::RldpConnection() {
-  bdw_stats_.on_update(td::Timestamp::now(), 0);
+RldpConnection::RldpConnection(td::Timestamp now) {
+  bdw_stats_.on_update(now, 0);
 
   rtt_stats_.windowed_min_rtt = 0.5;
   bdw_stats_.windowed_max_bdw = 10;
@@ -129,16 +129,16 @@ void RldpConnection::send(TransferId transfer_id, td::BufferSlice data, td::Time
   outbound_transfers_.emplace(transfer_id, OutboundTransfer{std::move(data)});
 }
 
-void RldpConnection::receive_raw(td::BufferSlice packet) {
+void RldpConnection::receive_raw(td::BufferSlice packet, td::Timestamp now) {
   auto F = ton::fetch_tl_object<ton::ton_api::rldp2_MessagePart>(std::move(packet), true);
   if (F.is_error()) {
     return;
   }
-  downcast_call(*F.move_as_ok(), [&](auto &obj) { this->receive_raw_obj(obj); });
+  downcast_call(*F.move_as_ok(), [&](auto &obj) { this->receive_raw_obj(obj, now); });
 }
 
 void RldpConnection::loop_bbr(td::Timestamp now) {
-  bbr_.step(rtt_stats_, bdw_stats_, in_flight_count_, td::Timestamp::now());
+  bbr_.step(rtt_stats_, bdw_stats_, in_flight_count_, now);
   //LOG(ERROR) << td::format::as_time(rtt_stats_.windowed_min_rtt) << " "
   //<< td::format::as_size((td::int64)bdw_stats_.windowed_max_bdw * 768) << " " << rtt_stats_.rtt_round;
   double speed = bbr_.get_rate();
@@ -148,8 +148,7 @@ void RldpConnection::loop_bbr(td::Timestamp now) {
   congestion_window_ = congestion_window;
 }
 
-td::Timestamp RldpConnection::run(ConnectionCallback &callback) {
-  auto now = td::Timestamp::now();
+td::Timestamp RldpConnection::run(ConnectionCallback &callback, td::Timestamp now) {
   loop_bbr(now);
 
   td::Timestamp alarm_timestamp;
@@ -175,10 +174,10 @@ td::Timestamp RldpConnection::run(ConnectionCallback &callback) {
   }
 
   for (auto &inbound : inbound_transfers_) {
-    alarm_timestamp.relax(run(inbound.first, inbound.second));
+    alarm_timestamp.relax(run(inbound.first, inbound.second, now));
   }
 
-  alarm_timestamp.relax(loop_limits(td::Timestamp::now()));
+  alarm_timestamp.relax(loop_limits(now));
 
   for (auto &data : to_receive_) {
     callback.receive(data.first, std::move(data.second));
@@ -196,20 +195,20 @@ td::Timestamp RldpConnection::run(ConnectionCallback &callback) {
   return alarm_timestamp;
 }
 
-td::Timestamp RldpConnection::run(const TransferId &transfer_id, InboundTransfer &inbound) {
+td::Timestamp RldpConnection::run(const TransferId &transfer_id, InboundTransfer &inbound, td::Timestamp now) {
   td::Timestamp wakeup_at;
   bool has_actions = true;
   while (has_actions) {
     has_actions = false;
     for (auto &it : inbound.parts()) {
       auto &inbound = it.second;
-      inbound.receiver.next_action(td::Timestamp::now())
+      inbound.receiver.next_action(now)
           .visit(td::overloaded([&](const RldpReceiver::ActionWait &wait) { wakeup_at.relax(wait.wait_till); },
                                 [&](const RldpReceiver::ActionSendAck &send) {
                                   send_packet(ton::create_serialize_tl_object<ton::ton_api::rldp2_confirm>(
                                       transfer_id, it.first, send.ack.max_seqno, send.ack.received_mask,
                                       send.ack.received_count));
-                                  inbound.receiver.on_ack_sent(td::Timestamp::now());
+                                  inbound.receiver.on_ack_sent(now);
                                   has_actions = true;
                                 }));
     }
@@ -265,7 +264,7 @@ td::optional<td::Timestamp> RldpConnection::step(const TransferId &transfer_id,
   return wakeup_at;
 }
 
-void RldpConnection::receive_raw_obj(ton::ton_api::rldp2_messagePart &part) {
+void RldpConnection::receive_raw_obj(ton::ton_api::rldp2_messagePart &part, td::Timestamp now) {
   if (completed_set_.count(part.transfer_id_) > 0) {
     send_packet(ton::create_serialize_tl_object<ton::ton_api::rldp2_complete>(part.transfer_id_, part.part_));
     return;
@@ -303,7 +302,7 @@ void RldpConnection::receive_raw_obj(ton::ton_api::rldp2_messagePart &part) {
     if (!has_limit) {
       // set timeout even for small inbound queries
       // TODO: other party stil may ddos us with small transfers
-      set_receive_limits(transfer_id, td::Timestamp::in(10), max_size);
+      set_receive_limits(transfer_id, td::Timestamp::in(10, now), max_size);
     }
     it = inbound_transfers_.emplace(transfer_id, InboundTransfer{total_size}).first;
   }
@@ -317,7 +316,7 @@ void RldpConnection::receive_raw_obj(ton::ton_api::rldp2_messagePart &part) {
       }
       return {};
     }
-    if (in_part->receiver.on_received(part.seqno_ + 1, td::Timestamp::now())) {
+    if (in_part->receiver.on_received(part.seqno_ + 1, now)) {
       TRY_STATUS_PREFIX(in_part->decoder->add_symbol({static_cast<td::uint32>(part.seqno_), std::move(part.data_)}),
                         td::Status::Error(ErrorCode::protoviolation, "invalid symbol"));
       if (in_part->decoder->may_try_decode()) {
@@ -332,12 +331,12 @@ void RldpConnection::receive_raw_obj(ton::ton_api::rldp2_messagePart &part) {
 
   if (o_res) {
     drop_limits(transfer_id);
-    on_inbound_completed(transfer_id, td::Timestamp::now());
+    on_inbound_completed(transfer_id, now);
     to_receive_.emplace_back(transfer_id, o_res.unwrap());
   }
 }
 
-void RldpConnection::receive_raw_obj(ton::ton_api::rldp2_complete &complete) {
+void RldpConnection::receive_raw_obj(ton::ton_api::rldp2_complete &complete, td::Timestamp now) {
   auto transfer_id = complete.transfer_id_;
   auto it = outbound_transfers_.find(transfer_id);
   if (it == outbound_transfers_.end()) {
@@ -357,7 +356,7 @@ void RldpConnection::receive_raw_obj(ton::ton_api::rldp2_complete &complete) {
   }
 }
 
-void RldpConnection::receive_raw_obj(ton::ton_api::rldp2_confirm &confirm) {
+void RldpConnection::receive_raw_obj(ton::ton_api::rldp2_confirm &confirm, td::Timestamp now) {
   auto transfer_id = confirm.transfer_id_;
   auto it = outbound_transfers_.find(transfer_id);
   if (it == outbound_transfers_.end()) {
@@ -372,7 +371,7 @@ void RldpConnection::receive_raw_obj(ton::ton_api::rldp2_confirm &confirm) {
   ack.max_seqno = confirm.max_seqno_;
   ack.received_count = confirm.received_count_;
   ack.received_mask = confirm.received_mask_;
-  auto update = part->sender.on_ack(ack, 0, td::Timestamp::now(), rtt_stats_, bdw_stats_, loss_stats_);
+  auto update = part->sender.on_ack(ack, 0, now, rtt_stats_, bdw_stats_, loss_stats_);
   // update.new_received event
   // update.o_loss_at event
 }
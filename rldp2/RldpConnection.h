@@ -48,15 +48,15 @@ class ConnectionCallback {
 
 class RldpConnection {
  public:
-  RldpConnection();
+  explicit RldpConnection(td::Timestamp now = td::Timestamp::now());
   RldpConnection(RldpConnection &&other) = delete;
   RldpConnection &operator=(RldpConnection &&other) = delete;
   void send(TransferId tranfer_id, td::BufferSlice data, td::Timestamp timeout = td::Timestamp::never());
   void set_receive_limits(TransferId transfer_id, td::Timestamp timeout, td::uint64 max_size);
 
-  void receive_raw(td::BufferSlice packet);
+  void receive_raw(td::BufferSlice packet, td::Timestamp now = td::Timestamp::now());
 
-  td::Timestamp run(ConnectionCallback &callback);
+  td::Timestamp run(ConnectionCallback &callback, td::Timestamp now = td::Timestamp::now());
 
   void set_default_mtu(td::uint64 mtu) {
     default_mtu_ = mtu;
@@ -64,6 +64,9 @@ class RldpConnection {
   td::uint64 default_mtu() const {
     return default_mtu_;
   }
+  void set_random(td::Random::Xorshift128plus *rnd) {
+    bbr_.set_random(rnd);
+  }
 
  private:
   td::uint64 default_mtu_ = 7680;
@@ -113,7 +116,7 @@ class RldpConnection {
     to_send_raw_.push_back(std::move(packet));
   };
 
-  td::Timestamp run(const TransferId &transfer_id, InboundTransfer &inbound);
+  td::Timestamp run(const TransferId &transfer_id, InboundTransfer &inbound, td::Timestamp now);
   struct Guard {
     td::uint32 &in_flight_count;
     const RldpSender &sender;
@@ -128,11 +131,11 @@ class RldpConnection {
 
   td::optional<td::Timestamp> step(const TransferId &transfer_id, OutboundTransfer &outbound, td::Timestamp now);
 
-  void receive_raw_obj(ton::ton_api::rldp2_messagePart &part);
+  void receive_raw_obj(ton::ton_api::rldp2_messagePart &part, td::Timestamp now);
 
-  void receive_raw_obj(ton::ton_api::rldp2_complete &part);
+  void receive_raw_obj(ton::ton_api::rldp2_complete &part, td::Timestamp now);
 
-  void receive_raw_obj(ton::ton_api::rldp2_confirm &part);
+  void receive_raw_obj(ton::ton_api::rldp2_confirm &part, td::Timestamp now);
 };
 }  // namespace rldp2
 }  // namespace ton
@@ -0,0 +1,514 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+
+// Deterministic network simulator for rldp2 congestion control.
+//
+// Drives pairs of RldpConnection through a virtual clock over a shared bottleneck link with configurable
+// bandwidth, rtt, loss and reordering, and reports goodput, retransmission overhead and time to first byte.
+// Nothing here touches real time or real sockets, so runs with the same options are directly comparable.
+
+#include "rldp2/RldpConnection.h"
+
+#include "auto/tl/ton_api.h"
+
+#include "td/utils/as.h"
+#include "td/utils/format.h"
+#include "td/utils/logging.h"
+#include "td/utils/misc.h"
+#include "td/utils/OptionParser.h"
+#include "td/utils/port/signals.h"
+#include "td/utils/Random.h"
+
+#include <cmath>
+#include <iostream>
+#include <map>
+
+namespace ton {
+namespace rldp2 {
+namespace sim {
+
+struct LinkOptions {
+  double bandwidth{12.5e6};        // bytes per second
+  double rtt{0.1};                 // seconds, split evenly between both directions
+  double loss{0};                  // probability of dropping a datagram
+  double reorder{0};               // probability of delaying a datagram by up to one rtt
+  td::uint64 queue_size{1 << 20};  // bytes buffered in front of the link before tail drop
+};
+
+struct Options {
+  LinkOptions link;
+  td::uint32 flows{1};
+  td::uint32 transfers{4};
+  td::uint64 transfer_size{1 << 20};
+  double time_limit{600};
+  td::uint64 seed{1};
+};
+
+class Link {
+ public:
+  Link(const LinkOptions &options, td::Random::Xorshift128plus &rnd) : options_(options), rnd_(rnd) {
+  }
+
+  // returns arrival time of the datagram or nothing if it is lost
+  td::optional<double> transmit(double now, size_t size) {
+    sent_packets_++;
+    if (options_.loss > 0 && random_double() < options_.loss) {
+      lost_packets_++;
+      return {};
+    }
+    double start_at = std::max(now, busy_till_);
+    if ((start_at - now) * options_.bandwidth > static_cast<double>(options_.queue_size)) {
+      dropped_packets_++;
+      return {};
+    }
+    busy_till_ = start_at + static_cast<double>(size) / options_.bandwidth;
+    double arrive_at = busy_till_ + options_.rtt * 0.5;
+    if (options_.reorder > 0 && random_double() < options_.reorder) {
+      reordered_packets_++;
+      arrive_at += random_double() * options_.rtt;
+    }
+    return arrive_at;
+  }
+
+  td::uint64 sent_packets() const {
+    return sent_packets_;
+  }
+  td::uint64 lost_packets() const {
+    return lost_packets_;
+  }
+  td::uint64 dropped_packets() const {
+    return dropped_packets_;
+  }
+  td::uint64 reordered_packets() const {
+    return reordered_packets_;
+  }
+
+ private:
+  const LinkOptions &options_;
+  td::Random::Xorshift128plus &rnd_;
+  double busy_till_{0};
+  td::uint64 sent_packets_{0};
+  td::uint64 lost_packets_{0};
+  td::uint64 dropped_packets_{0};
+  td::uint64 reordered_packets_{0};
+
+  double random_double() {
+    return static_cast<double>(rnd_() >> 11) * (1.0 / 9007199254740992.0);
+  }
+};
+
+class Endpoint : public ConnectionCallback {
+ public:
+  explicit Endpoint(td::Timestamp now) : connection(now) {
+  }
+
+  void send_raw(td::BufferSlice small_datagram) override {
+    outbox.push_back(std::move(small_datagram));
+  }
+  void receive(TransferId transfer_id, td::Result<td::BufferSlice> r_data) override {
+    received.emplace_back(transfer_id, std::move(r_data));
+  }
+  void on_sent(TransferId transfer_id, td::Result<td::Unit> state) override {
+    sent.emplace_back(transfer_id, std::move(state));
+  }
+
+  RldpConnection connection;
+  td::Timestamp wakeup_at;
+  bool need_run{true};
+  std::vector<td::BufferSlice> outbox;
+  std::vector<std::pair<TransferId, td::Result<td::BufferSlice>>> received;
+  std::vector<std::pair<TransferId, td::Result<td::Unit>>> sent;
+};
+
+struct TransferStats {
+  double started_at{0};
+  double first_byte_at{0};
+  double received_at{0};
+  double sent_at{0};
+  bool ok{false};
+};
+
+struct Flow {
+  Flow(td::uint32 id, td::Timestamp now) : id(id), sender(now), receiver(now) {
+  }
+  td::uint32 id;
+  Endpoint sender;
+  Endpoint receiver;
+  td::uint32 next_transfer{0};
+  td::uint32 finished_transfers{0};
+  td::uint64 part_bytes_sent{0};
+  td::uint64 payload_bytes_received{0};
+  std::map<TransferId, TransferStats> transfers;
+};
+
+class Simulator {
+ public:
+  explicit Simulator(Options options)
+      : options_(std::move(options))
+      , rnd_(options_.seed)
+      , forward_link_(options_.link, rnd_)
+      , backward_link_(options_.link, rnd_) {
+    for (td::uint32 i = 0; i < options_.flows; i++) {
+      flows_.push_back(std::make_unique<Flow>(i, td::Timestamp::at(now_)));
+      flows_.back()->sender.connection.set_random(&rnd_);
+      flows_.back()->receiver.connection.set_random(&rnd_);
+    }
+  }
+
+  void run() {
+    for (auto &flow : flows_) {
+      start_transfer(*flow);
+    }
+    double finish_at = now_ + options_.time_limit;
+    while (!is_done()) {
+      bool need_run = true;
+      while (need_run) {
+        need_run = false;
+        for (auto &flow : flows_) {
+          need_run |= run_endpoint(*flow, flow->sender, true);
+          need_run |= run_endpoint(*flow, flow->receiver, false);
+        }
+      }
+
+      td::Timestamp next_at;
+      if (!in_flight_.empty()) {
+        next_at.relax(td::Timestamp::at(in_flight_.begin()->first.first));
+      }
+      for (auto &flow : flows_) {
+        next_at.relax(flow->sender.wakeup_at);
+        next_at.relax(flow->receiver.wakeup_at);
+      }
+      if (!next_at) {
+        LOG(ERROR) << "Simulation stalled at " << td::format::as_time(now_ - start_at_);
+        break;
+      }
+      now_ = std::max(now_, next_at.at());
+      if (now_ > finish_at) {
+        LOG(ERROR) << "Simulation time limit exceeded";
+        break;
+      }
+
+      while (!in_flight_.empty() && in_flight_.begin()->first.first <= now_) {
+        auto datagram = std::move(in_flight_.begin()->second);
+        in_flight_.erase(in_flight_.begin());
+        deliver(std::move(datagram));
+      }
+    }
+    finished_at_ = now_;
+  }
+
+  void report() const {
+    td::StringBuilder sb;
+    double duration = finished_at_ - start_at_;
+    sb << "link: bandwidth=" << td::format::as_size(static_cast<td::uint64>(options_.link.bandwidth))
+       << "/s rtt=" << td::format::as_time(options_.link.rtt) << " loss=" << options_.link.loss
+       << " reorder=" << options_.link.reorder << " queue=" << td::format::as_size(options_.link.queue_size) << "\n";
+    sb << "simulated time: " << td::format::as_time(duration) << "\n";
+
+    double total_goodput = 0;
+    double sum_goodput_sq = 0;
+    td::uint64 total_payload = 0;
+    td::uint64 total_part_bytes = 0;
+    for (auto &flow : flows_) {
+      double first_byte_sum = 0;
+      double completion_sum = 0;
+      double flow_end = start_at_;
+      td::uint32 ok_count = 0;
+      for (auto &it : flow->transfers) {
+        auto &stats = it.second;
+        if (!stats.ok) {
+          continue;
+        }
+        ok_count++;
+        first_byte_sum += stats.first_byte_at - stats.started_at;
+        completion_sum += stats.received_at - stats.started_at;
+        flow_end = std::max(flow_end, stats.received_at);
+      }
+      auto payload = static_cast<double>(flow->payload_bytes_received);
+      double goodput = flow_end > start_at_ ? payload / (flow_end - start_at_) : 0;
+      double overhead = payload > 0 ? static_cast<double>(flow->part_bytes_sent) / payload - 1 : 0;
+      total_goodput += goodput;
+      sum_goodput_sq += goodput * goodput;
+      total_payload += flow->payload_bytes_received;
+      total_part_bytes += flow->part_bytes_sent;
+
+      sb << "flow #" << flow->id << ": transfers=" << ok_count << "/" << options_.transfers
+         << " goodput=" << td::format::as_size(static_cast<td::uint64>(goodput)) << "/s"
+         << " overhead=" << overhead * 100 << "%";
+      if (ok_count > 0) {
+        sb << " ttfb=" << td::format::as_time(first_byte_sum / ok_count)
+           << " completion=" << td::format::as_time(completion_sum / ok_count);
+      }
+      sb << "\n";
+    }
+
+    double fairness = sum_goodput_sq > 0 ? total_goodput * total_goodput / (flows_.size() * sum_goodput_sq) : 0;
+    double total_overhead =
+        total_payload > 0 ? static_cast<double>(total_part_bytes) / static_cast<double>(total_payload) - 1 : 0;
+    sb << "total: goodput=" << td::format::as_size(static_cast<td::uint64>(total_goodput)) << "/s"
+       << " link_utilization=" << total_goodput / options_.link.bandwidth * 100 << "%"
+       << " overhead=" << total_overhead * 100 << "%" << " fairness=" << fairness << "\n";
+    sb << "forward: sent=" << forward_link_.sent_packets() << " lost=" << forward_link_.lost_packets()
+       << " dropped=" << forward_link_.dropped_packets() << " reordered=" << forward_link_.reordered_packets() << "\n";
+    sb << "backward: sent=" << backward_link_.sent_packets() << " lost=" << backward_link_.lost_packets()
+       << " dropped=" << backward_link_.dropped_packets() << " reordered=" << backward_link_.reordered_packets()
+       << "\n";
+    std::cout << sb.as_cslice().str();
+  }
+
+  bool all_transfers_ok() const {
+    for (auto &flow : flows_) {
+      if (flow->finished_transfers != options_.transfers) {
+        return false;
+      }
+      for (auto &it : flow->transfers) {
+        if (!it.second.ok) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+ private:
+  // arbitrary non-zero origin of the virtual clock, td::Timestamp treats zero as "never"
+  static constexpr double start_at_ = 1000.0;
+  // alarms set in the past are re-run after this step of virtual time
+  static constexpr double min_step_ = 1e-4;
+
+  Options options_;
+  td::Random::Xorshift128plus rnd_;
+  Link forward_link_;
+  Link backward_link_;
+  double now_{start_at_};
+  double finished_at_{start_at_};
+  std::vector<std::unique_ptr<Flow>> flows_;
+
+  struct Datagram {
+    td::uint32 flow_id;
+    bool to_receiver;
+    td::BufferSlice data;
+  };
+  td::uint64 datagram_seqno_{0};
+  std::map<std::pair<double, td::uint64>, Datagram> in_flight_;
+
+  bool is_done() const {
+    for (auto &flow : flows_) {
+      if (flow->finished_transfers < options_.transfers) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  static TransferId gen_transfer_id(td::uint32 flow_id, td::uint32 seqno) {
+    TransferId transfer_id;
+    transfer_id.set_zero();
+    td::as<td::uint32>(transfer_id.data()) = flow_id + 1;
+    td::as<td::uint32>(transfer_id.data() + 4) = seqno + 1;
+    return transfer_id;
+  }
+
+  static td::optional<TransferId> get_part_transfer_id(td::Slice data) {
+    if (data.size() < 4 + 32 || td::as<td::int32>(data.data()) != ton_api::rldp2_messagePart::ID) {
+      return {};
+    }
+    TransferId transfer_id;
+    transfer_id.as_slice().copy_from(data.substr(4, 32));
+    return transfer_id;
+  }
+
+  void start_transfer(Flow &flow) {
+    if (flow.next_transfer >= options_.transfers) {
+      return;
+    }
+    auto transfer_id = gen_transfer_id(flow.id, flow.next_transfer++);
+    td::BufferSlice data(options_.transfer_size);
+    rnd_.bytes(data.as_slice());
+
+    auto timeout = td::Timestamp::at(now_ + options_.time_limit);
+    flow.receiver.connection.set_receive_limits(transfer_id, timeout, options_.transfer_size);
+    flow.sender.connection.send(transfer_id, std::move(data), timeout);
+    flow.sender.need_run = true;
+    flow.transfers[transfer_id].started_at = now_;
+  }
+
+  bool run_endpoint(Flow &flow, Endpoint &endpoint, bool is_sender) {
+    if (!endpoint.need_run && (!endpoint.wakeup_at || endpoint.wakeup_at.at() > now_)) {
+      return false;
+    }
+    endpoint.need_run = false;
+    auto wakeup_at = endpoint.connection.run(endpoint, td::Timestamp::at(now_));
+    if (wakeup_at) {
+      wakeup_at = td::Timestamp::at(std::max(wakeup_at.at(), now_ + min_step_));
+    }
+    endpoint.wakeup_at = wakeup_at;
+
+    for (auto &data : endpoint.outbox) {
+      if (is_sender && get_part_transfer_id(data.as_slice())) {
+        flow.part_bytes_sent += data.size();
+      }
+      auto o_arrive_at = (is_sender ? forward_link_ : backward_link_).transmit(now_, data.size());
+      if (o_arrive_at) {
+        in_flight_.emplace(std::make_pair(o_arrive_at.unwrap(), datagram_seqno_++),
+                           Datagram{flow.id, is_sender, std::move(data)});
+      }
+    }
+    endpoint.outbox.clear();
+
+    for (auto &it : endpoint.received) {
+      auto &stats = flow.transfers[it.first];
+      stats.received_at = now_;
+      if (it.second.is_error()) {
+        LOG(ERROR) << "Flow #" << flow.id << ": failed to receive transfer: " << it.second.error();
+        continue;
+      }
+      if (it.second.ok().size() != options_.transfer_size) {
+        LOG(ERROR) << "Flow #" << flow.id << ": received transfer of wrong size " << it.second.ok().size();
+        continue;
+      }
+      stats.ok = true;
+      flow.payload_bytes_received += options_.transfer_size;
+    }
+    endpoint.received.clear();
+
+    bool started = false;
+    for (auto &it : endpoint.sent) {
+      flow.transfers[it.first].sent_at = now_;
+      if (it.second.is_error()) {
+        LOG(ERROR) << "Flow #" << flow.id << ": failed to send transfer: " << it.second.error();
+      }
+      flow.finished_transfers++;
+      start_transfer(flow);
+      started = true;
+    }
+    endpoint.sent.clear();
+    return started;
+  }
+
+  void deliver(Datagram datagram) {
+    auto &flow = *flows_[datagram.flow_id];
+    auto &endpoint = datagram.to_receiver ? flow.receiver : flow.sender;
+    if (datagram.to_receiver) {
+      auto o_transfer_id = get_part_transfer_id(datagram.data.as_slice());
+      if (o_transfer_id) {
+        auto it = flow.transfers.find(o_transfer_id.value());
+        if (it != flow.transfers.end() && it->second.first_byte_at == 0) {
+          it->second.first_byte_at = now_;
+        }
+      }
+    }
+    endpoint.connection.receive_raw(std::move(datagram.data), td::Timestamp::at(now_));
+    endpoint.need_run = true;
+  }
+};
+
+}  // namespace sim
+}  // namespace rldp2
+}  // namespace ton
+
+int main(int argc, char *argv[]) {
+  SET_VERBOSITY_LEVEL(verbosity_WARNING);
+  td::set_default_failure_signal_handler().ensure();
+
+  ton::rldp2::sim::Options options;
+
+  td::OptionParser p;
+  p.set_description("deterministic rldp2 congestion control simulator");
+  p.add_option('v', "verbosity", "set verbosity level", [&](td::Slice arg) {
+    int v = VERBOSITY_NAME(FATAL) + (td::to_integer<int>(arg));
+    SET_VERBOSITY_LEVEL(v);
+  });
+  p.add_option('h', "help", "prints a help message", [&]() {
+    char b[10240];
+    td::StringBuilder sb(td::MutableSlice{b, 10000});
+    sb << p;
+    std::cout << sb.as_cslice().c_str();
+    std::exit(2);
+  });
+  p.add_checked_option('b', "bandwidth", "bottleneck bandwidth in bytes per second (default: 12.5e6)",
+                       [&](td::Slice arg) -> td::Status {
+                         options.link.bandwidth = td::to_double(arg);
+                         if (!(options.link.bandwidth > 0)) {
+                           return td::Status::Error("bandwidth must be positive");
+                         }
+                         return td::Status::OK();
+                       });
+  p.add_checked_option('r', "rtt", "round trip time in seconds (default: 0.1)", [&](td::Slice arg) -> td::Status {
+    options.link.rtt = td::to_double(arg);
+    if (options.link.rtt < 0) {
+      return td::Status::Error("rtt must be non-negative");
+    }
+    return td::Status::OK();
+  });
+  p.add_checked_option('l', "loss", "datagram loss probability (default: 0)", [&](td::Slice arg) -> td::Status {
+    options.link.loss = td::to_double(arg);
+    if (options.link.loss < 0 || options.link.loss >= 1) {
+      return td::Status::Error("loss must be in [0, 1)");
+    }
+    return td::Status::OK();
+  });
+  p.add_checked_option('o', "reorder", "probability of delaying a datagram by up to one rtt (default: 0)",
+                       [&](td::Slice arg) -> td::Status {
+                         options.link.reorder = td::to_double(arg);
+                         if (options.link.reorder < 0 || options.link.reorder > 1) {
+                           return td::Status::Error("reorder must be in [0, 1]");
+                         }
+                         return td::Status::OK();
+                       });
+  p.add_checked_option('q', "queue", "bottleneck queue size in bytes (default: 1MB)", [&](td::Slice arg) -> td::Status {
+    TRY_RESULT_ASSIGN(options.link.queue_size, td::to_integer_safe<td::uint64>(arg));
+    return td::Status::OK();
+  });
+  p.add_checked_option('f', "flows", "number of connections sharing the link (default: 1)",
+                       [&](td::Slice arg) -> td::Status {
+                         TRY_RESULT_ASSIGN(options.flows, td::to_integer_safe<td::uint32>(arg));
+                         if (options.flows == 0) {
+                           return td::Status::Error("at least one flow is required");
+                         }
+                         return td::Status::OK();
+                       });
+  p.add_checked_option('n', "transfers", "number of sequential transfers per flow (default: 4)",
+                       [&](td::Slice arg) -> td::Status {
+                         TRY_RESULT_ASSIGN(options.transfers, td::to_integer_safe<td::uint32>(arg));
+                         return td::Status::OK();
+                       });
+  p.add_checked_option('s', "size", "size of one transfer in bytes (default: 1MB)", [&](td::Slice arg) -> td::Status {
+    TRY_RESULT_ASSIGN(options.transfer_size, td::to_integer_safe<td::uint64>(arg));
+    if (options.transfer_size == 0) {
+      return td::Status::Error("transfer size must be positive");
+    }
+    return td::Status::OK();
+  });
+  p.add_checked_option('t', "time-limit", "limit of simulated time in seconds (default: 600)",
+                       [&](td::Slice arg) -> td::Status {
+                         options.time_limit = td::to_double(arg);
+                         return td::Status::OK();
+                       });
+  p.add_checked_option('S', "seed", "seed of all simulated randomness (default: 1)", [&](td::Slice arg) -> td::Status {
+    TRY_RESULT_ASSIGN(options.seed, td::to_integer_safe<td::uint64>(arg));
+    return td::Status::OK();
+  });
+  p.run(argc, argv).ensure();
+
+  ton::rldp2::sim::Simulator simulator(std::move(options));
+  simulator.run();
+  simulator.report();
+  return simulator.all_transfers_ok() ? 0 : 1;
+}
@@ -263,7 +263,8 @@ void NodeActor::loop() {
 std::string NodeActor::get_stats_str() {
   td::StringBuilder sb;
   sb << "Node " << self_id_ << " " << torrent_.get_ready_parts_count() << "\t" << download_speed_;
-  sb << "\toutq " << parts_.total_queries;
+  sb << "\toutq " << parts_.total_queries << "/" << parts_.total_queries_limit;
+  sb << "\tdup " << parts_.duplicate_queries;
   sb << "\n";
   for (auto &it : peers_) {
     auto &state = it.second.state;
@@ -280,7 +281,7 @@ std::string NodeActor::get_stats_str() {
         sb << "\tcnt:" << parts_helper_.get_want_download_count(it.second.peer_token);
       }
     }
-    sb << "\toutq:" << state->node_queries_active_.size();
+    sb << "\toutq:" << state->node_queries_active_.size() << "/" << it.second.queries_window;
     auto node_state = state->node_state_.load();
     sb << "\tNup:" << node_state.will_upload;
     sb << "\tNdown:" << node_state.want_download;
@@ -525,6 +526,7 @@ void NodeActor::loop_queries() {
   if (!should_download_) {
     return;
   }
+  parts_.total_queries_limit = calc_total_queries_limit();
   for (auto &it : peers_) {
     auto peer_token = it.second.peer_token;
     auto &state = it.second.state;
@@ -536,26 +538,139 @@ void NodeActor::loop_queries() {
       parts_helper_.set_peer_limit(peer_token, 0);
       continue;
     }
-    parts_helper_.set_peer_limit(
-        peer_token, td::narrow_cast<td::uint32>(MAX_PEER_TOTAL_QUERIES - state->node_queries_active_.size()));
+    it.second.queries_window = calc_peer_queries_window(it.second.download_speed.speed(), it.second.query_latency,
+                                                          torrent_.get_info().piece_size);
+    auto active = state->node_queries_active_.size();
+    auto window = it.second.queries_window;
+    parts_helper_.set_peer_limit(peer_token, active < window ? td::narrow_cast<td::uint32>(window - active) : 0);
   }
 
-  auto parts = parts_helper_.get_rarest_parts(MAX_TOTAL_QUERIES);
+  if (parts_.total_queries >= parts_.total_queries_limit) {
+    return;
+  }
+  auto parts = parts_helper_.get_rarest_parts(parts_.total_queries_limit - parts_.total_queries);
   for (auto &part : parts) {
     auto it = peers_.find(part.peer_id);
     CHECK(it != peers_.end());
     auto &state = it->second.state;
     CHECK(state->peer_state_ready_);
     CHECK(state->peer_state_.load().will_upload);
-    CHECK(state->node_queries_active_.size() < MAX_PEER_TOTAL_QUERIES);
-    auto part_id = part.part_id;
-    if (state->node_queries_active_.insert(static_cast<td::uint32>(part_id)).second) {
-      state->node_queries_.add_element(static_cast<td::uint32>(part_id));
+    CHECK(state->node_queries_active_.size() < it->second.queries_window);
+    start_part_query(it->second, part.part_id);
+  }
+  if (parts.empty()) {
+    loop_endgame();
+  }
+}
+
+void NodeActor::loop_endgame() {
+  if (parts_.total_queries == 0 || parts_.total_queries >= parts_.total_queries_limit) {
+    return;
+  }
+  if (parts_.total_queries > ENDGAME_MAX_PARTS * ENDGAME_MAX_QUERIES_PER_PART) {
+    return;
+  }
+  std::set<PartId> in_flight_set;
+  for (auto &it : peers_) {
+    for (auto part_id : it.second.state->node_queries_active_) {
+      if (parts_.parts[part_id].queries_count < ENDGAME_MAX_QUERIES_PER_PART) {
+        in_flight_set.insert(part_id);
+      }
     }
+  }
+  if (in_flight_set.empty() || in_flight_set.size() > ENDGAME_MAX_PARTS) {
+    return;
+  }
+  std::vector<PartId> in_flight(in_flight_set.begin(), in_flight_set.end());
+  std::sort(in_flight.begin(), in_flight.end(), [&](PartId a, PartId b) {
+    return parts_.parts[a].queries_count < parts_.parts[b].queries_count;
+  });
+  for (auto &it : peers_) {
+    auto &peer = it.second;
+    auto &state = peer.state;
+    if (!state->peer_state_ready_ || !state->peer_state_.load().will_upload) {
+      continue;
+    }
+    auto &peer_parts = parts_helper_.get_ready_parts(peer.peer_token);
+    for (auto part_id : in_flight) {
+      if (state->node_queries_active_.size() >= peer.queries_window ||
+          parts_.total_queries >= parts_.total_queries_limit) {
+        break;
+      }
+      auto &info = parts_.parts[part_id];
+      if (info.queries_count >= ENDGAME_MAX_QUERIES_PER_PART || !peer_parts.get(part_id) ||
+          state->node_queries_active_.count(static_cast<td::uint32>(part_id))) {
+        continue;
+      }
+      start_part_query(peer, part_id);
+      parts_.duplicate_queries++;
+    }
+  }
+}
+
+td::uint32 NodeActor::calc_peer_queries_window(double download_speed, double query_latency, td::uint64 piece_size) {
+  if (query_latency == 0) {
+    return INITIAL_PEER_QUERIES;
+  }
+  double window = download_speed * query_latency / static_cast<double>(piece_size) * QUERIES_WINDOW_HEADROOM + 1;
+  return static_cast<td::uint32>(
+      td::clamp(window, static_cast<double>(MIN_PEER_QUERIES), static_cast<double>(MAX_PEER_QUERIES)));
+}
+
+size_t NodeActor::calc_total_queries_limit() const {
+  double max_latency = 0;
+  for (auto &it : peers_) {
+    max_latency = td::max(max_latency, it.second.query_latency);
+  }
+  double piece_size = static_cast<double>(torrent_.get_info().piece_size);
+  double limit = download_speed_.speed() * max_latency / piece_size * QUERIES_WINDOW_HEADROOM;
+  return static_cast<size_t>(
+      td::clamp(limit, static_cast<double>(MIN_TOTAL_QUERIES), static_cast<double>(MAX_TOTAL_QUERIES)));
+}
+
+void NodeActor::start_part_query(Peer &peer, PartId part_id) {
+  auto &state = peer.state;
+  if (state->node_queries_active_.insert(static_cast<td::uint32>(part_id)).second) {
+    state->node_queries_.add_element(static_cast<td::uint32>(part_id));
+  }
+  auto &info = parts_.parts[part_id];
+  if (info.queries_count++ == 0) {
     parts_helper_.lock_part(part_id);
-    parts_.total_queries++;
-    parts_.parts[part_id].query_to_peer = part.peer_id;
-    state->notify_peer();
+  }
+  parts_.total_queries++;
+  peer.query_sent_at[part_id] = td::Timestamp::now();
+  state->notify_peer();
+}
+
+void NodeActor::finish_part_query(Peer &peer, PartId part_id, bool success) {
+  peer.state->node_queries_active_.erase(static_cast<td::uint32>(part_id));
+  auto it = peer.query_sent_at.find(part_id);
+  if (it != peer.query_sent_at.end()) {
+    if (success) {
+      double latency = td::Timestamp::now().at() - it->second.at();
+      peer.query_latency = peer.query_latency == 0 ? latency : peer.query_latency * 0.875 + latency * 0.125;
+    }
+    peer.query_sent_at.erase(it);
+  }
+  auto &info = parts_.parts[part_id];
+  CHECK(info.queries_count > 0);
+  parts_.total_queries--;
+  if (--info.queries_count == 0) {
+    parts_helper_.unlock_part(part_id);
+  }
+}
+
+void NodeActor::cancel_part_queries(PartId part_id) {
+  for (auto &it : peers_) {
+    if (parts_.parts[part_id].queries_count == 0) {
+      break;
+    }
+    auto &state = it.second.state;
+    if (state->node_queries_active_.count(static_cast<td::uint32>(part_id))) {
+      finish_part_query(it.second, part_id, false);
+      state->node_queries_cancelled_.add_element(static_cast<td::uint32>(part_id));
+      state->notify_peer();
+    }
   }
 }
 
@@ -651,12 +766,9 @@ void NodeActor::loop_peer(const PeerId &peer_id, Peer &peer) {
       return td::Unit();
     });
 
-    parts_.parts[part_id].query_to_peer = {};
-    parts_.total_queries--;
-    state->node_queries_active_.erase(part_id);
-    parts_helper_.unlock_part(part_id);
-
+    finish_part_query(peer, part_id, r_unit.is_ok());
     if (r_unit.is_ok()) {
+      cancel_part_queries(part_id);
       on_part_ready(part_id);
     }
   }
@@ -921,6 +1033,7 @@ void NodeActor::load_from_db(std::shared_ptr<db::DbType> db, td::Bits256 hash, t
         if (meta_str) {
           TRY_RESULT(meta, TorrentMeta::deserialize(meta_str.value().as_slice()));
           options.validate = true;
+          options.validate_extra_threads = VALIDATE_EXTRA_THREADS;
           return Torrent::open(std::move(options), std::move(meta));
         } else {
           return Torrent::open(std::move(options), hash_);
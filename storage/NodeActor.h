@@ -106,6 +106,16 @@ class NodeActor : public td::actor::Actor {
                            td::Promise<td::actor::ActorOwn<NodeActor>> promise);
   static void cleanup_db(std::shared_ptr<db::DbType> db, td::Bits256 hash, td::Promise<td::Unit> promise);
 
+  // Number of getPiece queries in flight is adapted to the link: each peer gets a window of about
+  // speed * latency / piece_size queries (bandwidth-delay product), the total is bounded the same way.
+  static constexpr td::uint32 MIN_PEER_QUERIES = 2;
+  static constexpr td::uint32 INITIAL_PEER_QUERIES = 5;
+  static constexpr td::uint32 MAX_PEER_QUERIES = 64;
+  static constexpr size_t MIN_TOTAL_QUERIES = 20;
+  static constexpr size_t MAX_TOTAL_QUERIES = 512;
+  static constexpr double QUERIES_WINDOW_HEADROOM = 2.0;
+  static td::uint32 calc_peer_queries_window(double download_speed, double query_latency, td::uint64 piece_size);
+
  private:
   PeerId self_id_;
   ton::Torrent torrent_;
@@ -133,22 +143,33 @@ class NodeActor : public td::actor::Actor {
     PeerId peer_id_;
   };
 
+  // Endgame: when no new parts can be requested and only a few are in flight, the remaining parts are also
+  // requested from other peers; the first response wins, the other queries are cancelled
+  static constexpr size_t ENDGAME_MAX_PARTS = 32;
+  static constexpr td::uint32 ENDGAME_MAX_QUERIES_PER_PART = 3;
+
   struct Peer {
     td::actor::ActorOwn<PeerActor> actor;
     td::actor::ActorOwn<Notifier> notifier;
     std::shared_ptr<PeerState> state;
     PartsHelper::PeerToken peer_token;
     LoadSpeed download_speed, upload_speed;
+    // getPiece latency (time from query to response), smoothed; 0 until the first successful query
+    double query_latency{0};
+    std::map<PartId, td::Timestamp> query_sent_at;
+    td::uint32 queries_window{INITIAL_PEER_QUERIES};
   };
 
   std::map<PeerId, Peer> peers_;
 
   struct PartsSet {
     struct Info {
-      td::optional<PeerId> query_to_peer;
+      td::uint32 queries_count{0};
       bool ready{false};
     };
     size_t total_queries{0};
+    size_t total_queries_limit{MIN_TOTAL_QUERIES};
+    size_t duplicate_queries{0};
     std::vector<Info> parts;
   };
 
@@ -189,9 +210,14 @@ class NodeActor : public td::actor::Actor {
 
   void loop_start_stop_peers();
 
-  static constexpr size_t MAX_TOTAL_QUERIES = 20;
-  static constexpr size_t MAX_PEER_TOTAL_QUERIES = 5;
+  // several torrents may be validated at once on startup, so each of them gets only a few helper threads
+  static constexpr size_t VALIDATE_EXTRA_THREADS = 3;
   void loop_queries();
+  void loop_endgame();
+  size_t calc_total_queries_limit() const;
+  void start_part_query(Peer &peer, PartId part_id);
+  void finish_part_query(Peer &peer, PartId part_id, bool success);
+  void cancel_part_queries(PartId part_id);
   void loop_get_peers();
   void got_peers(td::Result<std::vector<PeerId>> r_peers);
   void loop_peer(const PeerId &peer_id, Peer &peer);
@@ -338,6 +338,7 @@ void PeerActor::loop_node_get_piece() {
     if (state_->speed_limiters_.download.empty()) {
       node_get_piece_.emplace(part, NodePieceQuery{});
     } else {
+      node_get_piece_limited_.insert(part);
       if (!torrent_info_) {
         CHECK(state_->torrent_info_ready_);
         loop_get_torrent_info();
@@ -361,6 +362,13 @@ void PeerActor::loop_node_get_piece() {
     }
   }
 
+  // The part was received from another peer. Queries that are not sent yet are withdrawn; sent queries can't be
+  // aborted on the wire, so they are forgotten and their answers are dropped in on_query_result
+  for (auto part : state_->node_queries_cancelled_.read()) {
+    node_get_piece_limited_.erase(part);
+    node_get_piece_.erase(part);
+  }
+
   for (auto &query_it : node_get_piece_) {
     if (query_it.second.query_id) {
       continue;
@@ -373,6 +381,10 @@ void PeerActor::loop_node_get_piece() {
 }
 
 void PeerActor::node_get_piece_query_ready(PartId part, td::Result<td::Unit> R) {
+  if (!node_get_piece_limited_.erase(part)) {
+    // cancelled while waiting in the speed limiter
+    return;
+  }
   if (R.is_error()) {
     on_get_piece_result(part, R.move_as_error());
   } else {
@@ -87,6 +87,8 @@ class PeerActor : public td::actor::Actor {
     td::optional<td::uint64> query_id;
   };
   std::map<PartId, NodePieceQuery> node_get_piece_;
+  // getPiece queries waiting in the download speed limiter
+  std::set<PartId> node_get_piece_limited_;
 
   struct PeerPieceQuery {
     td::Promise<td::BufferSlice> promise;
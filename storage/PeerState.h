@@ -112,6 +112,7 @@ struct PeerState {
 
   std::set<PartId> node_queries_active_; // Node only
   MessageBuffer<PartId> node_queries_; // Node -> Peer
+  MessageBuffer<PartId> node_queries_cancelled_; // Node -> Peer
   MessageBuffer<std::pair<PartId, td::Result<Part>>> node_queries_results_; // Peer -> Node
 
   std::set<PartId> peer_queries_active_; // Peer only
@@ -0,0 +1,174 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+
+#include "PieceHasher.h"
+
+#include "td/utils/buffer.h"
+#include "td/utils/crypto.h"
+#include "td/utils/port/thread.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+namespace ton {
+namespace {
+struct Batch {
+  td::uint64 begin{0};
+  td::uint64 end{0};
+  td::BufferSlice buffer;
+  std::vector<td::Result<size_t>> sizes;
+  std::vector<td::Bits256> hashes;
+  // read and not yet reported, so the reader must not reuse the batch
+  bool ready{false};
+  size_t not_hashed{0};
+};
+}  // namespace
+
+void PieceHasher::run(const Options &options, const ReadPiece &read_piece, const OnPiece &on_piece) {
+  CHECK(options.piece_size > 0);
+  if (options.pieces_count == 0) {
+    return;
+  }
+  td::uint64 batch_pieces = td::max<td::uint64>(options.batch_size / options.piece_size, options.extra_threads + 1);
+  batch_pieces = td::min(batch_pieces, options.pieces_count);
+  td::uint64 batches_n = (options.pieces_count + batch_pieces - 1) / batch_pieces;
+
+  auto read_batch = [&](Batch &batch, td::uint64 begin) {
+    batch.begin = begin;
+    batch.end = td::min(begin + batch_pieces, options.pieces_count);
+    if (batch.buffer.empty()) {
+      batch.buffer = td::BufferSlice(batch_pieces * options.piece_size);
+    }
+    batch.sizes.clear();
+    for (td::uint64 piece_i = batch.begin; piece_i < batch.end; piece_i++) {
+      auto dest = batch.buffer.as_slice().substr((piece_i - batch.begin) * options.piece_size, options.piece_size);
+      batch.sizes.push_back(read_piece(piece_i, dest));
+    }
+    batch.hashes.resize(batch.sizes.size());
+  };
+  auto hash_piece = [&](Batch &batch, size_t i) {
+    auto data = batch.buffer.as_slice().substr(i * options.piece_size, batch.sizes[i].ok());
+    td::sha256(data, batch.hashes[i].as_slice());
+  };
+  auto report_batch = [&](Batch &batch) {
+    for (size_t i = 0; i < batch.sizes.size(); i++) {
+      if (batch.sizes[i].is_error()) {
+        on_piece(batch.begin + i, batch.sizes[i].move_as_error());
+      } else {
+        on_piece(batch.begin + i, batch.hashes[i]);
+      }
+    }
+  };
+
+  if (options.extra_threads == 0) {
+    Batch batch;
+    for (td::uint64 batch_i = 0; batch_i < batches_n; batch_i++) {
+      read_batch(batch, batch_i * batch_pieces);
+      for (size_t i = 0; i < batch.sizes.size(); i++) {
+        if (batch.sizes[i].is_ok()) {
+          hash_piece(batch, i);
+        }
+      }
+      report_batch(batch);
+    }
+    return;
+  }
+
+  // All threads live until the last piece is reported. The reader fills one batch while the other one is hashed,
+  // pieces of ready batches are queued in order and taken by the workers and by the calling thread.
+  std::mutex mutex;
+  std::condition_variable cond;
+  std::deque<std::pair<Batch *, size_t>> tasks;
+  bool closing = false;
+  Batch batches[2];
+
+  // must be called with the lock held; returns false if there are no queued pieces
+  auto run_task = [&](std::unique_lock<std::mutex> &lock) {
+    if (tasks.empty()) {
+      return false;
+    }
+    auto task = tasks.front();
+    tasks.pop_front();
+    lock.unlock();
+    hash_piece(*task.first, task.second);
+    lock.lock();
+    if (--task.first->not_hashed == 0) {
+      cond.notify_all();
+    }
+    return true;
+  };
+
+  std::vector<td::thread> workers;
+  for (size_t i = 0; i < options.extra_threads; i++) {
+    workers.emplace_back([&] {
+      std::unique_lock<std::mutex> lock(mutex);
+      while (!closing) {
+        if (!run_task(lock)) {
+          cond.wait(lock);
+        }
+      }
+    });
+  }
+  td::thread reader([&] {
+    for (td::uint64 batch_i = 0; batch_i < batches_n; batch_i++) {
+      auto &batch = batches[batch_i % 2];
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        cond.wait(lock, [&] { return !batch.ready; });
+      }
+      read_batch(batch, batch_i * batch_pieces);
+      std::lock_guard<std::mutex> lock(mutex);
+      for (size_t i = 0; i < batch.sizes.size(); i++) {
+        if (batch.sizes[i].is_ok()) {
+          tasks.emplace_back(&batch, i);
+          batch.not_hashed++;
+        }
+      }
+      batch.ready = true;
+      cond.notify_all();
+    }
+  });
+
+  for (td::uint64 batch_i = 0; batch_i < batches_n; batch_i++) {
+    auto &batch = batches[batch_i % 2];
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      while (!batch.ready || batch.not_hashed != 0) {
+        if (!run_task(lock)) {
+          cond.wait(lock);
+        }
+      }
+    }
+    report_batch(batch);
+    std::lock_guard<std::mutex> lock(mutex);
+    batch.ready = false;
+    cond.notify_all();
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    closing = true;
+    cond.notify_all();
+  }
+  reader.join();
+  for (auto &worker : workers) {
+    worker.join();
+  }
+}
+}  // namespace ton
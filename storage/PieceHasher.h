@@ -0,0 +1,54 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+
+#pragma once
+
+#include "td/utils/int_types.h"
+#include "td/utils/Slice.h"
+#include "td/utils/Status.h"
+
+#include "common/bitstring.h"
+
+#include <functional>
+
+namespace ton {
+// Computes sha256 hashes of consecutive torrent pieces.
+//
+// Pieces are read in batches of about batch_size bytes. With extra_threads > 0 a reader thread and extra_threads
+// hashing workers are started once per run(): the reader fills the next batch while the pieces of the current one
+// are taken from a queue by the workers and the calling thread, so disk reads and hashing overlap.
+// With extra_threads == 0 everything happens on the calling thread, one batch after another.
+// read_piece is always called in piece order from one thread at a time; on_piece is called in piece order on the
+// calling thread.
+class PieceHasher {
+ public:
+  // Fills dest (of size piece_size) with the data of the piece and returns the actual piece size
+  using ReadPiece = std::function<td::Result<size_t>(td::uint64 piece_i, td::MutableSlice dest)>;
+  using OnPiece = std::function<void(td::uint64 piece_i, td::Result<td::Bits256> r_hash)>;
+
+  struct Options {
+    td::uint64 pieces_count{0};
+    size_t piece_size{0};
+    size_t extra_threads{0};
+    size_t batch_size{8 << 20};
+  };
+
+  static void run(const Options &options, const ReadPiece &read_piece, const OnPiece &on_piece);
+};
+}  // namespace ton
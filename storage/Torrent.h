@@ -38,13 +38,15 @@ class Torrent {
     std::string root_dir;
     bool in_memory{false};
     bool validate{false};
+    // helper threads used to hash pieces during validation, 0 means hashing on the calling thread only
+    size_t validate_extra_threads{0};
   };
 
   // creation
   static td::Result<Torrent> open(Options options, td::Bits256 hash);
   static td::Result<Torrent> open(Options options, TorrentMeta meta);
   static td::Result<Torrent> open(Options options, td::Slice meta_str);
-  void validate();
+  void validate(size_t extra_threads = 0);
 
   std::string get_stats_str() const;
 
@@ -19,13 +19,12 @@
 
 #include "TorrentCreator.h"
 
-#include "td/db/utils/CyclicBuffer.h"
-
 #include "td/utils/crypto.h"
 #include "td/utils/PathView.h"
 #include "td/utils/port/path.h"
 #include "td/utils/tl_helpers.h"
 #include "MicrochunkTree.h"
+#include "PieceHasher.h"
 #include "TorrentHeader.hpp"
 
 namespace ton {
@@ -135,49 +134,12 @@ td::Result<Torrent> Torrent::Creator::finalize() {
     header.dir_name = options_.dir_name.value();
   }
 
-  // Now we should stream all data to calculate sha256 of all pieces
-
-  std::string buffer;
-  td::CyclicBuffer::Options cb_options;
-  cb_options.chunk_size = td::max(options_.piece_size * 16, (1 << 20) / options_.piece_size * options_.piece_size);
-  cb_options.count = 2;
-
-  auto reader_writer = td::CyclicBuffer::create(cb_options);
-  auto reader = std::move(reader_writer.first);
-  auto writer = std::move(reader_writer.second);
-
   auto header_size = header.serialization_size();
   auto file_size = header_size + data_offset;
   auto pieces_count = (file_size + options_.piece_size - 1) / options_.piece_size;
   std::vector<Torrent::ChunkState> chunks;
-  std::vector<td::Bits256> pieces;
-  auto flush_reader = [&](bool force) {
-    while (true) {
-      auto slice = reader.prepare_read();
-      slice.truncate(options_.piece_size);
-      if (slice.empty() || (slice.size() != options_.piece_size && !force)) {
-        break;
-      }
-      td::Bits256 hash;
-      sha256(slice, hash.as_slice());
-      pieces.push_back(hash);
-      reader.confirm_read(slice.size());
-    }
-  };
   td::uint64 offset = 0;
-  auto add_blob = [&](auto data, td::Slice name) {
-    td::uint64 data_offset = 0;
-    while (data_offset < data.size()) {
-      auto dest = writer.prepare_write();
-      CHECK(dest.size() != 0);
-      dest.truncate(data.size() - data_offset);
-      TRY_RESULT(got_size, data.view_copy(dest, data_offset));
-      CHECK(got_size != 0);
-      data_offset += got_size;
-      writer.confirm_write(got_size);
-      flush_reader(false);
-    }
-
+  auto add_blob = [&](td::BlobView data, td::Slice name) {
     Torrent::ChunkState chunk;
     chunk.name = name.str();
     chunk.offset = offset;
@@ -187,7 +149,6 @@ td::Result<Torrent> Torrent::Creator::finalize() {
 
     offset += chunk.size;
     chunks.push_back(std::move(chunk));
-    return td::Status::OK();
   };
 
   Torrent::Info info;
@@ -196,13 +157,55 @@ td::Result<Torrent> Torrent::Creator::finalize() {
   info.header_size = header_str.size();
   td::sha256(header_str, info.header_hash.as_slice());
 
-  add_blob(td::BufferSliceBlobView::create(td::BufferSlice(header_str)), "").ensure();
+  add_blob(td::BufferSliceBlobView::create(td::BufferSlice(header_str)), "");
   for (auto& file : files_) {
-    add_blob(std::move(file.data), file.name).ensure();
+    add_blob(std::move(file.data), file.name);
   }
-  flush_reader(true);
-  CHECK(pieces.size() == pieces_count);
   CHECK(offset == file_size);
+
+  // Now we should stream all data to calculate sha256 of all pieces
+  // Pieces are read in order, so it is enough to keep a cursor over chunks
+  size_t chunk_i = 0;
+  auto read_piece = [&](td::uint64 piece_i, td::MutableSlice dest) -> td::Result<size_t> {
+    td::uint64 piece_offset = piece_i * options_.piece_size;
+    size_t piece_size = static_cast<size_t>(td::min<td::uint64>(options_.piece_size, file_size - piece_offset));
+    size_t got = 0;
+    while (got < piece_size) {
+      CHECK(chunk_i < chunks.size());
+      auto& chunk = chunks[chunk_i];
+      td::uint64 chunk_offset = piece_offset + got - chunk.offset;
+      if (chunk_offset >= chunk.size) {
+        chunk_i++;
+        continue;
+      }
+      auto part = dest.substr(got, td::min<td::uint64>(piece_size - got, chunk.size - chunk_offset));
+      TRY_RESULT(got_size, chunk.data.view_copy(part, chunk_offset));
+      if (got_size == 0) {
+        return td::Status::Error("Failed to read the whole chunk");
+      }
+      got += got_size;
+    }
+    return piece_size;
+  };
+
+  std::vector<td::Bits256> pieces;
+  pieces.reserve(pieces_count);
+  td::Status status;
+  PieceHasher::Options hasher_options;
+  hasher_options.pieces_count = pieces_count;
+  hasher_options.piece_size = options_.piece_size;
+  hasher_options.extra_threads = options_.extra_threads;
+  PieceHasher::run(hasher_options, read_piece, [&](td::uint64 piece_i, td::Result<td::Bits256> r_hash) {
+    if (r_hash.is_error()) {
+      if (status.is_ok()) {
+        status = r_hash.move_as_error_prefix(PSTRING() << "Failed to read piece " << piece_i << ": ");
+      }
+      return;
+    }
+    pieces.push_back(r_hash.move_as_ok());
+  });
+  TRY_STATUS(std::move(status));
+  CHECK(pieces.size() == pieces_count);
   MerkleTree tree(std::move(pieces));
 
   info.header_size = header.serialization_size();
@@ -35,6 +35,9 @@ class Torrent::Creator {
     td::optional<std::string> dir_name;
 
     std::string description;
+
+    // helper threads used to hash pieces, 0 means hashing on the calling thread only
+    size_t extra_threads{0};
   };
 
   // If path is a file create a torrent with one file in it.
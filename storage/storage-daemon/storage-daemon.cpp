@@ -20,6 +20,7 @@
 #include "td/utils/OptionParser.h"
 #include "td/utils/port/path.h"
 #include "td/utils/port/signals.h"
+#include "td/utils/port/thread.h"
 #include "td/utils/port/user.h"
 #include "td/utils/port/IPAddress.h"
 #include "td/utils/Random.h"
@@ -294,6 +295,7 @@ class StorageDaemon : public td::actor::Actor {
           Torrent::Creator::Options options;
           options.piece_size = 128 * 1024;
           options.description = std::move(query.description_);
+          options.extra_threads = td::thread::hardware_concurrency();
           TRY_RESULT_PROMISE(promise, torrent, Torrent::Creator::create_from_path(std::move(options), query.path_));
           td::Bits256 hash = torrent.get_hash();
           td::actor::send_closure(manager, &StorageManager::add_torrent, std::move(torrent), false, query.allow_upload_,
@@ -1007,6 +1007,47 @@ TEST(Torrent, Meta) {
   }
 };
 
+TEST(Torrent, ParallelHashing) {
+  td::Random::Xorshift128plus rnd(123);
+  for (int test_i = 0; test_i < 20; test_i++) {
+    std::vector<std::pair<std::string, td::BufferSlice>> files;
+    auto files_n = rnd.fast(1, 10);
+    for (int i = 0; i < files_n; i++) {
+      td::BufferSlice data(rnd.fast(0, 100000));
+      rnd.bytes(data.as_slice());
+      files.emplace_back(PSTRING() << "#" << i << ".txt", std::move(data));
+    }
+    auto create = [&](size_t extra_threads) {
+      ton::Torrent::Creator::Options options;
+      options.piece_size = rnd.fast(1, 4096);
+      options.extra_threads = extra_threads;
+      ton::Torrent::Creator creator{options};
+      for (auto &file : files) {
+        creator.add_blob(file.first, file.second.as_slice()).ensure();
+      }
+      return creator.finalize().move_as_ok();
+    };
+    auto seed_rnd = rnd;
+    auto torrent = create(0);
+    rnd = seed_rnd;
+    auto parallel_torrent = create(3);
+    CHECK(torrent.get_hash() == parallel_torrent.get_hash());
+
+    ton::Torrent::Options options;
+    options.in_memory = true;
+    auto new_torrent = ton::Torrent::open(options, torrent.get_meta()).move_as_ok();
+    new_torrent.enable_write_to_files();
+    for (size_t piece_i = 0; piece_i < torrent.get_info().pieces_count(); piece_i++) {
+      auto piece_data = torrent.get_piece_data(piece_i).move_as_ok();
+      auto piece_proof = torrent.get_piece_proof(piece_i).move_as_ok();
+      new_torrent.add_piece(piece_i, std::move(piece_data), std::move(piece_proof)).ensure();
+    }
+    CHECK(new_torrent.is_completed());
+    new_torrent.validate(3);
+    CHECK(new_torrent.is_completed());
+  }
+};
+
 TEST(Torrent, OneFile) {
   td::rmrf("first").ignore();
   td::rmrf("second").ignore();
@@ -1073,208 +1114,220 @@ void print_debug(ton::Torrent *torrent) {
   LOG(ERROR) << torrent->get_stats_str();
 }
 
-TEST(Torrent, Peer) {
-  class PeerManager : public td::actor::Actor {
-   public:
-    void send_query(ton::PeerId src, ton::PeerId dst, td::BufferSlice query, td::Promise<td::BufferSlice> promise) {
-      send_closure(get_outbound_channel(src), &NetChannel::send, query.size(),
-                   promise.send_closure(actor_id(this), &PeerManager::do_send_query, src, dst, std::move(query)));
-    }
+class PeerManager : public td::actor::Actor {
+ public:
+  void send_query(ton::PeerId src, ton::PeerId dst, td::BufferSlice query, td::Promise<td::BufferSlice> promise) {
+    send_closure(get_outbound_channel(src), &NetChannel::send, query.size(),
+                 promise.send_closure(actor_id(this), &PeerManager::do_send_query, src, dst, std::move(query)));
+  }
 
-    void do_send_query(ton::PeerId src, ton::PeerId dst, td::BufferSlice query, td::Result<td::Unit> res,
-                       td::Promise<td::BufferSlice> promise) {
-      TRY_RESULT_PROMISE(promise, x, std::move(res));
-      (void)x;
-      send_closure(get_inbound_channel(dst), &NetChannel::send, query.size(),
-                   promise.send_closure(actor_id(this), &PeerManager::execute_query, src, dst, std::move(query)));
-    }
+  void do_send_query(ton::PeerId src, ton::PeerId dst, td::BufferSlice query, td::Result<td::Unit> res,
+                     td::Promise<td::BufferSlice> promise) {
+    TRY_RESULT_PROMISE(promise, x, std::move(res));
+    (void)x;
+    send_closure(get_inbound_channel(dst), &NetChannel::send, query.size(),
+                 promise.send_closure(actor_id(this), &PeerManager::execute_query, src, dst, std::move(query)));
+  }
 
-    void execute_query(ton::PeerId src, ton::PeerId dst, td::BufferSlice query, td::Result<td::Unit> res,
-                       td::Promise<td::BufferSlice> promise) {
-      TRY_RESULT_PROMISE(promise, x, std::move(res));
-      (void)x;
-      promise = promise.send_closure(actor_id(this), &PeerManager::send_response, src, dst);
-      auto it = peers_.find(std::make_pair(dst, src));
-      if (it == peers_.end()) {
-        LOG(ERROR) << "No such peer";
-        auto node_it = nodes_.find(dst);
-        if (node_it == nodes_.end()) {
-          LOG(ERROR) << "Unknown query destination";
-          promise.set_error(td::Status::Error("Unknown query destination"));
-          return;
-        }
-        send_closure(node_it->second, &ton::NodeActor::start_peer, src,
-                     [promise = std::move(promise),
-                      query = std::move(query)](td::Result<td::actor::ActorId<ton::PeerActor>> r_peer) mutable {
-                       TRY_RESULT_PROMISE(promise, peer, std::move(r_peer));
-                       send_closure(peer, &ton::PeerActor::execute_query, std::move(query), std::move(promise));
-                     });
+  void execute_query(ton::PeerId src, ton::PeerId dst, td::BufferSlice query, td::Result<td::Unit> res,
+                     td::Promise<td::BufferSlice> promise) {
+    TRY_RESULT_PROMISE(promise, x, std::move(res));
+    (void)x;
+    if (silent_.count(dst) && query.size() >= 4 &&
+        td::as<td::int32>(query.data()) == ton::ton_api::storage_getPiece::ID) {
+      lost_queries_.push_back(std::move(promise));
+      return;
+    }
+    promise = promise.send_closure(actor_id(this), &PeerManager::send_response, src, dst);
+    auto it = peers_.find(std::make_pair(dst, src));
+    if (it == peers_.end()) {
+      LOG(ERROR) << "No such peer";
+      auto node_it = nodes_.find(dst);
+      if (node_it == nodes_.end()) {
+        LOG(ERROR) << "Unknown query destination";
+        promise.set_error(td::Status::Error("Unknown query destination"));
         return;
       }
-      send_closure(it->second, &ton::PeerActor::execute_query, std::move(query), std::move(promise));
+      send_closure(node_it->second, &ton::NodeActor::start_peer, src,
+                   [promise = std::move(promise),
+                    query = std::move(query)](td::Result<td::actor::ActorId<ton::PeerActor>> r_peer) mutable {
+                     TRY_RESULT_PROMISE(promise, peer, std::move(r_peer));
+                     send_closure(peer, &ton::PeerActor::execute_query, std::move(query), std::move(promise));
+                   });
+      return;
     }
+    send_closure(it->second, &ton::PeerActor::execute_query, std::move(query), std::move(promise));
+  }
 
-    void send_response(ton::PeerId src, ton::PeerId dst, td::Result<td::BufferSlice> r_response,
-                       td::Promise<td::BufferSlice> promise) {
-      TRY_RESULT_PROMISE(promise, response, std::move(r_response));
-      send_closure(get_outbound_channel(dst), &NetChannel::send, response.size(),
-                   promise.send_closure(actor_id(this), &PeerManager::do_send_response, src, dst, std::move(response)));
-    }
+  void send_response(ton::PeerId src, ton::PeerId dst, td::Result<td::BufferSlice> r_response,
+                     td::Promise<td::BufferSlice> promise) {
+    TRY_RESULT_PROMISE(promise, response, std::move(r_response));
+    send_closure(get_outbound_channel(dst), &NetChannel::send, response.size(),
+                 promise.send_closure(actor_id(this), &PeerManager::do_send_response, src, dst, std::move(response)));
+  }
 
-    void do_send_response(ton::PeerId src, ton::PeerId dst, td::BufferSlice response, td::Result<td::Unit> res,
-                          td::Promise<td::BufferSlice> promise) {
-      TRY_RESULT_PROMISE(promise, x, std::move(res));
-      (void)x;
-      send_closure(
-          get_inbound_channel(src), &NetChannel::send, response.size(),
-          promise.send_closure(actor_id(this), &PeerManager::do_execute_response, src, dst, std::move(response)));
-    }
+  void do_send_response(ton::PeerId src, ton::PeerId dst, td::BufferSlice response, td::Result<td::Unit> res,
+                        td::Promise<td::BufferSlice> promise) {
+    TRY_RESULT_PROMISE(promise, x, std::move(res));
+    (void)x;
+    send_closure(
+        get_inbound_channel(src), &NetChannel::send, response.size(),
+        promise.send_closure(actor_id(this), &PeerManager::do_execute_response, src, dst, std::move(response)));
+  }
 
-    void do_execute_response(ton::PeerId src, ton::PeerId dst, td::BufferSlice response, td::Result<td::Unit> res,
-                             td::Promise<td::BufferSlice> promise) {
-      TRY_RESULT_PROMISE(promise, x, std::move(res));
-      (void)x;
-      promise.set_value(std::move(response));
-    }
+  void do_execute_response(ton::PeerId src, ton::PeerId dst, td::BufferSlice response, td::Result<td::Unit> res,
+                           td::Promise<td::BufferSlice> promise) {
+    TRY_RESULT_PROMISE(promise, x, std::move(res));
+    (void)x;
+    promise.set_value(std::move(response));
+  }
 
-    void register_peer(ton::PeerId src, ton::PeerId dst, td::actor::ActorId<ton::PeerActor> peer) {
-      peers_[std::make_pair(src, dst)] = std::move(peer);
-    }
+  void register_peer(ton::PeerId src, ton::PeerId dst, td::actor::ActorId<ton::PeerActor> peer) {
+    peers_[std::make_pair(src, dst)] = std::move(peer);
+  }
 
-    void register_node(ton::PeerId src, td::actor::ActorId<ton::NodeActor> node) {
-      nodes_[src] = std::move(node);
+  void register_node(ton::PeerId src, td::actor::ActorId<ton::NodeActor> node) {
+    nodes_[src] = std::move(node);
+  }
+
+  // getPiece queries to the peer are never answered
+  void set_silent(ton::PeerId peer_id) {
+    silent_.insert(peer_id);
+  }
+  ~PeerManager() {
+    for (auto &it : inbound_channel_) {
+      LOG(ERROR) << it.first << " received " << td::format::as_size(it.second.get_actor_unsafe().total_sent());
     }
-    ~PeerManager() {
-      for (auto &it : inbound_channel_) {
-        LOG(ERROR) << it.first << " received " << td::format::as_size(it.second.get_actor_unsafe().total_sent());
-      }
-      for (auto &it : outbound_channel_) {
-        LOG(ERROR) << it.first << " sent " << td::format::as_size(it.second.get_actor_unsafe().total_sent());
-      }
+    for (auto &it : outbound_channel_) {
+      LOG(ERROR) << it.first << " sent " << td::format::as_size(it.second.get_actor_unsafe().total_sent());
     }
+  }
 
-   private:
-    std::map<std::pair<ton::PeerId, ton::PeerId>, td::actor::ActorId<ton::PeerActor>> peers_;
-    std::map<ton::PeerId, td::actor::ActorId<ton::NodeActor>> nodes_;
-    std::map<ton::PeerId, td::actor::ActorOwn<NetChannel>> inbound_channel_;
-    std::map<ton::PeerId, td::actor::ActorOwn<NetChannel>> outbound_channel_;
+ private:
+  std::map<std::pair<ton::PeerId, ton::PeerId>, td::actor::ActorId<ton::PeerActor>> peers_;
+  std::map<ton::PeerId, td::actor::ActorId<ton::NodeActor>> nodes_;
+  std::map<ton::PeerId, td::actor::ActorOwn<NetChannel>> inbound_channel_;
+  std::map<ton::PeerId, td::actor::ActorOwn<NetChannel>> outbound_channel_;
+  std::set<ton::PeerId> silent_;
+  std::vector<td::Promise<td::BufferSlice>> lost_queries_;
+
+  td::actor::ActorOwn<Sleep> sleep_;
+  void start_up() override {
+    sleep_ = Sleep::create();
+  }
 
-    td::actor::ActorOwn<Sleep> sleep_;
-    void start_up() override {
-      sleep_ = Sleep::create();
+  td::actor::ActorId<NetChannel> get_outbound_channel(ton::PeerId peer_id) {
+    auto &res = outbound_channel_[peer_id];
+    if (res.empty()) {
+      NetChannel::Options options;
+      options.speed = 1000 * MegaByte;
+      options.buffer = 1000 * MegaByte;
+      options.rtt = 0;
+      res = NetChannel::create(options, sleep_.get());
     }
+    return res.get();
+  }
+  td::actor::ActorId<NetChannel> get_inbound_channel(ton::PeerId peer_id) {
+    auto &res = inbound_channel_[peer_id];
+    if (res.empty()) {
+      NetChannel::Options options;
+      options.speed = 1000 * MegaByte;
+      options.buffer = 1000 * MegaByte;
+      options.rtt = 0;
+      res = NetChannel::create(options, sleep_.get());
+    }
+    return res.get();
+  }
+};
 
-    td::actor::ActorId<NetChannel> get_outbound_channel(ton::PeerId peer_id) {
-      auto &res = outbound_channel_[peer_id];
-      if (res.empty()) {
-        NetChannel::Options options;
-        options.speed = 1000 * MegaByte;
-        options.buffer = 1000 * MegaByte;
-        options.rtt = 0;
-        res = NetChannel::create(options, sleep_.get());
+class PeerCreator : public ton::NodeActor::NodeCallback {
+ public:
+  PeerCreator(td::actor::ActorId<PeerManager> peer_manager, ton::PeerId self_id, std::vector<ton::PeerId> peers)
+      : peer_manager_(std::move(peer_manager)), peers_(std::move(peers)), self_id_(self_id) {
+  }
+  void get_peers(ton::PeerId src, td::Promise<std::vector<ton::PeerId>> promise) override {
+    auto peers = peers_;
+    promise.set_value(std::move(peers));
+  }
+  void register_self(td::actor::ActorId<ton::NodeActor> self) override {
+    self_ = self;
+    send_closure(peer_manager_, &PeerManager::register_node, self_id_, self_);
+  }
+  td::actor::ActorOwn<ton::PeerActor> create_peer(ton::PeerId self_id, ton::PeerId peer_id,
+                                                  std::shared_ptr<ton::PeerState> state) override {
+    class PeerCallback : public ton::PeerActor::Callback {
+     public:
+      PeerCallback(ton::PeerId self_id, ton::PeerId peer_id, td::actor::ActorId<PeerManager> peer_manager)
+          : self_id_{self_id}, peer_id_{peer_id}, peer_manager_(peer_manager) {
       }
-      return res.get();
-    }
-    td::actor::ActorId<NetChannel> get_inbound_channel(ton::PeerId peer_id) {
-      auto &res = inbound_channel_[peer_id];
-      if (res.empty()) {
-        NetChannel::Options options;
-        options.speed = 1000 * MegaByte;
-        options.buffer = 1000 * MegaByte;
-        options.rtt = 0;
-        res = NetChannel::create(options, sleep_.get());
+      void register_self(td::actor::ActorId<ton::PeerActor> self) override {
+        self_ = std::move(self);
+        send_closure(peer_manager_, &PeerManager::register_peer, self_id_, peer_id_, self_);
+      }
+      void send_query(td::uint64 query_id, td::BufferSlice query) override {
+        CHECK(!self_.empty());
+        class X : public td::actor::Actor {
+         public:
+          void start_up() override {
+            //LOG(ERROR) << "start";
+            alarm_timestamp() = td::Timestamp::in(4);
+          }
+          void tear_down() override {
+            //LOG(ERROR) << "finish";
+          }
+          void alarm() override {
+            //LOG(FATAL) << "WTF?";
+            alarm_timestamp() = td::Timestamp::in(4);
+          }
+        };
+        send_closure(
+            peer_manager_, &PeerManager::send_query, self_id_, peer_id_, std::move(query),
+            [self = self_, query_id,
+             tmp = td::actor::create_actor<X>(PSLICE() << self_id_ << "->" << peer_id_ << " : " << query_id)](
+                auto x) { promise_send_closure(self, &ton::PeerActor::on_query_result, query_id)(std::move(x)); });
       }
-      return res.get();
-    }
-  };
-
-  class PeerCreator : public ton::NodeActor::NodeCallback {
-   public:
-    PeerCreator(td::actor::ActorId<PeerManager> peer_manager, ton::PeerId self_id, std::vector<ton::PeerId> peers)
-        : peer_manager_(std::move(peer_manager)), peers_(std::move(peers)), self_id_(self_id) {
-    }
-    void get_peers(ton::PeerId src, td::Promise<std::vector<ton::PeerId>> promise) override {
-      auto peers = peers_;
-      promise.set_value(std::move(peers));
-    }
-    void register_self(td::actor::ActorId<ton::NodeActor> self) override {
-      self_ = self;
-      send_closure(peer_manager_, &PeerManager::register_node, self_id_, self_);
-    }
-    td::actor::ActorOwn<ton::PeerActor> create_peer(ton::PeerId self_id, ton::PeerId peer_id,
-                                                    std::shared_ptr<ton::PeerState> state) override {
-      class PeerCallback : public ton::PeerActor::Callback {
-       public:
-        PeerCallback(ton::PeerId self_id, ton::PeerId peer_id, td::actor::ActorId<PeerManager> peer_manager)
-            : self_id_{self_id}, peer_id_{peer_id}, peer_manager_(peer_manager) {
-        }
-        void register_self(td::actor::ActorId<ton::PeerActor> self) override {
-          self_ = std::move(self);
-          send_closure(peer_manager_, &PeerManager::register_peer, self_id_, peer_id_, self_);
-        }
-        void send_query(td::uint64 query_id, td::BufferSlice query) override {
-          CHECK(!self_.empty());
-          class X : public td::actor::Actor {
-           public:
-            void start_up() override {
-              //LOG(ERROR) << "start";
-              alarm_timestamp() = td::Timestamp::in(4);
-            }
-            void tear_down() override {
-              //LOG(ERROR) << "finish";
-            }
-            void alarm() override {
-              //LOG(FATAL) << "WTF?";
-              alarm_timestamp() = td::Timestamp::in(4);
-            }
-          };
-          send_closure(
-              peer_manager_, &PeerManager::send_query, self_id_, peer_id_, std::move(query),
-              [self = self_, query_id,
-               tmp = td::actor::create_actor<X>(PSLICE() << self_id_ << "->" << peer_id_ << " : " << query_id)](
-                  auto x) { promise_send_closure(self, &ton::PeerActor::on_query_result, query_id)(std::move(x)); });
-        }
 
-       private:
-        ton::PeerId self_id_;
-        ton::PeerId peer_id_;
-        td::actor::ActorId<ton::PeerActor> self_;
-        td::actor::ActorId<PeerManager> peer_manager_;
-      };
+     private:
+      ton::PeerId self_id_;
+      ton::PeerId peer_id_;
+      td::actor::ActorId<ton::PeerActor> self_;
+      td::actor::ActorId<PeerManager> peer_manager_;
+    };
 
-      return td::actor::create_actor<ton::PeerActor>(PSLICE() << "ton::PeerActor " << self_id << "->" << peer_id,
-                                                     td::make_unique<PeerCallback>(self_id, peer_id, peer_manager_),
-                                                     std::move(state));
-    }
+    return td::actor::create_actor<ton::PeerActor>(PSLICE() << "ton::PeerActor " << self_id << "->" << peer_id,
+                                                   td::make_unique<PeerCallback>(self_id, peer_id, peer_manager_),
+                                                   std::move(state));
+  }
 
-   private:
-    td::actor::ActorId<PeerManager> peer_manager_;
-    std::vector<ton::PeerId> peers_;
-    ton::PeerId self_id_;
-    td::actor::ActorId<ton::NodeActor> self_;
-  };
+ private:
+  td::actor::ActorId<PeerManager> peer_manager_;
+  std::vector<ton::PeerId> peers_;
+  ton::PeerId self_id_;
+  td::actor::ActorId<ton::NodeActor> self_;
+};
 
-  class TorrentCallback : public ton::NodeActor::Callback {
-   public:
-    TorrentCallback(std::shared_ptr<td::Destructor> stop_watcher, std::shared_ptr<td::Destructor> complete_watcher)
-        : stop_watcher_(stop_watcher), complete_watcher_(complete_watcher) {
-    }
+class TorrentCallback : public ton::NodeActor::Callback {
+ public:
+  TorrentCallback(std::shared_ptr<td::Destructor> stop_watcher, std::shared_ptr<td::Destructor> complete_watcher)
+      : stop_watcher_(stop_watcher), complete_watcher_(complete_watcher) {
+  }
 
-    void on_completed() override {
-      complete_watcher_.reset();
-    }
+  void on_completed() override {
+    complete_watcher_.reset();
+  }
 
-    void on_closed(ton::Torrent torrent) override {
-      CHECK(torrent.is_completed());
-      //TODO: validate torrent
-      stop_watcher_.reset();
-    }
+  void on_closed(ton::Torrent torrent) override {
+    CHECK(torrent.is_completed());
+    //TODO: validate torrent
+    stop_watcher_.reset();
+  }
 
-   private:
-    std::shared_ptr<td::Destructor> stop_watcher_;
-    std::shared_ptr<td::Destructor> complete_watcher_;
-  };
+ private:
+  std::shared_ptr<td::Destructor> stop_watcher_;
+  std::shared_ptr<td::Destructor> complete_watcher_;
+};
 
+TEST(Torrent, Peer) {
   size_t peers_n = 20;
   td::uint64 file_size = 200 * MegaByte;
   td::Random::Xorshift128plus rnd(123);
@@ -1362,3 +1415,66 @@ TEST(Torrent, Peer) {
   complete_watcher.reset();
   scheduler.run();
 }
+
+TEST(Torrent, QueriesWindow) {
+  using ton::NodeActor;
+  td::uint64 piece_size = 128 * KiloByte;
+  ASSERT_EQ(NodeActor::INITIAL_PEER_QUERIES, NodeActor::calc_peer_queries_window(0, 0, piece_size));
+  ASSERT_EQ(NodeActor::INITIAL_PEER_QUERIES, NodeActor::calc_peer_queries_window(100 * MegaByte, 0, piece_size));
+  // slow peer: the window doesn't drop below the minimum
+  ASSERT_EQ(NodeActor::MIN_PEER_QUERIES, NodeActor::calc_peer_queries_window(1 * KiloByte, 0.1, piece_size));
+  // 10 MB/s with 0.1s latency: ~8 pieces on the wire, twice as many with headroom
+  ASSERT_EQ(17u, NodeActor::calc_peer_queries_window(10 * MegaByte, 0.1, piece_size));
+  ASSERT_EQ(33u, NodeActor::calc_peer_queries_window(10 * MegaByte, 0.2, piece_size));
+  ASSERT_EQ(9u, NodeActor::calc_peer_queries_window(10 * MegaByte, 0.1, 2 * piece_size));
+  // fast peer far away: the window is capped
+  ASSERT_EQ(NodeActor::MAX_PEER_QUERIES, NodeActor::calc_peer_queries_window(1000 * MegaByte, 1, piece_size));
+}
+
+TEST(Torrent, Endgame) {
+  // One of the seeders accepts getPiece queries but never answers them. Its window is never freed, so the parts
+  // it holds can be downloaded only by the endgame duplicates sent to the other seeders.
+  td::uint64 file_size = 4 * MegaByte;
+  ton::PeerId seeders_n = 3;
+  ton::PeerId leecher_id = seeders_n + 1;
+  std::vector<ton::Torrent> seeders;
+  for (ton::PeerId i = 1; i <= seeders_n; i++) {
+    td::Random::Xorshift128plus rnd(123);
+    seeders.push_back(create_random_torrent(rnd, file_size, 128 * KiloByte).torrent.unwrap());
+  }
+  auto info = seeders[0].get_info();
+  std::vector<ton::PeerId> seeder_ids;
+  for (ton::PeerId i = 1; i <= seeders_n; i++) {
+    seeder_ids.push_back(i);
+  }
+
+  auto stop_watcher = td::create_shared_destructor([] { td::actor::SchedulerContext::get()->stop(); });
+  auto guard = std::make_shared<std::vector<td::actor::ActorOwn<>>>();
+  auto complete_watcher = td::create_shared_destructor([guard] {});
+
+  td::actor::Scheduler scheduler({0}, true);
+
+  scheduler.run_in_context([&] {
+    auto peer_manager = td::actor::create_actor<PeerManager>("PeerManager");
+    send_closure(peer_manager, &PeerManager::set_silent, 1);
+    for (ton::PeerId i = 1; i <= seeders_n; i++) {
+      guard->push_back(td::actor::create_actor<ton::NodeActor>(
+          PSLICE() << "Node#" << i, i, std::move(seeders[i - 1]),
+          td::make_unique<TorrentCallback>(stop_watcher, complete_watcher),
+          td::make_unique<PeerCreator>(peer_manager.get(), i, std::vector<ton::PeerId>{}), nullptr,
+          ton::SpeedLimiters{}));
+    }
+    ton::Torrent::Options options;
+    options.in_memory = true;
+    auto torrent = ton::Torrent::open(options, ton::TorrentMeta(info)).move_as_ok();
+    guard->push_back(td::actor::create_actor<ton::NodeActor>(
+        PSLICE() << "Node#" << leecher_id, leecher_id, std::move(torrent),
+        td::make_unique<TorrentCallback>(stop_watcher, complete_watcher),
+        td::make_unique<PeerCreator>(peer_manager.get(), leecher_id, seeder_ids), nullptr, ton::SpeedLimiters{}));
+    guard->push_back(std::move(peer_manager));
+  });
+  stop_watcher.reset();
+  guard.reset();
+  complete_watcher.reset();
+  scheduler.run();
+}
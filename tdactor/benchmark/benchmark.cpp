@@ -47,6 +47,7 @@ extern "C" {
 
 #include "td/utils/benchmark.h"
 #include "td/utils/crypto.h"
+#include "td/utils/Heap.h"
 #include "td/utils/logging.h"
 #include "td/utils/misc.h"
 #include "td/utils/MpmcQueue.h"
@@ -58,6 +59,7 @@ extern "C" {
 #include "td/utils/Status.h"
 #include "td/utils/StealingQueue.h"
 #include "td/utils/ThreadSafeCounter.h"
+#include "td/utils/TimerWheel.h"
 #include "td/utils/UInt.h"
 #include "td/utils/VectorQueue.h"
 
@@ -1637,6 +1639,93 @@ class YieldMany : public td::Benchmark {
   bool use_io_{false};
 };
 
+// Alarms of TIMERS_N actors: each operation moves one alarm, time goes forward and expired alarms are rearmed
+template <class Impl>
+class AlarmQueueBenchmark : public td::Benchmark {
+ public:
+  static constexpr int TIMERS_N = 1000000;
+  std::string get_description() const override {
+    return PSTRING() << "AlarmQueue " << Impl::get_description() << " timers=" << TIMERS_N;
+  }
+  void start_up() override {
+    nodes_ = std::vector<typename Impl::Node>(TIMERS_N);
+    impl_ = std::make_unique<Impl>(now_);
+    for (auto &node : nodes_) {
+      impl_->insert(random_timeout(), &node);
+    }
+  }
+  void tear_down() override {
+    impl_.reset();
+    nodes_.clear();
+  }
+  void run(int n) override {
+    for (int i = 0; i < n; i++) {
+      impl_->fix(random_timeout(), &nodes_[rnd_.fast(0, TIMERS_N - 1)]);
+      now_ += 0.00001;
+      while (auto *node = impl_->pop_expired(now_)) {
+        impl_->insert(random_timeout(), node);
+      }
+    }
+  }
+
+ private:
+  double now_ = 1000;
+  td::Random::Xorshift128plus rnd_{123};
+  std::vector<typename Impl::Node> nodes_;
+  std::unique_ptr<Impl> impl_;
+
+  double random_timeout() {
+    return now_ + rnd_.fast(1, 30000) * 0.001;
+  }
+};
+
+class HeapAlarms {
+ public:
+  using Node = td::HeapNode;
+  static const char *get_description() {
+    return "KHeap";
+  }
+  explicit HeapAlarms(double now) {
+  }
+  void insert(double at, Node *node) {
+    heap_.insert(at, node);
+  }
+  void fix(double at, Node *node) {
+    heap_.fix(at, node);
+  }
+  Node *pop_expired(double now) {
+    if (heap_.empty() || heap_.top_key() > now) {
+      return nullptr;
+    }
+    return heap_.pop();
+  }
+
+ private:
+  td::KHeap<double> heap_;
+};
+
+class WheelAlarms {
+ public:
+  using Node = td::TimerWheelNode;
+  static const char *get_description() {
+    return "TimerWheel";
+  }
+  explicit WheelAlarms(double now) : wheel_(now) {
+  }
+  void insert(double at, Node *node) {
+    wheel_.insert(at, node);
+  }
+  void fix(double at, Node *node) {
+    wheel_.fix(at, node);
+  }
+  Node *pop_expired(double now) {
+    return wheel_.pop_expired(now);
+  }
+
+ private:
+  td::TimerWheel<> wheel_;
+};
+
 int main(int argc, char **argv) {
   if (argc > 1) {
     if (argv[1][0] == 'a') {
@@ -1662,6 +1751,8 @@ int main(int argc, char **argv) {
   bench(ChainedSpawnInplace(true));
   bench(ChainedSpawn(false));
   bench(ChainedSpawn(true));
+  bench(AlarmQueueBenchmark<HeapAlarms>());
+  bench(AlarmQueueBenchmark<WheelAlarms>());
 
   run_queue_bench(10, 10);
   run_queue_bench(10, 1);
@@ -1,5 +1,6 @@
 #include "ActorStats.h"
 
+#include "td/utils/JsonBuilder.h"
 #include "td/utils/ThreadSafeCounter.h"
 namespace td {
 namespace actor {
@@ -23,8 +24,65 @@ double ActorStats::estimate_inv_ticks_per_second() {
   return estimated_inv_ticks_per_second;
 }
 
-std::string ActorStats::prepare_stats() {
+namespace {
+// counters are rates, so name.count is reported as name.qps and name.duration as name.load
+std::string rewrite_perf_counter_name(const std::string &name) {
+  auto dot_at = name.rfind('.');
+  CHECK(dot_at != std::string::npos);
+  auto base_name = name.substr(0, dot_at);
+  auto rest_name = name.substr(dot_at + 1);
+  td::Slice new_rest_name = rest_name;
+  if (rest_name == "count") {
+    new_rest_name = "qps";
+  }
+  if (rest_name == "duration") {
+    new_rest_name = "load";
+  }
+  return PSTRING() << base_name << "." << new_rest_name;
+}
+
+template <class F>
+class JsonLambda : public td::Jsonable {
+ public:
+  explicit JsonLambda(F f) : f_(std::move(f)) {
+  }
+  void store(td::JsonValueScope *scope) const {
+    f_(scope);
+  }
+
+ private:
+  F f_;
+};
+template <class F>
+JsonLambda<F> json_lambda(F f) {
+  return JsonLambda<F>(std::move(f));
+}
+
+// values for the 10sec, 10min and whole uptime windows
+auto json_windows(double value_10s, double value_10m, double value_forever) {
+  return json_lambda([=](td::JsonValueScope *scope) {
+    auto ja = scope->enter_array();
+    ja << value_10s << value_10m << value_forever;
+  });
+}
+}  // namespace
+
+template <class F>
+void ActorStats::for_each_counter(F &&f) {
+  NamedPerfCounter::get_default().for_each(f);
+  Debug(SchedulerContext::get()->scheduler_group())
+      .for_each_cpu_worker([&](size_t scheduler_id, size_t cpu_id, const core::WorkerStat &stat, size_t) {
+        auto prefix = PSTRING() << "worker_" << scheduler_id << "_cpu" << cpu_id;
+        f(prefix + "_execute.count", td::int64(stat.messages.load(std::memory_order_relaxed)));
+        f(prefix + "_execute.duration", td::int64(stat.execute_ticks.load(std::memory_order_relaxed)));
+        f(prefix + "_steal.count", td::int64(stat.steals.load(std::memory_order_relaxed)));
+      });
+}
+
+ActorStats::Snapshot ActorStats::collect_stats() {
+  Snapshot snapshot;
   auto estimated_inv_ticks_per_second = estimate_inv_ticks_per_second();
+  snapshot.inv_ticks_per_second = estimated_inv_ticks_per_second;
 
   auto current_stats = td::actor::ActorTypeStatManager::get_stats(estimated_inv_ticks_per_second);
   auto now = td::Timestamp::now();
@@ -43,17 +101,17 @@ std::string ActorStats::prepare_stats() {
     res /= duration;
     return res.stats;
   };
-  auto stats_10s = load_stats(stat_[0]);
-  auto stats_10m = load_stats(stat_[1]);
+  snapshot.stats_10s = load_stats(stat_[0]);
+  snapshot.stats_10m = load_stats(stat_[1]);
   current_stats /= double(now_ticks - begin_ticks_) * estimated_inv_ticks_per_second;
-  auto stats_forever = current_stats.stats;
+  snapshot.stats_forever = current_stats.stats;
+  snapshot.now_seconds = double(now_ticks) * estimated_inv_ticks_per_second;
 
-  std::map<std::string, double> current_perf_map;
-  std::map<std::string, double> perf_map_10s;
-  std::map<std::string, double> perf_map_10m;
+  auto &current_perf_map = snapshot.perf_map_forever;
+  auto &perf_map_10s = snapshot.perf_map_10s;
+  auto &perf_map_10m = snapshot.perf_map_10m;
   std::map<std::string, double> perf_values;
-  td::NamedPerfCounter::get_default().for_each(
-      [&](td::Slice name, td::int64 value_int64) { perf_values[name.str()] = double(value_int64); });
+  for_each_counter([&](td::Slice name, td::int64 value_int64) { perf_values[name.str()] = double(value_int64); });
   for (auto &value_it : perf_values) {
     const auto &name = value_it.first;
     auto value = value_it.second;
@@ -85,26 +143,26 @@ std::string ActorStats::prepare_stats() {
     // current_perf_map[name + ".raw"] = double(value);
     // current_perf_map[name + ".range"] = double(now_ticks - begin_ticks_) * estimated_inv_ticks_per_second;
   };
+  return snapshot;
+}
+
+std::string ActorStats::prepare_stats() {
+  auto snapshot = collect_stats();
+  auto estimated_inv_ticks_per_second = snapshot.inv_ticks_per_second;
+  auto &stats_10s = snapshot.stats_10s;
+  auto &stats_10m = snapshot.stats_10m;
+  auto &stats_forever = snapshot.stats_forever;
+  auto &perf_map_10s = snapshot.perf_map_10s;
+  auto &perf_map_10m = snapshot.perf_map_10m;
+  auto &current_perf_map = snapshot.perf_map_forever;
 
   td::StringBuilder sb;
   sb << "================================= PERF COUNTERS ================================\n";
   sb << "ticks_per_second_estimate\t" << 1.0 / estimated_inv_ticks_per_second << "\n";
   for (auto &it : perf_map_10s) {
     const std::string &name = it.first;
-    auto dot_at = name.rfind('.');
-    CHECK(dot_at != std::string::npos);
-    auto base_name = name.substr(0, dot_at);
-    auto rest_name = name.substr(dot_at + 1);
-    td::Slice new_rest_name = rest_name;
-    if (rest_name == "count") {
-      new_rest_name = "qps";
-    }
-    if (rest_name == "duration") {
-      new_rest_name = "load";
-    }
-    auto rewrite_name = PSTRING() << base_name << "." << new_rest_name;
-    sb << rewrite_name << "\t" << perf_map_10s[name] << " " << perf_map_10m[name] << " " << current_perf_map[name]
-       << "\n";
+    sb << rewrite_perf_counter_name(name) << "\t" << perf_map_10s[name] << " " << perf_map_10m[name] << " "
+       << current_perf_map[name] << "\n";
   }
   sb << "\n";
   sb << "================================= ACTORS STATS =================================\n";
@@ -147,6 +205,15 @@ std::string ActorStats::prepare_stats() {
             : double(td::Clocks::rdtsc()) * estimated_inv_ticks_per_second - stat_forever.executing_start;
     sb() << "max_delay:\t" << stat_forever.max_delay_seconds.value_10s << "s "
          << stat_forever.max_delay_seconds.value_10m << "s " << stat_forever.max_delay_seconds.value_forever << "s\n";
+    auto quantiles = [&](td::Slice name, double q, TicksHistogram ActorTypeStat::*histogram) {
+      sb() << name << ":\t" << (stat_10s.*histogram).quantile(q, estimated_inv_ticks_per_second) << "s "
+           << (stat_10m.*histogram).quantile(q, estimated_inv_ticks_per_second) << "s "
+           << (stat_forever.*histogram).quantile(q, estimated_inv_ticks_per_second) << "s\n";
+    };
+    quantiles("delay_p50", 0.5, &ActorTypeStat::delay_histogram);
+    quantiles("delay_p99", 0.99, &ActorTypeStat::delay_histogram);
+    quantiles("message_seconds_p50", 0.5, &ActorTypeStat::message_histogram);
+    quantiles("message_seconds_p99", 0.99, &ActorTypeStat::message_histogram);
     sb() << ""
          << "alive: " << stat_forever.alive << " executing: " << stat_forever.executing
          << " max_executing_for: " << executing_for << "s\n";
@@ -188,7 +255,7 @@ std::string ActorStats::prepare_stats() {
   top_k_by(stats_10m, 10, "load_10m", [](auto &x) { return cutoff(x.second.seconds, 0.005); });
   top_k_by(stats_forever, 10, "max_execute_seconds_10m",
            [](Entry &x) { return cutoff(x.second.max_execute_seconds.value_10m, 0.5); });
-  auto rdtsc_seconds = double(now_ticks) * estimated_inv_ticks_per_second;
+  auto rdtsc_seconds = snapshot.now_seconds;
   top_k_by(stats_forever, 10, "executing_for", [&](Entry &x) {
     if (x.second.executing_start > 1e15) {
       return 0.0;
@@ -220,6 +287,80 @@ std::string ActorStats::prepare_stats() {
   sb << "\n";
   return sb.as_cslice().str();
 }
+
+std::string ActorStats::prepare_stats_json() {
+  auto snapshot = collect_stats();
+  auto inv_ticks_per_second = snapshot.inv_ticks_per_second;
+  auto debug = Debug(SchedulerContext::get()->scheduler_group());
+
+  td::JsonBuilder jb;
+  auto jo = jb.enter_object();
+  jo("ticks_per_second", 1.0 / inv_ticks_per_second);
+  jo("perf_counters", json_lambda([&](td::JsonValueScope *scope) {
+       auto counters = scope->enter_object();
+       for (auto &it : snapshot.perf_map_10s) {
+         counters(rewrite_perf_counter_name(it.first),
+                  json_windows(it.second, snapshot.perf_map_10m[it.first], snapshot.perf_map_forever[it.first]));
+       }
+     }));
+  jo("cpu_workers", json_lambda([&](td::JsonValueScope *scope) {
+       auto workers = scope->enter_array();
+       debug.for_each_cpu_worker([&](size_t scheduler_id, size_t cpu_id, const core::WorkerStat &stat, size_t size) {
+         auto worker_value = workers.enter_value();
+         auto worker = worker_value.enter_object();
+         worker("scheduler", td::int64(scheduler_id));
+         worker("cpu", td::int64(cpu_id));
+         worker("local_queue_size", td::int64(size));
+         worker("messages", td::int64(stat.messages.load(std::memory_order_relaxed)));
+         worker("steals", td::int64(stat.steals.load(std::memory_order_relaxed)));
+       });
+     }));
+  jo("priority_queues", json_lambda([&](td::JsonValueScope *scope) {
+       auto queues = scope->enter_array();
+       debug.for_each_priority_queue([&](size_t scheduler_id, td::Slice name, size_t size) {
+         auto queue_value = queues.enter_value();
+         auto queue = queue_value.enter_object();
+         queue("scheduler", td::int64(scheduler_id));
+         queue("priority", name);
+         queue("size", td::int64(size));
+       });
+     }));
+  jo("actors", json_lambda([&](td::JsonValueScope *scope) {
+       auto actors = scope->enter_array();
+       for (auto &it : snapshot.stats_forever) {
+         auto &stat_10s = snapshot.stats_10s[it.first];
+         auto &stat_10m = snapshot.stats_10m[it.first];
+         auto &stat_forever = it.second;
+         auto actor_value = actors.enter_value();
+         auto actor = actor_value.enter_object();
+         actor("name", ActorTypeStatManager::get_class_name(it.first.name()));
+         actor("alive", stat_forever.alive);
+         actor("executing", stat_forever.executing);
+         actor("load", json_windows(stat_10s.seconds, stat_10m.seconds, stat_forever.seconds));
+         actor("messages_per_second", json_windows(stat_10s.messages, stat_10m.messages, stat_forever.messages));
+         actor("created_per_second", json_windows(stat_10s.created, stat_10m.created, stat_forever.created));
+         auto max_windows = [](const auto &group) {
+           return json_windows(group.value_10s, group.value_10m, group.value_forever);
+         };
+         actor("max_execute_messages", max_windows(stat_forever.max_execute_messages));
+         actor("max_execute_seconds", max_windows(stat_forever.max_execute_seconds));
+         actor("max_message_seconds", max_windows(stat_forever.max_message_seconds));
+         actor("max_delay_seconds", max_windows(stat_forever.max_delay_seconds));
+         for (auto q : {50, 90, 99}) {
+           auto quantile = [&](TicksHistogram ActorTypeStat::*histogram) {
+             return json_windows((stat_10s.*histogram).quantile(q * 0.01, inv_ticks_per_second),
+                                 (stat_10m.*histogram).quantile(q * 0.01, inv_ticks_per_second),
+                                 (stat_forever.*histogram).quantile(q * 0.01, inv_ticks_per_second));
+           };
+           actor(PSLICE() << "delay_seconds_p" << q, quantile(&ActorTypeStat::delay_histogram));
+           actor(PSLICE() << "message_seconds_p" << q, quantile(&ActorTypeStat::message_histogram));
+         }
+       }
+     }));
+  jo.leave();
+  return jb.string_builder().as_cslice().str();
+}
+
 ActorStats::PefStat::PefStat() {
   for (std::size_t i = 0; i < SIZE; i++) {
     perf_stat_[i] = td::TimedStat<StatStorer<td::int64>>(DURATIONS[i], td::Time::now());
@@ -232,7 +373,7 @@ void ActorStats::update(td::Timestamp now) {
   for (auto &timed_stat : stat_) {
     timed_stat.add_event(stat, now.at());
   }
-  NamedPerfCounter::get_default().for_each([&](td::Slice name, td::int64 value) {
+  for_each_counter([&](td::Slice name, td::int64 value) {
     auto &stat = pef_stats_[name.str()].perf_stat_;
     for (auto &timed_stat : stat) {
       timed_stat.add_event(value, now.at());
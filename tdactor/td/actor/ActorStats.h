@@ -11,8 +11,25 @@ class ActorStats : public td::actor::Actor {
   void start_up() override;
   double estimate_inv_ticks_per_second();
   std::string prepare_stats();
+  // the same statistics as a json object for monitoring systems
+  std::string prepare_stats_json();
 
  private:
+  struct Snapshot {
+    double inv_ticks_per_second{};
+    double now_seconds{};
+    std::map<std::type_index, ActorTypeStat> stats_10s;
+    std::map<std::type_index, ActorTypeStat> stats_10m;
+    std::map<std::type_index, ActorTypeStat> stats_forever;
+    std::map<std::string, double> perf_map_10s;
+    std::map<std::string, double> perf_map_10m;
+    std::map<std::string, double> perf_map_forever;
+  };
+  Snapshot collect_stats();
+  // named perf counters together with counters of cpu workers
+  template <class F>
+  static void for_each_counter(F &&f);
+
   template <class T>
   struct StatStorer {
     void on_event(const T &event) {
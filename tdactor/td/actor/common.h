@@ -26,11 +26,13 @@
 
 #include "td/actor/PromiseFuture.h"
 
+#include "td/utils/port/numa.h"
 #include "td/utils/Timer.h"
 
 namespace td {
 namespace actor {
 using core::ActorOptions;
+using core::ActorPriority;
 
 // Replacement for core::ActorSignals. Easier to use and do not allow internal signals
 class ActorSignals {
@@ -91,15 +93,42 @@ struct Debug {
       }
     });
     sb << "\nsizes of cpu local queues:\n";
-    for (auto &scheduler : group_info_->schedulers) {
+    for_each_cpu_worker([&](size_t scheduler_id, size_t i, const core::WorkerStat &, size_t size) {
+      if (size != 0) {
+        sb << "\t#" << scheduler_id << ":cpu#" << i << " queue.size() = " << size << "\n";
+      }
+    });
+    sb << "\nsizes of cpu priority queues:\n";
+    for_each_priority_queue([&](size_t scheduler_id, Slice name, size_t size) {
+      if (size != 0) {
+        sb << "\t#" << scheduler_id << " " << name << " queue.size() = " << size << "\n";
+      }
+    });
+    sb << "\n";
+  }
+
+  // f(scheduler_id, cpu_worker_id, worker stat, local queue size)
+  template <class F>
+  void for_each_cpu_worker(F &&f) {
+    for (size_t scheduler_id = 0; scheduler_id < group_info_->schedulers.size(); scheduler_id++) {
+      auto &scheduler = group_info_->schedulers[scheduler_id];
       for (size_t i = 0; i < scheduler.cpu_threads_count; i++) {
-        auto size = scheduler.cpu_local_queue[i].size();
-        if (size != 0) {
-          sb << "\tcpu#" << i << " queue.size() = " << size << "\n";
-        }
+        f(scheduler_id, i, scheduler.cpu_workers[i]->stat, scheduler.cpu_local_queue[i].size());
       }
     }
-    sb << "\n";
+  }
+
+  // f(scheduler_id, priority class name, queue size)
+  template <class F>
+  void for_each_priority_queue(F &&f) {
+    for (size_t scheduler_id = 0; scheduler_id < group_info_->schedulers.size(); scheduler_id++) {
+      auto &scheduler = group_info_->schedulers[scheduler_id];
+      if (scheduler.cpu_threads_count == 0) {
+        continue;
+      }
+      f(scheduler_id, Slice("critical"), scheduler.cpu_critical_queue->size.load(std::memory_order_relaxed));
+      f(scheduler_id, Slice("background"), scheduler.cpu_background_queue->size.load(std::memory_order_relaxed));
+    }
   }
 
  private:
@@ -113,10 +142,49 @@ class Scheduler {
     }
     NodeInfo(size_t cpu_threads, size_t io_threads) : cpu_threads_(cpu_threads), io_threads_(io_threads) {
     }
+    NodeInfo &with_timer_wheel(bool use_timer_wheel = true) {
+      use_timer_wheel_ = use_timer_wheel;
+      return *this;
+    }
+    NodeInfo &with_cpu_affinity(std::vector<td::int32> cpus) {
+      cpu_affinity_ = std::move(cpus);
+      return *this;
+    }
     size_t cpu_threads_;
     size_t io_threads_{1};
+    // keep alarms in a timer wheel instead of a heap; for schedulers with many frequently updated alarms
+    bool use_timer_wheel_{false};
+    // cpus for the threads of the scheduler, empty means no pinning
+    // io worker of the first scheduler runs in the caller's thread and is never pinned
+    std::vector<td::int32> cpu_affinity_;
   };
 
+  // One scheduler per NUMA node, pinned to the cpus of the node. Cpu threads are split proportionally to node sizes.
+  // Actors stay on the scheduler they were created on, so a subsystem started with ActorOptions().on_scheduler(id)
+  // keeps its memory local to one node.
+  static std::vector<NodeInfo> numa_node_infos(size_t cpu_threads) {
+    auto nodes = td::get_numa_nodes();
+    if (cpu_threads == 0) {
+      return {NodeInfo(0).with_cpu_affinity(std::move(nodes[0].cpus))};
+    }
+    if (nodes.size() > cpu_threads) {
+      nodes.resize(cpu_threads);
+    }
+    size_t total_cpus = 0;
+    for (auto &node : nodes) {
+      total_cpus += node.cpus.size();
+    }
+    std::vector<NodeInfo> infos;
+    size_t left = cpu_threads;
+    for (size_t i = 0; i < nodes.size(); i++) {
+      size_t threads = i + 1 == nodes.size() ? left : cpu_threads * nodes[i].cpus.size() / total_cpus;
+      threads = td::clamp<size_t>(threads, 1, left - (nodes.size() - i - 1));
+      left -= threads;
+      infos.push_back(NodeInfo(threads).with_cpu_affinity(std::move(nodes[i].cpus)));
+    }
+    return infos;
+  }
+
   enum Mode { Running, Paused };
   Scheduler(std::vector<NodeInfo> infos, bool skip_timeouts = false, Mode mode = Paused)
       : infos_(std::move(infos)), skip_timeouts_(skip_timeouts) {
@@ -148,6 +216,10 @@ class Scheduler {
           }
         });
         thread.set_name(PSLICE() << "#" << it << ":io");
+        if (!infos_[it].cpu_affinity_.empty()) {
+          auto status = thread.set_affinity(infos_[it].cpu_affinity_);
+          LOG_IF(WARNING, status.is_error()) << "Failed to pin io worker: " << status;
+        }
         thread.detach();
       }
     }
@@ -206,7 +278,10 @@ class Scheduler {
     td::uint8 id = 0;
     for (const auto &info : infos_) {
       schedulers_.emplace_back(
-          td::make_unique<core::Scheduler>(group_info_, core::SchedulerId{id}, info.cpu_threads_, skip_timeouts_));
+          td::make_unique<core::Scheduler>(group_info_, core::SchedulerId{id}, info.cpu_threads_, skip_timeouts_,
+                                           info.use_timer_wheel_ ? core::ActorAlarmQueue::Type::TimerWheel
+                                                                 : core::ActorAlarmQueue::Type::Heap));
+      schedulers_.back()->set_cpu_affinity(info.cpu_affinity_);
       id++;
     }
   }
@@ -215,6 +290,7 @@ class Scheduler {
 using core::ActorTypeStat;
 using core::ActorTypeStatManager;
 using core::ActorTypeStats;
+using core::TicksHistogram;
 
 // Some helper functions. Not part of public interface and not part
 // of namespace core
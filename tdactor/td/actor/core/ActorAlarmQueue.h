@@ -0,0 +1,114 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#pragma once
+
+#include "td/actor/core/ActorInfo.h"
+
+#include "td/utils/common.h"
+#include "td/utils/Heap.h"
+#include "td/utils/TimerWheel.h"
+
+#include <limits>
+
+namespace td {
+namespace actor {
+namespace core {
+// Alarms of actors owned by one scheduler. Backed either by a binary heap or by a hierarchical timer wheel,
+// which makes set/cancel O(1) for schedulers with many short-living timeouts.
+class ActorAlarmQueue {
+ public:
+  enum class Type { Heap, TimerWheel };
+
+  explicit ActorAlarmQueue(Type type = Type::Heap) : type_(type) {
+    if (type_ == Type::TimerWheel) {
+      wheel_ = std::make_unique<TimerWheel<>>(Time::now());
+    }
+  }
+
+  Type get_type() const {
+    return type_;
+  }
+
+  bool empty() const {
+    return type_ == Type::Heap ? heap_.empty() : wheel_->empty();
+  }
+
+  bool contains(ActorInfo *actor_info) {
+    return type_ == Type::Heap ? actor_info->as_heap_node()->in_heap()
+                               : actor_info->as_timer_wheel_node()->in_wheel();
+  }
+  void insert(double at, ActorInfo *actor_info) {
+    if (type_ == Type::Heap) {
+      heap_.insert(at, actor_info->as_heap_node());
+    } else {
+      wheel_->insert(at, actor_info->as_timer_wheel_node());
+    }
+  }
+  void fix(double at, ActorInfo *actor_info) {
+    if (type_ == Type::Heap) {
+      heap_.fix(at, actor_info->as_heap_node());
+    } else {
+      wheel_->fix(at, actor_info->as_timer_wheel_node());
+    }
+  }
+  void erase(ActorInfo *actor_info) {
+    if (type_ == Type::Heap) {
+      heap_.erase(actor_info->as_heap_node());
+    } else {
+      wheel_->erase(actor_info->as_timer_wheel_node());
+    }
+  }
+
+  // Returns an actor with alarm at or before now, nullptr if there is none
+  ActorInfo *pop_expired(double now) {
+    if (type_ == Type::Heap) {
+      if (heap_.empty() || heap_.top_key() > now) {
+        return nullptr;
+      }
+      return ActorInfo::from_heap_node(heap_.pop());
+    }
+    auto *node = wheel_->pop_expired(now);
+    return node == nullptr ? nullptr : ActorInfo::from_timer_wheel_node(node);
+  }
+
+  // Time of the next wakeup needed to process alarms, +inf if there are no alarms
+  double next_wakeup() const {
+    if (type_ == Type::Heap) {
+      return heap_.empty() ? std::numeric_limits<double>::infinity() : heap_.top_key();
+    }
+    return wheel_->next_expiration();
+  }
+
+  template <class F>
+  void for_each(F &&f) {
+    if (type_ == Type::Heap) {
+      heap_.for_each([&](auto &key, auto &node) { f(ActorInfo::from_heap_node(node)); });
+    } else {
+      wheel_->for_each([&](double key, TimerWheelNode *node) { f(ActorInfo::from_timer_wheel_node(node)); });
+    }
+  }
+
+ private:
+  Type type_;
+  KHeap<double> heap_;
+  std::unique_ptr<TimerWheel<>> wheel_;
+};
+}  // namespace core
+}  // namespace actor
+}  // namespace td
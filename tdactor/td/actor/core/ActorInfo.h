@@ -18,13 +18,14 @@
 */
 #pragma once
 
+#include "td/actor/core/ActorPriority.h"
 #include "td/actor/core/ActorState.h"
 #include "td/actor/core/ActorTypeStat.h"
 #include "td/actor/core/ActorMailbox.h"
 
 #include "td/utils/Heap.h"
-#include "td/utils/List.h"
 #include "td/utils/Time.h"
+#include "td/utils/TimerWheel.h"
 #include "td/utils/SharedObjectPool.h"
 
 namespace td {
@@ -33,10 +34,11 @@ namespace core {
 class Actor;
 class ActorInfo;
 using ActorInfoPtr = SharedObjectPool<ActorInfo>::Ptr;
-class ActorInfo : private HeapNode, private ListNode {
+class ActorInfo : private HeapNode, private TimerWheelNode {
  public:
-  ActorInfo(std::unique_ptr<Actor> actor, ActorState::Flags state_flags, Slice name, td::uint32 actor_stat_id)
-      : actor_(std::move(actor)), name_(name.begin(), name.size()), actor_stat_id_(actor_stat_id) {
+  ActorInfo(std::unique_ptr<Actor> actor, ActorState::Flags state_flags, Slice name, td::uint32 actor_stat_id,
+            ActorPriority priority = ActorPriority::Normal)
+      : actor_(std::move(actor)), name_(name.begin(), name.size()), actor_stat_id_(actor_stat_id), priority_(priority) {
     state_.set_flags_unsafe(state_flags);
     VLOG(actor) << "Create actor [" << name_ << "]";
   }
@@ -64,6 +66,7 @@ class ActorInfo : private HeapNode, private ListNode {
     auto res = ActorTypeStatManager::get_actor_type_stat(actor_stat_id_, actor_.get());
     if (in_queue_since_) {
       res.pop_from_queue(in_queue_since_);
+      ActorPriorityStat::on_delay(priority_, td::Clocks::rdtsc() - in_queue_since_);
       in_queue_since_ = 0;
     }
     return res;
@@ -83,6 +86,9 @@ class ActorInfo : private HeapNode, private ListNode {
   CSlice get_name() const {
     return name_;
   }
+  ActorPriority get_priority() const {
+    return priority_;
+  }
 
   HeapNode *as_heap_node() {
     return this;
@@ -90,6 +96,12 @@ class ActorInfo : private HeapNode, private ListNode {
   static ActorInfo *from_heap_node(HeapNode *node) {
     return static_cast<ActorInfo *>(node);
   }
+  TimerWheelNode *as_timer_wheel_node() {
+    return this;
+  }
+  static ActorInfo *from_timer_wheel_node(TimerWheelNode *node) {
+    return static_cast<ActorInfo *>(node);
+  }
 
   Timestamp get_alarm_timestamp() const {
     return Timestamp::at(alarm_timestamp_at_.load(std::memory_order_relaxed));
@@ -118,6 +130,7 @@ class ActorInfo : private HeapNode, private ListNode {
   ActorInfoPtr pin_;
   td::uint64 in_queue_since_{0};
   td::uint32 actor_stat_id_{0};
+  const ActorPriority priority_;
 };
 
 }  // namespace core
@@ -0,0 +1,82 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#pragma once
+
+#include "td/utils/common.h"
+#include "td/utils/logging.h"
+#include "td/utils/port/Clocks.h"
+#include "td/utils/Slice.h"
+#include "td/utils/ThreadSafeCounter.h"
+
+namespace td {
+namespace actor {
+namespace core {
+// Priority class of an actor. Normal actors use the usual global and per-worker queues, actors of other classes
+// are queued separately, and cpu workers choose between the classes with weights (see CpuWorker::try_pop).
+enum class ActorPriority : uint8 { Critical = 0, Normal = 1, Background = 2 };
+
+constexpr size_t actor_priority_count() {
+  return 3;
+}
+
+inline Slice actor_priority_name(ActorPriority priority) {
+  switch (priority) {
+    case ActorPriority::Critical:
+      return Slice("critical");
+    case ActorPriority::Normal:
+      return Slice("normal");
+    case ActorPriority::Background:
+      return Slice("background");
+  }
+  UNREACHABLE();
+}
+
+// Per-class perf counters, reported by ActorStats as actor_<class>_{delay,execute}.{qps,load}
+class ActorPriorityStat {
+ public:
+  static void on_delay(ActorPriority priority, uint64 ticks) {
+    auto &counter = get().delay_[static_cast<size_t>(priority)];
+    counter.count.add(1);
+    counter.duration.add(ticks);
+  }
+  static void on_execute(ActorPriority priority, uint64 ticks) {
+    auto &counter = get().execute_[static_cast<size_t>(priority)];
+    counter.count.add(1);
+    counter.duration.add(ticks);
+  }
+
+ private:
+  std::vector<NamedPerfCounter::PerfCounterRef> delay_;
+  std::vector<NamedPerfCounter::PerfCounterRef> execute_;
+
+  ActorPriorityStat() {
+    for (size_t i = 0; i < actor_priority_count(); i++) {
+      auto name = actor_priority_name(static_cast<ActorPriority>(i));
+      delay_.push_back(NamedPerfCounter::get_default().get_counter(PSLICE() << "actor_" << name << "_delay"));
+      execute_.push_back(NamedPerfCounter::get_default().get_counter(PSLICE() << "actor_" << name << "_execute"));
+    }
+  }
+  static ActorPriorityStat &get() {
+    static ActorPriorityStat stat;
+    return stat;
+  }
+};
+}  // namespace core
+}  // namespace actor
+}  // namespace td
@@ -1,7 +1,11 @@
 #pragma once
+#include "td/utils/bits.h"
 #include "td/utils/int_types.h"
 #include "td/utils/port/Clocks.h"
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
 #include <typeindex>
 #include <map>
 
@@ -10,6 +14,57 @@ namespace actor {
 namespace core {
 class Actor;
 
+// log2 histogram of durations in rdtsc ticks, bucket i counts durations in [2^i, 2^(i+1))
+struct TicksHistogram {
+  static constexpr size_t BUCKETS = 48;
+  std::array<double, BUCKETS> counts{};
+
+  static size_t bucket(td::uint64 ticks) {
+    if (ticks == 0) {
+      return 0;
+    }
+    return std::min<size_t>(BUCKETS - 1, 63 - td::count_leading_zeroes64(ticks));
+  }
+
+  double total() const {
+    double res = 0;
+    for (auto count : counts) {
+      res += count;
+    }
+    return res;
+  }
+
+  // q-quantile in seconds, interpolated geometrically inside of a bucket, so the error is below a factor of two
+  double quantile(double q, double inv_ticks_per_second) const {
+    auto need = q * total();
+    if (need <= 0) {
+      return 0;
+    }
+    double seen = 0;
+    for (size_t i = 0; i < BUCKETS; i++) {
+      if (counts[i] > 0 && seen + counts[i] >= need) {
+        auto fraction = (need - seen) / counts[i];
+        return std::ldexp(std::exp2(fraction), static_cast<int>(i)) * inv_ticks_per_second;
+      }
+      seen += counts[i];
+    }
+    return std::ldexp(1.0, static_cast<int>(BUCKETS)) * inv_ticks_per_second;
+  }
+
+  TicksHistogram &operator+=(const TicksHistogram &other) {
+    for (size_t i = 0; i < BUCKETS; i++) {
+      counts[i] += other.counts[i];
+    }
+    return *this;
+  }
+  TicksHistogram &operator-=(const TicksHistogram &other) {
+    for (size_t i = 0; i < BUCKETS; i++) {
+      counts[i] -= other.counts[i];
+    }
+    return *this;
+  }
+};
+
 struct ActorTypeStat {
   // diff (speed)
   double created{0};
@@ -40,6 +95,11 @@ struct ActorTypeStat {
   MaxStatGroup<double> max_execute_seconds;
   MaxStatGroup<double> max_delay_seconds;
 
+  // distributions, not scaled by operator/=
+  // delay is the time between a message being queued to the actor and the actor being taken by a worker
+  TicksHistogram delay_histogram;
+  TicksHistogram message_histogram;
+
   ActorTypeStat &operator+=(const ActorTypeStat &other) {
     created += other.created;
     executions += other.executions;
@@ -54,6 +114,9 @@ struct ActorTypeStat {
     max_message_seconds += other.max_message_seconds;
     max_execute_seconds += other.max_execute_seconds;
     max_delay_seconds += other.max_delay_seconds;
+
+    delay_histogram += other.delay_histogram;
+    message_histogram += other.message_histogram;
     return *this;
   }
 
@@ -62,6 +125,8 @@ struct ActorTypeStat {
     executions -= other.executions;
     messages -= other.messages;
     seconds -= other.seconds;
+    delay_histogram -= other.delay_histogram;
+    message_histogram -= other.message_histogram;
     return *this;
   }
   ActorTypeStat &operator/=(double t) {
@@ -121,9 +186,11 @@ struct ActorTypeStatImpl {
     inc(execute_messages_);
     add(total_ticks_, ticks);
     max_message_ticks_.update(ts, ticks);
+    inc(message_histogram_[TicksHistogram::bucket(ticks)]);
   }
   void on_delay(td::uint64 ts, td::uint64 ticks) {
     max_delay_ticks_.update(ts, ticks);
+    inc(delay_histogram_[TicksHistogram::bucket(ticks)]);
   }
 
   void execute_start(td::uint64 ts) {
@@ -175,7 +242,9 @@ struct ActorTypeStatImpl {
                          .max_execute_messages = load(max_execute_messages_),
                          .max_message_seconds = load_seconds(max_message_ticks_, inv_ticks_per_second),
                          .max_execute_seconds = load_seconds(max_execute_ticks_, inv_ticks_per_second),
-                         .max_delay_seconds = load_seconds(max_delay_ticks_, inv_ticks_per_second)};
+                         .max_delay_seconds = load_seconds(max_delay_ticks_, inv_ticks_per_second),
+                         .delay_histogram = load(delay_histogram_),
+                         .message_histogram = load(message_histogram_)};
   }
 
  private:
@@ -275,6 +344,13 @@ struct ActorTypeStatImpl {
             .value_10s = src.max_10s.get_max(ts),
             .value_10m = src.max_10m.get_max(ts)};
   }
+  static TicksHistogram load(const std::array<std::atomic<td::uint64>, TicksHistogram::BUCKETS> &src) {
+    TicksHistogram res;
+    for (size_t i = 0; i < TicksHistogram::BUCKETS; i++) {
+      res.counts[i] = double(load(src[i]));
+    }
+    return res;
+  }
   template <class T>
   static ActorTypeStat::MaxStatGroup<double> load_seconds(const MaxCounterGroup<T> &src, double inv_ticks_per_second) {
     auto ts = Clocks::rdtsc();
@@ -299,6 +375,9 @@ struct ActorTypeStatImpl {
   MaxCounterGroup<td::uint64> max_execute_ticks_;
   MaxCounterGroup<td::uint64> max_delay_ticks_;
 
+  std::array<std::atomic<td::uint64>, TicksHistogram::BUCKETS> delay_histogram_{};
+  std::array<std::atomic<td::uint64>, TicksHistogram::BUCKETS> message_histogram_{};
+
   // execute state
   std::atomic<td::uint64> execute_start_{0};
   std::atomic<td::uint32> execute_messages_{0};
@@ -41,7 +41,15 @@ void CpuWorker::run() {
         return;
       }
       auto lock = debug.start(message->get_name());
-      ActorExecutor executor(*message, dispatcher, ActorExecutor::Options().with_from_queue());
+      auto priority = message->get_priority();
+      auto started_at = Clocks::rdtsc();
+      {
+        ActorExecutor executor(*message, dispatcher, ActorExecutor::Options().with_from_queue());
+      }
+      auto ticks = Clocks::rdtsc() - started_at;
+      ActorPriorityStat::on_execute(priority, ticks);
+      WorkerStat::add(stat_.messages, 1);
+      WorkerStat::add(stat_.execute_ticks, ticks);
     } else {
       waiter_.wait(slot);
     }
@@ -66,7 +74,32 @@ bool CpuWorker::try_pop_global(SchedulerMessage &message, size_t thread_id) {
   return false;
 }
 
+bool CpuWorker::try_pop_priority(PriorityQueue &queue, SchedulerMessage &message, size_t thread_id) {
+  SchedulerMessage::Raw *raw_message;
+  if (queue.try_pop(raw_message, thread_id)) {
+    message = SchedulerMessage(SchedulerMessage::acquire_t{}, raw_message);
+    return true;
+  }
+  return false;
+}
+
 bool CpuWorker::try_pop(SchedulerMessage &message, size_t thread_id) {
+  // A class is skipped only when it has nothing to run, so a busy critical class still leaves some of the slots
+  // to normal and background actors
+  ++priority_cnt_;
+  if (priority_cnt_ % background_period() == 0) {
+    return try_pop_priority(background_queue_, message, thread_id) || try_pop_normal(message, thread_id) ||
+           try_pop_priority(critical_queue_, message, thread_id);
+  }
+  if (priority_cnt_ % normal_period() == 0) {
+    return try_pop_normal(message, thread_id) || try_pop_priority(critical_queue_, message, thread_id) ||
+           try_pop_priority(background_queue_, message, thread_id);
+  }
+  return try_pop_priority(critical_queue_, message, thread_id) || try_pop_normal(message, thread_id) ||
+         try_pop_priority(background_queue_, message, thread_id);
+}
+
+bool CpuWorker::try_pop_normal(SchedulerMessage &message, size_t thread_id) {
   if (++cnt_ == 51) {
     cnt_ = 0;
     if (try_pop_global(message, thread_id) || try_pop_local(message)) {
@@ -82,6 +115,7 @@ bool CpuWorker::try_pop(SchedulerMessage &message, size_t thread_id) {
     size_t pos = (i + id_) % local_queues_.size();
     SchedulerMessage::Raw *raw_message;
     if (local_queues_[id_].steal(raw_message, local_queues_[pos])) {
+      WorkerStat::add(stat_.steals, 1);
       message = SchedulerMessage(SchedulerMessage::acquire_t{}, raw_message);
       return true;
     }
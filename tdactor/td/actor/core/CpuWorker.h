@@ -29,25 +29,49 @@ namespace actor {
 namespace core {
 template <class T>
 struct LocalQueue;
+struct PriorityQueue;
+struct WorkerStat;
 class CpuWorker {
  public:
   CpuWorker(MpmcQueue<SchedulerMessage::Raw *> &queue, MpmcWaiter &waiter, size_t id,
-            MutableSpan<LocalQueue<SchedulerMessage::Raw *>> local_queues)
-      : queue_(queue), waiter_(waiter), id_(id), local_queues_(local_queues) {
+            MutableSpan<LocalQueue<SchedulerMessage::Raw *>> local_queues, PriorityQueue &critical_queue,
+            PriorityQueue &background_queue, WorkerStat &stat)
+      : queue_(queue)
+      , waiter_(waiter)
+      , id_(id)
+      , local_queues_(local_queues)
+      , critical_queue_(critical_queue)
+      , background_queue_(background_queue)
+      , stat_(stat) {
   }
   void run();
 
+  // While all classes have pending work, every normal_period()-th message is taken from normal actors and every
+  // background_period()-th one from background actors, the rest go to critical actors.
+  static constexpr size_t normal_period() {
+    return 4;
+  }
+  static constexpr size_t background_period() {
+    return 16;
+  }
+
  private:
   MpmcQueue<SchedulerMessage::Raw *> &queue_;
   MpmcWaiter &waiter_;
   size_t id_;
   MutableSpan<LocalQueue<SchedulerMessage::Raw *>> local_queues_;
+  PriorityQueue &critical_queue_;
+  PriorityQueue &background_queue_;
+  WorkerStat &stat_;
   size_t cnt_{0};
+  size_t priority_cnt_{0};
 
   bool try_pop(SchedulerMessage &message, size_t thread_id);
+  bool try_pop_normal(SchedulerMessage &message, size_t thread_id);
 
   bool try_pop_local(SchedulerMessage &message);
   bool try_pop_global(SchedulerMessage &message, size_t thread_id);
+  bool try_pop_priority(PriorityQueue &queue, SchedulerMessage &message, size_t thread_id);
 };
 }  // namespace core
 }  // namespace actor
@@ -42,14 +42,11 @@ bool IoWorker::run_once(double timeout, bool skip_timeouts) {
 #if TD_PORT_POSIX
   auto &poll = SchedulerContext::get()->get_poll();
 #endif
-  auto &heap = SchedulerContext::get()->get_heap();
+  auto &alarm_queue = SchedulerContext::get()->get_alarm_queue();
   auto &debug = SchedulerContext::get()->get_debug();
 
   auto now = Time::now();  // update Time::now_cached()
-  while (!heap.empty() && heap.top_key() <= now) {
-    auto *heap_node = heap.pop();
-    auto *actor_info = ActorInfo::from_heap_node(heap_node);
-
+  while (auto *actor_info = alarm_queue.pop_expired(now)) {
     auto id = actor_info->unpin();
     auto lock = debug.start(actor_info->get_name());
     ActorExecutor executor(*actor_info, dispatcher, ActorExecutor::Options().with_has_poll(true));
@@ -80,8 +77,8 @@ bool IoWorker::run_once(double timeout, bool skip_timeouts) {
   int32 timeout_ms = 0;
   if (can_sleep) {
     auto wakeup_timestamp = Timestamp::in(timeout);
-    if (!heap.empty()) {
-      wakeup_timestamp.relax(Timestamp::at(heap.top_key()));
+    if (!alarm_queue.empty()) {
+      wakeup_timestamp.relax(Timestamp::at(alarm_queue.next_wakeup()));
     }
     timeout_ms = static_cast<int>(wakeup_timestamp.in() * 1000) + 1;
     if (timeout_ms < 0) {
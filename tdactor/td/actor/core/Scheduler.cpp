@@ -34,9 +34,10 @@ bool need_debug() {
 }
 
 Scheduler::Scheduler(std::shared_ptr<SchedulerGroupInfo> scheduler_group_info, SchedulerId id, size_t cpu_threads_count,
-                     bool skip_timeouts)
+                     bool skip_timeouts, ActorAlarmQueue::Type alarm_queue_type)
     : scheduler_group_info_(std::move(scheduler_group_info))
     , cpu_threads_(cpu_threads_count)
+    , alarm_queue_(alarm_queue_type)
     , skip_timeouts_(skip_timeouts) {
   scheduler_group_info_->active_scheduler_count++;
   info_ = &scheduler_group_info_->schedulers.at(id.value());
@@ -47,6 +48,8 @@ Scheduler::Scheduler(std::shared_ptr<SchedulerGroupInfo> scheduler_group_info, S
     info_->cpu_queue_waiter = std::make_unique<MpmcWaiter>();
 
     info_->cpu_local_queue = std::vector<LocalQueue<SchedulerMessage::Raw *>>(cpu_threads_count);
+    info_->cpu_critical_queue = std::make_unique<PriorityQueue>(max_thread_count());
+    info_->cpu_background_queue = std::make_unique<PriorityQueue>(max_thread_count());
   }
   info_->io_queue = std::make_unique<MpscPollableQueue<SchedulerMessage>>();
   info_->io_queue->init();
@@ -79,10 +82,16 @@ void Scheduler::start() {
   for (size_t i = 0; i < cpu_threads_.size(); i++) {
     cpu_threads_[i] = td::thread([this, i] {
       this->run_in_context_impl(*this->info_->cpu_workers[i], [this, i] {
-        CpuWorker(*info_->cpu_queue, *info_->cpu_queue_waiter, i, info_->cpu_local_queue).run();
+        CpuWorker(*info_->cpu_queue, *info_->cpu_queue_waiter, i, info_->cpu_local_queue, *info_->cpu_critical_queue,
+                  *info_->cpu_background_queue, info_->cpu_workers[i]->stat)
+            .run();
       });
     });
     cpu_threads_[i].set_name(PSLICE() << "#" << info_->id.value() << ":cpu#" << i);
+    if (!cpu_affinity_.empty()) {
+      auto status = cpu_threads_[i].set_affinity(cpu_affinity_);
+      LOG_IF(WARNING, status.is_error()) << "Failed to pin cpu worker: " << status;
+    }
   }
 #if TD_PORT_WINDOWS
   // FIXME: use scheduler_id
@@ -131,7 +140,7 @@ void Scheduler::do_stop() {
 
   io_worker_.reset();
   poll_.clear();
-  heap_.for_each([](auto &key, auto &node) { ActorInfo::from_heap_node(node)->unpin(); });
+  alarm_queue_.for_each([](ActorInfo *actor_info) { actor_info->unpin(); });
 
   std::unique_lock<std::mutex> lock(scheduler_group_info_->active_scheduler_count_mutex);
   scheduler_group_info_->active_scheduler_count--;
@@ -139,13 +148,14 @@ void Scheduler::do_stop() {
 }
 
 Scheduler::ContextImpl::ContextImpl(ActorInfoCreator *creator, SchedulerId scheduler_id, CpuWorkerId cpu_worker_id,
-                                    SchedulerGroupInfo *scheduler_group, Poll *poll, KHeap<double> *heap, Debug *debug)
+                                    SchedulerGroupInfo *scheduler_group, Poll *poll, ActorAlarmQueue *alarm_queue,
+                                    Debug *debug)
     : creator_(creator)
     , scheduler_id_(scheduler_id)
     , cpu_worker_id_(cpu_worker_id)
     , scheduler_group_(scheduler_group)
     , poll_(poll)
-    , heap_(heap)
+    , alarm_queue_(alarm_queue)
     , debug_(debug) {
 }
 
@@ -161,6 +171,13 @@ void Scheduler::ContextImpl::add_to_queue(ActorInfoPtr actor_info_ptr, Scheduler
   if (need_poll || !info.cpu_queue) {
     info.io_queue->writer_put(std::move(actor_info_ptr));
   } else {
+    auto priority = actor_info_ptr->get_priority();
+    if (priority != ActorPriority::Normal) {
+      auto &queue = priority == ActorPriority::Critical ? *info.cpu_critical_queue : *info.cpu_background_queue;
+      queue.push(actor_info_ptr.release(), get_thread_id());
+      info.cpu_queue_waiter->notify();
+      return;
+    }
     if (scheduler_id == get_scheduler_id() && cpu_worker_id_.is_valid()) {
       // may push local
       CHECK(actor_info_ptr);
@@ -189,12 +206,12 @@ Poll &Scheduler::ContextImpl::get_poll() {
   return *poll_;
 }
 
-bool Scheduler::ContextImpl::has_heap() {
-  return heap_ != nullptr;
+bool Scheduler::ContextImpl::has_alarm_queue() {
+  return alarm_queue_ != nullptr;
 }
-KHeap<double> &Scheduler::ContextImpl::get_heap() {
-  CHECK(has_heap());
-  return *heap_;
+ActorAlarmQueue &Scheduler::ContextImpl::get_alarm_queue() {
+  CHECK(has_alarm_queue());
+  return *alarm_queue_;
 }
 Debug &Scheduler::ContextImpl::get_debug() {
   return *debug_;
@@ -205,26 +222,26 @@ void Scheduler::ContextImpl::set_alarm_timestamp(const ActorInfoPtr &actor_info_
   // 1. Several cpu actors with separate heaps. They ask io worker to update timeout only when it has been changed
   // 2. Update timeout only when it has increased
   // 3. Use signal-like logic to combile multiple timeout updates into one
-  if (!has_heap()) {
+  if (!has_alarm_queue()) {
     add_to_queue(actor_info_ptr, {}, true);
     return;
   }
   // we are in PollWorker
-  CHECK(has_heap());
-  auto &heap = get_heap();
-  auto *heap_node = actor_info_ptr->as_heap_node();
+  CHECK(has_alarm_queue());
+  auto &alarm_queue = get_alarm_queue();
+  auto *actor_info = &*actor_info_ptr;
   auto timestamp = actor_info_ptr->get_alarm_timestamp();
   if (timestamp) {
-    if (heap_node->in_heap()) {
-      heap.fix(timestamp.at(), heap_node);
+    if (alarm_queue.contains(actor_info)) {
+      alarm_queue.fix(timestamp.at(), actor_info);
     } else {
       actor_info_ptr->pin(actor_info_ptr);
-      heap.insert(timestamp.at(), heap_node);
+      alarm_queue.insert(timestamp.at(), actor_info);
     }
   } else {
-    if (heap_node->in_heap()) {
+    if (alarm_queue.contains(actor_info)) {
       actor_info_ptr->unpin();
-      heap.erase(heap_node);
+      alarm_queue.erase(actor_info);
     }
   }
 }
@@ -315,6 +332,20 @@ void Scheduler::close_scheduler_group(SchedulerGroupInfo &group_info) {
           queues_are_empty = false;
         }
       }
+      for (auto *queue : {scheduler_info.cpu_critical_queue.get(), scheduler_info.cpu_background_queue.get()}) {
+        if (!queue) {
+          continue;
+        }
+        while (true) {
+          SchedulerMessage::Raw *raw_message;
+          if (!queue->try_pop(raw_message, get_thread_id())) {
+            break;
+          }
+          SchedulerMessage(SchedulerMessage::acquire_t{}, raw_message);
+          // message's destructor is called
+          queues_are_empty = false;
+        }
+      }
     }
     if (++it > 100) {
       LOG(FATAL) << "Failed to drain all queues";
@@ -326,6 +357,8 @@ void Scheduler::close_scheduler_group(SchedulerGroupInfo &group_info) {
   for (auto &scheduler_info : group_info.schedulers) {
     scheduler_info.io_queue.reset();
     scheduler_info.cpu_queue.reset();
+    scheduler_info.cpu_critical_queue.reset();
+    scheduler_info.cpu_background_queue.reset();
 
     // Do not destroy worker infos. run_in_context will crash if they are empty
     scheduler_info.io_worker->actor_info_creator.clear();
@@ -114,6 +114,18 @@ struct Debug {
   AtomicRead<DebugInfo> info_;
 };
 
+// Totals of a cpu worker, written only by the worker itself
+struct WorkerStat {
+  std::atomic<uint64> messages{0};
+  std::atomic<uint64> execute_ticks{0};
+  // messages taken from local queues of other workers
+  std::atomic<uint64> steals{0};
+
+  static void add(std::atomic<uint64> &counter, uint64 value) {
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+  }
+};
+
 struct WorkerInfo {
   enum class Type { Io, Cpu } type{Type::Io};
   WorkerInfo() = default;
@@ -123,6 +135,7 @@ struct WorkerInfo {
   ActorInfoCreator actor_info_creator;
   CpuWorkerId cpu_worker_id;
   Debug debug;
+  WorkerStat stat;
 };
 
 template <class T>
@@ -148,6 +161,26 @@ struct LocalQueue {
   char pad[TD_CONCURRENCY_PAD - sizeof(optional<T>)];
 };
 
+struct PriorityQueue {
+  explicit PriorityQueue(size_t threads_n) : queue(1024, threads_n) {
+  }
+  void push(SchedulerMessage::Raw *value, size_t thread_id) {
+    size.fetch_add(1, std::memory_order_relaxed);
+    queue.push(value, thread_id);
+  }
+  bool try_pop(SchedulerMessage::Raw *&value, size_t thread_id) {
+    // cheap check, so that workers do not touch queues of classes that are not used
+    if (size.load(std::memory_order_relaxed) == 0 || !queue.try_pop(value, thread_id)) {
+      return false;
+    }
+    size.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  MpmcQueue<SchedulerMessage::Raw *> queue;
+  std::atomic<size_t> size{0};
+};
+
 struct SchedulerInfo {
   SchedulerId id;
   // will be read by all workers is any thread
@@ -155,6 +188,9 @@ struct SchedulerInfo {
   std::unique_ptr<MpmcWaiter> cpu_queue_waiter;
 
   std::vector<LocalQueue<SchedulerMessage::Raw *>> cpu_local_queue;
+  // queues for actors with priority other than ActorPriority::Normal
+  std::unique_ptr<PriorityQueue> cpu_critical_queue;
+  std::unique_ptr<PriorityQueue> cpu_background_queue;
   //std::vector<td::StealingQueue<SchedulerMessage>> cpu_stealing_queue;
 
   // only scheduler itself may read from io_queue_
@@ -194,7 +230,7 @@ class Scheduler {
   }
 
   Scheduler(std::shared_ptr<SchedulerGroupInfo> scheduler_group_info, SchedulerId id, size_t cpu_threads_count,
-            bool skip_timeouts = false);
+            bool skip_timeouts = false, ActorAlarmQueue::Type alarm_queue_type = ActorAlarmQueue::Type::Heap);
 
   Scheduler(const Scheduler &) = delete;
   Scheduler &operator=(const Scheduler &) = delete;
@@ -202,6 +238,11 @@ class Scheduler {
   Scheduler &operator=(Scheduler &&other) = delete;
   ~Scheduler();
 
+  // Cpu workers will be restricted to the given cpus. Must be called before start
+  void set_cpu_affinity(std::vector<int32> cpus) {
+    cpu_affinity_ = std::move(cpus);
+  }
+
   void start();
 
   template <class F>
@@ -231,16 +272,17 @@ class Scheduler {
   std::shared_ptr<SchedulerGroupInfo> scheduler_group_info_;
   SchedulerInfo *info_;
   std::vector<td::thread> cpu_threads_;
+  std::vector<int32> cpu_affinity_;
   bool is_stopped_{false};
   Poll poll_;
-  KHeap<double> heap_;
+  ActorAlarmQueue alarm_queue_;
   std::unique_ptr<IoWorker> io_worker_;
   bool skip_timeouts_{false};
 
   class ContextImpl : public SchedulerContext {
    public:
     ContextImpl(ActorInfoCreator *creator, SchedulerId scheduler_id, CpuWorkerId cpu_worker_id,
-                SchedulerGroupInfo *scheduler_group, Poll *poll, KHeap<double> *heap, Debug *debug);
+                SchedulerGroupInfo *scheduler_group, Poll *poll, ActorAlarmQueue *alarm_queue, Debug *debug);
 
     SchedulerId get_scheduler_id() const override;
     void add_to_queue(ActorInfoPtr actor_info_ptr, SchedulerId scheduler_id, bool need_poll) override;
@@ -250,8 +292,8 @@ class Scheduler {
     bool has_poll() override;
     Poll &get_poll() override;
 
-    bool has_heap() override;
-    KHeap<double> &get_heap() override;
+    bool has_alarm_queue() override;
+    ActorAlarmQueue &get_alarm_queue() override;
 
     Debug &get_debug() override;
 
@@ -272,7 +314,7 @@ class Scheduler {
     SchedulerGroupInfo *scheduler_group_;
     Poll *poll_;
 
-    KHeap<double> *heap_;
+    ActorAlarmQueue *alarm_queue_;
 
     Debug *debug_;
   };
@@ -284,8 +326,8 @@ class Scheduler {
 #endif
     bool is_io_worker = worker_info.type == WorkerInfo::Type::Io;
     ContextImpl context(&worker_info.actor_info_creator, info_->id, worker_info.cpu_worker_id,
-                        scheduler_group_info_.get(), is_io_worker ? &poll_ : nullptr, is_io_worker ? &heap_ : nullptr,
-                        &worker_info.debug);
+                        scheduler_group_info_.get(), is_io_worker ? &poll_ : nullptr,
+                        is_io_worker ? &alarm_queue_ : nullptr, &worker_info.debug);
     SchedulerContext::Guard guard(&context);
     f();
   }
@@ -19,11 +19,11 @@
 #pragma once
 #include "td/actor/core/Context.h"
 #include "td/actor/core/SchedulerId.h"
+#include "td/actor/core/ActorAlarmQueue.h"
 #include "td/actor/core/ActorInfo.h"
 #include "td/actor/core/ActorInfoCreator.h"
 
 #include "td/utils/port/Poll.h"
-#include "td/utils/Heap.h"
 
 namespace td {
 namespace actor {
@@ -51,8 +51,8 @@ class SchedulerContext : public Context<SchedulerContext>, public SchedulerDispa
   virtual Poll &get_poll() = 0;
 
   // Timeout interface
-  virtual bool has_heap() = 0;
-  virtual KHeap<double> &get_heap() = 0;
+  virtual bool has_alarm_queue() = 0;
+  virtual ActorAlarmQueue &get_alarm_queue() = 0;
 
   // Stop all schedulers
   virtual bool is_stop_requested() = 0;
@@ -0,0 +1,100 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#include "td/actor/coro.h"
+
+#if TD_ACTOR_HAVE_COROUTINES
+#include "td/utils/port/thread_local.h"
+
+#include <array>
+#include <new>
+
+namespace td {
+namespace actor {
+namespace detail {
+namespace {
+class FramePool {
+ public:
+  static constexpr size_t GRANULARITY = 64;
+  static constexpr size_t MAX_FRAME_SIZE = 4096;
+  static constexpr size_t MAX_FREE_FRAMES = 64;
+
+  FramePool() = default;
+  FramePool(const FramePool &) = delete;
+  FramePool &operator=(const FramePool &) = delete;
+  ~FramePool() {
+    for (auto &free_list : free_lists_) {
+      for (auto *ptr : free_list) {
+        ::operator delete(ptr);
+      }
+    }
+  }
+
+  static size_t get_class(size_t size) {
+    return (size + GRANULARITY - 1) / GRANULARITY;
+  }
+
+  void *allocate(size_t size) {
+    auto &free_list = free_lists_[get_class(size)];
+    if (free_list.empty()) {
+      return ::operator new(get_class(size) * GRANULARITY);
+    }
+    auto *ptr = free_list.back();
+    free_list.pop_back();
+    return ptr;
+  }
+  void deallocate(void *ptr, size_t size) {
+    auto &free_list = free_lists_[get_class(size)];
+    if (free_list.size() >= MAX_FREE_FRAMES) {
+      ::operator delete(ptr);
+      return;
+    }
+    free_list.push_back(ptr);
+  }
+
+ private:
+  std::array<std::vector<void *>, MAX_FRAME_SIZE / GRANULARITY + 1> free_lists_;
+};
+
+FramePool *get_frame_pool() {
+  static TD_THREAD_LOCAL FramePool *pool;
+  init_thread_local<FramePool>(pool);
+  return pool;
+}
+}  // namespace
+
+void *CoroutineFramePool::allocate(size_t size) {
+  if (size > FramePool::MAX_FRAME_SIZE) {
+    return ::operator new(size);
+  }
+  return get_frame_pool()->allocate(size);
+}
+
+void CoroutineFramePool::deallocate(void *ptr, size_t size) {
+  if (size > FramePool::MAX_FRAME_SIZE) {
+    ::operator delete(ptr);
+    return;
+  }
+  // frames may be freed by another thread, they just move to its pool
+  get_frame_pool()->deallocate(ptr, size);
+}
+
+}  // namespace detail
+}  // namespace actor
+}  // namespace td
+#endif
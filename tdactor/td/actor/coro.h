@@ -0,0 +1,310 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#pragma once
+
+#include "td/actor/actor.h"
+#include "td/actor/PromiseFuture.h"
+
+#include "td/utils/common.h"
+#include "td/utils/logging.h"
+#include "td/utils/Status.h"
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#define TD_ACTOR_HAVE_COROUTINES 1
+#else
+#define TD_ACTOR_HAVE_COROUTINES 0
+#endif
+
+#if TD_ACTOR_HAVE_COROUTINES
+#include <coroutine>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// TRY_STATUS and TRY_RESULT for coroutines, which can't use return
+#define CO_TRY_STATUS(status)               \
+  {                                         \
+    auto try_status = (status);             \
+    if (try_status.is_error()) {            \
+      co_return try_status.move_as_error(); \
+    }                                       \
+  }
+
+#define CO_TRY_RESULT(name, result) CO_TRY_RESULT_IMPL(TD_CONCAT(TD_CONCAT(r_, name), __LINE__), auto name, result)
+
+#define CO_TRY_RESULT_IMPL(r_name, name, result) \
+  auto r_name = (result);                        \
+  if (r_name.is_error()) {                       \
+    co_return r_name.move_as_error();            \
+  }                                              \
+  name = r_name.move_as_ok();
+
+// Coroutines over actors and promises.
+//
+//   Task<int> MyActor::sum(ActorId<Db> db) {
+//     CO_TRY_RESULT(a, co_await ask(db, &Db::get, "a"));
+//     CO_TRY_RESULT(b, co_await ask(db, &Db::get, "b"));
+//     co_return a + b;
+//   }
+//   ...
+//   sum(db_).start(std::move(promise));
+//
+// A coroutine started from an actor is always resumed on that actor, so it may use members of the actor
+// exactly as a continuation lambda sent with send_closure could. If the actor is destroyed while the coroutine
+// waits, the coroutine is destroyed too and the promise passed to start gets the "Lost promise" error.
+namespace td {
+namespace actor {
+template <class T = Unit>
+class Task;
+
+namespace detail {
+
+// Coroutine frames are reused through per-thread free lists, so each co_await of a Task costs no malloc
+class CoroutineFramePool {
+ public:
+  static void *allocate(size_t size);
+  static void deallocate(void *ptr, size_t size);
+};
+
+class TaskPromiseBase {
+ public:
+  static void *operator new(size_t size) {
+    return CoroutineFramePool::allocate(size);
+  }
+  static void operator delete(void *ptr, size_t size) {
+    CoroutineFramePool::deallocate(ptr, size);
+  }
+
+  std::suspend_always initial_suspend() noexcept {
+    return {};
+  }
+  void unhandled_exception() {
+    LOG(FATAL) << "Unhandled exception in coroutine";
+  }
+
+  // Destroys the whole chain of awaiting coroutines, starting from the detached one
+  void destroy_chain() {
+    auto *root = this;
+    while (root->parent_ != nullptr) {
+      root = root->parent_;
+    }
+    CHECK(root->is_detached_);
+    root->handle_.destroy();
+  }
+
+ protected:
+  std::coroutine_handle<> handle_;
+  std::coroutine_handle<> continuation_;
+  TaskPromiseBase *parent_{nullptr};
+  bool is_detached_{false};
+
+  template <class T>
+  friend class ::td::actor::Task;
+};
+
+// Resumes a suspended coroutine on the actor that was running it, or inline if it wasn't run by an actor
+class CoroutineResumer {
+ public:
+  CoroutineResumer() = default;
+  CoroutineResumer(std::coroutine_handle<> handle, TaskPromiseBase *promise) : handle_(handle), promise_(promise) {
+    auto *context = core::ActorExecuteContext::get();
+    if (context != nullptr && context->has_actor()) {
+      actor_id_ = actor_id(&context->actor());
+    }
+  }
+  CoroutineResumer(const CoroutineResumer &) = delete;
+  CoroutineResumer &operator=(const CoroutineResumer &) = delete;
+  CoroutineResumer(CoroutineResumer &&other) noexcept
+      : handle_(std::exchange(other.handle_, nullptr))
+      , promise_(other.promise_)
+      , actor_id_(std::move(other.actor_id_)) {
+  }
+  CoroutineResumer &operator=(CoroutineResumer &&other) = delete;
+  ~CoroutineResumer() {
+    if (handle_) {
+      promise_->destroy_chain();
+    }
+  }
+
+  void resume() && {
+    if (actor_id_.empty()) {
+      std::exchange(handle_, nullptr).resume();
+      return;
+    }
+    // the lambda owns the resumer, so the coroutine is destroyed if the actor is gone
+    auto actor_id = actor_id_;
+    send_lambda(actor_id, [self = std::move(*this)]() mutable { std::exchange(self.handle_, nullptr).resume(); });
+  }
+
+ private:
+  std::coroutine_handle<> handle_;
+  TaskPromiseBase *promise_{nullptr};
+  ActorId<> actor_id_;
+};
+
+template <class F>
+struct PromiseResultType;
+template <class C, class R, class... ArgsT>
+struct PromiseResultType<R (C::*)(ArgsT...)> {
+  using Last = std::decay_t<std::tuple_element_t<sizeof...(ArgsT) - 1, std::tuple<ArgsT...>>>;
+  using type = typename Last::ArgT;
+};
+
+}  // namespace detail
+
+// Lazily started coroutine with a result of type Result<T>
+template <class T>
+class Task {
+ public:
+  class promise_type : public detail::TaskPromiseBase {
+   public:
+    Task get_return_object() {
+      handle_ = std::coroutine_handle<promise_type>::from_promise(*this);
+      return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+    }
+    auto final_suspend() noexcept {
+      struct FinalAwaiter {
+        bool await_ready() noexcept {
+          return false;
+        }
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept {
+          auto &promise = handle.promise();
+          if (promise.is_detached_) {
+            auto result_promise = std::move(promise.result_promise_);
+            auto result = std::move(promise.result_);
+            handle.destroy();
+            result_promise.set_result(std::move(result));
+            return std::noop_coroutine();
+          }
+          return promise.continuation_;
+        }
+        void await_resume() noexcept {
+        }
+      };
+      return FinalAwaiter{};
+    }
+    void return_value(Result<T> result) {
+      result_ = std::move(result);
+    }
+
+   private:
+    Result<T> result_;
+    Promise<T> result_promise_;
+    friend class Task;
+  };
+
+  Task(Task &&other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {
+  }
+  Task &operator=(Task &&other) noexcept {
+    reset();
+    handle_ = std::exchange(other.handle_, nullptr);
+    return *this;
+  }
+  Task(const Task &) = delete;
+  Task &operator=(const Task &) = delete;
+  ~Task() {
+    reset();
+  }
+
+  // Runs the coroutine until its first suspension, the result is sent to the promise
+  void start(Promise<T> promise = {}) && {
+    CHECK(handle_);
+    auto handle = std::exchange(handle_, nullptr);
+    handle.promise().is_detached_ = true;
+    handle.promise().result_promise_ = std::move(promise);
+    handle.resume();
+  }
+
+  bool await_ready() const noexcept {
+    return false;
+  }
+  template <class P>
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<P> continuation) noexcept {
+    auto &promise = handle_.promise();
+    promise.continuation_ = continuation;
+    promise.parent_ = &continuation.promise();
+    return handle_;
+  }
+  Result<T> await_resume() noexcept {
+    return std::move(handle_.promise().result_);
+  }
+
+ private:
+  std::coroutine_handle<promise_type> handle_;
+
+  explicit Task(std::coroutine_handle<promise_type> handle) : handle_(handle) {
+  }
+  void reset() {
+    if (handle_) {
+      std::exchange(handle_, nullptr).destroy();
+    }
+  }
+};
+
+// Awaitable which passes a promise to f and resumes the coroutine on the current actor with its result
+template <class T, class F>
+class PromiseAwaiter {
+ public:
+  explicit PromiseAwaiter(F &&f) : f_(std::move(f)) {
+  }
+  bool await_ready() const noexcept {
+    return false;
+  }
+  template <class P>
+  void await_suspend(std::coroutine_handle<P> handle) {
+    detail::CoroutineResumer resumer(handle, &handle.promise());
+    // the coroutine may be resumed and destroyed before f returns, so f must not live in the awaiter
+    auto f = std::move(f_);
+    f(Promise<T>([this, resumer = std::move(resumer)](Result<T> result) mutable {
+      result_ = std::move(result);
+      std::move(resumer).resume();
+    }));
+  }
+  Result<T> await_resume() noexcept {
+    return std::move(result_);
+  }
+
+ private:
+  F f_;
+  Result<T> result_;
+};
+
+template <class T, class F>
+PromiseAwaiter<T, std::decay_t<F>> await_promise(F &&f) {
+  return PromiseAwaiter<T, std::decay_t<F>>(std::forward<F>(f));
+}
+
+// co_await ask(actor_id, &Actor::method, args...) is send_closure with the promise replaced by the coroutine
+template <class ActorIdT, class FunctionT, class... ArgsT>
+auto ask(ActorIdT &&actor_id, FunctionT function, ArgsT &&... args) {
+  using T = typename detail::PromiseResultType<FunctionT>::type;
+  return await_promise<T>([actor_id = std::forward<ActorIdT>(actor_id), function,
+                           args = std::make_tuple(std::forward<ArgsT>(args)...)](Promise<T> promise) mutable {
+    std::apply(
+        [&](auto &&... unpacked) {
+          send_closure(std::move(actor_id), function, std::forward<decltype(unpacked)>(unpacked)...,
+                       std::move(promise));
+        },
+        std::move(args));
+  });
+}
+
+}  // namespace actor
+}  // namespace td
+#endif
@@ -22,6 +22,7 @@
 #include "td/actor/ActorStats.h"
 
 #include "td/utils/format.h"
+#include "td/utils/JsonBuilder.h"
 #include "td/utils/logging.h"
 #include "td/utils/misc.h"
 #include "td/utils/port/thread.h"
@@ -37,6 +38,7 @@
 #include <array>
 #include <atomic>
 #include <deque>
+#include <limits>
 #include <memory>
 
 TEST(Actor2, signals) {
@@ -659,6 +661,51 @@ TEST(Actor2, actor_timeout_simple2) {
   sb.clear();
 }
 
+TEST(Actor2, actor_timeout_timer_wheel) {
+  auto group_info = std::make_shared<core::SchedulerGroupInfo>(1);
+  core::Scheduler scheduler{group_info, SchedulerId{0}, 2, false, core::ActorAlarmQueue::Type::TimerWheel};
+  sb.clear();
+  scheduler.start();
+
+  auto watcher = td::create_shared_destructor([] { SchedulerContext::get()->stop(); });
+  scheduler.run_in_context([watcher = std::move(watcher)] {
+    class A : public Actor {
+     public:
+      A(std::shared_ptr<td::Destructor> watcher) : watcher_(std::move(watcher)) {
+      }
+      void start_up() override {
+        set_timeout();
+      }
+      void alarm() override {
+        CHECK(wakeup_at_ <= td::Time::now());
+        if (--left_ == 0) {
+          stop();
+          return;
+        }
+        set_timeout();
+      }
+
+     private:
+      std::shared_ptr<td::Destructor> watcher_;
+      int left_ = 5;
+      double wakeup_at_ = 0;
+      void set_timeout() {
+        wakeup_at_ = td::Time::now() + td::Random::fast(0, 20) * 0.001;
+        alarm_timestamp() = td::Timestamp::at(wakeup_at_);
+      }
+    };
+    for (int i = 0; i < 100; i++) {
+      create_actor<A>(core::ActorInfoCreator::Options().with_name("A").with_poll(td::Random::fast(0, 1) == 0), watcher)
+          .release();
+    }
+  });
+  watcher.reset();
+  while (scheduler.run(1000)) {
+  }
+  core::Scheduler::close_scheduler_group(*group_info);
+  sb.clear();
+}
+
 TEST(Actor2, actor_function_result) {
   auto group_info = std::make_shared<core::SchedulerGroupInfo>(1);
   core::Scheduler scheduler{group_info, SchedulerId{0}, 2};
@@ -1147,6 +1194,14 @@ TEST(Actor2, test_stats) {
       }
       void on_stats(td::Result<std::string> r_stats) {
         LOG(ERROR) << "\n" << r_stats.ok();
+        td::actor::send_closure(stats_, &ActorStats::prepare_stats_json,
+                                td::promise_send_closure(actor_id(this), &Master::on_stats_json));
+      }
+      void on_stats_json(td::Result<std::string> r_stats) {
+        auto json = r_stats.move_as_ok();
+        auto r_value = td::json_decode(json);
+        LOG_IF(FATAL, r_value.is_error()) << r_value.error() << " " << json;
+        ASSERT_TRUE(r_value.ok().type() == td::JsonValue::Type::Object);
         if (--cnt_ == 0) {
           stop();
         }
@@ -1162,4 +1217,102 @@ TEST(Actor2, test_stats) {
 
   scheduler.run();
 }
+
+TEST(Actor2, stats_histogram) {
+  using td::actor::core::TicksHistogram;
+  TicksHistogram histogram;
+  ASSERT_EQ(0.0, histogram.quantile(0.5, 1.0));
+  for (td::uint64 ticks = 1; ticks <= 1000; ticks++) {
+    histogram.counts[TicksHistogram::bucket(ticks)]++;
+  }
+  ASSERT_EQ(1000.0, histogram.total());
+  // quantiles are exact up to a factor of two
+  for (auto q : {0.1, 0.5, 0.9, 0.99}) {
+    auto value = histogram.quantile(q, 1.0);
+    ASSERT_TRUE(value >= q * 1000 / 2 && value <= q * 1000 * 2);
+  }
+
+  auto window = histogram;
+  window -= histogram;
+  ASSERT_EQ(0.0, window.total());
+  window += histogram;
+  ASSERT_EQ(histogram.quantile(0.5, 1.0), window.quantile(0.5, 1.0));
+  ASSERT_EQ(TicksHistogram::BUCKETS - 1, TicksHistogram::bucket(std::numeric_limits<td::uint64>::max()));
+}
+
+TEST(Actor2, priority_classes) {
+  Scheduler scheduler({1});
+
+  static std::vector<ActorPriority> finished;
+  finished.clear();
+  auto watcher = td::create_shared_destructor([] { SchedulerContext::get()->stop(); });
+  scheduler.run_in_context([watcher = std::move(watcher)] {
+    class Worker : public Actor {
+     public:
+      Worker(ActorPriority priority, std::shared_ptr<td::Destructor> watcher)
+          : priority_(priority), watcher_(std::move(watcher)) {
+      }
+      void start_up() override {
+        send_closure_later(actor_id(this), &Worker::step);
+      }
+      void step() {
+        if (--cnt_ == 0) {
+          finished.push_back(priority_);
+          stop();
+          return;
+        }
+        send_closure_later(actor_id(this), &Worker::step);
+      }
+
+     private:
+      ActorPriority priority_;
+      std::shared_ptr<td::Destructor> watcher_;
+      int cnt_ = 1000;
+    };
+    for (auto priority : {ActorPriority::Background, ActorPriority::Normal, ActorPriority::Critical}) {
+      create_actor<Worker>(ActorOptions().with_name("worker").with_priority(priority), priority, watcher).release();
+    }
+  });
+  scheduler.run();
+
+  // all classes make progress, higher classes get more of the worker
+  ASSERT_EQ(3u, finished.size());
+  ASSERT_TRUE(finished[0] == ActorPriority::Critical);
+  ASSERT_TRUE(finished[1] == ActorPriority::Normal);
+  ASSERT_TRUE(finished[2] == ActorPriority::Background);
+}
+
+TEST(Actor2, numa_node_infos) {
+  for (size_t threads : {1, 2, 7, 64}) {
+    auto infos = Scheduler::numa_node_infos(threads);
+    ASSERT_TRUE(!infos.empty());
+    size_t total = 0;
+    for (auto &info : infos) {
+      ASSERT_TRUE(info.cpu_threads_ > 0);
+      ASSERT_TRUE(!info.cpu_affinity_.empty());
+      total += info.cpu_threads_;
+    }
+    ASSERT_EQ(threads, total);
+  }
+
+  auto infos = Scheduler::numa_node_infos(2);
+  auto last_id = SchedulerId{static_cast<td::uint8>(infos.size() - 1)};
+  Scheduler scheduler(infos);
+  scheduler.run_in_context([last_id] {
+    class A : public Actor {
+     public:
+      explicit A(SchedulerId id) : id_(id) {
+      }
+      void start_up() override {
+        CHECK(SchedulerContext::get()->get_scheduler_id() == id_);
+        SchedulerContext::get()->stop();
+      }
+
+     private:
+      SchedulerId id_;
+    };
+    create_actor<A>(ActorOptions().with_name("A").on_scheduler(last_id), last_id).release();
+  });
+  scheduler.run();
+}
 #endif  //!TD_THREAD_UNSUPPORTED
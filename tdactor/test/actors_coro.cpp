@@ -0,0 +1,154 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#include "td/actor/actor.h"
+#include "td/actor/coro.h"
+
+#include "td/utils/tests.h"
+
+#if TD_ACTOR_HAVE_COROUTINES
+namespace {
+using namespace td::actor;
+
+class Storage : public Actor {
+ public:
+  void get(int key, td::Promise<int> promise) {
+    if (key < 0) {
+      return promise.set_error(td::Status::Error("negative key"));
+    }
+    if (key % 2 == 0) {
+      return promise.set_value(key * 10);
+    }
+    // answer later, from another message
+    send_closure(actor_id(this), &Storage::get, key - 1, promise.wrap([](int value) { return value + 10; }));
+  }
+  void get_slowly(int key, td::Promise<int> promise) {
+    pending_.push_back(std::move(promise));
+    alarm_timestamp() = td::Timestamp::in(0.01);
+  }
+  void drop(td::Promise<int> promise) {
+  }
+
+ private:
+  std::vector<td::Promise<int>> pending_;
+
+  void alarm() override {
+    for (auto &promise : pending_) {
+      promise.set_value(1);
+    }
+    pending_.clear();
+  }
+};
+
+class Client : public Actor {
+ public:
+  Client(ActorId<Storage> storage, td::Promise<int> promise)
+      : storage_(std::move(storage)), promise_(std::move(promise)) {
+  }
+
+  void start_up() override {
+    run().start(std::move(promise_));
+  }
+
+ private:
+  ActorId<Storage> storage_;
+  td::Promise<int> promise_;
+  int steps_ = 0;
+
+  void check_on_actor() {
+    CHECK(&core::ActorExecuteContext::get()->actor() == this);
+    steps_++;
+  }
+
+  Task<int> get_pair(int a, int b) {
+    CO_TRY_RESULT(x, co_await ask(storage_, &Storage::get, a));
+    check_on_actor();
+    CO_TRY_RESULT(y, co_await ask(storage_, &Storage::get, b));
+    check_on_actor();
+    co_return x + y;
+  }
+
+  Task<int> run() {
+    CO_TRY_RESULT(sum, co_await get_pair(2, 3));
+    CHECK(sum == 20 + 30);
+    auto r_error = co_await get_pair(4, -1);
+    CHECK(r_error.is_error());
+    auto r_lost = co_await ask(storage_, &Storage::drop);
+    CHECK(r_lost.is_error());
+    auto r_value = co_await await_promise<int>([](td::Promise<int> promise) { promise.set_value(7); });
+    CHECK(r_value.ok() == 7);
+    check_on_actor();
+    co_return sum + steps_;
+  }
+};
+
+class DyingClient : public Actor {
+ public:
+  DyingClient(ActorId<Storage> storage, td::Promise<int> promise)
+      : storage_(std::move(storage)), promise_(std::move(promise)) {
+  }
+
+  void start_up() override {
+    run().start(std::move(promise_));
+    stop();
+  }
+
+ private:
+  ActorId<Storage> storage_;
+  td::Promise<int> promise_;
+
+  Task<int> run() {
+    auto r_value = co_await ask(storage_, &Storage::get_slowly, 1);
+    LOG(FATAL) << "Coroutine of a destroyed actor must not be resumed";
+    co_return r_value;
+  }
+};
+}  // namespace
+
+TEST(ActorCoro, ask) {
+  Scheduler scheduler({1});
+  int result = 0;
+  scheduler.run_in_context([&] {
+    auto storage = create_actor<Storage>("Storage");
+    auto storage_id = storage.get();
+    create_actor<Client>("Client", storage_id, [&, storage = std::move(storage)](td::Result<int> r_sum) mutable {
+      result = r_sum.move_as_ok();
+      storage.reset();
+      SchedulerContext::get()->stop();
+    }).release();
+  });
+  scheduler.run();
+  ASSERT_EQ(50 + 4, result);
+}
+
+TEST(ActorCoro, owner_destroyed) {
+  Scheduler scheduler({1});
+  bool is_lost = false;
+  scheduler.run_in_context([&] {
+    auto storage = create_actor<Storage>("Storage");
+    auto storage_id = storage.get();
+    create_actor<DyingClient>("Client", storage_id, [&, storage = std::move(storage)](td::Result<int> r) mutable {
+      is_lost = r.is_error();
+      storage.reset();
+      SchedulerContext::get()->stop();
+    }).release();
+  });
+  scheduler.run();
+  ASSERT_TRUE(is_lost);
+}
+#endif
@@ -28,6 +28,16 @@ class KeyValueReader {
   enum class GetStatus : int32 { Ok, NotFound };
 
   virtual Result<GetStatus> get(Slice key, std::string &value) = 0;
+  // Calls f with the value of the key, if it exists. The value is valid only during the call, which allows
+  // implementations to pass their own buffers instead of copying the value
+  virtual Result<GetStatus> get_view(Slice key, const std::function<Status(Slice)> &f) {
+    std::string value;
+    TRY_RESULT(status, get(key, value));
+    if (status == GetStatus::Ok) {
+      TRY_STATUS(f(value));
+    }
+    return status;
+  }
   virtual Result<size_t> count(Slice prefix) = 0;
   virtual Status for_each(std::function<Status(Slice, Slice)> f) {
     return Status::Error("for_each is not supported");
@@ -45,6 +55,9 @@ class PrefixedKeyValueReader : public KeyValueReader {
   Result<GetStatus> get(Slice key, std::string &value) override {
     return reader_->get(PSLICE() << prefix_ << key, value);
   }
+  Result<GetStatus> get_view(Slice key, const std::function<Status(Slice)> &f) override {
+    return reader_->get_view(PSLICE() << prefix_ << key, f);
+  }
   Result<size_t> count(Slice prefix) override {
     return reader_->count(PSLICE() << prefix_ << prefix);
   }
@@ -88,6 +101,9 @@ class PrefixedKeyValue : public KeyValue {
   Result<GetStatus> get(Slice key, std::string &value) override {
     return kv_->get(PSLICE() << prefix_ << key, value);
   }
+  Result<GetStatus> get_view(Slice key, const std::function<Status(Slice)> &f) override {
+    return kv_->get_view(PSLICE() << prefix_ << key, f);
+  }
   Result<size_t> count(Slice prefix) override {
     return kv_->count(PSLICE() << prefix_ << prefix);
   }
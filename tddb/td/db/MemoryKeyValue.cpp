@@ -30,6 +30,15 @@ Result<MemoryKeyValue::GetStatus> MemoryKeyValue::get(Slice key, std::string &va
   return GetStatus::Ok;
 }
 
+Result<MemoryKeyValue::GetStatus> MemoryKeyValue::get_view(Slice key, const std::function<Status(Slice)> &f) {
+  auto it = map_.find(key);
+  if (it == map_.end()) {
+    return GetStatus::NotFound;
+  }
+  TRY_STATUS(f(it->second));
+  return GetStatus::Ok;
+}
+
 Status MemoryKeyValue::for_each(std::function<Status(Slice, Slice)> f) {
   for (auto &it : map_) {
     TRY_STATUS(f(it.first, it.second));
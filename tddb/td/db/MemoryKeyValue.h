@@ -25,6 +25,7 @@ namespace td {
 class MemoryKeyValue : public KeyValue {
  public:
   Result<GetStatus> get(Slice key, std::string &value) override;
+  Result<GetStatus> get_view(Slice key, const std::function<Status(Slice)> &f) override;
   Status for_each(std::function<Status(Slice, Slice)> f) override;
   Status for_each_in_range(Slice begin, Slice end, std::function<Status(Slice, Slice)> f) override;
   Status set(Slice key, Slice value) override;
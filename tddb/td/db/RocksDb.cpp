@@ -19,12 +19,15 @@
 #include "td/db/RocksDb.h"
 
 #include "rocksdb/db.h"
+#include "rocksdb/sst_file_writer.h"
 #include "rocksdb/table.h"
 #include "rocksdb/statistics.h"
 #include "rocksdb/write_batch.h"
 #include "rocksdb/utilities/optimistic_transaction_db.h"
 #include "rocksdb/utilities/transaction.h"
 
+#include "td/utils/port/path.h"
+
 namespace td {
 namespace {
 static Status from_rocksdb(rocksdb::Status status) {
@@ -153,6 +156,29 @@ Result<RocksDb::GetStatus> RocksDb::get(Slice key, std::string &value) {
   return from_rocksdb(status);
 }
 
+Result<RocksDb::GetStatus> RocksDb::get_view(Slice key, const std::function<Status(Slice)> &f) {
+  // the value stays pinned in the block cache (or memtable) while f is running
+  rocksdb::PinnableSlice value;
+  rocksdb::Status status;
+  if (snapshot_) {
+    rocksdb::ReadOptions options;
+    options.snapshot = snapshot_.get();
+    status = db_->Get(options, db_->DefaultColumnFamily(), to_rocksdb(key), &value);
+  } else if (transaction_) {
+    status = transaction_->Get({}, db_->DefaultColumnFamily(), to_rocksdb(key), &value);
+  } else {
+    status = db_->Get({}, db_->DefaultColumnFamily(), to_rocksdb(key), &value);
+  }
+  if (status.code() == rocksdb::Status::kNotFound) {
+    return GetStatus::NotFound;
+  }
+  if (!status.ok()) {
+    return from_rocksdb(status);
+  }
+  TRY_STATUS(f(from_rocksdb(rocksdb::Slice(value))));
+  return GetStatus::Ok;
+}
+
 Status RocksDb::set(Slice key, Slice value) {
   if (write_batch_) {
     return from_rocksdb(write_batch_->Put(to_rocksdb(key), to_rocksdb(value)));
@@ -306,10 +332,75 @@ Status RocksDb::end_snapshot() {
   return td::Status::OK();
 }
 
+Status RocksDb::ingest_external_files(std::vector<std::string> paths) {
+  if (paths.empty()) {
+    return Status::OK();
+  }
+  rocksdb::IngestExternalFileOptions options;
+  options.move_files = true;
+  return from_rocksdb(db_->IngestExternalFile(paths, options));
+}
+
 RocksDb::RocksDb(std::shared_ptr<rocksdb::OptimisticTransactionDB> db, RocksDbOptions options)
     : db_(std::move(db)), options_(options) {
 }
 
+RocksDbSstWriter::RocksDbSstWriter(std::string dir, uint64 max_file_size)
+    : dir_(std::move(dir)), max_file_size_(max_file_size) {
+}
+
+RocksDbSstWriter::RocksDbSstWriter(RocksDbSstWriter &&) = default;
+RocksDbSstWriter &RocksDbSstWriter::operator=(RocksDbSstWriter &&) = default;
+
+RocksDbSstWriter::~RocksDbSstWriter() {
+  abort();
+}
+
+Status RocksDbSstWriter::open_next_file() {
+  if (files_.empty()) {
+    auto S = mkpath(dir_);
+    if (S.is_error()) {
+      return S.move_as_error_prefix("failed to create sst directory: ");
+    }
+  }
+  auto path = PSTRING() << dir_ << "/ingest-" << files_.size() << ".sst";
+  writer_ = std::make_unique<rocksdb::SstFileWriter>(rocksdb::EnvOptions(), rocksdb::Options());
+  files_.push_back(path);
+  return from_rocksdb(writer_->Open(path));
+}
+
+Status RocksDbSstWriter::close_file() {
+  auto writer = std::move(writer_);
+  return from_rocksdb(writer->Finish());
+}
+
+Status RocksDbSstWriter::add(Slice key, Slice value) {
+  if (writer_ && writer_->FileSize() >= max_file_size_) {
+    TRY_STATUS(close_file());
+  }
+  if (!writer_) {
+    TRY_STATUS(open_next_file());
+  }
+  return from_rocksdb(writer_->Put(to_rocksdb(key), to_rocksdb(value)));
+}
+
+Result<std::vector<std::string>> RocksDbSstWriter::finish() {
+  if (writer_) {
+    TRY_STATUS(close_file());
+  }
+  auto files = std::move(files_);
+  files_.clear();
+  return std::move(files);
+}
+
+void RocksDbSstWriter::abort() {
+  writer_.reset();
+  for (auto &file : files_) {
+    unlink(file).ignore();
+  }
+  files_.clear();
+}
+
 void RocksDbSnapshotStatistics::begin_snapshot(const rocksdb::Snapshot *snapshot) {
   auto lock = std::unique_lock<std::mutex>(mutex_);
   auto id = reinterpret_cast<std::uintptr_t>(snapshot);
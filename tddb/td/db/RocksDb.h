@@ -32,6 +32,7 @@
 #include <map>
 #include <mutex>
 #include <set>
+#include <vector>
 
 #include <functional>
 
@@ -41,6 +42,7 @@ class OptimisticTransactionDB;
 class Transaction;
 class WriteBatch;
 class Snapshot;
+class SstFileWriter;
 class Statistics;
 }  // namespace rocksdb
 
@@ -72,6 +74,7 @@ class RocksDb : public KeyValue {
   static Result<RocksDb> open(std::string path, RocksDbOptions options = {});
 
   Result<GetStatus> get(Slice key, std::string &value) override;
+  Result<GetStatus> get_view(Slice key, const std::function<Status(Slice)> &f) override;
   Status set(Slice key, Slice value) override;
   Status erase(Slice key) override;
   Result<size_t> count(Slice prefix) override;
@@ -90,6 +93,10 @@ class RocksDb : public KeyValue {
   Status begin_snapshot();
   Status end_snapshot();
 
+  // Atomically adds external SST files (see RocksDbSstWriter) to the database, bypassing memtables and WAL.
+  // Files are moved into the database directory, so they must reside on the same filesystem.
+  Status ingest_external_files(std::vector<std::string> paths);
+
   std::unique_ptr<KeyValueReader> snapshot() override;
   std::string stats() const override;
 
@@ -124,4 +131,29 @@ class RocksDb : public KeyValue {
 
   explicit RocksDb(std::shared_ptr<rocksdb::OptimisticTransactionDB> db, RocksDbOptions options);
 };
+
+// Writes key-value pairs into a sequence of external SST files for RocksDb::ingest_external_files.
+// Keys must be added in strictly increasing bytewise order.
+class RocksDbSstWriter {
+ public:
+  static constexpr uint64 DEFAULT_MAX_FILE_SIZE = 256 << 20;
+
+  explicit RocksDbSstWriter(std::string dir, uint64 max_file_size = DEFAULT_MAX_FILE_SIZE);
+  RocksDbSstWriter(RocksDbSstWriter &&);
+  RocksDbSstWriter &operator=(RocksDbSstWriter &&);
+  ~RocksDbSstWriter();
+
+  Status add(Slice key, Slice value);
+  Result<std::vector<std::string>> finish();
+  void abort();
+
+ private:
+  std::string dir_;
+  uint64 max_file_size_;
+  std::unique_ptr<rocksdb::SstFileWriter> writer_;
+  std::vector<std::string> files_;
+
+  Status open_next_file();
+  Status close_file();
+};
 }  // namespace td
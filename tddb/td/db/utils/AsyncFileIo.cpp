@@ -0,0 +1,199 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#include "AsyncFileIo.h"
+
+#include "td/utils/logging.h"
+
+#include <cerrno>
+
+namespace td {
+namespace {
+// The kernel never transfers more than about 2GB per call anyway
+constexpr size_t MAX_IO_SIZE = 1 << 30;
+}  // namespace
+
+Result<actor::ActorOwn<AsyncFileIo>> AsyncFileIo::create(Slice name, uint32 queue_size) {
+  TRY_RESULT(ring, IoUring::create(queue_size));
+  return actor::create_actor<AsyncFileIo>(actor::ActorOptions().with_name(name).with_poll(), std::move(ring));
+}
+
+AsyncFileIo::AsyncFileIo(IoUring ring) : ring_(std::move(ring)) {
+}
+
+void AsyncFileIo::pwrite(const FileFd *fd, BufferSlice data, int64 offset, bool sync, Promise<Unit> promise) {
+  Request request;
+  request.type = data.empty() && sync ? Request::Type::Sync : Request::Type::Write;
+  request.fd = fd;
+  request.buffer = std::move(data);
+  request.offset = offset;
+  request.sync = sync;
+  request.write_promise = std::move(promise);
+  add_request(std::move(request));
+}
+
+void AsyncFileIo::pread(const FileFd *fd, size_t size, int64 offset, Promise<BufferSlice> promise) {
+  Request request;
+  request.type = Request::Type::Read;
+  request.fd = fd;
+  request.buffer = BufferSlice(size);
+  request.offset = offset;
+  request.read_promise = std::move(promise);
+  add_request(std::move(request));
+}
+
+void AsyncFileIo::add_request(Request request) {
+  if (request.type != Request::Type::Sync && request.buffer.empty()) {
+    request.type == Request::Type::Read ? request.read_promise.set_value(std::move(request.buffer))
+                                        : request.write_promise.set_value(Unit());
+    return;
+  }
+  pending_.push(requests_.create(std::move(request)));
+  // everything that arrives before the wakeup is handled goes to the kernel in the same batch
+  if (!flush_scheduled_) {
+    flush_scheduled_ = true;
+    yield();
+  }
+}
+
+void AsyncFileIo::submit_request(Container<Request>::Id id) {
+  auto *request = requests_.get(id);
+  CHECK(request);
+  auto offset = request->offset + static_cast<int64>(request->done);
+  switch (request->type) {
+    case Request::Type::Read:
+      ring_.pread(*request->fd, request->buffer.as_slice().substr(request->done).truncate(MAX_IO_SIZE), offset, id);
+      break;
+    case Request::Type::Write:
+      ring_.pwrite(*request->fd, request->buffer.as_slice().substr(request->done).truncate(MAX_IO_SIZE), offset, id);
+      break;
+    case Request::Type::Sync:
+      ring_.fsync(*request->fd, id);
+      break;
+  }
+}
+
+void AsyncFileIo::on_completion(IoUring::Completion completion) {
+  auto id = completion.user_data;
+  auto *request = requests_.get(id);
+  CHECK(request);
+  if (completion.result == -EINTR || completion.result == -EAGAIN) {
+    pending_.push(id);
+    return;
+  }
+  if (completion.result < 0) {
+    const char *operation = request->type == Request::Type::Read    ? "pread"
+                            : request->type == Request::Type::Write ? "pwrite"
+                                                                    : "fsync";
+    return finish_request(id, Status::PosixError(-completion.result, PSLICE() << "Async " << operation << " failed"));
+  }
+
+  auto size = static_cast<size_t>(completion.result);
+  switch (request->type) {
+    case Request::Type::Read:
+      request->done += size;
+      if (size == 0 || request->done == request->buffer.size()) {
+        request->buffer.truncate(request->done);
+        return finish_request(id, Status::OK());
+      }
+      break;
+    case Request::Type::Write:
+      if (size == 0) {
+        return finish_request(id, Status::Error("Async pwrite returned 0"));
+      }
+      request->done += size;
+      if (request->done == request->buffer.size()) {
+        if (!request->sync) {
+          return finish_request(id, Status::OK());
+        }
+        // fsync is issued only after the data is written, as io_uring doesn't order requests
+        request->type = Request::Type::Sync;
+        request->buffer = {};
+      }
+      break;
+    case Request::Type::Sync:
+      return finish_request(id, Status::OK());
+  }
+  pending_.push(id);
+}
+
+void AsyncFileIo::finish_request(Container<Request>::Id id, Status status) {
+  auto request = requests_.extract(id);
+  if (request.type == Request::Type::Read) {
+    if (status.is_error()) {
+      request.read_promise.set_error(std::move(status));
+    } else {
+      request.read_promise.set_value(std::move(request.buffer));
+    }
+  } else {
+    if (status.is_error()) {
+      request.write_promise.set_error(std::move(status));
+    } else {
+      request.write_promise.set_value(Unit());
+    }
+  }
+}
+
+void AsyncFileIo::notify() {
+  actor::send_closure_later(self_, &AsyncFileIo::on_ready);
+}
+
+void AsyncFileIo::on_ready() {
+  ring_.clear_poll();
+  loop();
+}
+
+void AsyncFileIo::start_up() {
+  self_ = actor_id(this);
+  actor::SchedulerContext::get()->get_poll().subscribe(ring_.get_poll_info().extract_pollable_fd(this),
+                                                       PollFlags::Read());
+}
+
+void AsyncFileIo::tear_down() {
+  actor::SchedulerContext::get()->get_poll().unsubscribe(ring_.get_poll_info().get_pollable_fd_ref());
+  // the kernel may still access buffers of submitted requests, so they must be waited for
+  while (ring_.get_in_flight() != 0) {
+    ring_.submit(1).ensure();
+    IoUring::Completion completion;
+    while (ring_.pop_completion(completion)) {
+      finish_request(completion.user_data, Status::Error("AsyncFileIo is closed"));
+    }
+  }
+  requests_.clear();
+}
+
+void AsyncFileIo::loop() {
+  flush_scheduled_ = false;
+  IoUring::Completion completion;
+  while (ring_.pop_completion(completion)) {
+    on_completion(completion);
+  }
+  while (!pending_.empty() && ring_.get_free_slots() > 0) {
+    submit_request(pending_.pop());
+  }
+  auto r_submitted = ring_.submit();
+  if (r_submitted.is_error()) {
+    LOG(ERROR) << "Failed to submit file requests: " << r_submitted.error();
+    alarm_timestamp() = Timestamp::in(0.01);
+  }
+}
+
+void AsyncFileIo::alarm() {
+  loop();
+}
+}  // namespace td
@@ -0,0 +1,77 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#pragma once
+
+#include "td/utils/buffer.h"
+#include "td/utils/Container.h"
+#include "td/utils/Observer.h"
+#include "td/utils/port/FileFd.h"
+#include "td/utils/port/IoUring.h"
+#include "td/utils/VectorQueue.h"
+
+#include "td/actor/actor.h"
+
+namespace td {
+// Positional file I/O that doesn't block the caller's thread. Requests received by the actor while it is busy are
+// passed to the kernel with a single io_uring_enter call, and completions are picked up through the scheduler poll.
+// A file must stay open until the promises of all requests on it are set.
+class AsyncFileIo : public actor::Actor, public ObserverBase {
+ public:
+  // Returns an error if io_uring can't be used on this host, so that callers can keep using blocking I/O
+  static Result<actor::ActorOwn<AsyncFileIo>> create(Slice name = "FileIo", uint32 queue_size = 256);
+
+  explicit AsyncFileIo(IoUring ring);
+
+  // Writes the whole buffer, then calls fsync if sync is set
+  void pwrite(const FileFd *fd, BufferSlice data, int64 offset, bool sync, Promise<Unit> promise);
+  // The result is shorter than size only if the end of file is reached
+  void pread(const FileFd *fd, size_t size, int64 offset, Promise<BufferSlice> promise);
+
+ private:
+  struct Request {
+    enum class Type : int32 { Read, Write, Sync } type{Type::Read};
+    const FileFd *fd{nullptr};
+    BufferSlice buffer;
+    int64 offset{0};
+    size_t done{0};
+    bool sync{false};
+    Promise<Unit> write_promise;
+    Promise<BufferSlice> read_promise;
+  };
+
+  IoUring ring_;
+  Container<Request> requests_;
+  VectorQueue<Container<Request>::Id> pending_;
+  actor::ActorId<AsyncFileIo> self_;
+  bool flush_scheduled_{false};
+
+  void add_request(Request request);
+  void submit_request(Container<Request>::Id id);
+  void on_completion(IoUring::Completion completion);
+  void finish_request(Container<Request>::Id id, Status status);
+
+  void notify() override;
+  void on_ready();
+
+  void start_up() override;
+  void tear_down() override;
+  void loop() override;
+  void alarm() override;
+};
+}  // namespace td
@@ -38,6 +38,7 @@
 
 #include "td/actor/actor.h"
 
+#include "td/db/utils/AsyncFileIo.h"
 #include "td/db/utils/StreamInterface.h"
 #include "td/db/utils/ChainBuffer.h"
 #include "td/db/utils/CyclicBuffer.h"
@@ -808,3 +809,69 @@ TEST(Buffers, ChainBuffer) {
     ASSERT_EQ(data, res);
   }
 }
+
+TEST(AsyncFileIo, ReadWrite) {
+  td::CSlice path("test_async_file_io.txt");
+  td::unlink(path).ignore();
+  auto fd = td::FileFd::open(path, td::FileFd::Read | td::FileFd::Write | td::FileFd::CreateNew).move_as_ok();
+
+  const size_t chunk_count = 300;
+  std::vector<std::string> chunks(chunk_count);
+  std::vector<td::int64> offsets(chunk_count);
+  td::int64 size = 0;
+  for (size_t i = 0; i < chunk_count; i++) {
+    chunks[i] = td::rand_string('a', 'z', td::Random::fast(1, 10000));
+    offsets[i] = size;
+    size += chunks[i].size();
+  }
+
+  bool supported = true;
+  size_t read_ok = 0;
+  td::actor::Scheduler scheduler({1});
+  scheduler.run_in_context([&]() mutable {
+    auto r_file_io = td::AsyncFileIo::create("FileIo", 16);
+    if (r_file_io.is_error()) {
+      LOG(INFO) << "Skip AsyncFileIo test: " << r_file_io.error();
+      supported = false;
+      td::actor::SchedulerContext::get()->stop();
+      return;
+    }
+    auto file_io = std::make_shared<td::actor::ActorOwn<td::AsyncFileIo>>(r_file_io.move_as_ok());
+    auto read_all = [&, file_io] {
+      auto pending = std::make_shared<size_t>(chunk_count);
+      for (size_t i = 0; i < chunk_count; i++) {
+        // the last read asks for more than was written to check that reads stop at the end of file
+        auto read_size = chunks[i].size() + (i + 1 == chunk_count ? 10 : 0);
+        td::actor::send_closure(file_io->get(), &td::AsyncFileIo::pread, &fd, read_size, offsets[i],
+                                [&, i, pending, file_io](td::Result<td::BufferSlice> r_data) mutable {
+                                  if (r_data.move_as_ok().as_slice() == chunks[i]) {
+                                    read_ok++;
+                                  }
+                                  if (--*pending == 0) {
+                                    file_io->reset();
+                                    td::actor::SchedulerContext::get()->stop();
+                                  }
+                                });
+      }
+    };
+    auto pending = std::make_shared<size_t>(chunk_count);
+    for (size_t i = 0; i < chunk_count; i++) {
+      td::actor::send_closure(file_io->get(), &td::AsyncFileIo::pwrite, &fd, td::BufferSlice(chunks[i]), offsets[i],
+                              i % 100 == 0, [pending, read_all](td::Result<td::Unit> r) {
+                                r.ensure();
+                                if (--*pending == 0) {
+                                  read_all();
+                                }
+                              });
+    }
+  });
+  scheduler.run();
+  scheduler.stop();
+
+  if (supported) {
+    ASSERT_EQ(chunk_count, read_ok);
+    ASSERT_EQ(size, fd.get_size().move_as_ok());
+  }
+  fd.close();
+  td::unlink(path).ensure();
+}
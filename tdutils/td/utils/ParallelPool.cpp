@@ -0,0 +1,181 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#include "td/utils/ParallelPool.h"
+
+#include "td/utils/port/thread.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+namespace td {
+
+namespace {
+
+class Pool {
+ public:
+  ~Pool() {
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      closing_ = true;
+    }
+    cv_.notify_all();
+    for (auto &thread : threads_) {
+      thread.join();
+    }
+  }
+
+  void set_max_threads(size_t threads) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    max_threads_ = threads;
+  }
+
+  size_t max_threads() {
+    std::lock_guard<std::mutex> guard(mutex_);
+    return get_max_threads();
+  }
+
+  void run(size_t n, const std::function<void(size_t)> &run_task, size_t extra_threads_n) {
+    extra_threads_n = std::min(extra_threads_n, n == 0 ? 0 : n - 1);
+    if (extra_threads_n == 0) {
+      for (size_t i = 0; i < n; i++) {
+        run_task(i);
+      }
+      return;
+    }
+    auto job = std::make_shared<Job>(n, run_task);
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      extra_threads_n = std::min(extra_threads_n, get_max_threads());
+      for (size_t i = 0; i < extra_threads_n; i++) {
+        queue_.push_back(job);
+      }
+      while (threads_.size() < get_max_threads() && idle_ < queue_.size()) {
+        idle_++;
+        threads_.emplace_back([this] { loop(); });
+      }
+    }
+    cv_.notify_all();
+    job->run();
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      queue_.erase(std::remove(queue_.begin(), queue_.end(), job), queue_.end());
+    }
+    job->finish();
+  }
+
+ private:
+  // a helper either joins the job before finish() and is waited for, or doesn't touch run_task at all
+  class Job {
+   public:
+    Job(size_t n, const std::function<void(size_t)> &run_task) : n_(n), run_task_(run_task) {
+    }
+    void run() {
+      while (true) {
+        auto task_id = next_task_id_++;
+        if (task_id >= n_) {
+          break;
+        }
+        run_task_(task_id);
+      }
+    }
+    void help() {
+      {
+        std::lock_guard<std::mutex> guard(mutex_);
+        if (finished_) {
+          return;
+        }
+        active_++;
+      }
+      run();
+      std::lock_guard<std::mutex> guard(mutex_);
+      if (--active_ == 0) {
+        cv_.notify_all();
+      }
+    }
+    void finish() {
+      std::unique_lock<std::mutex> lock(mutex_);
+      finished_ = true;
+      cv_.wait(lock, [&] { return active_ == 0; });
+    }
+
+   private:
+    size_t n_;
+    const std::function<void(size_t)> &run_task_;
+    std::atomic<size_t> next_task_id_{0};
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    size_t active_ = 0;
+    bool finished_ = false;
+  };
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<std::shared_ptr<Job>> queue_;
+  // NB: td::thread is used, not std::thread, so that thread-local objects are destroyed when the thread exits
+  std::vector<td::thread> threads_;
+  size_t idle_ = 0;
+  size_t max_threads_ = 0;
+  bool closing_ = false;
+
+  size_t get_max_threads() const {
+    return max_threads_ != 0 ? max_threads_ : std::max<size_t>(td::thread::hardware_concurrency(), 1) - 1;
+  }
+
+  void loop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      cv_.wait(lock, [&] { return closing_ || !queue_.empty(); });
+      if (closing_) {
+        return;
+      }
+      auto job = std::move(queue_.front());
+      queue_.pop_front();
+      idle_--;
+      lock.unlock();
+      job->help();
+      job.reset();
+      lock.lock();
+      idle_++;
+    }
+  }
+};
+
+Pool &pool() {
+  static Pool pool;
+  return pool;
+}
+
+}  // namespace
+
+void ParallelPool::set_max_threads(size_t threads) {
+  pool().set_max_threads(threads);
+}
+
+size_t ParallelPool::max_threads() {
+  return pool().max_threads();
+}
+
+void ParallelPool::run(size_t n, const std::function<void(size_t)> &run_task, size_t extra_threads_n) {
+  pool().run(n, run_task, extra_threads_n);
+}
+
+}  // namespace td
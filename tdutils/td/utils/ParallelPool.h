@@ -0,0 +1,42 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#pragma once
+
+#include "td/utils/common.h"
+
+#include <functional>
+
+namespace td {
+
+// Worker threads shared by all data-parallel loops of the process. Threads are started on demand, up to
+// max_threads(), and are never stopped, so a parallel loop doesn't create threads of its own
+class ParallelPool {
+ public:
+  // 0 (default) means hardware_concurrency() - 1, because the calling thread takes part in every loop;
+  // the limit doesn't stop threads that are already running, so it should be set at startup
+  static void set_max_threads(size_t threads);
+  static size_t max_threads();
+
+  // runs run_task(0), ..., run_task(n - 1) on the calling thread and on up to extra_threads_n pool threads and
+  // returns when all tasks are done. The caller runs tasks itself until none are left, so nested loops and loops
+  // started while the pool is busy make progress anyway. run_task must not throw
+  static void run(size_t n, const std::function<void(size_t)> &run_task, size_t extra_threads_n);
+};
+
+}  // namespace td
@@ -0,0 +1,262 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#include "td/utils/Sha256Batch.h"
+
+#include "td/utils/check.h"
+#include "td/utils/config.h"
+#include "td/utils/port/thread_local.h"
+#include "td/utils/Sha256BatchKernel.h"
+
+#if TD_HAVE_OPENSSL
+#include <openssl/evp.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+
+#if TD_SHA256_BATCH_X86 && TD_HAVE_OPENSSL
+#include <cpuid.h>
+#endif
+
+namespace td {
+
+namespace {
+#if !TD_HAVE_OPENSSL
+struct ScalarLanes {
+  using Type = uint32;
+  static constexpr size_t LANES = 1;
+
+  static Type set1(uint32 x) {
+    return x;
+  }
+  static Type load(const uint32 *ptr) {
+    return *ptr;
+  }
+  static void store(uint32 *ptr, Type x) {
+    *ptr = x;
+  }
+  static Type add(Type a, Type b) {
+    return a + b;
+  }
+  static Type xor3(Type a, Type b, Type c) {
+    return a ^ b ^ c;
+  }
+  template <int N>
+  static Type rotr(Type x) {
+    return (x >> N) | (x << (32 - N));
+  }
+  template <int N>
+  static Type shr(Type x) {
+    return x >> N;
+  }
+  static Type ch(Type e, Type f, Type g) {
+    return (e & f) ^ (~e & g);
+  }
+  static Type maj(Type a, Type b, Type c) {
+    return (a & b) | (c & (a | b));
+  }
+  static Type select(Type mask, Type a, Type b) {
+    return (a & mask) | (b & ~mask);
+  }
+};
+#endif
+
+void pad_message(Slice message, detail::Sha256PaddedMessage &padded) {
+  auto rem = message.size() % 64;
+  padded.data = message.ubegin();
+  padded.full_blocks = message.size() / 64;
+  padded.blocks = padded.full_blocks + (rem + 9 <= 64 ? 1 : 2);
+  auto tail_size = (padded.blocks - padded.full_blocks) * 64;
+  std::memset(padded.tail, 0, tail_size);
+  std::memcpy(padded.tail, message.ubegin() + padded.full_blocks * 64, rem);
+  padded.tail[rem] = 0x80;
+  uint64 bits = static_cast<uint64>(message.size()) * 8;
+  for (int i = 0; i < 8; i++) {
+    padded.tail[tail_size - 1 - i] = static_cast<unsigned char>(bits >> (8 * i));
+  }
+}
+
+#if TD_HAVE_OPENSSL
+// initializing a digest context looks up the algorithm, which costs more than hashing a short message,
+// so an initialized context is copied instead
+class Sha256Hasher {
+ public:
+  Sha256Hasher() {
+    base_ctx_ = EVP_MD_CTX_new();
+    ctx_ = EVP_MD_CTX_new();
+    CHECK(base_ctx_ && ctx_);
+    CHECK(EVP_DigestInit_ex(base_ctx_, EVP_sha256(), nullptr) == 1);
+  }
+  Sha256Hasher(const Sha256Hasher &) = delete;
+  Sha256Hasher &operator=(const Sha256Hasher &) = delete;
+  ~Sha256Hasher() {
+    EVP_MD_CTX_free(ctx_);
+    EVP_MD_CTX_free(base_ctx_);
+  }
+
+  void hash(Slice message, MutableSlice digest) {
+    unsigned size = 0;
+    CHECK(EVP_MD_CTX_copy_ex(ctx_, base_ctx_) == 1);
+    CHECK(EVP_DigestUpdate(ctx_, message.ubegin(), message.size()) == 1);
+    CHECK(EVP_DigestFinal_ex(ctx_, digest.ubegin(), &size) == 1);
+    CHECK(size == 32);
+  }
+
+ private:
+  EVP_MD_CTX *base_ctx_ = nullptr;
+  EVP_MD_CTX *ctx_ = nullptr;
+};
+#endif
+
+void hash_single(Slice message, MutableSlice digest) {
+#if TD_HAVE_OPENSSL
+  static TD_THREAD_LOCAL Sha256Hasher *hasher;
+  init_thread_local<Sha256Hasher>(hasher);
+  hasher->hash(message, digest);
+#else
+  detail::Sha256PaddedMessage padded;
+  pad_message(message, padded);
+  const detail::Sha256PaddedMessage *ptr = &padded;
+  unsigned char *out = digest.ubegin();
+  detail::sha256_lanes<ScalarLanes>(&ptr, 1, &out);
+#endif
+}
+
+// whether hash_single() runs on SHA-NI, which OpenSSL uses if the CPU has it
+bool single_uses_sha_extensions() {
+#if TD_SHA256_BATCH_X86 && TD_HAVE_OPENSSL
+  unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
+  return __get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) != 0 && (ebx & (1u << 29)) != 0;
+#else
+  return false;
+#endif
+}
+
+bool cpu_supports(Sha256Batch::Kernel kernel) {
+#if TD_SHA256_BATCH_X86
+  switch (kernel) {
+    case Sha256Batch::Kernel::Avx2:
+      return detail::sha256_avx2_lanes() != 0 && __builtin_cpu_supports("avx2");
+    case Sha256Batch::Kernel::Avx512:
+      return detail::sha256_avx512_lanes() != 0 && __builtin_cpu_supports("avx512f");
+    default:
+      break;
+  }
+#endif
+  return kernel == Sha256Batch::Kernel::Single;
+}
+}  // namespace
+
+Sha256Batch::Kernel Sha256Batch::best_kernel() {
+  static const Kernel kernel = [] {
+    // measured on a CPU with both SHA-NI and AVX-512 on 40..260-byte messages: AVX-512 is 1.3-1.9 times faster
+    // than one message at a time with SHA-NI, while AVX2 is on par for one-block messages and 1.1-1.5 times
+    // slower for longer ones, so AVX2 is used only without SHA-NI
+    if (is_supported(Kernel::Avx512)) {
+      return Kernel::Avx512;
+    }
+    if (is_supported(Kernel::Avx2) && !single_uses_sha_extensions()) {
+      return Kernel::Avx2;
+    }
+    return Kernel::Single;
+  }();
+  return kernel;
+}
+
+bool Sha256Batch::is_supported(Kernel kernel) {
+  static const bool supported[3] = {cpu_supports(Kernel::Single), cpu_supports(Kernel::Avx2),
+                                    cpu_supports(Kernel::Avx512)};
+  return supported[static_cast<int32>(kernel)];
+}
+
+size_t Sha256Batch::lanes(Kernel kernel) {
+  switch (kernel) {
+    case Kernel::Avx2:
+      return detail::sha256_avx2_lanes();
+    case Kernel::Avx512:
+      return detail::sha256_avx512_lanes();
+    default:
+      return 1;
+  }
+}
+
+Slice Sha256Batch::kernel_name(Kernel kernel) {
+  switch (kernel) {
+    case Kernel::Avx2:
+      return Slice("avx2");
+    case Kernel::Avx512:
+      return Slice("avx512");
+    default:
+      return Slice("single");
+  }
+}
+
+void Sha256Batch::hash(Span<Slice> messages, Span<MutableSlice> digests) {
+  hash(messages, digests, best_kernel());
+}
+
+void Sha256Batch::hash(Span<Slice> messages, Span<MutableSlice> digests, Kernel kernel) {
+  CHECK(messages.size() == digests.size());
+  for (auto &digest : digests) {
+    CHECK(digest.size() >= 32);
+  }
+  CHECK(is_supported(kernel));
+  size_t n = messages.size();
+  size_t lanes_count = lanes(kernel);
+  // a wide kernel pays for all of its lanes, so nearly empty batches are cheaper one by one
+  size_t min_batch = td::max(lanes_count / 4, static_cast<size_t>(2));
+  if (kernel == Kernel::Single || n < min_batch) {
+    for (size_t i = 0; i < n; i++) {
+      hash_single(messages[i], digests[i]);
+    }
+    return;
+  }
+
+  std::vector<detail::Sha256PaddedMessage> padded(n);
+  std::vector<uint32> order(n);
+  for (size_t i = 0; i < n; i++) {
+    pad_message(messages[i], padded[i]);
+    order[i] = static_cast<uint32>(i);
+  }
+  std::stable_sort(order.begin(), order.end(),
+                   [&](uint32 a, uint32 b) { return padded[a].blocks < padded[b].blocks; });
+
+  const detail::Sha256PaddedMessage *chunk_messages[16];
+  unsigned char *chunk_digests[16];
+  for (size_t begin = 0; begin < n; begin += lanes_count) {
+    size_t size = td::min(lanes_count, n - begin);
+    if (size < min_batch) {
+      for (size_t i = begin; i < n; i++) {
+        hash_single(messages[order[i]], digests[order[i]]);
+      }
+      break;
+    }
+    for (size_t i = 0; i < size; i++) {
+      chunk_messages[i] = &padded[order[begin + i]];
+      chunk_digests[i] = digests[order[begin + i]].ubegin();
+    }
+    if (kernel == Kernel::Avx512) {
+      detail::sha256_avx512(chunk_messages, size, chunk_digests);
+    } else {
+      detail::sha256_avx2(chunk_messages, size, chunk_digests);
+    }
+  }
+}
+
+}  // namespace td
@@ -0,0 +1,45 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#pragma once
+
+#include "td/utils/common.h"
+#include "td/utils/Slice.h"
+#include "td/utils/Span.h"
+
+namespace td {
+
+// SHA-256 of many independent short messages at once.
+// Wide kernels hash one message per 32-bit lane of an AVX2 (8 lanes) or AVX-512 (16 lanes) register;
+// the kernel is chosen at runtime. Single hashes one message at a time, with OpenSSL if available, which uses SHA-NI
+// if the CPU has it; best_kernel() prefers Single to AVX2 on such CPUs
+class Sha256Batch {
+ public:
+  enum class Kernel : int32 { Single, Avx2, Avx512 };
+
+  static Kernel best_kernel();
+  static bool is_supported(Kernel kernel);
+  static size_t lanes(Kernel kernel);
+  static Slice kernel_name(Kernel kernel);
+
+  // digests[i] = sha256(messages[i]); every digest must have at least 32 bytes
+  static void hash(Span<Slice> messages, Span<MutableSlice> digests);
+  static void hash(Span<Slice> messages, Span<MutableSlice> digests, Kernel kernel);
+};
+
+}  // namespace td
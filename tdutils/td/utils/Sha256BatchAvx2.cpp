@@ -0,0 +1,86 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#include "td/utils/Sha256BatchKernel.h"
+
+#if TD_SHA256_BATCH_X86 && defined(__AVX2__)
+#include <immintrin.h>
+
+namespace td {
+namespace detail {
+namespace {
+struct Avx2Lanes {
+  using Type = __m256i;
+  static constexpr size_t LANES = 8;
+
+  static Type set1(uint32 x) {
+    return _mm256_set1_epi32(static_cast<int>(x));
+  }
+  static Type load(const uint32 *ptr) {
+    return _mm256_load_si256(reinterpret_cast<const __m256i *>(ptr));
+  }
+  static void store(uint32 *ptr, Type x) {
+    _mm256_store_si256(reinterpret_cast<__m256i *>(ptr), x);
+  }
+  static Type add(Type a, Type b) {
+    return _mm256_add_epi32(a, b);
+  }
+  static Type xor3(Type a, Type b, Type c) {
+    return _mm256_xor_si256(_mm256_xor_si256(a, b), c);
+  }
+  template <int N>
+  static Type rotr(Type x) {
+    return _mm256_or_si256(_mm256_srli_epi32(x, N), _mm256_slli_epi32(x, 32 - N));
+  }
+  template <int N>
+  static Type shr(Type x) {
+    return _mm256_srli_epi32(x, N);
+  }
+  static Type ch(Type e, Type f, Type g) {
+    return _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+  }
+  static Type maj(Type a, Type b, Type c) {
+    return _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(c, _mm256_or_si256(a, b)));
+  }
+  static Type select(Type mask, Type a, Type b) {
+    return _mm256_blendv_epi8(b, a, mask);
+  }
+};
+}  // namespace
+
+size_t sha256_avx2_lanes() {
+  return Avx2Lanes::LANES;
+}
+
+void sha256_avx2(const Sha256PaddedMessage *const *messages, size_t n, unsigned char *const *digests) {
+  sha256_lanes<Avx2Lanes>(messages, n, digests);
+}
+}  // namespace detail
+}  // namespace td
+#else
+namespace td {
+namespace detail {
+size_t sha256_avx2_lanes() {
+  return 0;
+}
+
+void sha256_avx2(const Sha256PaddedMessage *const *messages, size_t n, unsigned char *const *digests) {
+}
+}  // namespace detail
+}  // namespace td
+#endif
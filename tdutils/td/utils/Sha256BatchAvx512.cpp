@@ -0,0 +1,86 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#include "td/utils/Sha256BatchKernel.h"
+
+#if TD_SHA256_BATCH_X86 && defined(__AVX512F__)
+#include <immintrin.h>
+
+namespace td {
+namespace detail {
+namespace {
+struct Avx512Lanes {
+  using Type = __m512i;
+  static constexpr size_t LANES = 16;
+
+  static Type set1(uint32 x) {
+    return _mm512_set1_epi32(static_cast<int>(x));
+  }
+  static Type load(const uint32 *ptr) {
+    return _mm512_load_si512(ptr);
+  }
+  static void store(uint32 *ptr, Type x) {
+    _mm512_store_si512(ptr, x);
+  }
+  static Type add(Type a, Type b) {
+    return _mm512_add_epi32(a, b);
+  }
+  static Type xor3(Type a, Type b, Type c) {
+    return _mm512_ternarylogic_epi32(a, b, c, 0x96);
+  }
+  template <int N>
+  static Type rotr(Type x) {
+    return _mm512_ror_epi32(x, N);
+  }
+  template <int N>
+  static Type shr(Type x) {
+    return _mm512_srli_epi32(x, N);
+  }
+  static Type ch(Type e, Type f, Type g) {
+    return _mm512_ternarylogic_epi32(e, f, g, 0xca);
+  }
+  static Type maj(Type a, Type b, Type c) {
+    return _mm512_ternarylogic_epi32(a, b, c, 0xe8);
+  }
+  static Type select(Type mask, Type a, Type b) {
+    return _mm512_mask_blend_epi32(_mm512_test_epi32_mask(mask, mask), b, a);
+  }
+};
+}  // namespace
+
+size_t sha256_avx512_lanes() {
+  return Avx512Lanes::LANES;
+}
+
+void sha256_avx512(const Sha256PaddedMessage *const *messages, size_t n, unsigned char *const *digests) {
+  sha256_lanes<Avx512Lanes>(messages, n, digests);
+}
+}  // namespace detail
+}  // namespace td
+#else
+namespace td {
+namespace detail {
+size_t sha256_avx512_lanes() {
+  return 0;
+}
+
+void sha256_avx512(const Sha256PaddedMessage *const *messages, size_t n, unsigned char *const *digests) {
+}
+}  // namespace detail
+}  // namespace td
+#endif
@@ -0,0 +1,157 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#pragma once
+
+#include "td/utils/int_types.h"
+
+// Kernels are compiled in separate translation units with their own instruction set flags, so this header
+// must not pull in anything with external inline functions, which the linker could share with generic code
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__)) && !defined(__EMSCRIPTEN__)
+#define TD_SHA256_BATCH_X86 1
+#else
+#define TD_SHA256_BATCH_X86 0
+#endif
+
+namespace td {
+namespace detail {
+
+// message as a sequence of 64-byte blocks; the last one or two blocks with the padding are stored in tail
+struct Sha256PaddedMessage {
+  const unsigned char *data;
+  size_t full_blocks;
+  size_t blocks;
+  unsigned char tail[128];
+};
+
+// lanes of the kernel, or 0 if the kernel isn't compiled in
+size_t sha256_avx2_lanes();
+size_t sha256_avx512_lanes();
+
+// hash n <= lanes messages side by side
+void sha256_avx2(const Sha256PaddedMessage *const *messages, size_t n, unsigned char *const *digests);
+void sha256_avx512(const Sha256PaddedMessage *const *messages, size_t n, unsigned char *const *digests);
+
+static const uint32 sha256_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+static const uint32 sha256_h0[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                                    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+
+static inline uint32 sha256_load_be32(const unsigned char *ptr) {
+  return (uint32(ptr[0]) << 24) | (uint32(ptr[1]) << 16) | (uint32(ptr[2]) << 8) | uint32(ptr[3]);
+}
+
+static inline void sha256_store_be32(unsigned char *ptr, uint32 value) {
+  ptr[0] = static_cast<unsigned char>(value >> 24);
+  ptr[1] = static_cast<unsigned char>(value >> 16);
+  ptr[2] = static_cast<unsigned char>(value >> 8);
+  ptr[3] = static_cast<unsigned char>(value);
+}
+
+// SHA-256 over V::LANES independent 32-bit lanes. Lanes without a block to process keep their state,
+// so messages of different lengths may share a call, but the caller groups them by length to keep lanes busy
+template <class V>
+static void sha256_lanes(const Sha256PaddedMessage *const *messages, size_t n, unsigned char *const *digests) {
+  using T = typename V::Type;
+  constexpr size_t LANES = V::LANES;
+  static const unsigned char zero_block[64] = {};
+
+  size_t max_blocks = 0;
+  for (size_t lane = 0; lane < n; lane++) {
+    if (messages[lane]->blocks > max_blocks) {
+      max_blocks = messages[lane]->blocks;
+    }
+  }
+
+  T state[8];
+  for (int i = 0; i < 8; i++) {
+    state[i] = V::set1(sha256_h0[i]);
+  }
+
+  alignas(64) uint32 words[16][LANES];
+  alignas(64) uint32 active[LANES];
+  for (size_t b = 0; b < max_blocks; b++) {
+    for (size_t lane = 0; lane < LANES; lane++) {
+      const unsigned char *block = zero_block;
+      active[lane] = 0;
+      if (lane < n && b < messages[lane]->blocks) {
+        auto *message = messages[lane];
+        block = b < message->full_blocks ? message->data + b * 64 : message->tail + (b - message->full_blocks) * 64;
+        active[lane] = 0xffffffff;
+      }
+      for (int t = 0; t < 16; t++) {
+        words[t][lane] = sha256_load_be32(block + 4 * t);
+      }
+    }
+
+    T w[16];
+    for (int t = 0; t < 16; t++) {
+      w[t] = V::load(words[t]);
+    }
+    T a = state[0], b_ = state[1], c = state[2], d = state[3], e = state[4], f = state[5], g = state[6],
+      h = state[7];
+    for (int t = 0; t < 64; t++) {
+      if (t >= 16) {
+        T w15 = w[(t - 15) & 15];
+        T w2 = w[(t - 2) & 15];
+        T s0 = V::xor3(V::template rotr<7>(w15), V::template rotr<18>(w15), V::template shr<3>(w15));
+        T s1 = V::xor3(V::template rotr<17>(w2), V::template rotr<19>(w2), V::template shr<10>(w2));
+        w[t & 15] = V::add(V::add(w[t & 15], s0), V::add(w[(t - 7) & 15], s1));
+      }
+      T s1 = V::xor3(V::template rotr<6>(e), V::template rotr<11>(e), V::template rotr<25>(e));
+      T t1 = V::add(V::add(h, s1), V::add(V::ch(e, f, g), V::add(V::set1(sha256_k[t]), w[t & 15])));
+      T s0 = V::xor3(V::template rotr<2>(a), V::template rotr<13>(a), V::template rotr<22>(a));
+      T t2 = V::add(s0, V::maj(a, b_, c));
+      h = g;
+      g = f;
+      f = e;
+      e = V::add(d, t1);
+      d = c;
+      c = b_;
+      b_ = a;
+      a = V::add(t1, t2);
+    }
+
+    T mask = V::load(active);
+    T result[8] = {a, b_, c, d, e, f, g, h};
+    for (int i = 0; i < 8; i++) {
+      state[i] = V::select(mask, V::add(state[i], result[i]), state[i]);
+    }
+  }
+
+  alignas(64) uint32 out[8][LANES];
+  for (int i = 0; i < 8; i++) {
+    V::store(out[i], state[i]);
+  }
+  for (size_t lane = 0; lane < n; lane++) {
+    for (int i = 0; i < 8; i++) {
+      sha256_store_be32(digests[lane] + 4 * i, out[i][lane]);
+    }
+  }
+}
+
+}  // namespace detail
+}  // namespace td
@@ -0,0 +1,258 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#pragma once
+
+#include "td/utils/bits.h"
+#include "td/utils/common.h"
+#include "td/utils/List.h"
+#include "td/utils/logging.h"
+
+#include <array>
+#include <cmath>
+#include <limits>
+
+namespace td {
+
+struct TimerWheelNode : private ListNode {
+  bool in_wheel() const {
+    return in_wheel_;
+  }
+  double wheel_key() const {
+    return key_;
+  }
+
+ private:
+  template <int Levels, int Bits>
+  friend class TimerWheel;
+  double key_ = 0;
+  bool in_wheel_ = false;
+};
+
+// Hierarchical timing wheel with the same purpose as KHeap<double> keyed by time: O(1) insert, fix and erase.
+// Keys are rounded up to resolution, so a node never expires before its key, but may expire up to one
+// resolution later. Levels * Bits bits of ticks are covered by the wheels, later keys wait in an overflow list.
+template <int Levels = 4, int Bits = 8>
+class TimerWheel {
+ public:
+  explicit TimerWheel(double now, double resolution = 0.001)
+      : resolution_(resolution), inv_resolution_(1 / resolution), current_(to_tick_floor(now)) {
+  }
+  TimerWheel(const TimerWheel &) = delete;
+  TimerWheel &operator=(const TimerWheel &) = delete;
+  ~TimerWheel() {
+    for_each_list([](ListNode &list) {
+      while (!list.empty()) {
+        list.get();
+      }
+    });
+  }
+
+  bool empty() const {
+    return size_ == 0;
+  }
+  size_t size() const {
+    return size_;
+  }
+
+  void insert(double key, TimerWheelNode *node) {
+    CHECK(!node->in_wheel());
+    node->key_ = key;
+    node->in_wheel_ = true;
+    size_++;
+    place(node);
+  }
+
+  void fix(double key, TimerWheelNode *node) {
+    CHECK(node->in_wheel());
+    static_cast<ListNode *>(node)->remove();
+    node->key_ = key;
+    place(node);
+  }
+
+  void erase(TimerWheelNode *node) {
+    CHECK(node->in_wheel());
+    static_cast<ListNode *>(node)->remove();
+    node->in_wheel_ = false;
+    size_--;
+  }
+
+  // Returns a node with key <= now, or nullptr if there is none
+  TimerWheelNode *pop_expired(double now) {
+    if (ready_.empty()) {
+      advance(to_tick_floor(now));
+    }
+    auto *list_node = ready_.get();
+    if (list_node == nullptr) {
+      return nullptr;
+    }
+    auto *node = static_cast<TimerWheelNode *>(list_node);
+    node->in_wheel_ = false;
+    size_--;
+    return node;
+  }
+
+  // Lower bound on the key of the first node to expire, +inf if the wheel is empty.
+  // It may be earlier than any key when nodes have to be moved between levels first.
+  double next_expiration() const {
+    if (empty()) {
+      return std::numeric_limits<double>::infinity();
+    }
+    auto tick = ready_.empty() ? next_event_tick() : current_;
+    // a bit after the start of the tick, so that the tick is reached despite rounding errors
+    return (static_cast<double>(tick) + 0.001) * resolution_;
+  }
+
+  template <class F>
+  void for_each(F &&f) {
+    for_each_list([&](ListNode &list) {
+      for (auto *it = list.begin(); it != list.end(); it = it->get_next()) {
+        auto *node = static_cast<TimerWheelNode *>(it);
+        f(node->key_, node);
+      }
+    });
+  }
+
+ private:
+  static constexpr int SLOTS = 1 << Bits;
+  static constexpr int WORDS = (SLOTS + 63) / 64;
+  static constexpr uint64 MAX_TICK = static_cast<uint64>(1) << 62;
+
+  struct Level {
+    std::array<ListNode, SLOTS> slots;
+    std::array<uint64, WORDS> mask{};
+
+    void put(int slot, ListNode *node) {
+      slots[slot].put_back(node);
+      mask[slot / 64] |= static_cast<uint64>(1) << (slot % 64);
+    }
+    // first non-empty slot after the given one, -1 if none
+    int next_slot(int slot) const {
+      for (int i = slot + 1; i < SLOTS; i++) {
+        auto word = mask[i / 64] >> (i % 64);
+        if (word == 0) {
+          i = (i / 64 + 1) * 64 - 1;
+          continue;
+        }
+        return i + count_trailing_zeroes64(word);
+      }
+      return -1;
+    }
+  };
+
+  double resolution_;
+  double inv_resolution_;
+  uint64 current_;
+  size_t size_{0};
+  std::array<Level, Levels> levels_;
+  ListNode overflow_;
+  ListNode ready_;
+
+  uint64 to_tick_floor(double key) const {
+    auto tick = std::floor(key * inv_resolution_);
+    return tick <= 0 ? 0 : tick >= static_cast<double>(MAX_TICK) ? MAX_TICK : static_cast<uint64>(tick);
+  }
+  uint64 to_tick_ceil(double key) const {
+    auto tick = std::ceil(key * inv_resolution_);
+    return tick <= 0 ? 0 : tick >= static_cast<double>(MAX_TICK) ? MAX_TICK : static_cast<uint64>(tick);
+  }
+  static int digit(uint64 tick, int level) {
+    return static_cast<int>((tick >> (level * Bits)) & (SLOTS - 1));
+  }
+
+  void place(TimerWheelNode *node) {
+    auto tick = to_tick_ceil(node->key_);
+    if (tick <= current_) {
+      ready_.put_back(node);
+      return;
+    }
+    for (int level = 0; level < Levels; level++) {
+      auto shift = (level + 1) * Bits;
+      if ((tick >> shift) == (current_ >> shift)) {
+        levels_[level].put(digit(tick, level), node);
+        return;
+      }
+    }
+    overflow_.put_back(node);
+  }
+
+  // first tick at which some slot or the overflow list has to be processed
+  uint64 next_event_tick() const {
+    uint64 result = std::numeric_limits<uint64>::max();
+    for (int level = 0; level < Levels; level++) {
+      auto slot = levels_[level].next_slot(digit(current_, level));
+      if (slot >= 0) {
+        auto shift = (level + 1) * Bits;
+        auto tick = ((current_ >> shift) << shift) | (static_cast<uint64>(slot) << (level * Bits));
+        result = td::min(result, tick);
+      }
+    }
+    if (!overflow_.empty()) {
+      auto shift = Levels * Bits;
+      result = td::min(result, ((current_ >> shift) + 1) << shift);
+    }
+    return result;
+  }
+
+  void advance(uint64 target) {
+    while (current_ < target && ready_.empty()) {
+      auto tick = next_event_tick();
+      if (tick > target) {
+        // nothing happens till target, so the position of every node stays valid
+        current_ = target;
+        return;
+      }
+      current_ = tick;
+      if ((current_ & ((static_cast<uint64>(1) << (Levels * Bits)) - 1)) == 0) {
+        replace_all(overflow_);
+      }
+      for (int level = Levels - 1; level >= 0; level--) {
+        if ((current_ & ((static_cast<uint64>(1) << (level * Bits)) - 1)) != 0) {
+          continue;
+        }
+        auto slot = digit(current_, level);
+        auto &list = levels_[level].slots[slot];
+        levels_[level].mask[slot / 64] &= ~(static_cast<uint64>(1) << (slot % 64));
+        replace_all(list);
+      }
+    }
+  }
+
+  void replace_all(ListNode &list) {
+    ListNode nodes;
+    while (auto *node = list.get()) {
+      nodes.put_back(node);
+    }
+    while (auto *node = nodes.get()) {
+      place(static_cast<TimerWheelNode *>(node));
+    }
+  }
+
+  template <class F>
+  void for_each_list(F &&f) {
+    f(ready_);
+    for (auto &level : levels_) {
+      for (auto &slot : level.slots) {
+        f(slot);
+      }
+    }
+    f(overflow_);
+  }
+};
+
+}  // namespace td
@@ -18,6 +18,8 @@
 #include "td/utils/misc.h"
 #include <lz4.h>
 
+#include <memory>
+
 namespace td {
 
 td::BufferSlice lz4_compress(td::Slice data) {
@@ -45,4 +47,40 @@ td::Result<td::BufferSlice> lz4_decompress(td::Slice data, int max_decompressed_
   return td::BufferSlice{decompressed.as_slice().substr(0, result)};
 }
 
+td::BufferSlice lz4_compress(td::Slice data, td::Slice dictionary) {
+  if (dictionary.empty()) {
+    return lz4_compress(data);
+  }
+  std::unique_ptr<LZ4_stream_t, decltype(&LZ4_freeStream)> stream(LZ4_createStream(), &LZ4_freeStream);
+  CHECK(stream);
+  LZ4_loadDict(stream.get(), dictionary.data(), narrow_cast<int>(dictionary.size()));
+  int size = narrow_cast<int>(data.size());
+  int buf_size = LZ4_compressBound(size);
+  td::BufferSlice compressed(buf_size);
+  int compressed_size = LZ4_compress_fast_continue(stream.get(), data.data(), compressed.data(), size, buf_size, 1);
+  CHECK(compressed_size > 0);
+  return td::BufferSlice{compressed.as_slice().substr(0, compressed_size)};
+}
+
+td::Result<td::BufferSlice> lz4_decompress(td::Slice data, int max_decompressed_size, td::Slice dictionary) {
+  if (dictionary.empty()) {
+    return lz4_decompress(data, max_decompressed_size);
+  }
+  TRY_RESULT(size, narrow_cast_safe<int>(data.size()));
+  TRY_RESULT(dictionary_size, narrow_cast_safe<int>(dictionary.size()));
+  if (max_decompressed_size < 0) {
+    return td::Status::Error("invalid max_decompressed_size");
+  }
+  td::BufferSlice decompressed(max_decompressed_size);
+  int result = LZ4_decompress_safe_usingDict(data.data(), decompressed.data(), size, max_decompressed_size,
+                                             dictionary.data(), dictionary_size);
+  if (result < 0) {
+    return td::Status::Error(PSTRING() << "lz4 decompression failed, error code: " << result);
+  }
+  if (result == max_decompressed_size) {
+    return decompressed;
+  }
+  return td::BufferSlice{decompressed.as_slice().substr(0, result)};
+}
+
 }  // namespace td
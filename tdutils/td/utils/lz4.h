@@ -24,4 +24,9 @@ namespace td {
 td::BufferSlice lz4_compress(td::Slice data);
 td::Result<td::BufferSlice> lz4_decompress(td::Slice data, int max_decompressed_size);
 
+// Same as above, but the data is compressed against a preset dictionary (only the last 64KB of it are used).
+// Data compressed with a dictionary can be decompressed only with the same dictionary.
+td::BufferSlice lz4_compress(td::Slice data, td::Slice dictionary);
+td::Result<td::BufferSlice> lz4_decompress(td::Slice data, int max_decompressed_size, td::Slice dictionary);
+
 }  // namespace td
@@ -0,0 +1,337 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#include "td/utils/port/IoUring.h"
+
+#include "td/utils/port/config.h"
+
+#if TD_LINUX && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define TD_HAS_IO_URING 1
+#endif
+#endif
+
+#include "td/utils/logging.h"
+
+#if TD_HAS_IO_URING
+#include "td/utils/port/EventFd.h"
+
+#include <linux/io_uring.h>
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#endif
+
+namespace td {
+
+#if TD_HAS_IO_URING
+namespace {
+int sys_io_uring_setup(uint32 entries, io_uring_params *params) {
+  return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int sys_io_uring_enter(int fd, uint32 to_submit, uint32 min_complete, uint32 flags) {
+  return static_cast<int>(syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+int sys_io_uring_register(int fd, uint32 opcode, const void *arg, uint32 nr_args) {
+  return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, nr_args));
+}
+
+uint32 *ring_field(void *ring, uint32 offset) {
+  return reinterpret_cast<uint32 *>(static_cast<char *>(ring) + offset);
+}
+}  // namespace
+
+class IoUring::Impl {
+ public:
+  Impl() = default;
+  Impl(const Impl &other) = delete;
+  Impl &operator=(const Impl &other) = delete;
+  ~Impl() {
+    if (cq_ring_ != MAP_FAILED && cq_ring_ != sq_ring_) {
+      munmap(cq_ring_, cq_ring_size_);
+    }
+    if (sq_ring_ != MAP_FAILED) {
+      munmap(sq_ring_, sq_ring_size_);
+    }
+    if (sqes_ != MAP_FAILED) {
+      munmap(sqes_, sqes_size_);
+    }
+  }
+
+  Status init(uint32 entries) {
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    ring_fd_ = NativeFd(sys_io_uring_setup(entries, &params));
+    if (!ring_fd_) {
+      return OS_ERROR("io_uring_setup failed");
+    }
+#ifdef IORING_FEAT_RW_CUR_POS
+    if ((params.features & IORING_FEAT_RW_CUR_POS) == 0)
+#endif
+    {
+      // IORING_OP_READ and IORING_OP_WRITE appeared together with this feature
+      return Status::Error("io_uring is too old");
+    }
+
+    sq_entries_ = params.sq_entries;
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(uint32);
+    cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap) {
+      sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+    }
+    auto fd = ring_fd_.fd();
+    sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (sq_ring_ == MAP_FAILED) {
+      return OS_ERROR("io_uring submission ring mmap failed");
+    }
+    if (single_mmap) {
+      cq_ring_ = sq_ring_;
+    } else {
+      cq_ring_ =
+          mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+      if (cq_ring_ == MAP_FAILED) {
+        return OS_ERROR("io_uring completion ring mmap failed");
+      }
+    }
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    sqes_ = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (sqes_ == MAP_FAILED) {
+      return OS_ERROR("io_uring sqes mmap failed");
+    }
+
+    sq_head_ = ring_field(sq_ring_, params.sq_off.head);
+    sq_tail_ = ring_field(sq_ring_, params.sq_off.tail);
+    sq_mask_ = *ring_field(sq_ring_, params.sq_off.ring_mask);
+    sq_array_ = ring_field(sq_ring_, params.sq_off.array);
+    sq_local_tail_ = *sq_tail_;
+    cq_head_ = ring_field(cq_ring_, params.cq_off.head);
+    cq_tail_ = ring_field(cq_ring_, params.cq_off.tail);
+    cq_mask_ = *ring_field(cq_ring_, params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe *>(static_cast<char *>(cq_ring_) + params.cq_off.cqes);
+
+    event_fd_.init();
+    int event_fd = event_fd_.get_poll_info().native_fd().fd();
+    if (sys_io_uring_register(fd, IORING_REGISTER_EVENTFD, &event_fd, 1) < 0) {
+      return OS_ERROR("io_uring eventfd registration failed");
+    }
+    return Status::OK();
+  }
+
+  size_t get_free_slots() const {
+    // the completion ring is at least as large as the submission ring, so it can't overflow either
+    return sq_entries_ - in_flight_;
+  }
+  size_t get_in_flight() const {
+    return in_flight_;
+  }
+
+  io_uring_sqe *get_sqe(const FileFd &fd, uint8 opcode, uint64 user_data) {
+    CHECK(get_free_slots() > 0);
+    auto index = sq_local_tail_ & sq_mask_;
+    auto *sqe = static_cast<io_uring_sqe *>(sqes_) + index;
+    std::memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = opcode;
+    sqe->fd = fd.get_native_fd().fd();
+    sqe->user_data = user_data;
+    sq_array_[index] = index;
+    sq_local_tail_++;
+    to_submit_++;
+    in_flight_++;
+    return sqe;
+  }
+
+  void prep_rw(const FileFd &fd, uint8 opcode, const char *data, size_t size, int64 offset, uint64 user_data) {
+    CHECK(size <= std::numeric_limits<uint32>::max());
+    auto *sqe = get_sqe(fd, opcode, user_data);
+    sqe->addr = reinterpret_cast<uint64>(data);
+    sqe->len = static_cast<uint32>(size);
+    sqe->off = static_cast<uint64>(offset);
+  }
+
+  Result<size_t> submit(uint32 min_complete) {
+    if (to_submit_ == 0 && min_complete == 0) {
+      return 0;
+    }
+    __atomic_store_n(sq_tail_, sq_local_tail_, __ATOMIC_RELEASE);
+    uint32 flags = min_complete != 0 ? IORING_ENTER_GETEVENTS : 0;
+    while (true) {
+      auto res = sys_io_uring_enter(ring_fd_.fd(), to_submit_, min_complete, flags);
+      if (res >= 0) {
+        // operations rejected by the kernel stay in the submission ring until the next call
+        to_submit_ -= static_cast<uint32>(res);
+        return static_cast<size_t>(res);
+      }
+      if (errno != EINTR) {
+        return OS_ERROR("io_uring_enter failed");
+      }
+    }
+  }
+
+  bool pop_completion(Completion &completion) {
+    auto head = *cq_head_;
+    if (head == __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+      return false;
+    }
+    auto &cqe = cqes_[head & cq_mask_];
+    completion.user_data = cqe.user_data;
+    completion.result = cqe.res;
+    __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+    CHECK(in_flight_ > 0);
+    in_flight_--;
+    return true;
+  }
+
+  PollableFdInfo &get_poll_info() {
+    return event_fd_.get_poll_info();
+  }
+  void clear_poll() {
+    event_fd_.acquire();
+  }
+
+ private:
+  NativeFd ring_fd_;
+  EventFd event_fd_;
+
+  void *sq_ring_{MAP_FAILED};
+  size_t sq_ring_size_{0};
+  void *cq_ring_{MAP_FAILED};
+  size_t cq_ring_size_{0};
+  void *sqes_{MAP_FAILED};
+  size_t sqes_size_{0};
+
+  uint32 *sq_head_{nullptr};
+  uint32 *sq_tail_{nullptr};
+  uint32 sq_mask_{0};
+  uint32 *sq_array_{nullptr};
+  uint32 sq_entries_{0};
+  uint32 sq_local_tail_{0};
+  uint32 to_submit_{0};
+
+  uint32 *cq_head_{nullptr};
+  uint32 *cq_tail_{nullptr};
+  uint32 cq_mask_{0};
+  io_uring_cqe *cqes_{nullptr};
+
+  size_t in_flight_{0};
+};
+
+Result<IoUring> IoUring::create(uint32 entries) {
+  auto impl = make_unique<Impl>();
+  TRY_STATUS(impl->init(entries));
+  return IoUring(std::move(impl));
+}
+
+size_t IoUring::get_free_slots() const {
+  return impl_->get_free_slots();
+}
+
+size_t IoUring::get_in_flight() const {
+  return impl_->get_in_flight();
+}
+
+void IoUring::pread(const FileFd &fd, MutableSlice slice, int64 offset, uint64 user_data) {
+  impl_->prep_rw(fd, IORING_OP_READ, slice.data(), slice.size(), offset, user_data);
+}
+
+void IoUring::pwrite(const FileFd &fd, Slice slice, int64 offset, uint64 user_data) {
+  impl_->prep_rw(fd, IORING_OP_WRITE, slice.data(), slice.size(), offset, user_data);
+}
+
+void IoUring::fsync(const FileFd &fd, uint64 user_data) {
+  impl_->get_sqe(fd, IORING_OP_FSYNC, user_data);
+}
+
+Result<size_t> IoUring::submit(uint32 min_complete) {
+  return impl_->submit(min_complete);
+}
+
+bool IoUring::pop_completion(Completion &completion) {
+  return impl_->pop_completion(completion);
+}
+
+PollableFdInfo &IoUring::get_poll_info() {
+  return impl_->get_poll_info();
+}
+
+void IoUring::clear_poll() {
+  impl_->clear_poll();
+}
+
+#else
+
+class IoUring::Impl {};
+
+Result<IoUring> IoUring::create(uint32 entries) {
+  return Status::Error("io_uring is not supported on this platform");
+}
+
+size_t IoUring::get_free_slots() const {
+  UNREACHABLE();
+}
+
+size_t IoUring::get_in_flight() const {
+  UNREACHABLE();
+}
+
+void IoUring::pread(const FileFd &fd, MutableSlice slice, int64 offset, uint64 user_data) {
+  UNREACHABLE();
+}
+
+void IoUring::pwrite(const FileFd &fd, Slice slice, int64 offset, uint64 user_data) {
+  UNREACHABLE();
+}
+
+void IoUring::fsync(const FileFd &fd, uint64 user_data) {
+  UNREACHABLE();
+}
+
+Result<size_t> IoUring::submit(uint32 min_complete) {
+  UNREACHABLE();
+}
+
+bool IoUring::pop_completion(Completion &completion) {
+  UNREACHABLE();
+}
+
+PollableFdInfo &IoUring::get_poll_info() {
+  UNREACHABLE();
+}
+
+void IoUring::clear_poll() {
+  UNREACHABLE();
+}
+
+#endif
+
+IoUring::IoUring() = default;
+IoUring::IoUring(unique_ptr<Impl> impl) : impl_(std::move(impl)) {
+}
+IoUring::IoUring(IoUring &&other) = default;
+IoUring &IoUring::operator=(IoUring &&other) = default;
+IoUring::~IoUring() = default;
+
+}  // namespace td
@@ -0,0 +1,73 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#pragma once
+
+#include "td/utils/common.h"
+#include "td/utils/port/detail/PollableFd.h"
+#include "td/utils/port/FileFd.h"
+#include "td/utils/Slice.h"
+#include "td/utils/Status.h"
+
+namespace td {
+
+// Minimal io_uring instance for positional file I/O, driven by raw syscalls (Linux 5.6+)
+// Operations are only queued by pread/pwrite/fsync and reach the kernel in one batch on submit().
+// Completions are announced through an eventfd, so get_poll_info() can be subscribed to like a socket.
+class IoUring {
+ public:
+  struct Completion {
+    uint64 user_data;
+    int32 result;  // number of bytes transferred or -errno
+  };
+
+  // Returns an error if io_uring is unsupported or disabled on this host
+  static Result<IoUring> create(uint32 entries);
+
+  IoUring();
+  IoUring(const IoUring &other) = delete;
+  IoUring &operator=(const IoUring &other) = delete;
+  IoUring(IoUring &&other);
+  IoUring &operator=(IoUring &&other);
+  ~IoUring();
+
+  // Number of operations that can be queued before some completions are popped
+  size_t get_free_slots() const;
+  size_t get_in_flight() const;
+
+  // Buffers must stay valid until the corresponding completion is popped
+  void pread(const FileFd &fd, MutableSlice slice, int64 offset, uint64 user_data);
+  void pwrite(const FileFd &fd, Slice slice, int64 offset, uint64 user_data);
+  void fsync(const FileFd &fd, uint64 user_data);
+
+  // Passes all queued operations to the kernel and waits for at least min_complete completions
+  Result<size_t> submit(uint32 min_complete = 0);
+
+  bool pop_completion(Completion &completion);
+
+  PollableFdInfo &get_poll_info();
+  // Must be called before popping completions after a poll notification
+  void clear_poll();
+
+ private:
+  class Impl;
+  unique_ptr<Impl> impl_;
+  explicit IoUring(unique_ptr<Impl> impl);
+};
+
+}  // namespace td
@@ -0,0 +1,98 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#include "td/utils/port/numa.h"
+
+#include "td/utils/port/config.h"
+
+#include "td/utils/misc.h"
+#include "td/utils/port/FileFd.h"
+#include "td/utils/port/thread.h"
+
+#include <algorithm>
+
+namespace td {
+
+#if TD_LINUX
+namespace {
+// sysfs files report a size of one page, so read_file can't be used for them
+Result<std::vector<int32>> read_cpu_list(CSlice path) {
+  TRY_RESULT(fd, FileFd::open(path, FileFd::Read));
+  char buf[4096];
+  TRY_RESULT(size, fd.read(MutableSlice(buf, sizeof(buf))));
+  fd.close();
+  return parse_cpu_list(Slice(buf, size));
+}
+}  // namespace
+#endif
+
+Result<std::vector<int32>> parse_cpu_list(Slice list) {
+  std::vector<int32> result;
+  for (auto range : full_split(trim(list), ',')) {
+    range = trim(range);
+    if (range.empty()) {
+      continue;
+    }
+    auto dash = range.find('-');
+    int32 from;
+    int32 to;
+    if (dash == Slice::npos) {
+      TRY_RESULT_ASSIGN(from, to_integer_safe<int32>(range));
+      to = from;
+    } else {
+      TRY_RESULT_ASSIGN(from, to_integer_safe<int32>(range.substr(0, dash)));
+      TRY_RESULT_ASSIGN(to, to_integer_safe<int32>(range.substr(dash + 1)));
+    }
+    if (from < 0 || to < from || to >= (1 << 16)) {
+      return Status::Error(PSLICE() << "Invalid cpu range \"" << range << '"');
+    }
+    for (auto cpu = from; cpu <= to; cpu++) {
+      result.push_back(cpu);
+    }
+  }
+  std::sort(result.begin(), result.end());
+  result.erase(std::unique(result.begin(), result.end()), result.end());
+  return std::move(result);
+}
+
+std::vector<NumaNode> get_numa_nodes() {
+  std::vector<NumaNode> result;
+#if TD_LINUX
+  auto r_ids = read_cpu_list("/sys/devices/system/node/online");
+  if (r_ids.is_ok()) {
+    for (auto id : r_ids.ok()) {
+      auto r_cpus = read_cpu_list(PSLICE() << "/sys/devices/system/node/node" << id << "/cpulist");
+      if (r_cpus.is_error() || r_cpus.ok().empty()) {
+        continue;
+      }
+      result.push_back(NumaNode{id, r_cpus.move_as_ok()});
+    }
+  }
+#endif
+  if (result.empty()) {
+    NumaNode node;
+    auto cpu_count = static_cast<int32>(thread::hardware_concurrency());
+    for (int32 cpu = 0; cpu < cpu_count; cpu++) {
+      node.cpus.push_back(cpu);
+    }
+    result.push_back(std::move(node));
+  }
+  return result;
+}
+
+}  // namespace td
@@ -0,0 +1,38 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#pragma once
+
+#include "td/utils/common.h"
+#include "td/utils/Slice.h"
+#include "td/utils/Status.h"
+
+namespace td {
+
+struct NumaNode {
+  int32 id{0};
+  std::vector<int32> cpus;
+};
+
+// NUMA nodes of the host with their online cpus. Hosts without NUMA information are one node with all cpus
+std::vector<NumaNode> get_numa_nodes();
+
+// Parses cpu lists in the Linux format, e.g. "0-3,8,10-11"
+Result<std::vector<int32>> parse_cpu_list(Slice list);
+
+}  // namespace td
@@ -0,0 +1,55 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#include "td/utils/ParallelPool.h"
+#include "td/utils/port/thread_local.h"
+#include "td/utils/tests.h"
+
+#include <atomic>
+#include <mutex>
+#include <set>
+
+TEST(ParallelPool, Run) {
+  td::ParallelPool::set_max_threads(3);
+  ASSERT_EQ(3u, td::ParallelPool::max_threads());
+
+  std::vector<int> done(1000);
+  std::mutex mutex;
+  std::set<td::int32> thread_ids;
+  td::ParallelPool::run(
+      done.size(),
+      [&](size_t task_id) {
+        done[task_id]++;
+        std::lock_guard<std::mutex> guard(mutex);
+        thread_ids.insert(td::get_thread_id());
+      },
+      10);
+  for (auto x : done) {
+    ASSERT_EQ(1, x);
+  }
+  ASSERT_TRUE(thread_ids.size() <= 4);
+
+  // nested loops make progress even when all pool threads are busy
+  std::atomic<size_t> count{0};
+  td::ParallelPool::run(
+      8, [&](size_t) { td::ParallelPool::run(100, [&](size_t) { count++; }, 3); }, 3);
+  ASSERT_EQ(800u, count.load());
+
+  td::ParallelPool::run(0, [](size_t) { UNREACHABLE(); }, 3);
+  td::ParallelPool::set_max_threads(0);
+}
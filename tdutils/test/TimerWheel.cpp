@@ -0,0 +1,124 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#include "td/utils/tests.h"
+
+#include "td/utils/common.h"
+#include "td/utils/Random.h"
+#include "td/utils/TimerWheel.h"
+
+#include <cmath>
+
+namespace {
+struct Timer : public td::TimerWheelNode {
+  double at = 0;
+};
+}  // namespace
+
+TEST(TimerWheel, simple) {
+  td::TimerWheel<> wheel(0);
+  std::vector<Timer> timers(3);
+  double keys[] = {0.5, 0.002, 100000.0};
+  for (size_t i = 0; i < timers.size(); i++) {
+    wheel.insert(keys[i], &timers[i]);
+  }
+  ASSERT_EQ(3u, wheel.size());
+  ASSERT_TRUE(wheel.pop_expired(0.001) == nullptr);
+  ASSERT_TRUE(wheel.pop_expired(0.002) == &timers[1]);
+  ASSERT_TRUE(wheel.pop_expired(0.1) == nullptr);
+  ASSERT_TRUE(wheel.next_expiration() <= 0.5 + 1e-9);
+
+  wheel.fix(0.05, &timers[0]);
+  ASSERT_TRUE(wheel.pop_expired(0.05) == &timers[0]);
+  ASSERT_TRUE(!timers[0].in_wheel());
+
+  ASSERT_TRUE(wheel.pop_expired(99999.0) == nullptr);
+  ASSERT_TRUE(wheel.pop_expired(100000.0) == &timers[2]);
+  ASSERT_TRUE(wheel.empty());
+  ASSERT_TRUE(wheel.pop_expired(1e9) == nullptr);
+}
+
+TEST(TimerWheel, random) {
+  td::Random::Xorshift128plus rnd(123);
+  const double resolution = 0.001;
+  const int n = 10000;
+  std::vector<Timer> timers(n);
+  td::TimerWheel<> wheel(1000, resolution);
+  double now = 1000;
+  size_t size = 0;
+  auto random_key = [&] {
+    switch (rnd.fast(0, 3)) {
+      case 0:
+        return now + rnd.fast(0, 1000) * 0.0001;
+      case 1:
+        return now + rnd.fast(0, 1000000) * 0.001;
+      case 2:
+        return now + rnd.fast(0, 1000000) * 100.0;
+      default:
+        return now - 1;
+    }
+  };
+
+  for (int step = 0; step < 200000; step++) {
+    auto &timer = timers[rnd.fast(0, n - 1)];
+    switch (rnd.fast(0, 3)) {
+      case 0:
+      case 1:
+        timer.at = random_key();
+        if (timer.in_wheel()) {
+          wheel.fix(timer.at, &timer);
+        } else {
+          wheel.insert(timer.at, &timer);
+          size++;
+        }
+        break;
+      case 2:
+        if (timer.in_wheel()) {
+          wheel.erase(&timer);
+          size--;
+        }
+        break;
+      default: {
+        now += rnd.fast(0, 1) ? rnd.fast(0, 100) * 0.0003 : rnd.fast(0, 100) * 37.0;
+        while (auto *node = wheel.pop_expired(now)) {
+          auto *fired = static_cast<Timer *>(node);
+          ASSERT_TRUE(fired->at <= now);
+          size--;
+        }
+        ASSERT_TRUE(now < wheel.next_expiration());
+        break;
+      }
+    }
+    ASSERT_EQ(size, wheel.size());
+  }
+
+  while (wheel.pop_expired(now) != nullptr) {
+    size--;
+  }
+  for (auto &timer : timers) {
+    if (timer.in_wheel()) {
+      ASSERT_TRUE(timer.at + resolution > now);
+    }
+  }
+  size_t visited = 0;
+  wheel.for_each([&](double key, td::TimerWheelNode *node) {
+    ASSERT_EQ(key, static_cast<Timer *>(node)->at);
+    visited++;
+  });
+  ASSERT_EQ(size, visited);
+}
@@ -22,6 +22,7 @@
 #include "td/utils/crypto.h"
 #include "td/utils/logging.h"
 #include "td/utils/Random.h"
+#include "td/utils/Sha256Batch.h"
 #include "td/utils/Slice.h"
 #include "td/utils/tests.h"
 #include "td/utils/UInt.h"
@@ -252,6 +253,32 @@ TEST(Crypto, sha256) {
   }
 }
 
+TEST(Crypto, sha256_batch) {
+  td::Random::Xorshift128plus rnd(123);
+  for (auto kernel :
+       {td::Sha256Batch::Kernel::Single, td::Sha256Batch::Kernel::Avx2, td::Sha256Batch::Kernel::Avx512}) {
+    if (!td::Sha256Batch::is_supported(kernel)) {
+      LOG(INFO) << "Skip unsupported kernel " << td::Sha256Batch::kernel_name(kernel);
+      continue;
+    }
+    for (auto count : {0, 1, 2, 3, 7, 8, 9, 15, 16, 17, 33, 100}) {
+      td::vector<td::string> messages(count);
+      for (auto &message : messages) {
+        // block boundaries of the padding are at 55/56 and 119/120 bytes
+        auto length = rnd.fast(0, 2) == 0 ? rnd.fast(54, 57) + 64 * rnd.fast(0, 2) : rnd.fast(0, 300);
+        message = td::rand_string(std::numeric_limits<char>::min(), std::numeric_limits<char>::max(), length);
+      }
+      td::vector<td::string> digests(count, td::string(32, '\0'));
+      td::vector<td::Slice> message_slices(messages.begin(), messages.end());
+      td::vector<td::MutableSlice> digest_slices(digests.begin(), digests.end());
+      td::Sha256Batch::hash(message_slices, digest_slices, kernel);
+      for (int i = 0; i < count; i++) {
+        ASSERT_EQ(td::sha256(messages[i]), digests[i]);
+      }
+    }
+  }
+}
+
 TEST(Crypto, md5) {
   td::vector<td::Slice> answers{
       "1B2M2Y8AsgTpgAmY7PhCfg==", "xMpCOKC5I4INzFCab3WEmw==", "vwBninYbDRkgk+uA7GMiIQ==", "dwfWrk4CfHDuoqk1wilvIQ=="};
@@ -21,6 +21,8 @@
 #include "td/utils/misc.h"
 #include "td/utils/port/FileFd.h"
 #include "td/utils/port/IoSlice.h"
+#include "td/utils/port/IoUring.h"
+#include "td/utils/port/numa.h"
 #include "td/utils/port/path.h"
 #include "td/utils/port/signals.h"
 #include "td/utils/port/thread.h"
@@ -146,6 +148,62 @@ TEST(Port, Writev) {
   ASSERT_EQ(expected_content, content);
 }
 
+TEST(Port, IoUring) {
+  auto r_ring = IoUring::create(8);
+  if (r_ring.is_error()) {
+    LOG(INFO) << "Skip io_uring test: " << r_ring.error();
+    return;
+  }
+  auto ring = r_ring.move_as_ok();
+  CSlice test_file_path = "test_io_uring.txt";
+  unlink(test_file_path).ignore();
+  auto fd = FileFd::open(test_file_path, FileFd::Read | FileFd::Write | FileFd::CreateNew).move_as_ok();
+
+  auto wait_all = [&](std::vector<IoUring::Completion> &completions) {
+    while (ring.get_in_flight() != 0) {
+      ring.submit(1).ensure();
+      IoUring::Completion completion;
+      while (ring.pop_completion(completion)) {
+        completions.push_back(completion);
+      }
+    }
+  };
+
+  std::string chunks[] = {"hello ", "io_uring ", "world"};
+  int64 offset = 0;
+  for (size_t i = 0; i < 3; i++) {
+    ring.pwrite(fd, chunks[i], offset, i);
+    offset += chunks[i].size();
+  }
+  ring.fsync(fd, 3);
+  ASSERT_EQ(4u, ring.get_in_flight());
+  ASSERT_EQ(4u, ring.get_free_slots());
+  // all queued operations are passed to the kernel at once
+  ASSERT_EQ(4u, ring.submit().move_as_ok());
+  std::vector<IoUring::Completion> completions;
+  wait_all(completions);
+  ASSERT_EQ(4u, completions.size());
+  for (auto &completion : completions) {
+    ASSERT_EQ(completion.user_data < 3 ? static_cast<int32>(chunks[completion.user_data].size()) : 0,
+              completion.result);
+  }
+  ASSERT_EQ(offset, fd.get_size().move_as_ok());
+
+  std::string content(offset + 10, '\0');
+  ring.pread(fd, content, 0, 10);
+  ring.pread(fd, MutableSlice(content).substr(0, 5), offset, 11);
+  completions.clear();
+  wait_all(completions);
+  ASSERT_EQ(2u, completions.size());
+  for (auto &completion : completions) {
+    ASSERT_EQ(completion.user_data == 10 ? offset : 0, completion.result);
+  }
+  ASSERT_EQ("hello io_uring world", Slice(content).substr(0, offset));
+
+  fd.close();
+  unlink(test_file_path).ensure();
+}
+
 #if TD_PORT_POSIX && !TD_THREAD_UNSUPPORTED
 #include <signal.h>
 #include <sys/syscall.h>
@@ -226,3 +284,21 @@ TEST(Post, SignalsAndThread) {
   }
 }
 #endif
+
+TEST(Port, CpuList) {
+  auto check = [](td::Slice list, std::vector<td::int32> expected) {
+    ASSERT_EQ(expected, parse_cpu_list(list).move_as_ok());
+  };
+  check("", {});
+  check("0\n", {0});
+  check("0-3,8,10-11", {0, 1, 2, 3, 8, 10, 11});
+  check("4-5,0-1,5", {0, 1, 4, 5});
+  ASSERT_TRUE(parse_cpu_list("3-1").is_error());
+  ASSERT_TRUE(parse_cpu_list("a").is_error());
+
+  auto nodes = get_numa_nodes();
+  ASSERT_TRUE(!nodes.empty());
+  for (auto &node : nodes) {
+    ASSERT_TRUE(!node.cpus.empty());
+  }
+}
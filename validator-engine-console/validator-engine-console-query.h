@@ -1122,6 +1122,29 @@ class GetActorStatsQuery : public Query {
   std::string file_name_;
 };
 
+class GetActorStatsJsonQuery : public Query {
+ public:
+  GetActorStatsJsonQuery(td::actor::ActorId<ValidatorEngineConsole> console, Tokenizer tokenizer)
+      : Query(console, std::move(tokenizer)) {
+  }
+  td::Status run() override;
+  td::Status send() override;
+  td::Status receive(td::BufferSlice data) override;
+  static std::string get_name() {
+    return "getactorstatsjson";
+  }
+  static std::string get_help() {
+    return "getactorstatsjson [<outfile>]\tget actor stats with latency quantiles and cpu worker counters as json "
+           "and print it either in stdout or in <outfile>";
+  }
+  std::string name() const override {
+    return get_name();
+  }
+
+ private:
+  std::string file_name_;
+};
+
 class GetPerfTimerStatsJsonQuery : public Query {
  public:
   GetPerfTimerStatsJsonQuery(td::actor::ActorId<ValidatorEngineConsole> console, Tokenizer tokenizer)
@@ -45,6 +45,7 @@
 #include "td/actor/MultiPromise.h"
 #include "td/utils/overloaded.h"
 #include "td/utils/OptionParser.h"
+#include "td/utils/ParallelPool.h"
 #include "td/utils/port/path.h"
 #include "td/utils/port/signals.h"
 #include "td/utils/port/user.h"
@@ -1468,6 +1469,10 @@ td::Status ValidatorEngine::load_global_config() {
   validator_options_.write().set_celldb_in_memory(celldb_in_memory_);
   validator_options_.write().set_max_open_archive_files(max_open_archive_files_);
   validator_options_.write().set_archive_preload_period(archive_preload_period_);
+  validator_options_.write().set_archive_compression_enabled(archive_compression_enabled_);
+  validator_options_.write().set_archive_compression_dictionary(archive_compression_dictionary_);
+  validator_options_.write().set_db_scheduler_id(db_scheduler_id_);
+  validator_options_.write().set_async_file_io_enabled(async_file_io_enabled_);
   validator_options_.write().set_disable_rocksdb_stats(disable_rocksdb_stats_);
   validator_options_.write().set_nonfinal_ls_queries_enabled(nonfinal_ls_queries_enabled_);
   if (celldb_cache_size_) {
@@ -1478,6 +1483,7 @@ td::Status ValidatorEngine::load_global_config() {
   }
   validator_options_.write().set_celldb_direct_io(celldb_direct_io_);
   validator_options_.write().set_celldb_preload_all(celldb_preload_all_);
+  validator_options_.write().set_celldb_compact_cells(celldb_compact_cells_);
   if (catchain_max_block_delay_) {
     validator_options_.write().set_catchain_max_block_delay(catchain_max_block_delay_.value());
   }
@@ -1504,6 +1510,7 @@ td::Status ValidatorEngine::load_global_config() {
   }
   validator_options_.write().set_hardforks(std::move(h));
   validator_options_.write().set_fast_state_serializer_enabled(fast_state_serializer_enabled_);
+  validator_options_.write().set_tx_index_enabled(tx_index_enabled_);
 
   return td::Status::OK();
 }
@@ -3700,6 +3707,30 @@ void ValidatorEngine::run_control_query(ton::ton_api::engine_validator_getActorT
                           std::move(P));
 }
 
+void ValidatorEngine::run_control_query(ton::ton_api::engine_validator_getActorStatsJson &query, td::BufferSlice data,
+                                        ton::PublicKeyHash src, td::uint32 perm, td::Promise<td::BufferSlice> promise) {
+  if (!(perm & ValidatorEnginePermissions::vep_default)) {
+    promise.set_value(create_control_query_error(td::Status::Error(ton::ErrorCode::error, "not authorized")));
+    return;
+  }
+
+  if (validator_manager_.empty()) {
+    promise.set_value(
+        create_control_query_error(td::Status::Error(ton::ErrorCode::notready, "validator manager not started")));
+    return;
+  }
+
+  auto P = td::PromiseCreator::lambda([promise = std::move(promise)](td::Result<std::string> R) mutable {
+    if (R.is_error()) {
+      promise.set_value(create_control_query_error(R.move_as_error()));
+    } else {
+      promise.set_value(ton::create_serialize_tl_object<ton::ton_api::engine_validator_textStats>(R.move_as_ok()));
+    }
+  });
+  td::actor::send_closure(validator_manager_, &ton::validator::ValidatorManagerInterface::prepare_actor_stats_json,
+                          std::move(P));
+}
+
 void ValidatorEngine::run_control_query(ton::ton_api::engine_validator_getPerfTimerStats &query, td::BufferSlice data,
                                         ton::PublicKeyHash src, td::uint32 perm, td::Promise<td::BufferSlice> promise) {
   if (!(perm & ValidatorEnginePermissions::vep_default)) {
@@ -4451,6 +4482,18 @@ int main(int argc, char *argv[]) {
         threads = v;
         return td::Status::OK();
       });
+  bool numa = false;
+  p.add_option('\0', "numa",
+               "run one scheduler per NUMA node with threads pinned to its cpus, the database gets the last node",
+               [&]() { numa = true; });
+  p.add_checked_option('\0', "parallel-threads",
+                       "number of worker threads shared by parallel dictionary scans of the validator and by "
+                       "in-memory celldb loading (default: number of cpus - 1)",
+                       [&](td::Slice arg) {
+                         TRY_RESULT(value, td::to_integer_safe<td::uint32>(arg));
+                         td::ParallelPool::set_max_threads(value);
+                         return td::Status::OK();
+                       });
   p.add_checked_option('u', "user", "change user", [&](td::Slice user) { return td::change_user(user.str()); });
   p.add_checked_option('\0', "shutdown-at", "stop validator at the given time (unix timestamp)", [&](td::Slice arg) {
     TRY_RESULT(at, td::to_integer_safe<td::uint32>(arg));
@@ -4484,6 +4527,32 @@ int main(int argc, char *argv[]) {
         acts.push_back([&x, v]() { td::actor::send_closure(x, &ValidatorEngine::set_archive_preload_period, v); });
         return td::Status::OK();
       });
+  p.add_option('\0', "archive-compression",
+               "store entries of new archive packages compressed with lz4 (existing packages are not converted)",
+               [&]() {
+                 acts.push_back(
+                     [&x]() { td::actor::send_closure(x, &ValidatorEngine::set_archive_compression_enabled, true); });
+               });
+  p.add_option('\0', "async-file-io",
+               "write archive packages and persistent states and read archive slices through io_uring (Linux only, "
+               "falls back to blocking I/O if unavailable)",
+               [&]() {
+                 acts.push_back(
+                     [&x]() { td::actor::send_closure(x, &ValidatorEngine::set_async_file_io_enabled, true); });
+               });
+  p.add_checked_option(
+      '\0', "archive-compression-dict",
+      "lz4 dictionary (up to 64KB, e.g. trained on block files) for new compressed archive packages",
+      [&](td::Slice s) -> td::Status {
+        TRY_RESULT(data, td::read_file_str(s.str()));
+        if (data.size() > (1 << 16)) {
+          return td::Status::Error("archive compression dictionary is too big");
+        }
+        acts.push_back([&x, data = std::move(data)]() {
+          td::actor::send_closure(x, &ValidatorEngine::set_archive_compression_dictionary, data);
+        });
+        return td::Status::OK();
+      });
   p.add_option('\0', "enable-precompiled-smc",
                "enable exectuion of precompiled contracts (experimental, disabled by default)",
                []() { block::precompiled::set_precompiled_execution_enabled(true); });
@@ -4513,6 +4582,12 @@ int main(int argc, char *argv[]) {
                [&]() {
                  acts.push_back([&x]() { td::actor::send_closure(x, &ValidatorEngine::set_celldb_preload_all, true); });
                });
+  p.add_option(
+      '\0', "celldb-compact-cells",
+      "store cells in CellDb in the compact format (small children inlined); existing cells are rewritten when loaded",
+      [&]() {
+        acts.push_back([&x]() { td::actor::send_closure(x, &ValidatorEngine::set_celldb_compact_cells, true); });
+      });
 
   p.add_option(
       '\0', "celldb-in-memory",
@@ -4547,6 +4622,12 @@ int main(int argc, char *argv[]) {
         acts.push_back(
             [&x]() { td::actor::send_closure(x, &ValidatorEngine::set_fast_state_serializer_enabled, true); });
       });
+  p.add_option('\0', "tx-index",
+               "maintain an index of account transactions of applied blocks, speeds up getTransactions liteserver "
+               "queries (only blocks applied after enabling are indexed)",
+               [&]() {
+                 acts.push_back([&x]() { td::actor::send_closure(x, &ValidatorEngine::set_tx_index_enabled, true); });
+               });
   p.add_option(
       '\0', "collect-validator-telemetry",
       "store validator telemetry from private block overlay to a given file (json format)",
@@ -4566,7 +4647,17 @@ int main(int argc, char *argv[]) {
   td::set_runtime_signal_handler(2, need_scheduler_status).ensure();
 
   td::actor::set_debug(true);
-  td::actor::Scheduler scheduler({threads});
+  std::vector<td::actor::Scheduler::NodeInfo> scheduler_nodes{td::actor::Scheduler::NodeInfo(threads)};
+  if (numa) {
+    scheduler_nodes = td::actor::Scheduler::numa_node_infos(threads);
+    LOG(INFO) << "Using " << scheduler_nodes.size() << " NUMA-local schedulers";
+    if (scheduler_nodes.size() > 1) {
+      acts.push_back([&x, id = static_cast<td::uint8>(scheduler_nodes.size() - 1)]() {
+        td::actor::send_closure(x, &ValidatorEngine::set_db_scheduler_id, td::actor::SchedulerId{id});
+      });
+    }
+  }
+  td::actor::Scheduler scheduler(std::move(scheduler_nodes));
 
   scheduler.run_in_context([&] {
     vm::init_vm().ensure();
@@ -212,11 +212,16 @@ class ValidatorEngine : public td::actor::Actor {
   td::uint32 celldb_compress_depth_ = 0;
   size_t max_open_archive_files_ = 0;
   double archive_preload_period_ = 0.0;
+  bool archive_compression_enabled_ = false;
+  std::string archive_compression_dictionary_;
+  td::actor::SchedulerId db_scheduler_id_;
+  bool async_file_io_enabled_ = false;
   bool disable_rocksdb_stats_ = false;
   bool nonfinal_ls_queries_enabled_ = false;
   td::optional<td::uint64> celldb_cache_size_ = 1LL << 30;
   bool celldb_direct_io_ = false;
   bool celldb_preload_all_ = false;
+  bool celldb_compact_cells_ = false;
   bool celldb_in_memory_ = false;
   td::optional<double> catchain_max_block_delay_, catchain_max_block_delay_slow_;
   bool read_config_ = false;
@@ -225,6 +230,7 @@ class ValidatorEngine : public td::actor::Actor {
   ton::BlockSeqno truncate_seqno_{0};
   std::string session_logs_file_;
   bool fast_state_serializer_enabled_ = false;
+  bool tx_index_enabled_ = false;
   std::string validator_telemetry_filename_;
   bool not_all_shards_ = false;
   std::vector<ton::ShardIdFull> add_shard_cmds_;
@@ -289,6 +295,18 @@ class ValidatorEngine : public td::actor::Actor {
   void set_archive_preload_period(double value) {
     archive_preload_period_ = value;
   }
+  void set_archive_compression_enabled(bool value) {
+    archive_compression_enabled_ = value;
+  }
+  void set_archive_compression_dictionary(std::string value) {
+    archive_compression_dictionary_ = std::move(value);
+  }
+  void set_db_scheduler_id(td::actor::SchedulerId value) {
+    db_scheduler_id_ = value;
+  }
+  void set_async_file_io_enabled(bool value) {
+    async_file_io_enabled_ = value;
+  }
   void set_disable_rocksdb_stats(bool value) {
     disable_rocksdb_stats_ = value;
   }
@@ -304,6 +322,9 @@ class ValidatorEngine : public td::actor::Actor {
   void set_celldb_preload_all(bool value) {
     celldb_preload_all_ = value;
   }
+  void set_celldb_compact_cells(bool value) {
+    celldb_compact_cells_ = value;
+  }
   void set_celldb_in_memory(bool value) {
     celldb_in_memory_ = value;
   }
@@ -316,6 +337,9 @@ class ValidatorEngine : public td::actor::Actor {
   void set_fast_state_serializer_enabled(bool value) {
     fast_state_serializer_enabled_ = value;
   }
+  void set_tx_index_enabled(bool value) {
+    tx_index_enabled_ = value;
+  }
   void set_validator_telemetry_filename(std::string value) {
     validator_telemetry_filename_ = std::move(value);
   }
@@ -499,6 +523,8 @@ class ValidatorEngine : public td::actor::Actor {
                          ton::PublicKeyHash src, td::uint32 perm, td::Promise<td::BufferSlice> promise);
   void run_control_query(ton::ton_api::engine_validator_getActorTextStats &query, td::BufferSlice data,
                          ton::PublicKeyHash src, td::uint32 perm, td::Promise<td::BufferSlice> promise);
+  void run_control_query(ton::ton_api::engine_validator_getActorStatsJson &query, td::BufferSlice data,
+                         ton::PublicKeyHash src, td::uint32 perm, td::Promise<td::BufferSlice> promise);
   void run_control_query(ton::ton_api::engine_validator_addShard &query, td::BufferSlice data,
                          ton::PublicKeyHash src, td::uint32 perm, td::Promise<td::BufferSlice> promise);
   void run_control_query(ton::ton_api::engine_validator_delShard &query, td::BufferSlice data,
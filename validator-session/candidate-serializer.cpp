@@ -17,25 +17,51 @@
 #include "candidate-serializer.h"
 #include "tl-utils/tl-utils.hpp"
 #include "vm/boc.h"
+#include "vm/cells/CellBuilder.h"
+#include "vm/db/DynamicBagOfCellsDb.h"
 #include "td/utils/lz4.h"
+#include "td/utils/tl_parsers.h"
 #include "validator-session-types.h"
 
+#include <map>
+#include <set>
+
 namespace ton::validatorsession {
 
+namespace {
+
+// validatorSession.compressedCandidate flag: data is candidateDataWithStateRefs
+constexpr td::int32 COMPRESSED_WITH_STATE_REFS = 1;
+// Max number of cells in a subtree referenced by one hash, the receiver loads at most this many cells from celldb
+constexpr td::uint64 MAX_STATE_REF_CELLS = 1 << 12;
+
+}  // namespace
+
 td::Result<td::BufferSlice> serialize_candidate(const tl_object_ptr<ton_api::validatorSession_candidate>& block,
-                                                bool compression_enabled) {
+                                                bool compression_enabled, bool use_state_refs) {
   if (!compression_enabled) {
     return serialize_tl_object(block, true);
   }
   size_t decompressed_size;
+  if (use_state_refs) {
+    bool has_state_refs = false;
+    auto R = compress_candidate_data_with_state_refs(block->data_, block->collated_data_, decompressed_size,
+                                                     has_state_refs);
+    if (R.is_error()) {
+      LOG(DEBUG) << "Cannot compress block candidate with state refs: " << R.move_as_error();
+    } else if (has_state_refs) {
+      return create_serialize_tl_object<ton_api::validatorSession_compressedCandidate>(
+          COMPRESSED_WITH_STATE_REFS, block->src_, block->round_, block->root_hash_, (int)decompressed_size,
+          R.move_as_ok());
+    }
+  }
   TRY_RESULT(compressed, compress_candidate_data(block->data_, block->collated_data_, decompressed_size))
   return create_serialize_tl_object<ton_api::validatorSession_compressedCandidate>(
       0, block->src_, block->round_, block->root_hash_, (int)decompressed_size, std::move(compressed));
 }
 
-td::Result<tl_object_ptr<ton_api::validatorSession_candidate>> deserialize_candidate(td::Slice data,
-                                                                                     bool compression_enabled,
-                                                                                     int max_decompressed_data_size) {
+td::Result<tl_object_ptr<ton_api::validatorSession_candidate>> deserialize_candidate(
+    td::Slice data, bool compression_enabled, int max_decompressed_data_size, vm::CellDbReader* state_cell_reader) {
   if (!compression_enabled) {
     return fetch_tl_object<ton_api::validatorSession_candidate>(data, true);
   }
@@ -43,11 +69,33 @@ td::Result<tl_object_ptr<ton_api::validatorSession_candidate>> deserialize_candi
   if (f->decompressed_size_ > max_decompressed_data_size) {
     return td::Status::Error("decompressed size is too big");
   }
-  TRY_RESULT(p, decompress_candidate_data(f->data_, f->decompressed_size_));
+  std::pair<td::BufferSlice, td::BufferSlice> p;
+  if (f->flags_ & COMPRESSED_WITH_STATE_REFS) {
+    if (!state_cell_reader) {
+      return td::Status::Error("cannot restore state cells: no cell db");
+    }
+    TRY_RESULT_ASSIGN(p, decompress_candidate_data_with_state_refs(f->data_, f->decompressed_size_,
+                                                                   *state_cell_reader));
+    if (p.first.size() + p.second.size() > (size_t)max_decompressed_data_size) {
+      return td::Status::Error("decompressed size is too big");
+    }
+  } else {
+    TRY_RESULT_ASSIGN(p, decompress_candidate_data(f->data_, f->decompressed_size_));
+  }
   return create_tl_object<ton_api::validatorSession_candidate>(f->src_, f->round_, f->root_hash_, std::move(p.first),
                                                                std::move(p.second));
 }
 
+bool candidate_has_state_refs(td::Slice data) {
+  // flags is the first field of compressedCandidate, the rest is not parsed
+  td::TlParser parser{data};
+  if (parser.fetch_int() != ton_api::validatorSession_compressedCandidate::ID) {
+    return false;
+  }
+  td::int32 flags = parser.fetch_int();
+  return parser.get_error() == nullptr && (flags & COMPRESSED_WITH_STATE_REFS);
+}
+
 td::Result<td::BufferSlice> compress_candidate_data(td::Slice block, td::Slice collated_data,
                                                     size_t& decompressed_size) {
   vm::BagOfCells boc1, boc2;
@@ -85,4 +133,215 @@ td::Result<std::pair<td::BufferSlice, td::BufferSlice>> decompress_candidate_dat
   return std::make_pair(std::move(block_data), std::move(collated_data));
 }
 
+namespace {
+
+// Root hash of the state the block was built on: the "from" side of its state update
+td::Result<vm::Cell::Hash> get_prev_state_hash(const td::Ref<vm::Cell>& block_root) {
+  TRY_RESULT(block, block_root->load_cell());
+  if (block.data_cell->size_refs() < 3) {
+    return td::Status::Error("invalid block");
+  }
+  TRY_RESULT(update, block.data_cell->get_ref(2)->load_cell());
+  if (update.data_cell->special_type() != vm::Cell::SpecialType::MerkleUpdate) {
+    return td::Status::Error("invalid block state update");
+  }
+  return update.data_cell->get_ref(0)->get_hash(0);
+}
+
+bool is_state_proof(const td::Ref<vm::Cell>& root, const vm::Cell::Hash& state_hash) {
+  auto R = root->load_cell();
+  if (R.is_error()) {
+    return false;
+  }
+  auto& cell = R.ok_ref().data_cell;
+  return cell->special_type() == vm::Cell::SpecialType::MerkleProof && cell->get_ref(0)->get_hash(0) == state_hash;
+}
+
+td::Result<td::Ref<vm::Cell>> rebuild_cell(const td::Ref<vm::DataCell>& cell, std::vector<td::Ref<vm::Cell>> refs) {
+  vm::CellBuilder cb;
+  cb.store_bits(cell->get_data(), cell->get_bits());
+  for (auto& ref : refs) {
+    cb.store_ref(std::move(ref));
+  }
+  TRY_RESULT(result, cb.finalize_novm_nothrow(cell->is_special()));
+  return result;
+}
+
+template <class F>
+td::Result<td::Ref<vm::Cell>> rebuild_proof(const td::Ref<vm::Cell>& proof, F&& f) {
+  TRY_RESULT(loaded, proof->load_cell());
+  TRY_RESULT(child, f(loaded.data_cell->get_ref(0)));
+  return rebuild_cell(loaded.data_cell, {std::move(child)});
+}
+
+// Replaces complete (level 0) subtrees of a state proof with pruned branches
+class StateRefsCompressor {
+ public:
+  std::vector<td::Bits256> state_cells;
+
+  void add_existing_pruned_branches(const td::Ref<vm::Cell>& root) {
+    if (!existing_visited_.insert(root->get_hash()).second) {
+      return;
+    }
+    auto cell = root->load_cell().move_as_ok().data_cell;
+    if (cell->special_type() == vm::Cell::SpecialType::PrunnedBranch) {
+      existing_pruned_.insert(cell->get_hash(0));
+    }
+    for (unsigned i = 0; i < cell->size_refs(); ++i) {
+      add_existing_pruned_branches(cell->get_ref(i));
+    }
+  }
+
+  td::Result<td::Ref<vm::Cell>> replace(const td::Ref<vm::Cell>& root) {
+    auto hash = root->get_hash();
+    auto it = visited_.find(hash);
+    if (it != visited_.end()) {
+      return it->second;
+    }
+    TRY_RESULT(loaded, root->load_cell());
+    auto& cell = loaded.data_cell;
+    td::Ref<vm::Cell> result = root;
+    // A pruned branch identical to an existing one would be indistinguishable from it
+    if (cell->get_level() == 0 && worth_replacing(cell) && !existing_pruned_.count(hash) &&
+        vm::VmStorageStat{MAX_STATE_REF_CELLS}.add_storage(root)) {
+      result = vm::CellBuilder::create_pruned_branch(root, 1);
+      state_cells.push_back(td::Bits256{hash.bits()});
+    } else if (!cell->is_special()) {
+      std::vector<td::Ref<vm::Cell>> refs;
+      for (unsigned i = 0; i < cell->size_refs(); ++i) {
+        TRY_RESULT(ref, replace(cell->get_ref(i)));
+        refs.push_back(std::move(ref));
+      }
+      TRY_RESULT_ASSIGN(result, rebuild_cell(cell, std::move(refs)));
+    }
+    visited_.emplace(hash, result);
+    return result;
+  }
+
+ private:
+  std::set<vm::Cell::Hash> existing_visited_;
+  std::set<vm::Cell::Hash> existing_pruned_;
+  std::map<vm::Cell::Hash, td::Ref<vm::Cell>> visited_;
+
+  static bool worth_replacing(const td::Ref<vm::DataCell>& cell) {
+    // Pruned branch and hash in the list take ~70 bytes
+    return cell->size_refs() > 0 || cell->get_bits() > 64 * 8;
+  }
+};
+
+// Reverse of StateRefsCompressor
+class StateRefsDecompressor {
+ public:
+  StateRefsDecompressor(vm::CellDbReader& reader, const std::vector<td::Bits256>& state_cells) : reader_(reader) {
+    for (const auto& hash : state_cells) {
+      state_cells_.insert(vm::Cell::Hash::from_slice(hash.as_slice()));
+    }
+  }
+
+  td::Result<td::Ref<vm::Cell>> restore(const td::Ref<vm::Cell>& root) {
+    if (root->get_level() == 0) {
+      return root;
+    }
+    auto hash = root->get_hash();
+    auto it = visited_.find(hash);
+    if (it != visited_.end()) {
+      return it->second;
+    }
+    TRY_RESULT(loaded, root->load_cell());
+    auto& cell = loaded.data_cell;
+    td::Ref<vm::Cell> result = root;
+    if (cell->special_type() == vm::Cell::SpecialType::PrunnedBranch) {
+      auto state_hash = cell->get_hash(0);
+      if (cell->get_level_mask().get_mask() == 1 && state_cells_.count(state_hash)) {
+        TRY_RESULT_PREFIX_ASSIGN(result, reader_.load_cell(state_hash.as_slice()), "failed to load state cell: ");
+        // The sender never refers to bigger subtrees, stop loading cells as soon as the limit is reached
+        if (!vm::VmStorageStat{MAX_STATE_REF_CELLS}.add_storage(result)) {
+          return td::Status::Error("too many cells in a state cell subtree");
+        }
+      }
+    } else if (!cell->is_special()) {
+      std::vector<td::Ref<vm::Cell>> refs;
+      for (unsigned i = 0; i < cell->size_refs(); ++i) {
+        TRY_RESULT(ref, restore(cell->get_ref(i)));
+        refs.push_back(std::move(ref));
+      }
+      TRY_RESULT_ASSIGN(result, rebuild_cell(cell, std::move(refs)));
+    }
+    visited_.emplace(hash, result);
+    return result;
+  }
+
+ private:
+  vm::CellDbReader& reader_;
+  std::set<vm::Cell::Hash> state_cells_;
+  std::map<vm::Cell::Hash, td::Ref<vm::Cell>> visited_;
+};
+
+}  // namespace
+
+td::Result<td::BufferSlice> compress_candidate_data_with_state_refs(td::Slice block, td::Slice collated_data,
+                                                                    size_t& decompressed_size, bool& has_state_refs) {
+  TRY_RESULT(block_root, vm::std_boc_deserialize(block));
+  TRY_RESULT(roots, vm::std_boc_deserialize_multi(collated_data));
+  TRY_RESULT(prev_state_hash, get_prev_state_hash(block_root));
+
+  StateRefsCompressor compressor;
+  compressor.add_existing_pruned_branches(block_root);
+  for (auto& root : roots) {
+    compressor.add_existing_pruned_branches(root);
+  }
+  for (auto& root : roots) {
+    if (is_state_proof(root, prev_state_hash)) {
+      TRY_RESULT_ASSIGN(root, rebuild_proof(root, [&](const td::Ref<vm::Cell>& cell) {
+                          return compressor.replace(cell);
+                        }));
+    }
+  }
+  has_state_refs = !compressor.state_cells.empty();
+  roots.insert(roots.begin(), std::move(block_root));
+  TRY_RESULT(data, vm::std_boc_serialize_multi(std::move(roots), 2));
+  auto obj = create_tl_object<ton_api::validatorSession_candidateDataWithStateRefs>(
+      std::move(data), std::move(compressor.state_cells));
+  auto serialized = serialize_tl_object(obj, true);
+  decompressed_size = serialized.size();
+  td::BufferSlice compressed = td::lz4_compress(serialized);
+  LOG(DEBUG) << "Compressing block candidate with state refs: " << block.size() + collated_data.size() << " -> "
+             << compressed.size() << " (" << obj->state_cells_.size() << " state cells)";
+  return compressed;
+}
+
+td::Result<std::pair<td::BufferSlice, td::BufferSlice>> decompress_candidate_data_with_state_refs(
+    td::Slice compressed, int decompressed_size, vm::CellDbReader& state_cell_reader) {
+  TRY_RESULT(decompressed, td::lz4_decompress(compressed, decompressed_size));
+  if (decompressed.size() != (size_t)decompressed_size) {
+    return td::Status::Error("decompressed size mismatch");
+  }
+  TRY_RESULT(f, fetch_tl_object<ton_api::validatorSession_candidateDataWithStateRefs>(decompressed, true));
+  TRY_RESULT(roots, vm::std_boc_deserialize_multi(f->data_));
+  if (roots.empty()) {
+    return td::Status::Error("boc is empty");
+  }
+  TRY_RESULT(prev_state_hash, get_prev_state_hash(roots[0]));
+
+  StateRefsDecompressor decompressor{state_cell_reader, f->state_cells_};
+  // Each restored subtree has at most MAX_STATE_REF_CELLS cells, bound the total before serializing them
+  vm::VmStorageStat stat{(td::uint64)decompressed_size + (td::uint64)f->state_cells_.size() * MAX_STATE_REF_CELLS};
+  for (size_t i = 1; i < roots.size(); ++i) {
+    if (is_state_proof(roots[i], prev_state_hash)) {
+      TRY_RESULT_ASSIGN(roots[i], rebuild_proof(roots[i], [&](const td::Ref<vm::Cell>& cell) {
+                          return decompressor.restore(cell);
+                        }));
+    }
+    if (!stat.add_storage(roots[i])) {
+      return td::Status::Error("too many cells in collated data");
+    }
+  }
+  TRY_RESULT(block_data, vm::std_boc_serialize(roots[0], 31));
+  roots.erase(roots.begin());
+  TRY_RESULT(collated_data, vm::std_boc_serialize_multi(std::move(roots), 31));
+  LOG(DEBUG) << "Decompressing block candidate with state refs: " << compressed.size() << " -> "
+             << block_data.size() + collated_data.size();
+  return std::make_pair(std::move(block_data), std::move(collated_data));
+}
+
 }  // namespace ton::validatorsession
@@ -18,17 +18,29 @@
 #include "ton/ton-types.h"
 #include "auto/tl/ton_api.h"
 
+namespace vm {
+class CellDbReader;
+}  // namespace vm
+
 namespace ton::validatorsession {
 
 td::Result<td::BufferSlice> serialize_candidate(const tl_object_ptr<ton_api::validatorSession_candidate>& block,
-                                                bool compression_enabled);
-td::Result<tl_object_ptr<ton_api::validatorSession_candidate>> deserialize_candidate(td::Slice data,
-                                                                                     bool compression_enabled,
-                                                                                     int max_decompressed_data_size);
+                                                bool compression_enabled, bool use_state_refs = false);
+td::Result<tl_object_ptr<ton_api::validatorSession_candidate>> deserialize_candidate(
+    td::Slice data, bool compression_enabled, int max_decompressed_data_size,
+    vm::CellDbReader* state_cell_reader = nullptr);
+bool candidate_has_state_refs(td::Slice data);
 
 td::Result<td::BufferSlice> compress_candidate_data(td::Slice block, td::Slice collated_data,
                                                     size_t& decompressed_size);
 td::Result<std::pair<td::BufferSlice, td::BufferSlice>> decompress_candidate_data(td::Slice compressed,
                                                                                   int decompressed_size);
 
+// Cells of collated data that belong to the previous state of the shard are replaced with references by hash.
+// The receiver restores them from its own celldb, see candidateDataWithStateRefs.
+td::Result<td::BufferSlice> compress_candidate_data_with_state_refs(td::Slice block, td::Slice collated_data,
+                                                                    size_t& decompressed_size, bool& has_state_refs);
+td::Result<std::pair<td::BufferSlice, td::BufferSlice>> decompress_candidate_data_with_state_refs(
+    td::Slice compressed, int decompressed_size, vm::CellDbReader& state_cell_reader);
+
 }  // namespace ton::validatorsession
@@ -0,0 +1,115 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "td/utils/tests.h"
+
+#include "vm/boc.h"
+#include "vm/cells/CellBuilder.h"
+#include "vm/cells/MerkleProof.h"
+#include "vm/db/DynamicBagOfCellsDb.h"
+
+#include "validator-session/candidate-serializer.h"
+
+#include <map>
+
+namespace {
+
+class TestCellDbReader : public vm::CellDbReader {
+ public:
+  void add(const td::Ref<vm::Cell>& root) {
+    auto cell = root->load_cell().move_as_ok().data_cell;
+    if (!cells_.emplace(cell->get_hash(), cell).second) {
+      return;
+    }
+    for (unsigned i = 0; i < cell->size_refs(); i++) {
+      add(cell->get_ref(i));
+    }
+  }
+
+  td::Result<td::Ref<vm::DataCell>> load_cell(td::Slice hash) override {
+    auto it = cells_.find(vm::Cell::Hash::from_slice(hash));
+    if (it == cells_.end()) {
+      return td::Status::Error("cell not found");
+    }
+    return it->second;
+  }
+
+ private:
+  std::map<vm::Cell::Hash, td::Ref<vm::DataCell>> cells_;
+};
+
+td::Ref<vm::Cell> node(std::vector<td::Ref<vm::Cell>> refs, td::uint32 x, unsigned bits = 32) {
+  vm::CellBuilder cb;
+  cb.store_long(x, 32);
+  cb.store_zeroes(bits - 32);
+  for (auto& ref : refs) {
+    cb.store_ref(std::move(ref));
+  }
+  return cb.finalize();
+}
+
+td::Ref<vm::Cell> tree(int depth, td::uint32& x) {
+  if (depth == 0) {
+    return node({}, x++);
+  }
+  auto left = tree(depth - 1, x);
+  auto right = tree(depth - 1, x);
+  return node({std::move(left), std::move(right)}, x++);
+}
+
+}  // namespace
+
+TEST(CandidateSerializer, StateRefs) {
+  using namespace ton::validatorsession;
+
+  // previous state: the proof in collated data keeps the first three subtrees and prunes the last one,
+  // the second subtree is too big to be referenced by one hash
+  auto small = node({node({}, 1), node({}, 2, 1000)}, 3);
+  td::uint32 x = 100;
+  auto big = tree(13, x);
+  auto state = node({small, big, node({}, 4, 800), node({node({}, 5)}, 6)}, 7);
+  auto pruned = state->load_cell().move_as_ok().data_cell->get_ref(3)->get_hash();
+  auto state_proof = vm::MerkleProof::generate(state, [&](const td::Ref<vm::Cell>& cell) {
+    return cell->get_hash() == pruned;
+  });
+  ASSERT_TRUE(state_proof.not_null());
+  auto new_state = node({small, big}, 8);
+  auto update = vm::CellBuilder::create_merkle_update(vm::CellBuilder::create_pruned_branch(state, 1),
+                                                      vm::CellBuilder::create_pruned_branch(new_state, 1));
+  auto block_root = node({node({}, 9), node({}, 10), update}, 11);
+
+  auto block = vm::std_boc_serialize(block_root, 31).move_as_ok();
+  auto collated_data = vm::std_boc_serialize_multi({state_proof, node({small}, 12)}, 31).move_as_ok();
+  auto candidate = ton::create_tl_object<ton::ton_api::validatorSession_candidate>(
+      td::Bits256::zero(), 1, td::Bits256::zero(), block.clone(), collated_data.clone());
+
+  auto serialized = serialize_candidate(candidate, true, true).move_as_ok();
+  ASSERT_TRUE(candidate_has_state_refs(serialized));
+  ASSERT_TRUE(serialized.size() < 1000);
+  ASSERT_TRUE(!candidate_has_state_refs(serialize_candidate(candidate, true, false).move_as_ok()));
+  ASSERT_TRUE(!candidate_has_state_refs(serialize_candidate(candidate, false, true).move_as_ok()));
+
+  int max_size = 1 << 20;
+  ASSERT_TRUE(deserialize_candidate(serialized, true, max_size).is_error());
+  TestCellDbReader reader;
+  ASSERT_TRUE(deserialize_candidate(serialized, true, max_size, &reader).is_error());
+
+  reader.add(state);
+  auto restored = deserialize_candidate(serialized, true, max_size, &reader).move_as_ok();
+  ASSERT_EQ(block.as_slice(), restored->data_.as_slice());
+  ASSERT_EQ(collated_data.as_slice(), restored->collated_data_.as_slice());
+  ASSERT_EQ(1, restored->round_);
+}
@@ -220,17 +220,77 @@ bool ValidatorSessionImpl::ensure_candidate_unique(td::uint32 src_idx, td::uint3
   return true;
 }
 
+namespace {
+
+// Restoring state cells loads them from celldb and serializes the block and collated data again,
+// so it is done by a separate actor instead of the session itself
+class StateRefsCandidateDeserializer : public td::actor::Actor {
+ public:
+  StateRefsCandidateDeserializer(td::BufferSlice data, int max_decompressed_data_size,
+                                 std::shared_ptr<vm::CellDbReader> state_cell_reader,
+                                 td::Promise<tl_object_ptr<ton_api::validatorSession_candidate>> promise)
+      : data_(std::move(data))
+      , max_decompressed_data_size_(max_decompressed_data_size)
+      , state_cell_reader_(std::move(state_cell_reader))
+      , promise_(std::move(promise)) {
+  }
+
+  void start_up() override {
+    promise_.set_result(deserialize_candidate(data_, true, max_decompressed_data_size_, state_cell_reader_.get()));
+    stop();
+  }
+
+ private:
+  td::BufferSlice data_;
+  int max_decompressed_data_size_;
+  std::shared_ptr<vm::CellDbReader> state_cell_reader_;
+  td::Promise<tl_object_ptr<ton_api::validatorSession_candidate>> promise_;
+};
+
+}  // namespace
+
 void ValidatorSessionImpl::process_broadcast(PublicKeyHash src, td::BufferSlice data,
                                              td::optional<ValidatorSessionCandidateId> expected_id,
                                              bool is_overlay_broadcast) {
+  int max_decompressed_data_size =
+      description().opts().max_block_size + description().opts().max_collated_data_size + 1024;
+  td::Timer deserialize_timer;
+  if (compress_block_candidates_ && candidate_has_state_refs(data)) {
+    auto P = td::PromiseCreator::lambda([SelfId = actor_id(this), src, data = std::move(data),
+                                         expected_id = std::move(expected_id), is_overlay_broadcast,
+                                         max_decompressed_data_size, deserialize_timer](
+                                            td::Result<std::shared_ptr<vm::CellDbReader>> R) mutable {
+      if (R.is_error()) {
+        LOG(WARNING) << "failed to get cell db reader: " << R.move_as_error();
+        return;
+      }
+      auto data_ref = data.clone();
+      td::actor::create_actor<StateRefsCandidateDeserializer>(
+          "deserializecandidate", std::move(data_ref), max_decompressed_data_size, R.move_as_ok(),
+          [SelfId, src, data = std::move(data), expected_id = std::move(expected_id), is_overlay_broadcast,
+           deserialize_timer](td::Result<tl_object_ptr<ton_api::validatorSession_candidate>> res) mutable {
+            td::actor::send_closure(SelfId, &ValidatorSessionImpl::process_broadcast_cont, src, std::move(data),
+                                    std::move(expected_id), is_overlay_broadcast, std::move(res),
+                                    deserialize_timer.elapsed());
+          })
+          .release();
+    });
+    callback_->get_cell_db_reader(std::move(P));
+    return;
+  }
+  auto R = deserialize_candidate(data, compress_block_candidates_, max_decompressed_data_size);
+  process_broadcast_cont(src, std::move(data), std::move(expected_id), is_overlay_broadcast, std::move(R),
+                         deserialize_timer.elapsed());
+}
+
+void ValidatorSessionImpl::process_broadcast_cont(PublicKeyHash src, td::BufferSlice data,
+                                                  td::optional<ValidatorSessionCandidateId> expected_id,
+                                                  bool is_overlay_broadcast,
+                                                  td::Result<tl_object_ptr<ton_api::validatorSession_candidate>> R,
+                                                  double deserialize_time) {
   // Note: src is not necessarily equal to the sender of this message:
   // If requested using get_broadcast_p2p, src is the creator of the block, sender possibly is some other node.
   auto src_idx = description().get_source_idx(src);
-  td::Timer deserialize_timer;
-  auto R =
-      deserialize_candidate(data, compress_block_candidates_,
-                            description().opts().max_block_size + description().opts().max_collated_data_size + 1024);
-  double deserialize_time = deserialize_timer.elapsed();
   if (R.is_error()) {
     VLOG(VALIDATOR_SESSION_WARNING) << this << "[node " << src << "][broadcast " << sha256_bits256(data.as_slice())
                                     << "]: failed to parse: " << R.move_as_error();
@@ -480,7 +540,9 @@ void ValidatorSessionImpl::generated_block(td::uint32 round, ValidatorSessionCan
   td::Timer serialize_timer;
   auto b = create_tl_object<ton_api::validatorSession_candidate>(local_id().tl(), round, root_hash, std::move(data),
                                                                  std::move(collated_data));
-  auto B = serialize_candidate(b, compress_block_candidates_).move_as_ok();
+  // Only the broadcast refers to state cells: candidates requested by peers are sent in full, so a node that
+  // cannot restore the broadcast from its celldb can still download the candidate
+  auto B = serialize_candidate(b, compress_block_candidates_, candidates_with_state_refs_).move_as_ok();
   if (stat) {
     stat->serialize_time = serialize_timer.elapsed();
     stat->serialized_size = B.size();
@@ -995,6 +1057,7 @@ ValidatorSessionImpl::ValidatorSessionImpl(catchain::CatChainSessionId session_i
     , overlay_manager_(overlays)
     , allow_unsafe_self_blocks_resync_(allow_unsafe_self_blocks_resync) {
   compress_block_candidates_ = opts.proto_version >= 4;
+  candidates_with_state_refs_ = opts.proto_version >= 5;
   description_ = ValidatorSessionDescription::create(std::move(opts), nodes, local_id);
   src_round_candidate_.resize(description_->get_total_nodes());
 }
@@ -1262,9 +1325,10 @@ td::actor::ActorOwn<ValidatorSession> ValidatorSession::create(
     td::actor::ActorId<keyring::Keyring> keyring, td::actor::ActorId<adnl::Adnl> adnl,
     td::actor::ActorId<rldp::Rldp> rldp, td::actor::ActorId<overlay::Overlays> overlays, std::string db_root,
     std::string db_suffix, bool allow_unsafe_self_blocks_resync) {
-  return td::actor::create_actor<ValidatorSessionImpl>("session", session_id, std::move(opts), local_id,
-                                                       std::move(nodes), std::move(callback), keyring, adnl, rldp,
-                                                       overlays, db_root, db_suffix, allow_unsafe_self_blocks_resync);
+  return td::actor::create_actor<ValidatorSessionImpl>(
+      td::actor::ActorOptions().with_name("session").with_priority(td::actor::ActorPriority::Critical), session_id,
+      std::move(opts), local_id, std::move(nodes), std::move(callback), keyring, adnl, rldp, overlays, db_root,
+      db_suffix, allow_unsafe_self_blocks_resync);
 }
 
 td::Bits256 ValidatorSessionOptions::get_hash() const {
@@ -30,6 +30,10 @@
 #include "validator-session-types.h"
 #include "auto/tl/lite_api.h"
 
+namespace vm {
+class CellDbReader;
+}  // namespace vm
+
 namespace ton {
 
 namespace validatorsession {
@@ -98,6 +102,8 @@ class ValidatorSession : public td::actor::Actor {
                                         ValidatorSessionFileHash file_hash,
                                         ValidatorSessionCollatedDataFileHash collated_data_file_hash,
                                         td::Promise<BlockCandidate> promise) = 0;
+    // Used to restore cells of the previous state that are sent by reference in candidate broadcasts
+    virtual void get_cell_db_reader(td::Promise<std::shared_ptr<vm::CellDbReader>> promise) = 0;
     virtual ~Callback() = default;
   };
 
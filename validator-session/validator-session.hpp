@@ -161,6 +161,7 @@ class ValidatorSessionImpl : public ValidatorSession {
   bool catchain_started_ = false;
   bool allow_unsafe_self_blocks_resync_;
   bool compress_block_candidates_ = false;
+  bool candidates_with_state_refs_ = false;
 
   ValidatorSessionStats cur_stats_;
   bool stats_inited_ = false;
@@ -205,6 +206,10 @@ class ValidatorSessionImpl : public ValidatorSession {
   bool ensure_candidate_unique(td::uint32 src_idx, td::uint32 round, ValidatorSessionCandidateId block_id);
   void process_broadcast(PublicKeyHash src, td::BufferSlice data, td::optional<ValidatorSessionCandidateId> expected_id,
                          bool is_overlay_broadcast);
+  void process_broadcast_cont(PublicKeyHash src, td::BufferSlice data,
+                              td::optional<ValidatorSessionCandidateId> expected_id, bool is_overlay_broadcast,
+                              td::Result<tl_object_ptr<ton_api::validatorSession_candidate>> R,
+                              double deserialize_time);
   void process_message(PublicKeyHash src, td::BufferSlice data);
   void process_query(PublicKeyHash src, td::BufferSlice data, td::Promise<td::BufferSlice> promise);
 
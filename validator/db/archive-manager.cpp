@@ -335,7 +335,8 @@ void ArchiveManager::add_zero_state(BlockIdExt block_id, td::BufferSlice data, t
           promise.set_value(td::Unit());
         }
       });
-  td::actor::create_actor<db::WriteFile>("writefile", db_root_ + "/archive/tmp/", path, std::move(data), std::move(P))
+  td::actor::create_actor<db::WriteFile>("writefile", db_root_ + "/archive/tmp/", path, std::move(data), std::move(P),
+                                         file_io_.get())
       .release();
 }
 
@@ -343,7 +344,7 @@ void ArchiveManager::add_persistent_state(BlockIdExt block_id, BlockIdExt master
                                           td::Promise<td::Unit> promise) {
   auto create_writer = [&](std::string path, td::Promise<std::string> P) {
     td::actor::create_actor<db::WriteFile>("writefile", db_root_ + "/archive/tmp/", std::move(path), std::move(data),
-                                           std::move(P))
+                                           std::move(P), file_io_.get())
         .release();
   };
   add_persistent_state_impl(block_id, masterchain_block_id, std::move(promise), std::move(create_writer));
@@ -447,9 +448,136 @@ void ArchiveManager::get_persistent_state_slice(BlockIdExt block_id, BlockIdExt
     promise.set_error(td::Status::Error(ErrorCode::notready, "state file not in db"));
     return;
   }
+  if (offset < 0) {
+    promise.set_error(td::Status::Error(ErrorCode::protoviolation, "invalid offset"));
+    return;
+  }
 
   auto path = db_root_ + "/archive/states/" + id.filename_short();
-  td::actor::create_actor<db::ReadFile>("readfile", path, offset, max_size, 0, std::move(promise)).release();
+  auto R = get_mapped_state(hash, path);
+  if (R.is_error()) {
+    LOG(INFO) << "cannot map state file " << path << ": " << R.move_as_error();
+    td::actor::create_actor<db::ReadFile>("readfile", path, offset, max_size, 0, std::move(promise)).release();
+    return;
+  }
+  auto blob = R.move_as_ok();
+
+  StateSliceKey key{hash, offset, max_size};
+  auto &entry = state_slice_cache_[key];
+  entry.last_access = td::Timestamp::now();
+  if (entry.ready) {
+    promise.set_value(entry.data.clone());
+    return;
+  }
+  entry.waiters.push_back(std::move(promise));
+  if (entry.waiters.size() > 1) {
+    return;
+  }
+  // Reading from the mapping may block on page faults, so the range is copied out of the manager actor
+  delay_action(
+      [SelfId = actor_id(this), blob = std::move(blob), key, offset, max_size]() {
+        td::Result<td::BufferSlice> R;
+        auto size = blob->size();
+        if (static_cast<td::uint64>(offset) > size) {
+          R = td::Status::Error(ErrorCode::protoviolation, "offset is too big");
+        } else {
+          auto len = size - offset;
+          if (max_size >= 0 && static_cast<td::uint64>(max_size) < len) {
+            len = max_size;
+          }
+          td::BufferSlice data{len};
+          auto S = blob->view_copy(data.as_slice(), offset);
+          if (S.is_error()) {
+            R = S.move_as_error();
+          } else {
+            R = std::move(data);
+          }
+        }
+        td::actor::send_closure(SelfId, &ArchiveManager::got_persistent_state_slice, key, std::move(R));
+      },
+      td::Timestamp::now());
+}
+
+void ArchiveManager::got_persistent_state_slice(StateSliceKey key, td::Result<td::BufferSlice> R) {
+  auto it = state_slice_cache_.find(key);
+  if (it == state_slice_cache_.end()) {
+    return;
+  }
+  auto waiters = std::move(it->second.waiters);
+  if (R.is_error()) {
+    state_slice_cache_.erase(it);
+    for (auto &promise : waiters) {
+      promise.set_error(R.error().clone());
+    }
+    return;
+  }
+  auto data = R.move_as_ok();
+  for (auto &promise : waiters) {
+    promise.set_value(data.clone());
+  }
+  // huge ranges (e.g. whole small states) would evict everything else
+  if (data.size() * 4 > max_state_slice_cache_size()) {
+    state_slice_cache_.erase(it);
+    return;
+  }
+  it->second.ready = true;
+  state_slice_cache_size_ += data.size();
+  it->second.data = std::move(data);
+  while (state_slice_cache_size_ > max_state_slice_cache_size()) {
+    auto oldest = state_slice_cache_.end();
+    for (auto it2 = state_slice_cache_.begin(); it2 != state_slice_cache_.end(); ++it2) {
+      if (it2->second.ready && (oldest == state_slice_cache_.end() ||
+                                it2->second.last_access.at() < oldest->second.last_access.at())) {
+        oldest = it2;
+      }
+    }
+    CHECK(oldest != state_slice_cache_.end());
+    state_slice_cache_size_ -= oldest->second.data.size();
+    state_slice_cache_.erase(oldest);
+  }
+}
+
+td::Result<std::shared_ptr<td::BlobView>> ArchiveManager::get_mapped_state(FileHash hash, const std::string &path) {
+  auto it = mapped_states_.find(hash);
+  if (it == mapped_states_.end()) {
+    TRY_RESULT(blob, td::FileMemoryMappingBlobView::create(path));
+    it = mapped_states_.emplace(hash, MappedStateFile{std::make_shared<td::BlobView>(std::move(blob))}).first;
+  }
+  it->second.last_access = td::Timestamp::now();
+  return it->second.blob;
+}
+
+void ArchiveManager::drop_mapped_state(FileHash hash) {
+  mapped_states_.erase(hash);
+  auto it = state_slice_cache_.lower_bound(StateSliceKey{hash, std::numeric_limits<td::int64>::min(),
+                                                         std::numeric_limits<td::int64>::min()});
+  while (it != state_slice_cache_.end() && std::get<0>(it->first) == hash) {
+    if (!it->second.ready) {
+      // in-flight read keeps its own reference to the mapping
+      ++it;
+      continue;
+    }
+    state_slice_cache_size_ -= it->second.data.size();
+    it = state_slice_cache_.erase(it);
+  }
+}
+
+void ArchiveManager::cleanup_state_cache() {
+  for (auto it = mapped_states_.begin(); it != mapped_states_.end();) {
+    if (it->second.last_access.in(mapped_state_idle_timeout()).is_in_past()) {
+      it = mapped_states_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  for (auto it = state_slice_cache_.begin(); it != state_slice_cache_.end();) {
+    if (it->second.ready && it->second.last_access.in(state_slice_idle_timeout()).is_in_past()) {
+      state_slice_cache_size_ -= it->second.data.size();
+      it = state_slice_cache_.erase(it);
+    } else {
+      ++it;
+    }
+  }
 }
 
 void ArchiveManager::check_persistent_state(BlockIdExt block_id, BlockIdExt masterchain_block_id,
@@ -625,7 +753,8 @@ void ArchiveManager::load_package(PackageId id) {
   }
 
   desc.file = td::actor::create_actor<ArchiveSlice>("slice", id.id, id.key, id.temp, false, 0, db_root_,
-                                                    archive_lru_.get(), statistics_);
+                                                    archive_lru_.get(), statistics_, package_compression_,
+                                                    file_io_.get());
 
   m.emplace(id, std::move(desc));
   update_permanent_slices();
@@ -661,7 +790,8 @@ const ArchiveManager::FileDescription *ArchiveManager::add_file_desc(ShardIdFull
   std::string prefix = PSTRING() << db_root_ << id.path() << id.name();
   new_desc.file = td::actor::create_actor<ArchiveSlice>("slice", id.id, id.key, id.temp, false,
                                                         id.key || id.temp ? 0 : cur_shard_split_depth_, db_root_,
-                                                        archive_lru_.get(), statistics_);
+                                                        archive_lru_.get(), statistics_, package_compression_,
+                                                        file_io_.get());
   const FileDescription &desc = f.emplace(id, std::move(new_desc));
   if (!id.temp) {
     update_desc(f, desc, shard, seqno, ts, lt);
@@ -857,6 +987,18 @@ void ArchiveManager::start_up() {
   if (!opts_->get_disable_rocksdb_stats()) {
     statistics_.init();
   }
+  if (opts_->get_archive_compression_enabled()) {
+    package_compression_ = std::make_shared<Package::Compression>(
+        Package::Compression{opts_->get_archive_compression_dictionary()});
+  }
+  if (opts_->get_async_file_io_enabled()) {
+    auto r_file_io = td::AsyncFileIo::create("archivefileio");
+    if (r_file_io.is_error()) {
+      LOG(WARNING) << "Async file I/O is unavailable, archive files are written synchronously: " << r_file_io.error();
+    } else {
+      file_io_ = r_file_io.move_as_ok();
+    }
+  }
   td::RocksDbOptions db_options;
   db_options.statistics = statistics_.rocksdb_statistics;
   index_ = std::make_shared<td::RocksDb>(
@@ -1001,6 +1143,7 @@ void ArchiveManager::run_gc(UnixTime mc_ts, UnixTime gc_ts, UnixTime archive_ttl
 }
 
 void ArchiveManager::persistent_state_gc(std::pair<BlockSeqno, FileHash> last) {
+  cleanup_state_cache();
   if (perm_states_.empty()) {
     delay_action(
         [SelfId = actor_id(this)]() {
@@ -1032,6 +1175,7 @@ void ArchiveManager::persistent_state_gc(std::pair<BlockSeqno, FileHash> last) {
 
   if (res == -1) {
     td::unlink(db_root_ + "/archive/states/" + F.filename_short()).ignore();
+    drop_mapped_state(key.second);
     perm_states_.erase(it);
   }
   if (res != 0) {
@@ -1082,6 +1226,7 @@ void ArchiveManager::got_gc_masterchain_handle(ConstBlockHandle handle, std::pai
   auto &F = it->second;
   if (to_del) {
     td::unlink(db_root_ + "/archive/states/" + F.filename_short()).ignore();
+    drop_mapped_state(key.second);
     perm_states_.erase(it);
   }
   delay_action(
@@ -1145,7 +1290,7 @@ void ArchiveManager::get_archive_id(BlockSeqno masterchain_seqno, ShardIdFull sh
                           std::move(promise));
 }
 
-void ArchiveManager::get_archive_slice(td::uint64 archive_id, td::uint64 offset, td::uint32 limit,
+void ArchiveManager::get_archive_slice(td::uint64 archive_id, td::uint64 offset, td::uint32 limit, bool compressed,
                                        td::Promise<td::BufferSlice> promise) {
   auto arch = static_cast<BlockSeqno>(archive_id);
   auto F = get_file_desc(ShardIdFull{masterchainId}, PackageId{arch, false, false}, 0, 0, 0, false);
@@ -1154,7 +1299,8 @@ void ArchiveManager::get_archive_slice(td::uint64 archive_id, td::uint64 offset,
     return;
   }
 
-  td::actor::send_closure(F->file_actor_id(), &ArchiveSlice::get_slice, archive_id, offset, limit, std::move(promise));
+  td::actor::send_closure(F->file_actor_id(), &ArchiveSlice::get_slice, archive_id, offset, limit, compressed,
+                          std::move(promise));
 }
 
 void ArchiveManager::commit_transaction() {
@@ -1294,6 +1440,7 @@ void ArchiveManager::truncate(BlockSeqno masterchain_seqno, ConstBlockHandle han
         auto it2 = it;
         it++;
         td::unlink(db_root_ + "/archive/states/" + it2->second.filename_short()).ignore();
+        drop_mapped_state(it2->first.second);
         perm_states_.erase(it2);
       }
     }
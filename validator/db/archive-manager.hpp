@@ -19,6 +19,7 @@
 #pragma once
 
 #include "archive-slice.hpp"
+#include "td/db/utils/BlobView.h"
 
 namespace ton {
 
@@ -68,7 +69,7 @@ class ArchiveManager : public td::actor::Actor {
   void get_block_by_seqno(AccountIdPrefixFull account_id, BlockSeqno seqno, td::Promise<ConstBlockHandle> promise);
 
   void get_archive_id(BlockSeqno masterchain_seqno, ShardIdFull shard_prefix, td::Promise<td::uint64> promise);
-  void get_archive_slice(td::uint64 archive_id, td::uint64 offset, td::uint32 limit,
+  void get_archive_slice(td::uint64 archive_id, td::uint64 offset, td::uint32 limit, bool compressed,
                          td::Promise<td::BufferSlice> promise);
 
   void start_up() override;
@@ -182,6 +183,8 @@ class ArchiveManager : public td::actor::Actor {
   td::uint32 cur_shard_split_depth_ = 0;
 
   DbStatistics statistics_;
+  std::shared_ptr<const Package::Compression> package_compression_;
+  td::actor::ActorOwn<td::AsyncFileIo> file_io_;
 
   FileMap &get_file_map(const PackageId &p) {
     return p.key ? key_files_ : p.temp ? temp_files_ : files_;
@@ -189,6 +192,34 @@ class ArchiveManager : public td::actor::Actor {
 
   std::map<std::pair<BlockSeqno, FileHash>, FileReferenceShort> perm_states_;  // Mc block seqno, hash -> state
 
+  // Persistent state files are mapped once and served to peers from the mapping. Recently requested ranges are kept
+  // as BufferSlices and shared between all responses by reference, so many peers downloading the same state do not
+  // multiply reads and memory.
+  struct MappedStateFile {
+    std::shared_ptr<td::BlobView> blob;
+    td::Timestamp last_access;
+  };
+  struct StateSliceCacheEntry {
+    bool ready = false;
+    td::BufferSlice data;
+    std::vector<td::Promise<td::BufferSlice>> waiters;
+    td::Timestamp last_access;
+  };
+  using StateSliceKey = std::tuple<FileHash, td::int64, td::int64>;
+  std::map<FileHash, MappedStateFile> mapped_states_;
+  std::map<StateSliceKey, StateSliceCacheEntry> state_slice_cache_;
+  td::uint64 state_slice_cache_size_ = 0;
+
+  static constexpr td::uint64 max_state_slice_cache_size() {
+    return 256 << 20;
+  }
+  static constexpr double mapped_state_idle_timeout() {
+    return 600.0;
+  }
+  static constexpr double state_slice_idle_timeout() {
+    return 60.0;
+  }
+
   void load_package(PackageId seqno);
   void delete_package(PackageId seqno, td::Promise<td::Unit> promise);
   void deleted_package(PackageId seqno, td::Promise<td::Unit> promise);
@@ -216,6 +247,11 @@ class ArchiveManager : public td::actor::Actor {
                                  std::function<void(std::string, td::Promise<std::string>)> create_writer);
   void register_perm_state(FileReferenceShort id);
 
+  void got_persistent_state_slice(StateSliceKey key, td::Result<td::BufferSlice> R);
+  td::Result<std::shared_ptr<td::BlobView>> get_mapped_state(FileHash hash, const std::string &path);
+  void drop_mapped_state(FileHash hash);
+  void cleanup_state_cache();
+
   void persistent_state_gc(std::pair<BlockSeqno, FileHash> last);
   void got_gc_masterchain_handle(ConstBlockHandle handle, std::pair<BlockSeqno, FileHash> key);
 
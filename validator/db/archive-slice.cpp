@@ -108,26 +108,82 @@ std::string DbStatistics::to_string_and_reset() {
 
 void PackageWriter::append(std::string filename, td::BufferSlice data,
                            td::Promise<std::pair<td::uint64, td::uint64>> promise) {
-  td::uint64 offset, size;
+  auto p = package_.lock();
+  if (!p) {
+    promise.set_error(td::Status::Error("Package is closed"));
+    return;
+  }
   auto data_size = data.size();
-  td::Timestamp start, end;
-  {
-    auto p = package_.lock();
-    if (!p) {
-      promise.set_error(td::Status::Error("Package is closed"));
-      return;
-    }
-    start = td::Timestamp::now();
-    offset = p->append(std::move(filename), std::move(data), !async_mode_);
-    end = td::Timestamp::now();
-    size = p->size();
+  if (!file_io_.empty()) {
+    // with no appends in flight the package size is exact, e.g. after the package was truncated
+    auto offset = pending_appends_.empty() ? p->size() : reserved_end_;
+    auto seqno = next_append_seqno_++;
+    auto &pending = pending_appends_[seqno];
+    pending.start = td::Timestamp::now();
+    pending.data_size = data_size;
+    pending.promise = std::move(promise);
+    reserved_end_ = p->append_async(file_io_, offset, std::move(filename), std::move(data), !async_mode_,
+                                    [SelfId = actor_id(this), seqno, p](td::Result<td::Unit> R) {
+                                      td::actor::send_closure(SelfId, &PackageWriter::on_appended, seqno,
+                                                              std::move(R));
+                                    });
+    pending.result = {offset, reserved_end_};
+    return;
   }
+  td::uint64 offset, size;
+  td::Timestamp start, end;
+  start = td::Timestamp::now();
+  offset = p->append(std::move(filename), std::move(data), !async_mode_);
+  end = td::Timestamp::now();
+  size = p->size();
+  p.reset();
   if (statistics_) {
     statistics_->record_write((end.at() - start.at()) * 1e6, data_size);
   }
   promise.set_value(std::pair<td::uint64, td::uint64>{offset, size});
 }
 
+void PackageWriter::on_appended(td::uint64 seqno, td::Result<td::Unit> R) {
+  // a failed write leaves a hole in the package, blocking appends fail the same way
+  R.ensure();
+  pending_appends_[seqno].done = true;
+  auto end = td::Timestamp::now();
+  while (!pending_appends_.empty() && pending_appends_.begin()->second.done) {
+    auto &pending = pending_appends_.begin()->second;
+    if (statistics_) {
+      statistics_->record_write((end.at() - pending.start.at()) * 1e6, pending.data_size);
+    }
+    pending.promise.set_value(std::move(pending.result));
+    pending_appends_.erase(pending_appends_.begin());
+  }
+  if (pending_appends_.empty() && !pending_sync_promises_.empty()) {
+    sync_package();
+  }
+}
+
+void PackageWriter::set_async_mode(bool mode, td::Promise<td::Unit> promise) {
+  async_mode_ = mode;
+  if (async_mode_) {
+    promise.set_value(td::Unit());
+    return;
+  }
+  pending_sync_promises_.push_back(std::move(promise));
+  if (pending_appends_.empty()) {
+    sync_package();
+  }
+}
+
+void PackageWriter::sync_package() {
+  auto p = package_.lock();
+  if (p) {
+    p->sync();
+  }
+  for (auto &promise : pending_sync_promises_) {
+    promise.set_value(td::Unit());
+  }
+  pending_sync_promises_.clear();
+}
+
 class PackageReader : public td::actor::Actor {
  public:
   PackageReader(std::shared_ptr<Package> package, td::uint64 offset,
@@ -403,6 +459,19 @@ void ArchiveSlice::get_file(ConstBlockHandle handle, FileReference ref_id, td::P
           promise.set_value(std::move(R.move_as_ok().second));
         }
       });
+  if (!file_io_.empty()) {
+    auto start = td::Timestamp::now();
+    p->package->read_async(file_io_, offset,
+                           [package = p->package, statistics = statistics_.pack_statistics, start,
+                            P = std::move(P)](td::Result<std::pair<std::string, td::BufferSlice>> R) mutable {
+                             if (statistics && R.is_ok()) {
+                               statistics->record_read((td::Timestamp::now().at() - start.at()) * 1e6,
+                                                       R.ok_ref().second.size());
+                             }
+                             P.set_result(std::move(R));
+                           });
+    return;
+  }
   td::actor::create_actor<PackageReader>("reader", p->package, offset, std::move(P), statistics_.pack_statistics).release();
 }
 
@@ -545,7 +614,7 @@ td::BufferSlice ArchiveSlice::get_db_key_block_info(BlockIdExt block_id) {
   return create_serialize_tl_object<ton_api::db_blockdb_key_value>(create_tl_block_id(block_id));
 }
 
-void ArchiveSlice::get_slice(td::uint64 archive_id, td::uint64 offset, td::uint32 limit,
+void ArchiveSlice::get_slice(td::uint64 archive_id, td::uint64 offset, td::uint32 limit, bool compressed,
                              td::Promise<td::BufferSlice> promise) {
   if (static_cast<td::uint32>(archive_id) != archive_id_) {
     promise.set_error(td::Status::Error(ErrorCode::error, "bad archive id"));
@@ -564,9 +633,34 @@ void ArchiveSlice::get_slice(td::uint64 archive_id, td::uint64 offset, td::uint3
     p = &packages_[value];
   }
   promise = begin_async_query(std::move(promise));
+  if (p->package->is_compressed() && !compressed) {
+    td::actor::send_closure(get_uncompressed_reader(p->path, p->package), &UncompressedSliceReader::get_slice, offset,
+                            limit, std::move(promise));
+    return;
+  }
   td::actor::create_actor<db::ReadFile>("readfile", p->path, offset, limit, 0, std::move(promise)).release();
 }
 
+td::actor::ActorId<UncompressedSliceReader> ArchiveSlice::get_uncompressed_reader(const std::string &path,
+                                                                                  std::shared_ptr<Package> package) {
+  for (auto it = uncompressed_readers_.begin(); it != uncompressed_readers_.end(); ++it) {
+    if (it->first == path) {
+      uncompressed_readers_.splice(uncompressed_readers_.end(), uncompressed_readers_, it);
+      return uncompressed_readers_.back().second.get();
+    }
+  }
+  if (uncompressed_readers_.size() >= MAX_UNCOMPRESSED_READERS) {
+    uncompressed_readers_.pop_front();
+  }
+  uncompressed_readers_.emplace_back(
+      path, td::actor::create_actor<UncompressedSliceReader>("uncompress", std::move(package)));
+  return uncompressed_readers_.back().second.get();
+}
+
+void ArchiveSlice::drop_uncompressed_reader(const std::string &path) {
+  uncompressed_readers_.remove_if([&](const auto &reader) { return reader.first == path; });
+}
+
 void ArchiveSlice::get_archive_id(BlockSeqno masterchain_seqno, ShardIdFull shard_prefix,
                                   td::Promise<td::uint64> promise) {
   before_query();
@@ -699,6 +793,7 @@ void ArchiveSlice::do_close() {
   }
   packages_.clear();
   id_to_package_.clear();
+  uncompressed_readers_.clear();
 }
 
 template<typename T>
@@ -756,7 +851,9 @@ void ArchiveSlice::set_async_mode(bool mode, td::Promise<td::Unit> promise) {
 
 ArchiveSlice::ArchiveSlice(td::uint32 archive_id, bool key_blocks_only, bool temp, bool finalized,
                            td::uint32 shard_split_depth, std::string db_root,
-                           td::actor::ActorId<ArchiveLru> archive_lru, DbStatistics statistics)
+                           td::actor::ActorId<ArchiveLru> archive_lru, DbStatistics statistics,
+                           std::shared_ptr<const Package::Compression> compression,
+                           td::actor::ActorId<td::AsyncFileIo> file_io)
     : archive_id_(archive_id)
     , key_blocks_only_(key_blocks_only)
     , temp_(temp)
@@ -765,7 +862,9 @@ ArchiveSlice::ArchiveSlice(td::uint32 archive_id, bool key_blocks_only, bool tem
     , shard_split_depth_(temp || key_blocks_only ? 0 : shard_split_depth)
     , db_root_(std::move(db_root))
     , archive_lru_(std::move(archive_lru))
-    , statistics_(statistics) {
+    , statistics_(statistics)
+    , compression_(std::move(compression))
+    , file_io_(std::move(file_io)) {
   db_path_ = PSTRING() << db_root_ << p_id_.path() << p_id_.name() << ".index";
 }
 
@@ -809,7 +908,7 @@ td::Result<ArchiveSlice::PackageInfo *> ArchiveSlice::choose_package(BlockSeqno
 void ArchiveSlice::add_package(td::uint32 seqno, ShardIdFull shard_prefix, td::uint64 size, td::uint32 version) {
   PackageId p_id{seqno, key_blocks_only_, temp_};
   std::string path = PSTRING() << db_root_ << p_id.path() << get_package_file_name(p_id, shard_prefix);
-  auto R = Package::open(path, false, true);
+  auto R = Package::open(path, false, true, compression_.get());
   if (R.is_error()) {
     LOG(FATAL) << "failed to open/create archive '" << path << "': " << R.move_as_error();
     return;
@@ -827,7 +926,8 @@ void ArchiveSlice::add_package(td::uint32 seqno, ShardIdFull shard_prefix, td::u
   if (version >= 1) {
     pack->truncate(size).ensure();
   }
-  auto writer = td::actor::create_actor<PackageWriter>("writer", pack, async_mode_, statistics_.pack_statistics);
+  auto writer = td::actor::create_actor<PackageWriter>("writer", pack, async_mode_, statistics_.pack_statistics,
+                                                             file_io_);
   packages_.emplace_back(std::move(pack), std::move(writer), seqno, shard_prefix, path, idx, version);
 }
 
@@ -857,6 +957,7 @@ void ArchiveSlice::destroy(td::Promise<td::Unit> promise) {
   for (auto &p : packages_) {
     td::unlink(p.path).ensure();
   }
+  uncompressed_readers_.clear();
   if (statistics_.pack_statistics) {
     statistics_.pack_statistics->record_close(packages_.size());
   }
@@ -1042,7 +1143,7 @@ void ArchiveSlice::truncate(BlockSeqno masterchain_seqno, ConstBlockHandle, td::
     CHECK(package);
     if (!old_packages.count(package->shard_prefix)) {
       old_packages[package->shard_prefix] = package;
-      auto new_package_r = Package::open(package->path + ".new", false, true);
+      auto new_package_r = Package::open(package->path + ".new", false, true, compression_.get());
       new_package_r.ensure();
       auto new_package = std::make_shared<Package>(new_package_r.move_as_ok());
       new_package->truncate(0).ensure();
@@ -1058,7 +1159,8 @@ void ArchiveSlice::truncate(BlockSeqno masterchain_seqno, ConstBlockHandle, td::
     package->writer.reset();
     td::unlink(package->path).ensure();
     td::rename(package->path + ".new", package->path).ensure();
-    package->writer = td::actor::create_actor<PackageWriter>("writer", new_package, async_mode_);
+    drop_uncompressed_reader(package->path);
+    package->writer = td::actor::create_actor<PackageWriter>("writer", new_package, async_mode_, nullptr, file_io_);
   }
 
   std::vector<PackageInfo> new_packages_info;
@@ -1071,6 +1173,7 @@ void ArchiveSlice::truncate(BlockSeqno masterchain_seqno, ConstBlockHandle, td::
         new_packages_info.push_back(std::move(package));
       } else {
         td::unlink(package.path).ensure();
+        drop_uncompressed_reader(package.path);
       }
     }
     id_to_package_.clear();
@@ -22,6 +22,7 @@
 #include "package.hpp"
 #include "fileref.hpp"
 #include "td/db/RocksDb.h"
+#include <list>
 #include <map>
 
 namespace rocksdb {
@@ -70,26 +71,54 @@ struct DbStatistics {
 
 class PackageWriter : public td::actor::Actor {
  public:
-  PackageWriter(std::weak_ptr<Package> package, bool async_mode = false, std::shared_ptr<PackageStatistics> statistics = nullptr)
-      : package_(std::move(package)), async_mode_(async_mode), statistics_(std::move(statistics)) {
+  PackageWriter(std::weak_ptr<Package> package, bool async_mode = false,
+                std::shared_ptr<PackageStatistics> statistics = nullptr,
+                td::actor::ActorId<td::AsyncFileIo> file_io = {})
+      : package_(std::move(package))
+      , async_mode_(async_mode)
+      , statistics_(std::move(statistics))
+      , file_io_(std::move(file_io)) {
   }
 
   void append(std::string filename, td::BufferSlice data, td::Promise<std::pair<td::uint64, td::uint64>> promise);
-  void set_async_mode(bool mode, td::Promise<td::Unit> promise) {
-    async_mode_ = mode;
-    if (!async_mode_) {
-      auto p = package_.lock();
-      if (p) {
-        p->sync();
-      }
-    }
-    promise.set_value(td::Unit());
-  }
+  void set_async_mode(bool mode, td::Promise<td::Unit> promise);
 
  private:
   std::weak_ptr<Package> package_;
   bool async_mode_ = false;
   std::shared_ptr<PackageStatistics> statistics_;
+  td::actor::ActorId<td::AsyncFileIo> file_io_;
+
+  // Appends through file_io_ may complete in any order, but results are reported in the order of appends,
+  // so that the package size stored by the caller never covers an entry that is not written yet
+  struct PendingAppend {
+    std::pair<td::uint64, td::uint64> result;
+    td::Timestamp start;
+    size_t data_size = 0;
+    bool done = false;
+    td::Promise<std::pair<td::uint64, td::uint64>> promise;
+  };
+  std::map<td::uint64, PendingAppend> pending_appends_;
+  // end of the last entry in flight; the package size covers only entries that are written already
+  td::uint64 reserved_end_ = 0;
+  td::uint64 next_append_seqno_ = 0;
+  std::vector<td::Promise<td::Unit>> pending_sync_promises_;
+
+  void on_appended(td::uint64 seqno, td::Result<td::Unit> R);
+  void sync_package();
+};
+
+class UncompressedSliceReader : public td::actor::Actor {
+ public:
+  explicit UncompressedSliceReader(std::shared_ptr<Package> package) : reader_(std::move(package)) {
+  }
+
+  void get_slice(td::uint64 offset, td::uint32 limit, td::Promise<td::BufferSlice> promise) {
+    promise.set_result(reader_.read(offset, limit));
+  }
+
+ private:
+  UncompressedPackageReader reader_;
 };
 
 class ArchiveLru;
@@ -97,7 +126,9 @@ class ArchiveLru;
 class ArchiveSlice : public td::actor::Actor {
  public:
   ArchiveSlice(td::uint32 archive_id, bool key_blocks_only, bool temp, bool finalized, td::uint32 shard_split_depth,
-               std::string db_root, td::actor::ActorId<ArchiveLru> archive_lru, DbStatistics statistics = {});
+               std::string db_root, td::actor::ActorId<ArchiveLru> archive_lru, DbStatistics statistics = {},
+               std::shared_ptr<const Package::Compression> compression = nullptr,
+               td::actor::ActorId<td::AsyncFileIo> file_io = {});
 
   void get_archive_id(BlockSeqno masterchain_seqno, ShardIdFull shard_prefix, td::Promise<td::uint64> promise);
 
@@ -117,7 +148,9 @@ class ArchiveSlice : public td::actor::Actor {
                         std::function<td::int32(ton_api::db_lt_el_value &)> compare, bool exact,
                         td::Promise<ConstBlockHandle> promise);
 
-  void get_slice(td::uint64 archive_id, td::uint64 offset, td::uint32 limit, td::Promise<td::BufferSlice> promise);
+  // Compressed packages are sent as stored only if the peer asked for them compressed
+  void get_slice(td::uint64 archive_id, td::uint64 offset, td::uint32 limit, bool compressed,
+                 td::Promise<td::BufferSlice> promise);
 
   void destroy(td::Promise<td::Unit> promise);
   void truncate(BlockSeqno masterchain_seqno, ConstBlockHandle handle, td::Promise<td::Unit> promise);
@@ -140,6 +173,15 @@ class ArchiveSlice : public td::actor::Actor {
   void add_file_cont(size_t idx, FileReference ref_id, td::uint64 offset, td::uint64 size,
                      td::Promise<td::Unit> promise);
 
+  // Compressed packages are served to peers that can't read them in the original format, decompressed on the fly;
+  // the readers of the last few packages are kept, least recently used first
+  static constexpr size_t MAX_UNCOMPRESSED_READERS = 4;
+  std::list<std::pair<std::string, td::actor::ActorOwn<UncompressedSliceReader>>> uncompressed_readers_;
+
+  td::actor::ActorId<UncompressedSliceReader> get_uncompressed_reader(const std::string &path,
+                                                                      std::shared_ptr<Package> package);
+  void drop_uncompressed_reader(const std::string &path);
+
   /* ltdb */
   td::BufferSlice get_db_key_lt_desc(ShardIdFull shard);
   td::BufferSlice get_db_key_lt_el(ShardIdFull shard, td::uint32 idx);
@@ -169,6 +211,8 @@ class ArchiveSlice : public td::actor::Actor {
   std::string db_root_;
   td::actor::ActorId<ArchiveLru> archive_lru_;
   DbStatistics statistics_;
+  std::shared_ptr<const Package::Compression> compression_;
+  td::actor::ActorId<td::AsyncFileIo> file_io_;
   std::unique_ptr<td::KeyValue> kv_;
 
   struct PackageInfo {
@@ -22,12 +22,15 @@
 #include "rootdb.hpp"
 
 #include "td/db/RocksDb.h"
+#include "td/utils/port/path.h"
 #include "rocksdb/utilities/optimistic_transaction_db.h"
 
 #include "ton/ton-tl.hpp"
 #include "ton/ton-io.hpp"
 #include "common/delay.h"
 
+#include <unordered_map>
+
 namespace ton {
 
 namespace validator {
@@ -76,12 +79,13 @@ CellDbIn::CellDbIn(td::actor::ActorId<RootDb> root_db, td::actor::ActorId<CellDb
 void CellDbIn::start_up() {
   on_load_callback_ = [actor = std::make_shared<td::actor::ActorOwn<MigrationProxy>>(
                            td::actor::create_actor<MigrationProxy>("celldbmigration", actor_id(this))),
-                       compress_depth = opts_->get_celldb_compress_depth()](const vm::CellLoader::LoadResult& res) {
+                       compress_depth = opts_->get_celldb_compress_depth(),
+                       compact = opts_->get_celldb_compact_cells()](const vm::CellLoader::LoadResult& res) {
     if (res.cell_.is_null()) {
       return;
     }
     bool expected_stored_boc = res.cell_->get_depth() == compress_depth && compress_depth != 0;
-    if (expected_stored_boc != res.stored_boc_) {
+    if (expected_stored_boc != res.stored_boc_ || (!expected_stored_boc && compact != res.stored_compact_)) {
       td::actor::send_closure(*actor, &CellDbIn::MigrationProxy::migrate_cell,
                               td::Bits256{res.cell_->get_hash().bits()});
     }
@@ -207,32 +211,11 @@ void CellDbIn::store_cell(BlockIdExt block_id, td::Ref<vm::Cell> cell, td::Promi
     td::actor::send_lambda(
         SelfId, [=, this, timer = std::move(timer), promise = std::move(promise), cell = std::move(cell)]() mutable {
           TD_PERF_COUNTER(celldb_store_cell);
-          auto empty = get_empty_key_hash();
-          auto ER = get_block(empty);
-          ER.ensure();
-          auto E = ER.move_as_ok();
-
-          auto PR = get_block(E.prev);
-          PR.ensure();
-          auto P = PR.move_as_ok();
-          CHECK(P.next == empty);
-
-          DbEntry D{block_id, E.prev, empty, cell->get_hash().bits()};
-
-          E.prev = key_hash;
-          P.next = key_hash;
-
-          if (P.is_empty()) {
-            E.next = key_hash;
-            P.prev = key_hash;
-          }
           td::Timer timer_write;
-          vm::CellStorer stor{*cell_db_};
+          vm::CellStorer stor{*cell_db_, opts_->get_celldb_compact_cells()};
           cell_db_->begin_write_batch().ensure();
           boc_->commit(stor).ensure();
-          set_block(get_empty_key_hash(), std::move(E));
-          set_block(D.prev, std::move(P));
-          set_block(key_hash, std::move(D));
+          link_block(block_id, cell->get_hash().bits());
           cell_db_->commit_write_batch().ensure();
           timer_write.pause();
 
@@ -253,6 +236,197 @@ void CellDbIn::store_cell(BlockIdExt block_id, td::Ref<vm::Cell> cell, td::Promi
   });
 }
 
+void CellDbIn::import_cell(BlockIdExt block_id, td::Ref<vm::Cell> cell, td::Promise<td::Ref<vm::DataCell>> promise) {
+  if (opts_->get_celldb_in_memory()) {
+    store_cell(block_id, std::move(cell), std::move(promise));
+    return;
+  }
+  if (db_busy_) {
+    action_queue_.push(
+        [self = this, block_id, cell = std::move(cell), promise = std::move(promise)](td::Result<td::Unit> R) mutable {
+          R.ensure();
+          self->import_cell(block_id, std::move(cell), std::move(promise));
+        });
+    return;
+  }
+  if (get_block(get_key_hash(block_id)).is_ok()) {
+    promise.set_result(boc_->load_cell(cell->get_hash().as_slice()));
+    return;
+  }
+
+  // Cells are collected and written into SST files by the async executor, the db stays locked meanwhile
+  db_busy_ = true;
+  LOG(WARNING) << "Importing state " << block_id.to_str() << " into celldb";
+  async_executor->execute_async(
+      [SelfId = actor_id(this), snapshot = std::shared_ptr<td::KeyValueReader>(cell_db_->snapshot()), block_id, cell,
+       dir = import_dir(), compress_depth = opts_->get_celldb_compress_depth(),
+       compact = opts_->get_celldb_compact_cells(),
+       promise_ptr = std::make_shared<td::Promise<td::Ref<vm::DataCell>>>(std::move(promise))]() mutable {
+        auto R = write_import_files(*snapshot, cell, std::move(dir), compress_depth, compact);
+        td::actor::send_closure(SelfId, &CellDbIn::import_cell_cont, block_id, std::move(cell), std::move(R),
+                                std::move(*promise_ptr));
+      });
+}
+
+td::Result<CellDbIn::ImportedCells> CellDbIn::write_import_files(td::KeyValueReader& snapshot, td::Ref<vm::Cell> root,
+                                                                 std::string dir, td::uint32 compress_depth,
+                                                                 bool compact, size_t batch_size) {
+  td::Timer timer;
+  ImportedCells result;
+  std::string value;
+
+  // First pass counts references to the new cells from other new cells (plus one for the root).
+  // Only hashes are kept, the cells themselves are already in memory as a part of the state
+  constexpr td::int32 IN_DB = 0;
+  std::unordered_map<vm::CellHash, td::int32> refcnt;
+  std::vector<td::Ref<vm::DataCell>> stack;
+  auto visit = [&](const td::Ref<vm::Cell>& cell) -> td::Status {
+    if (cell->get_virtualization() != 0) {
+      return td::Status::Error("cannot import virtualized cell");
+    }
+    auto hash = cell->get_hash();
+    auto it = refcnt.find(hash);
+    if (it != refcnt.end()) {
+      if (it->second == IN_DB) {
+        result.existing_refs.push_back(cell);
+      } else {
+        it->second++;
+      }
+      return td::Status::OK();
+    }
+    TRY_RESULT(status, snapshot.get(hash.as_slice(), value));
+    if (status == td::KeyValue::GetStatus::Ok) {
+      refcnt.emplace(hash, IN_DB);
+      result.existing_refs.push_back(cell);
+      return td::Status::OK();
+    }
+    TRY_RESULT(loaded_cell, cell->load_cell());
+    refcnt.emplace(hash, 1);
+    stack.push_back(std::move(loaded_cell.data_cell));
+    return td::Status::OK();
+  };
+  TRY_STATUS(visit(root));
+  while (!stack.empty()) {
+    auto cell = std::move(stack.back());
+    stack.pop_back();
+    for (unsigned i = 0; i < cell->size_refs(); i++) {
+      TRY_STATUS(visit(cell->get_ref(i)));
+    }
+  }
+  double collect_time = timer.elapsed();
+
+  // Second pass serializes the new cells in batches. A batch is sorted and written into its own SST files,
+  // so files of different batches overlap, which RocksDb handles by ingesting them into level 0
+  std::vector<std::pair<vm::CellHash, std::string>> batch;
+  size_t batch_bytes = 0;
+  auto flush_batch = [&]() -> td::Status {
+    std::sort(batch.begin(), batch.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+    td::RocksDbSstWriter writer{PSTRING() << dir << result.batches_count++ << "/"};
+    for (auto& c : batch) {
+      TRY_STATUS(writer.add(c.first.as_slice(), c.second));
+    }
+    TRY_RESULT(files, writer.finish());
+    for (auto& file : files) {
+      result.sst_files.push_back(std::move(file));
+    }
+    batch.clear();
+    batch_bytes = 0;
+    return td::Status::OK();
+  };
+  auto emit = [&](const td::Ref<vm::Cell>& cell) -> td::Status {
+    auto it = refcnt.find(cell->get_hash());
+    if (it == refcnt.end() || it->second == IN_DB) {
+      // already emitted or in db
+      return td::Status::OK();
+    }
+    TRY_RESULT(loaded_cell, cell->load_cell());
+    auto& data_cell = loaded_cell.data_cell;
+    bool as_boc = data_cell->get_depth() == compress_depth && compress_depth != 0;
+    batch.emplace_back(it->first, vm::CellStorer::serialize_value(it->second, data_cell, as_boc, compact));
+    batch_bytes += batch.back().second.size();
+    result.cells_count++;
+    refcnt.erase(it);
+    stack.push_back(std::move(data_cell));
+    if (batch_bytes >= batch_size) {
+      TRY_STATUS(flush_batch());
+    }
+    return td::Status::OK();
+  };
+  TRY_STATUS(emit(root));
+  while (!stack.empty()) {
+    auto cell = std::move(stack.back());
+    stack.pop_back();
+    for (unsigned i = 0; i < cell->size_refs(); i++) {
+      TRY_STATUS(emit(cell->get_ref(i)));
+    }
+  }
+  if (!batch.empty()) {
+    TRY_STATUS(flush_batch());
+  }
+  LOG(WARNING) << "Prepared " << result.cells_count << " cells for import in " << timer.elapsed() << "s (collect "
+               << collect_time << "s, " << result.batches_count << " batches), " << result.existing_refs.size()
+               << " references to existing cells";
+  return result;
+}
+
+void CellDbIn::import_cell_cont(BlockIdExt block_id, td::Ref<vm::Cell> cell, td::Result<ImportedCells> R,
+                                td::Promise<td::Ref<vm::DataCell>> promise) {
+  if (R.is_error()) {
+    LOG(WARNING) << "Failed to import state " << block_id.to_str()
+                 << ", storing it cell by cell: " << R.move_as_error();
+    td::rmrf(import_dir()).ignore();
+    release_db();
+    store_cell(block_id, std::move(cell), std::move(promise));
+    return;
+  }
+  auto imported = R.move_as_ok();
+  td::Timer timer;
+
+  // References to old cells are accounted before the new cells become visible, and the block entry is added last.
+  // This way an interrupted import can only leave unreachable cells, never cells with missing children.
+  if (!imported.existing_refs.empty()) {
+    for (auto& c : imported.existing_refs) {
+      boc_->inc(c);
+    }
+    vm::CellStorer stor{*cell_db_, opts_->get_celldb_compact_cells()};
+    cell_db_->begin_write_batch().ensure();
+    boc_->commit(stor).ensure();
+    cell_db_->commit_write_batch().ensure();
+  }
+  auto S = static_cast<td::RocksDb&>(*cell_db_).ingest_external_files(std::move(imported.sst_files));
+  td::rmrf(import_dir()).ignore();
+  if (S.is_error()) {
+    // New cells are not visible, so taking the references back restores the db as it was before the import
+    LOG(WARNING) << "Failed to ingest state " << block_id.to_str() << ", storing it cell by cell: " << S;
+    if (!imported.existing_refs.empty()) {
+      boc_->set_loader(std::make_unique<vm::CellLoader>(cell_db_->snapshot(), on_load_callback_)).ensure();
+      for (auto& c : imported.existing_refs) {
+        boc_->dec(c);
+      }
+      vm::CellStorer stor{*cell_db_, opts_->get_celldb_compact_cells()};
+      cell_db_->begin_write_batch().ensure();
+      boc_->commit(stor).ensure();
+      cell_db_->commit_write_batch().ensure();
+      boc_->set_loader(std::make_unique<vm::CellLoader>(cell_db_->snapshot(), on_load_callback_)).ensure();
+    }
+    release_db();
+    store_cell(block_id, std::move(cell), std::move(promise));
+    return;
+  }
+
+  cell_db_->begin_write_batch().ensure();
+  link_block(block_id, cell->get_hash().bits());
+  cell_db_->commit_write_batch().ensure();
+
+  boc_->set_loader(std::make_unique<vm::CellLoader>(cell_db_->snapshot(), on_load_callback_)).ensure();
+  td::actor::send_closure(parent_, &CellDb::update_snapshot, cell_db_->snapshot());
+
+  promise.set_result(boc_->load_cell(cell->get_hash().as_slice()));
+  LOG(WARNING) << "Imported state " << block_id.to_str() << " (" << imported.cells_count << " new cells), ingested in "
+               << timer.elapsed() << "s";
+  release_db();
+}
+
 void CellDbIn::get_cell_db_reader(td::Promise<std::shared_ptr<vm::CellDbReader>> promise) {
   if (db_busy_) {
     action_queue_.push(
@@ -442,7 +616,7 @@ void CellDbIn::gc_cont2(BlockHandle handle) {
                                         P = std::move(P), N = std::move(N), cell = std::move(cell),
                                         timer = std::move(timer), timer_all = std::move(timer_all), handle]() mutable {
           TD_PERF_COUNTER(celldb_gc_cell);
-          vm::CellStorer stor{*cell_db_};
+          vm::CellStorer stor{*cell_db_, opts_->get_celldb_compact_cells()};
           timer_boc.reset();
 
           td::PerfWarningTimer timer_write_batch{"gccell_write_batch", 0.05};
@@ -533,6 +707,32 @@ void CellDbIn::set_block(KeyHash key_hash, DbEntry e) {
   cell_db_->set(td::as_slice(key), e.release()).ensure();
 }
 
+void CellDbIn::link_block(BlockIdExt block_id, RootHash root_hash) {
+  auto key_hash = get_key_hash(block_id);
+  auto empty = get_empty_key_hash();
+  auto ER = get_block(empty);
+  ER.ensure();
+  auto E = ER.move_as_ok();
+
+  auto PR = get_block(E.prev);
+  PR.ensure();
+  auto P = PR.move_as_ok();
+  CHECK(P.next == empty);
+
+  DbEntry D{block_id, E.prev, empty, root_hash};
+
+  E.prev = key_hash;
+  P.next = key_hash;
+
+  if (P.is_empty()) {
+    E.next = key_hash;
+    P.prev = key_hash;
+  }
+  set_block(empty, std::move(E));
+  set_block(D.prev, std::move(P));
+  set_block(key_hash, std::move(D));
+}
+
 void CellDbIn::migrate_cell(td::Bits256 hash) {
   cells_to_migrate_.insert(hash);
   if (!migration_active_) {
@@ -558,7 +758,7 @@ void CellDbIn::migrate_cells() {
   if (!migration_stats_) {
     migration_stats_ = std::make_unique<MigrationStats>();
   }
-  vm::CellStorer stor{*cell_db_};
+  vm::CellStorer stor{*cell_db_, opts_->get_celldb_compact_cells()};
   auto loader = std::make_unique<vm::CellLoader>(cell_db_->snapshot());
   boc_->set_loader(std::make_unique<vm::CellLoader>(*loader)).ensure();
   cell_db_->begin_write_batch().ensure();
@@ -576,7 +776,8 @@ void CellDbIn::migrate_cells() {
     }
     bool expected_stored_boc =
         R.ok().cell_->get_depth() == opts_->get_celldb_compress_depth() && opts_->get_celldb_compress_depth() != 0;
-    if (expected_stored_boc != R.ok().stored_boc_) {
+    bool expected_compact = !expected_stored_boc && opts_->get_celldb_compact_cells();
+    if (expected_stored_boc != R.ok().stored_boc_ || expected_compact != R.ok().stored_compact_) {
       ++migrated;
       stor.set(R.ok().refcnt(), R.ok().cell_, expected_stored_boc).ensure();
     }
@@ -645,6 +846,10 @@ void CellDb::store_cell(BlockIdExt block_id, td::Ref<vm::Cell> cell, td::Promise
   td::actor::send_closure(cell_db_, &CellDbIn::store_cell, block_id, std::move(cell), std::move(promise));
 }
 
+void CellDb::import_cell(BlockIdExt block_id, td::Ref<vm::Cell> cell, td::Promise<td::Ref<vm::DataCell>> promise) {
+  td::actor::send_closure(cell_db_, &CellDbIn::import_cell, block_id, std::move(cell), std::move(promise));
+}
+
 void CellDb::get_cell_db_reader(td::Promise<std::shared_ptr<vm::CellDbReader>> promise) {
   td::actor::send_closure(cell_db_, &CellDbIn::get_cell_db_reader, std::move(promise));
 }
@@ -656,12 +861,13 @@ void CellDb::start_up() {
   cell_db_ = td::actor::create_actor<CellDbIn>("celldbin", root_db_, actor_id(this), path_, opts_);
   on_load_callback_ = [actor = std::make_shared<td::actor::ActorOwn<CellDbIn::MigrationProxy>>(
                            td::actor::create_actor<CellDbIn::MigrationProxy>("celldbmigration", cell_db_.get())),
-                       compress_depth = opts_->get_celldb_compress_depth()](const vm::CellLoader::LoadResult& res) {
+                       compress_depth = opts_->get_celldb_compress_depth(),
+                       compact = opts_->get_celldb_compact_cells()](const vm::CellLoader::LoadResult& res) {
     if (res.cell_.is_null()) {
       return;
     }
     bool expected_stored_boc = res.cell_->get_depth() == compress_depth && compress_depth != 0;
-    if (expected_stored_boc != res.stored_boc_) {
+    if (expected_stored_boc != res.stored_boc_ || (!expected_stored_boc && compact != res.stored_compact_)) {
       td::actor::send_closure(*actor, &CellDbIn::MigrationProxy::migrate_cell,
                               td::Bits256{res.cell_->get_hash().bits()});
     }
@@ -65,6 +65,7 @@ class CellDbIn : public CellDbBase {
   std::vector<std::pair<std::string, std::string>> prepare_stats();
   void load_cell(RootHash hash, td::Promise<td::Ref<vm::DataCell>> promise);
   void store_cell(BlockIdExt block_id, td::Ref<vm::Cell> cell, td::Promise<td::Ref<vm::DataCell>> promise);
+  void import_cell(BlockIdExt block_id, td::Ref<vm::Cell> cell, td::Promise<td::Ref<vm::DataCell>> promise);
   void get_cell_db_reader(td::Promise<std::shared_ptr<vm::CellDbReader>> promise);
 
   void migrate_cell(td::Bits256 hash);
@@ -77,6 +78,20 @@ class CellDbIn : public CellDbBase {
   void start_up() override;
   void alarm() override;
 
+  struct ImportedCells {
+    std::vector<std::string> sst_files;
+    // References from the imported cells to cells that are already in db, with multiplicity
+    std::vector<td::Ref<vm::Cell>> existing_refs;
+    size_t cells_count = 0;
+    size_t batches_count = 0;
+  };
+  // Writes cells of the tree which are not in db yet into SST files for RocksDb::ingest_external_files.
+  // Cells are serialized in batches of about batch_size bytes, each batch is sorted on its own
+  static td::Result<ImportedCells> write_import_files(td::KeyValueReader& snapshot, td::Ref<vm::Cell> root,
+                                                      std::string dir, td::uint32 compress_depth, bool compact,
+                                                      size_t batch_size = IMPORT_BATCH_SIZE);
+  static constexpr size_t IMPORT_BATCH_SIZE = 256 << 20;
+
  private:
   struct DbEntry {
     BlockIdExt block_id;
@@ -96,6 +111,13 @@ class CellDbIn : public CellDbBase {
   };
   td::Result<DbEntry> get_block(KeyHash key);
   void set_block(KeyHash key, DbEntry e);
+  void link_block(BlockIdExt block_id, RootHash root_hash);
+
+  void import_cell_cont(BlockIdExt block_id, td::Ref<vm::Cell> cell, td::Result<ImportedCells> R,
+                        td::Promise<td::Ref<vm::DataCell>> promise);
+  std::string import_dir() const {
+    return path_ + "/import/";
+  }
 
   static std::string get_key(KeyHash key);
   static KeyHash get_key_hash(BlockIdExt block_id);
@@ -187,6 +209,7 @@ class CellDb : public CellDbBase {
   void prepare_stats(td::Promise<std::vector<std::pair<std::string, std::string>>> promise);
   void load_cell(RootHash hash, td::Promise<td::Ref<vm::DataCell>> promise);
   void store_cell(BlockIdExt block_id, td::Ref<vm::Cell> cell, td::Promise<td::Ref<vm::DataCell>> promise);
+  void import_cell(BlockIdExt block_id, td::Ref<vm::Cell> cell, td::Promise<td::Ref<vm::DataCell>> promise);
   void update_snapshot(std::unique_ptr<td::KeyValueReader> snapshot) {
     CHECK(!opts_->get_celldb_in_memory());
     if (!started_) {
@@ -21,6 +21,7 @@
 #include "td/utils/port/path.h"
 #include "td/utils/filesystem.h"
 #include "td/actor/actor.h"
+#include "td/db/utils/AsyncFileIo.h"
 #include "td/utils/buffer.h"
 
 #include "common/errorcode.h"
@@ -50,36 +51,33 @@ class WriteFile : public td::actor::Actor {
       return;
     }
     auto res = R.move_as_ok();
-    auto file = std::move(res.first);
-    auto old_name = res.second;
-    auto status = write_data_(file);
-    if (!status.is_error()) {
-      status = file.sync();
-    }
-    if (status.is_error()) {
-      td::unlink(old_name).ignore();
-      promise_.set_error(std::move(status));
-      stop();
+    auto file = std::make_shared<td::FileFd>(std::move(res.first));
+    old_name_ = res.second;
+    if (!file_io_.empty()) {
+      td::actor::send_closure(file_io_, &td::AsyncFileIo::pwrite, file.get(), std::move(data_), 0, true,
+                              [SelfId = actor_id(this), file](td::Result<td::Unit> R) {
+                                td::actor::send_closure(SelfId, &WriteFile::written, R.move_as_status());
+                              });
       return;
     }
-    if (new_name_.length() > 0) {
-      status = td::rename(old_name, new_name_);
-      if (status.is_error()) {
-        promise_.set_error(std::move(status));
-      } else {
-        promise_.set_value(std::move(new_name_));
-      }
-    } else {
-      promise_.set_value(std::move(old_name));
+    auto status = write_data_(*file);
+    if (!status.is_error()) {
+      status = file->sync();
     }
-    stop();
+    written(std::move(status));
   }
   WriteFile(std::string tmp_dir, std::string new_name, std::function<td::Status(td::FileFd&)> write_data,
             td::Promise<std::string> promise)
       : tmp_dir_(tmp_dir), new_name_(new_name), write_data_(std::move(write_data)), promise_(std::move(promise)) {
   }
-  WriteFile(std::string tmp_dir, std::string new_name, td::BufferSlice data, td::Promise<std::string> promise)
-      : tmp_dir_(tmp_dir), new_name_(new_name), promise_(std::move(promise)) {
+  // The data is written through file_io if it is set, without blocking the scheduler thread
+  WriteFile(std::string tmp_dir, std::string new_name, td::BufferSlice data, td::Promise<std::string> promise,
+            td::actor::ActorId<td::AsyncFileIo> file_io = {})
+      : tmp_dir_(tmp_dir), new_name_(new_name), promise_(std::move(promise)), file_io_(std::move(file_io)) {
+    if (!file_io_.empty()) {
+      data_ = std::move(data);
+      return;
+    }
     write_data_ = [data_ptr = std::make_shared<td::BufferSlice>(std::move(data))] (td::FileFd& fd) {
       auto data = std::move(*data_ptr);
       while (data.size() > 0) {
@@ -94,8 +92,31 @@ class WriteFile : public td::actor::Actor {
  private:
   const std::string tmp_dir_;
   std::string new_name_;
+  std::string old_name_;
   std::function<td::Status(td::FileFd&)> write_data_;
   td::Promise<std::string> promise_;
+  td::actor::ActorId<td::AsyncFileIo> file_io_;
+  td::BufferSlice data_;
+
+  void written(td::Status status) {
+    if (status.is_error()) {
+      td::unlink(old_name_).ignore();
+      promise_.set_error(std::move(status));
+      stop();
+      return;
+    }
+    if (new_name_.length() > 0) {
+      status = td::rename(old_name_, new_name_);
+      if (status.is_error()) {
+        promise_.set_error(std::move(status));
+      } else {
+        promise_.set_value(std::move(new_name_));
+      }
+    } else {
+      promise_.set_value(std::move(old_name_));
+    }
+    stop();
+  }
 };
 
 class ReadFile : public td::actor::Actor {
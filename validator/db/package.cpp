@@ -18,6 +18,7 @@
 */
 #include "package.hpp"
 #include "common/errorcode.h"
+#include "td/utils/lz4.h"
 
 namespace ton {
 
@@ -35,33 +36,76 @@ constexpr td::uint32 max_filename_size() {
   return (1u << 16) - 1;
 }
 
+constexpr td::uint32 max_compressed_data_size() {
+  return 1u << 30;
+}
+
+constexpr td::uint32 max_dictionary_size() {
+  return 1u << 16;
+}
+
 constexpr td::uint16 entry_header_magic() {
   return 0x1e8b;
 }
 
+constexpr td::uint16 compressed_entry_header_magic() {
+  return 0x1e8c;
+}
+
 constexpr td::uint32 package_header_magic() {
   return 0xae8fdd01;
 }
+
+constexpr td::uint32 compressed_package_header_magic() {
+  return 0xae8fdd02;
+}
 }  // namespace
 
-Package::Package(td::FileFd fd) : fd_(std::move(fd)) {
+Package::Package(td::FileFd fd) : fd_(std::move(fd)), header_size_(header_size()) {
+}
+
+Package::Package(td::FileFd fd, bool compressed, std::string dictionary)
+    : fd_(std::move(fd)), compressed_(compressed), dictionary_(std::move(dictionary)) {
+  header_size_ = compressed_ ? 8 + td::narrow_cast<td::uint32>(dictionary_.size()) : header_size();
 }
 
 td::Status Package::truncate(td::uint64 size) {
-  TRY_STATUS(fd_.seek(size + header_size()));
-  return fd_.truncate_to_current_position(size + header_size());
+  TRY_STATUS(fd_.seek(size + header_size_));
+  return fd_.truncate_to_current_position(size + header_size_);
 }
 
-td::uint64 Package::append(std::string filename, td::Slice data, bool sync) {
+td::uint32 Package::make_entry_header(td::Slice filename, td::Slice &data, td::BufferSlice &compressed,
+                                      td::uint32 (&header)[3]) const {
   CHECK(data.size() <= max_data_size());
   CHECK(filename.size() <= max_filename_size());
+  td::uint32 header_len = 8;
+  if (compressed_) {
+    // entry is stored raw if compression does not make it smaller
+    header[0] = compressed_entry_header_magic() + (td::narrow_cast<td::uint32>(filename.size()) << 16);
+    header[2] = td::narrow_cast<td::uint32>(data.size());
+    header_len = 12;
+    if (data.size() <= max_compressed_data_size()) {
+      compressed = td::lz4_compress(data, dictionary_);
+      if (compressed.size() < data.size()) {
+        data = compressed.as_slice();
+      }
+    }
+  } else {
+    header[0] = entry_header_magic() + (td::narrow_cast<td::uint32>(filename.size()) << 16);
+  }
+  header[1] = td::narrow_cast<td::uint32>(data.size());
+  return header_len;
+}
+
+td::uint64 Package::append(std::string filename, td::Slice data, bool sync) {
   auto size = fd_.get_size().move_as_ok();
   auto orig_size = size;
-  td::uint32 header[2];
-  header[0] = entry_header_magic() + (td::narrow_cast<td::uint32>(filename.size()) << 16);
-  header[1] = td::narrow_cast<td::uint32>(data.size());
-  CHECK(fd_.pwrite(td::Slice(reinterpret_cast<const td::uint8*>(header), 8), size).move_as_ok() == 8);
-  size += 8;
+  td::uint32 header[3];
+  td::BufferSlice compressed;
+  auto header_len = make_entry_header(filename, data, compressed, header);
+  CHECK(fd_.pwrite(td::Slice(reinterpret_cast<const td::uint8*>(header), header_len), size).move_as_ok() ==
+        header_len);
+  size += header_len;
   CHECK(fd_.pwrite(filename, size).move_as_ok() == filename.size());
   size += filename.size();
   while (data.size() != 0) {
@@ -75,7 +119,26 @@ td::uint64 Package::append(std::string filename, td::Slice data, bool sync) {
   if (sync) {
     fd_.sync().ensure();
   }
-  return orig_size - header_size();
+  return orig_size - header_size_;
+}
+
+td::uint64 Package::append_async(td::actor::ActorId<td::AsyncFileIo> file_io, td::uint64 offset, std::string filename,
+                                 td::Slice data, bool sync, td::Promise<td::Unit> promise) {
+  td::uint32 header[3];
+  td::BufferSlice compressed;
+  auto header_len = make_entry_header(filename, data, compressed, header);
+  // the entry is written with a single request, so the file never contains a partially written header
+  td::BufferSlice entry(header_len + filename.size() + data.size());
+  auto dest = entry.as_slice();
+  dest.copy_from(td::Slice(reinterpret_cast<const td::uint8*>(header), header_len));
+  dest.remove_prefix(header_len);
+  dest.copy_from(filename);
+  dest.remove_prefix(filename.size());
+  dest.copy_from(data);
+  auto end = offset + entry.size();
+  td::actor::send_closure(file_io, &td::AsyncFileIo::pwrite, &fd_, std::move(entry), offset + header_size_, sync,
+                          std::move(promise));
+  return end;
 }
 
 void Package::sync() {
@@ -83,60 +146,101 @@ void Package::sync() {
 }
 
 td::uint64 Package::size() const {
-  return fd_.get_size().move_as_ok() - header_size();
+  return fd_.get_size().move_as_ok() - header_size_;
 }
 
-td::Result<std::pair<std::string, td::BufferSlice>> Package::read(td::uint64 offset) const {
-  offset += header_size();
-
-  td::uint32 header[2];
-  TRY_RESULT(s1, fd_.pread(td::MutableSlice(reinterpret_cast<td::uint8*>(header), 8), offset));
-  if (s1 != 8) {
+td::Result<Package::EntryHeader> Package::parse_entry_header(td::Slice data, td::uint64 offset) const {
+  td::uint32 header[3];
+  td::uint32 header_len = entry_header_size();
+  if (data.size() != header_len) {
     return td::Status::Error(ErrorCode::notready, "too short read");
   }
-  if ((header[0] & 0xffff) != entry_header_magic()) {
+  td::MutableSlice(reinterpret_cast<td::uint8*>(header), header_len).copy_from(data);
+  if ((header[0] & 0xffff) != (compressed_ ? compressed_entry_header_magic() : entry_header_magic())) {
     return td::Status::Error(ErrorCode::notready,
                              PSTRING() << "bad entry magic " << (header[0] & 0xffff) << " offset=" << offset);
   }
-  offset += 8;
-  auto fname_size = header[0] >> 16;
-  auto data_size = header[1];
-
-  std::string fname(fname_size, '\0');
-  TRY_RESULT(s2, fd_.pread(fname, offset));
-  if (s2 != fname_size) {
-    return td::Status::Error(ErrorCode::notready, "too short read (filename)");
-  }
-  offset += fname_size;
+  EntryHeader result;
+  result.filename_size = header[0] >> 16;
+  result.data_size = header[1];
+  result.raw_size = compressed_ ? header[2] : header[1];
+  return result;
+}
 
-  td::BufferSlice data{data_size};
-  TRY_RESULT(s3, fd_.pread(data.as_slice(), offset));
-  if (s3 != data_size) {
+td::Result<std::pair<std::string, td::BufferSlice>> Package::parse_entry_body(const EntryHeader& header,
+                                                                               td::BufferSlice body) const {
+  if (body.size() != header.filename_size + static_cast<td::uint64>(header.data_size)) {
     return td::Status::Error(ErrorCode::notready, "too short read (data)");
   }
-  return std::pair<std::string, td::BufferSlice>{std::move(fname), std::move(data)};
+  std::string fname = body.as_slice().substr(0, header.filename_size).str();
+  body.confirm_read(header.filename_size);
+  if (header.raw_size != header.data_size) {
+    if (header.raw_size > max_data_size()) {
+      return td::Status::Error(ErrorCode::notready, "bad entry size");
+    }
+    TRY_RESULT_PREFIX_ASSIGN(body, td::lz4_decompress(body, td::narrow_cast<int>(header.raw_size), dictionary_),
+                             "broken compressed entry: ");
+    if (body.size() != header.raw_size) {
+      return td::Status::Error(ErrorCode::notready, "broken compressed entry: size mismatch");
+    }
+  }
+  return std::pair<std::string, td::BufferSlice>{std::move(fname), std::move(body)};
+}
+
+td::Result<std::pair<std::string, td::BufferSlice>> Package::read(td::uint64 offset) const {
+  offset += header_size_;
+
+  td::uint8 header_data[12];
+  auto header_slice = td::MutableSlice(header_data, entry_header_size());
+  TRY_RESULT(s1, fd_.pread(header_slice, offset));
+  TRY_RESULT(header, parse_entry_header(header_slice.substr(0, s1), offset));
+  offset += header_slice.size();
+
+  td::BufferSlice body{header.filename_size + static_cast<size_t>(header.data_size)};
+  TRY_RESULT(s2, fd_.pread(body.as_slice(), offset));
+  body.truncate(s2);
+  return parse_entry_body(header, std::move(body));
+}
+
+void Package::read_async(td::actor::ActorId<td::AsyncFileIo> file_io, td::uint64 offset,
+                         td::Promise<std::pair<std::string, td::BufferSlice>> promise) const {
+  offset += header_size_;
+  auto P = td::PromiseCreator::lambda([this, file_io, offset, promise = std::move(promise)](
+                                          td::Result<td::BufferSlice> R) mutable {
+    TRY_RESULT_PROMISE(promise, header_data, std::move(R));
+    TRY_RESULT_PROMISE(promise, header, parse_entry_header(header_data.as_slice(), offset));
+    auto P = td::PromiseCreator::lambda(
+        [this, header, promise = std::move(promise)](td::Result<td::BufferSlice> R) mutable {
+          TRY_RESULT_PROMISE(promise, body, std::move(R));
+          promise.set_result(parse_entry_body(header, std::move(body)));
+        });
+    td::actor::send_closure(file_io, &td::AsyncFileIo::pread, &fd_,
+                            header.filename_size + static_cast<size_t>(header.data_size),
+                            offset + header_data.size(), std::move(P));
+  });
+  td::actor::send_closure(file_io, &td::AsyncFileIo::pread, &fd_, entry_header_size(), offset, std::move(P));
 }
 
 td::Result<td::uint64> Package::advance(td::uint64 offset) {
-  offset += header_size();
+  offset += header_size_;
 
   td::uint32 header[2];
   TRY_RESULT(s1, fd_.pread(td::MutableSlice(reinterpret_cast<td::uint8*>(header), 8), offset));
   if (s1 != 8) {
     return td::Status::Error(ErrorCode::notready, "too short read");
   }
-  if ((header[0] & 0xffff) != entry_header_magic()) {
+  if ((header[0] & 0xffff) != (compressed_ ? compressed_entry_header_magic() : entry_header_magic())) {
     return td::Status::Error(ErrorCode::notready, "bad entry magic");
   }
 
-  offset += 8 + (header[0] >> 16) + header[1];
+  offset += (compressed_ ? 12 : 8) + (header[0] >> 16) + header[1];
   if (offset > static_cast<td::uint64>(fd_.get_size().move_as_ok())) {
     return td::Status::Error(ErrorCode::notready, "truncated read");
   }
-  return offset - header_size();
+  return offset - header_size_;
 }
 
-td::Result<Package> Package::open(std::string path, bool read_only, bool create) {
+td::Result<Package> Package::open(std::string path, bool read_only, bool create, const Compression *compression) {
   td::uint32 flags = td::FileFd::Flags::Read;
   if (!read_only) {
     flags |= td::FileFd::Write;
@@ -152,34 +256,60 @@ td::Result<Package> Package::open(std::string path, bool read_only, bool create)
     if (!create) {
       return td::Status::Error(ErrorCode::notready, "db is too short");
     }
-    td::uint32 header[1];
-    header[0] = package_header_magic();
-    TRY_RESULT(s, fd.pwrite(td::Slice(reinterpret_cast<const td::uint8*>(header), header_size()), size));
-    if (s != header_size()) {
-      return td::Status::Error(ErrorCode::notready, "db write is short");
+    if (!compression) {
+      td::uint32 header[1];
+      header[0] = package_header_magic();
+      TRY_RESULT(s, fd.pwrite(td::Slice(reinterpret_cast<const td::uint8*>(header), header_size()), size));
+      if (s != header_size()) {
+        return td::Status::Error(ErrorCode::notready, "db write is short");
+      }
+      return Package{std::move(fd)};
     }
-  } else {
-    td::uint32 header[1];
-    TRY_RESULT(s, fd.pread(td::MutableSlice(reinterpret_cast<td::uint8*>(header), header_size()), 0));
-    if (s != header_size()) {
-      return td::Status::Error(ErrorCode::notready, "db read failed");
+    if (compression->dictionary.size() > max_dictionary_size()) {
+      return td::Status::Error(ErrorCode::error, "compression dictionary is too big");
     }
-    if (header[0] != package_header_magic()) {
-      return td::Status::Error(ErrorCode::notready, "magic mismatch");
+    td::uint32 header[2];
+    header[0] = compressed_package_header_magic();
+    header[1] = td::narrow_cast<td::uint32>(compression->dictionary.size());
+    std::string data = td::Slice(reinterpret_cast<const td::uint8*>(header), 8).str() + compression->dictionary;
+    TRY_RESULT(s, fd.pwrite(data, 0));
+    if (s != data.size()) {
+      return td::Status::Error(ErrorCode::notready, "db write is short");
     }
+    return Package{std::move(fd), true, compression->dictionary};
+  }
+  td::uint32 header[2];
+  TRY_RESULT(s, fd.pread(td::MutableSlice(reinterpret_cast<td::uint8*>(header), header_size()), 0));
+  if (s != header_size()) {
+    return td::Status::Error(ErrorCode::notready, "db read failed");
+  }
+  if (header[0] == package_header_magic()) {
+    return Package{std::move(fd)};
+  }
+  if (header[0] != compressed_package_header_magic()) {
+    return td::Status::Error(ErrorCode::notready, "magic mismatch");
   }
-  return Package{std::move(fd)};
+  TRY_RESULT(s2, fd.pread(td::MutableSlice(reinterpret_cast<td::uint8*>(header + 1), 4), header_size()));
+  if (s2 != 4 || header[1] > max_dictionary_size() || 8 + header[1] > size) {
+    return td::Status::Error(ErrorCode::notready, "bad compressed package header");
+  }
+  std::string dictionary(header[1], '\0');
+  TRY_RESULT(s3, fd.pread(dictionary, 8));
+  if (s3 != dictionary.size()) {
+    return td::Status::Error(ErrorCode::notready, "db read failed");
+  }
+  return Package{std::move(fd), true, std::move(dictionary)};
 }
 
 void Package::iterate(std::function<bool(std::string, td::BufferSlice, td::uint64)> func) {
   td::uint64 p = 0;
 
   td::uint64 size = fd_.get_size().move_as_ok();
-  if (size < header_size()) {
+  if (size < header_size_) {
     LOG(ERROR) << "too short archive";
     return;
   }
-  size -= header_size();
+  size -= header_size_;
   while (p != size) {
     auto R = read(p);
     if (R.is_error()) {
@@ -195,6 +325,96 @@ void Package::iterate(std::function<bool(std::string, td::BufferSlice, td::uint6
   }
 }
 
+void UncompressedPackageReader::update_index() {
+  if (uncompressed_end_ == 0) {
+    uncompressed_end_ = header_size();
+  }
+  auto size = package_->size();
+  while (end_ < size) {
+    // the last entries may still be in flight
+    td::uint8 header_data[12];
+    auto header_slice = td::MutableSlice(header_data, package_->entry_header_size());
+    auto R = package_->fd_.pread(header_slice, end_ + package_->header_size_);
+    if (R.is_error()) {
+      break;
+    }
+    auto H = package_->parse_entry_header(header_slice.substr(0, R.move_as_ok()), end_);
+    if (H.is_error()) {
+      break;
+    }
+    auto header = H.move_as_ok();
+    auto next = end_ + header_slice.size() + header.filename_size + header.data_size;
+    if (next > size) {
+      break;
+    }
+    entries_.push_back(Entry{end_, uncompressed_end_});
+    uncompressed_end_ += 8 + header.filename_size + static_cast<td::uint64>(header.raw_size);
+    end_ = next;
+  }
+}
+
+td::Result<td::Slice> UncompressedPackageReader::get_entry(size_t i) {
+  for (auto it = cache_.begin(); it != cache_.end(); ++it) {
+    if (it->first == i) {
+      std::rotate(it, it + 1, cache_.end());
+      return cache_.back().second.as_slice();
+    }
+  }
+  TRY_RESULT(entry, package_->read(entries_[i].offset));
+  td::uint32 header[2];
+  header[0] = entry_header_magic() + (td::narrow_cast<td::uint32>(entry.first.size()) << 16);
+  header[1] = td::narrow_cast<td::uint32>(entry.second.size());
+  td::BufferSlice data(8 + entry.first.size() + entry.second.size());
+  auto dest = data.as_slice();
+  dest.copy_from(td::Slice(reinterpret_cast<const td::uint8 *>(header), 8));
+  dest.remove_prefix(8);
+  dest.copy_from(entry.first);
+  dest.remove_prefix(entry.first.size());
+  dest.copy_from(entry.second);
+  if (cache_.size() == CACHE_SIZE) {
+    cache_.erase(cache_.begin());
+  }
+  cache_.emplace_back(i, std::move(data));
+  return cache_.back().second.as_slice();
+}
+
+td::Result<td::BufferSlice> UncompressedPackageReader::read(td::uint64 offset, td::uint32 limit) {
+  if (!package_->is_compressed()) {
+    return td::Status::Error(ErrorCode::error, "package is not compressed");
+  }
+  update_index();
+  if (offset >= uncompressed_end_) {
+    return td::BufferSlice();
+  }
+  td::BufferSlice res(static_cast<size_t>(std::min<td::uint64>(limit, uncompressed_end_ - offset)));
+  auto dest = res.as_slice();
+  if (offset < header_size()) {
+    td::uint32 magic = package_header_magic();
+    auto part = td::Slice(reinterpret_cast<const td::uint8 *>(&magic), header_size())
+                    .substr(static_cast<size_t>(offset))
+                    .truncate(dest.size());
+    dest.copy_from(part);
+    dest.remove_prefix(part.size());
+    offset += part.size();
+  }
+  while (!dest.empty()) {
+    auto it = std::upper_bound(
+        entries_.begin(), entries_.end(), offset,
+        [](td::uint64 offset, const Entry &entry) { return offset < entry.uncompressed_offset; });
+    CHECK(it != entries_.begin());
+    size_t i = it - entries_.begin() - 1;
+    TRY_RESULT(entry, get_entry(i));
+    auto part = entry.substr(static_cast<size_t>(offset - entries_[i].uncompressed_offset)).truncate(dest.size());
+    if (part.empty()) {
+      return td::Status::Error(ErrorCode::error, "entry size mismatch");
+    }
+    dest.copy_from(part);
+    dest.remove_prefix(part.size());
+    offset += part.size();
+  }
+  return std::move(res);
+}
+
 Package::~Package() {
   fd_.close();
 }
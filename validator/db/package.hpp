@@ -19,6 +19,7 @@
 #pragma once
 
 #include "td/actor/actor.h"
+#include "td/db/utils/AsyncFileIo.h"
 #include "td/utils/port/FileFd.h"
 #include "td/utils/buffer.h"
 
@@ -26,18 +27,35 @@ namespace ton {
 
 class Package {
  public:
-  static td::Result<Package> open(std::string path, bool read_only = false, bool create = false);
+  // Packages created with compression store every entry as an independent LZ4 block, optionally compressed against
+  // a dictionary kept in the package header. Offsets returned by append() still point at entry headers, so read()
+  // needs a single seek regardless of the format. The format of an existing package is detected from its header.
+  struct Compression {
+    std::string dictionary;
+  };
+
+  static td::Result<Package> open(std::string path, bool read_only = false, bool create = false,
+                                  const Compression *compression = nullptr);
 
   Package(td::FileFd fd);
+  Package(td::FileFd fd, bool compressed, std::string dictionary);
   Package(Package &&p) = default;
   ~Package();
 
   td::Status truncate(td::uint64 size);
 
   td::uint64 append(std::string filename, td::Slice data, bool sync = true);
+  // Writes the entry at offset and returns the end of the entry; the promise is set once the entry is written.
+  // Entries written one after another may reach the disk in any order, so the caller reserves space for them:
+  // size() doesn't cover entries in flight. The package must stay alive until the promise is set, the same applies
+  // to read_async.
+  td::uint64 append_async(td::actor::ActorId<td::AsyncFileIo> file_io, td::uint64 offset, std::string filename,
+                          td::Slice data, bool sync, td::Promise<td::Unit> promise);
   void sync();
   td::uint64 size() const;
   td::Result<std::pair<std::string, td::BufferSlice>> read(td::uint64 offset) const;
+  void read_async(td::actor::ActorId<td::AsyncFileIo> file_io, td::uint64 offset,
+                  td::Promise<std::pair<std::string, td::BufferSlice>> promise) const;
 
   td::Result<td::uint64> advance(td::uint64 offset);
   void iterate(std::function<bool(std::string, td::BufferSlice, td::uint64)> func);
@@ -45,9 +63,60 @@ class Package {
   td::FileFd &fd() {
     return fd_;
   }
+  bool is_compressed() const {
+    return compressed_;
+  }
 
  private:
+  struct EntryHeader {
+    td::uint32 filename_size;
+    td::uint32 data_size;
+    td::uint32 raw_size;  // differs from data_size for compressed entries
+  };
+
+  friend class UncompressedPackageReader;
+
   td::FileFd fd_;
+  bool compressed_ = false;
+  std::string dictionary_;
+  td::uint32 header_size_;
+
+  td::uint32 entry_header_size() const {
+    return compressed_ ? 12 : 8;
+  }
+  td::uint32 make_entry_header(td::Slice filename, td::Slice &data, td::BufferSlice &compressed,
+                               td::uint32 (&header)[3]) const;
+  td::Result<EntryHeader> parse_entry_header(td::Slice data, td::uint64 offset) const;
+  td::Result<std::pair<std::string, td::BufferSlice>> parse_entry_body(const EntryHeader &header,
+                                                                       td::BufferSlice body) const;
+};
+
+// Presents a compressed package as a package of the original format with the same entries, for peers that download
+// packages byte by byte and can't read the compressed format. Entries are decompressed on the fly: their offsets are
+// indexed as the package grows, and the last few decompressed entries are kept, as consecutive slices share entries
+class UncompressedPackageReader {
+ public:
+  explicit UncompressedPackageReader(std::shared_ptr<Package> package) : package_(std::move(package)) {
+  }
+
+  // up to limit bytes of the package in the original format starting from offset, fewer at the end of the package
+  td::Result<td::BufferSlice> read(td::uint64 offset, td::uint32 limit);
+
+ private:
+  static constexpr size_t CACHE_SIZE = 4;
+
+  struct Entry {
+    td::uint64 offset;               // in the compressed package
+    td::uint64 uncompressed_offset;  // in the original format, from the beginning of the file
+  };
+  std::shared_ptr<Package> package_;
+  std::vector<Entry> entries_;
+  td::uint64 end_ = 0;  // offset of the first entry that is not indexed yet
+  td::uint64 uncompressed_end_ = 0;
+  std::vector<std::pair<size_t, td::BufferSlice>> cache_;  // entries in the original format, least recently used first
+
+  void update_index();
+  td::Result<td::Slice> get_entry(size_t i);
 };
 
 }  // namespace ton
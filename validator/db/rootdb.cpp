@@ -228,6 +228,16 @@ void RootDb::get_block_candidate_by_block_id(BlockIdExt id, td::Promise<BlockCan
 
 void RootDb::store_block_state(BlockHandle handle, td::Ref<ShardState> state,
                                td::Promise<td::Ref<ShardState>> promise) {
+  store_block_state_impl(std::move(handle), std::move(state), false, std::move(promise));
+}
+
+void RootDb::import_block_state(BlockHandle handle, td::Ref<ShardState> state,
+                                td::Promise<td::Ref<ShardState>> promise) {
+  store_block_state_impl(std::move(handle), std::move(state), true, std::move(promise));
+}
+
+void RootDb::store_block_state_impl(BlockHandle handle, td::Ref<ShardState> state, bool bulk_import,
+                                    td::Promise<td::Ref<ShardState>> promise) {
   if (handle->moved_to_archive()) {
     promise.set_value(std::move(state));
     return;
@@ -253,7 +263,11 @@ void RootDb::store_block_state(BlockHandle handle, td::Ref<ShardState> state,
         td::actor::send_closure(b, &ArchiveManager::update_handle, std::move(handle), std::move(P));
       }
     });
-    td::actor::send_closure(cell_db_, &CellDb::store_cell, handle->id(), state->root_cell(), std::move(P));
+    if (bulk_import) {
+      td::actor::send_closure(cell_db_, &CellDb::import_cell, handle->id(), state->root_cell(), std::move(P));
+    } else {
+      td::actor::send_closure(cell_db_, &CellDb::store_cell, handle->id(), state->root_cell(), std::move(P));
+    }
   } else {
     get_block_state(handle, std::move(promise));
   }
@@ -347,6 +361,15 @@ void RootDb::try_get_static_file(FileHash file_hash, td::Promise<td::BufferSlice
 }
 
 void RootDb::apply_block(BlockHandle handle, td::Promise<td::Unit> promise) {
+  if (!tx_index_db_.empty()) {
+    promise = td::PromiseCreator::lambda(
+        [promise = std::move(promise), handle, tx_index_db = tx_index_db_.get()](td::Result<td::Unit> R) mutable {
+          if (R.is_ok()) {
+            td::actor::send_closure(tx_index_db, &TxIndexDb::add_block, handle);
+          }
+          promise.set_result(std::move(R));
+        });
+  }
   td::actor::create_actor<BlockArchiver>("archiver", std::move(handle), archive_db_.get(), actor_id(this),
                                          std::move(promise))
       .release();
@@ -360,6 +383,16 @@ void RootDb::get_block_by_unix_time(AccountIdPrefixFull account, UnixTime ts, td
   td::actor::send_closure(archive_db_, &ArchiveManager::get_block_by_unix_time, account, ts, std::move(promise));
 }
 
+void RootDb::get_account_transactions(WorkchainId workchain, StdSmcAddress addr, LogicalTime lt, Bits256 hash,
+                                      td::uint32 count, td::Promise<std::vector<AccountTransactionRef>> promise) {
+  if (tx_index_db_.empty()) {
+    promise.set_error(td::Status::Error(ErrorCode::notready, "transaction index is disabled"));
+    return;
+  }
+  td::actor::send_closure(tx_index_db_, &TxIndexDb::get_account_transactions, workchain, addr, lt, hash, count,
+                          std::move(promise));
+}
+
 void RootDb::get_block_by_seqno(AccountIdPrefixFull account, BlockSeqno seqno, td::Promise<ConstBlockHandle> promise) {
   td::actor::send_closure(archive_db_, &ArchiveManager::get_block_by_seqno, account, seqno, std::move(promise));
 }
@@ -419,6 +452,9 @@ void RootDb::start_up() {
   state_db_ = td::actor::create_actor<StateDb>("statedb", actor_id(this), root_path_ + "/state/");
   static_files_db_ = td::actor::create_actor<StaticFilesDb>("staticfilesdb", actor_id(this), root_path_ + "/static/");
   archive_db_ = td::actor::create_actor<ArchiveManager>("archive", actor_id(this), root_path_, opts_);
+  if (opts_->get_tx_index_enabled()) {
+    tx_index_db_ = td::actor::create_actor<TxIndexDb>("txindex", actor_id(this), root_path_ + "/txindex/");
+  }
 }
 
 void RootDb::archive(BlockHandle handle, td::Promise<td::Unit> promise) {
@@ -447,6 +483,9 @@ void RootDb::truncate(BlockSeqno seqno, ConstBlockHandle handle, td::Promise<td:
 
   td::actor::send_closure(archive_db_, &ArchiveManager::truncate, seqno, handle, ig.get_promise());
   td::actor::send_closure(state_db_, &StateDb::truncate, seqno, handle, ig.get_promise());
+  if (!tx_index_db_.empty()) {
+    td::actor::send_closure(tx_index_db_, &TxIndexDb::truncate, seqno, ig.get_promise());
+  }
 }
 
 void RootDb::add_key_block_proof(td::Ref<Proof> proof, td::Promise<td::Unit> promise) {
@@ -508,9 +547,9 @@ void RootDb::get_archive_id(BlockSeqno masterchain_seqno, ShardIdFull shard_pref
                           std::move(promise));
 }
 
-void RootDb::get_archive_slice(td::uint64 archive_id, td::uint64 offset, td::uint32 limit,
+void RootDb::get_archive_slice(td::uint64 archive_id, td::uint64 offset, td::uint32 limit, bool compressed,
                                td::Promise<td::BufferSlice> promise) {
-  td::actor::send_closure(archive_db_, &ArchiveManager::get_archive_slice, archive_id, offset, limit,
+  td::actor::send_closure(archive_db_, &ArchiveManager::get_archive_slice, archive_id, offset, limit, compressed,
                           std::move(promise));
 }
 
@@ -520,6 +559,10 @@ void RootDb::set_async_mode(bool mode, td::Promise<td::Unit> promise) {
 
 void RootDb::run_gc(UnixTime mc_ts, UnixTime gc_ts, UnixTime archive_ttl) {
   td::actor::send_closure(archive_db_, &ArchiveManager::run_gc, mc_ts, gc_ts, archive_ttl);
+  if (!tx_index_db_.empty() && archive_ttl > 0 && gc_ts > archive_ttl) {
+    // blocks older than this are removed from the archive, so their transactions can't be served anyway
+    td::actor::send_closure(tx_index_db_, &TxIndexDb::prune, gc_ts - archive_ttl);
+  }
 }
 
 void RootDb::add_persistent_state_description(td::Ref<PersistentStateDescription> desc, td::Promise<td::Unit> promise) {
@@ -26,6 +26,7 @@
 #include "statedb.hpp"
 #include "staticfilesdb.hpp"
 #include "archive-manager.hpp"
+#include "txindex.hpp"
 #include "validator.h"
 
 namespace ton {
@@ -62,6 +63,8 @@ class RootDb : public Db {
 
   void store_block_state(BlockHandle handle, td::Ref<ShardState> state,
                          td::Promise<td::Ref<ShardState>> promise) override;
+  void import_block_state(BlockHandle handle, td::Ref<ShardState> state,
+                          td::Promise<td::Ref<ShardState>> promise) override;
   void get_block_state(ConstBlockHandle handle, td::Promise<td::Ref<ShardState>> promise) override;
   void get_cell_db_reader(td::Promise<std::shared_ptr<vm::CellDbReader>> promise) override;
 
@@ -93,6 +96,8 @@ class RootDb : public Db {
   void apply_block(BlockHandle handle, td::Promise<td::Unit> promise) override;
   void get_block_by_lt(AccountIdPrefixFull account, LogicalTime lt, td::Promise<ConstBlockHandle> promise) override;
   void get_block_by_unix_time(AccountIdPrefixFull account, UnixTime ts, td::Promise<ConstBlockHandle> promise) override;
+  void get_account_transactions(WorkchainId workchain, StdSmcAddress addr, LogicalTime lt, Bits256 hash,
+                                td::uint32 count, td::Promise<std::vector<AccountTransactionRef>> promise) override;
   void get_block_by_seqno(AccountIdPrefixFull account, BlockSeqno seqno,
                           td::Promise<ConstBlockHandle> promise) override;
 
@@ -133,7 +138,7 @@ class RootDb : public Db {
   void check_key_block_proof_link_exists(BlockIdExt block_id, td::Promise<bool> promise) override;
 
   void get_archive_id(BlockSeqno masterchain_seqno, ShardIdFull shard_prefix, td::Promise<td::uint64> promise) override;
-  void get_archive_slice(td::uint64 archive_id, td::uint64 offset, td::uint32 limit,
+  void get_archive_slice(td::uint64 archive_id, td::uint64 offset, td::uint32 limit, bool compressed,
                          td::Promise<td::BufferSlice> promise) override;
   void set_async_mode(bool mode, td::Promise<td::Unit> promise) override;
 
@@ -151,6 +156,10 @@ class RootDb : public Db {
   td::actor::ActorOwn<StateDb> state_db_;
   td::actor::ActorOwn<StaticFilesDb> static_files_db_;
   td::actor::ActorOwn<ArchiveManager> archive_db_;
+  td::actor::ActorOwn<TxIndexDb> tx_index_db_;
+
+  void store_block_state_impl(BlockHandle handle, td::Ref<ShardState> state, bool bulk_import,
+                              td::Promise<td::Ref<ShardState>> promise);
 };
 
 }  // namespace validator
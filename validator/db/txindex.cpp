@@ -0,0 +1,282 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#include "txindex.hpp"
+#include "rootdb.hpp"
+#include "td/db/RocksDb.h"
+#include "td/utils/tl_parsers.h"
+#include "td/utils/tl_storers.h"
+#include "block/block.h"
+#include "block/block-auto.h"
+#include "block/block-parse.h"
+#include "vm/dict.h"
+
+namespace ton {
+
+namespace validator {
+
+namespace {
+
+constexpr size_t TX_INDEX_KEY_SIZE = 4 + 32 + 8;
+constexpr size_t TX_INDEX_BLOCK_KEY_SIZE = 1 + 4 + 4 + 8 + 4 + 32;
+constexpr size_t TX_INDEX_VALUE_SIZE = 4 + 8 + 4 + 32 + 32 + 32 + 8 + 32;
+
+}  // namespace
+
+std::string TxIndex::serialize_key(WorkchainId workchain, const StdSmcAddress &addr, LogicalTime lt) {
+  std::string key(TX_INDEX_KEY_SIZE, '\0');
+  td::TlStorerUnsafe storer(reinterpret_cast<unsigned char *>(&key[0]));
+  storer.store_int(workchain);
+  storer.store_slice(addr.as_slice());
+  storer.store_long(lt);
+  return key;
+}
+
+std::string TxIndex::serialize_block_key_prefix(UnixTime gen_utime) {
+  // big-endian time, so that blocks are ordered by time
+  std::string key(5, '\0');
+  key[0] = 'b';
+  for (int i = 0; i < 4; i++) {
+    key[1 + i] = static_cast<char>(gen_utime >> (24 - 8 * i));
+  }
+  return key;
+}
+
+std::string TxIndex::serialize_block_key(UnixTime gen_utime, const BlockIdExt &block_id) {
+  std::string key = serialize_block_key_prefix(gen_utime);
+  key.resize(TX_INDEX_BLOCK_KEY_SIZE);
+  td::TlStorerUnsafe storer(reinterpret_cast<unsigned char *>(&key[5]));
+  storer.store_int(block_id.id.workchain);
+  storer.store_long(block_id.id.shard);
+  storer.store_int(block_id.id.seqno);
+  storer.store_slice(block_id.root_hash.as_slice());
+  return key;
+}
+
+std::string TxIndex::serialize_value(const AccountTransactionRef &tx) {
+  std::string value(TX_INDEX_VALUE_SIZE, '\0');
+  td::TlStorerUnsafe storer(reinterpret_cast<unsigned char *>(&value[0]));
+  storer.store_int(tx.block_id.id.workchain);
+  storer.store_long(tx.block_id.id.shard);
+  storer.store_int(tx.block_id.id.seqno);
+  storer.store_slice(tx.block_id.root_hash.as_slice());
+  storer.store_slice(tx.block_id.file_hash.as_slice());
+  storer.store_slice(tx.hash.as_slice());
+  storer.store_long(tx.prev_lt);
+  storer.store_slice(tx.prev_hash.as_slice());
+  return value;
+}
+
+td::Result<AccountTransactionRef> TxIndex::parse_value(td::Slice data) {
+  td::TlParser parser(data);
+  AccountTransactionRef tx;
+  auto fetch_bits256 = [&](Bits256 &x) { x.as_slice().copy_from(parser.fetch_string_raw<td::Slice>(32)); };
+  tx.block_id.id.workchain = parser.fetch_int();
+  tx.block_id.id.shard = parser.fetch_long();
+  tx.block_id.id.seqno = parser.fetch_int();
+  fetch_bits256(tx.block_id.root_hash);
+  fetch_bits256(tx.block_id.file_hash);
+  fetch_bits256(tx.hash);
+  tx.prev_lt = parser.fetch_long();
+  fetch_bits256(tx.prev_hash);
+  parser.fetch_end();
+  TRY_STATUS(parser.get_status());
+  return tx;
+}
+
+td::Result<std::vector<TxIndex::Transaction>> TxIndex::extract_transactions(const BlockIdExt &block_id,
+                                                                             td::Ref<vm::Cell> root,
+                                                                             UnixTime &gen_utime) {
+  std::vector<Transaction> result;
+  try {
+    block::gen::Block::Record blk;
+    block::gen::BlockInfo::Record info;
+    block::gen::BlockExtra::Record extra;
+    if (!(tlb::unpack_cell(root, blk) && tlb::unpack_cell(blk.info, info) &&
+          tlb::unpack_cell(std::move(blk.extra), extra))) {
+      return td::Status::Error("cannot unpack block extra");
+    }
+    gen_utime = info.gen_utime;
+    vm::AugmentedDictionary acc_dict{vm::load_cell_slice_ref(extra.account_blocks), 256,
+                                     block::tlb::aug_ShardAccountBlocks};
+    bool ok = acc_dict.check_for_each_extra([&](td::Ref<vm::CellSlice> value, td::Ref<vm::CellSlice>,
+                                                td::ConstBitPtr, int) {
+      block::gen::AccountBlock::Record acc_blk;
+      if (!tlb::csr_unpack(std::move(value), acc_blk)) {
+        return false;
+      }
+      StdSmcAddress addr = acc_blk.account_addr;
+      vm::AugmentedDictionary trans_dict{vm::DictNonEmpty(), std::move(acc_blk.transactions), 64,
+                                         block::tlb::aug_AccountTransactions};
+      return trans_dict.check_for_each_extra([&](td::Ref<vm::CellSlice> tvalue, td::Ref<vm::CellSlice>,
+                                                 td::ConstBitPtr key, int) {
+        auto trans_root = tvalue->prefetch_ref();
+        block::gen::Transaction::Record trans;
+        if (trans_root.is_null() || !tlb::unpack_cell(trans_root, trans)) {
+          return false;
+        }
+        AccountTransactionRef tx{block_id, key.get_uint(64), trans_root->get_hash().bits(), trans.prev_trans_lt,
+                                 trans.prev_trans_hash};
+        result.push_back(Transaction{addr, std::move(tx)});
+        return true;
+      });
+    });
+    if (!ok) {
+      return td::Status::Error("invalid account blocks");
+    }
+  } catch (vm::VmError &err) {
+    return td::Status::Error(PSTRING() << "error while parsing account blocks: " << err.get_msg());
+  }
+  return result;
+}
+
+td::Status TxIndex::add_block(const BlockIdExt &block_id, UnixTime gen_utime, BlockSeqno mc_seqno,
+                              const std::vector<Transaction> &transactions) {
+  std::string block_value(4, '\0');
+  td::TlStorerUnsafe storer(reinterpret_cast<unsigned char *>(&block_value[0]));
+  storer.store_int(mc_seqno);
+  TRY_STATUS(kv_->begin_write_batch());
+  for (auto &entry : transactions) {
+    auto key = serialize_key(block_id.id.workchain, entry.addr, entry.tx.lt);
+    TRY_STATUS(kv_->set(key, serialize_value(entry.tx)));
+    block_value += key;
+  }
+  TRY_STATUS(kv_->set(serialize_block_key(gen_utime, block_id), block_value));
+  return kv_->commit_write_batch();
+}
+
+td::Result<std::vector<AccountTransactionRef>> TxIndex::get_account_transactions(WorkchainId workchain,
+                                                                                 const StdSmcAddress &addr,
+                                                                                 LogicalTime lt, Bits256 hash,
+                                                                                 td::uint32 count) {
+  std::vector<AccountTransactionRef> result;
+  std::string value;
+  while (result.size() < count && lt != 0) {
+    TRY_RESULT(status, kv_->get(serialize_key(workchain, addr, lt), value));
+    if (status == td::KeyValue::GetStatus::NotFound) {
+      break;
+    }
+    auto r_tx = parse_value(value);
+    if (r_tx.is_error() || r_tx.ok().hash != hash) {
+      // entry of a block which is not in the chain anymore
+      break;
+    }
+    auto tx = r_tx.move_as_ok();
+    tx.lt = lt;
+    lt = tx.prev_lt;
+    hash = tx.prev_hash;
+    result.push_back(std::move(tx));
+  }
+  return result;
+}
+
+td::Status TxIndex::erase_blocks(const std::vector<std::pair<std::string, std::string>> &blocks) {
+  if (blocks.empty()) {
+    return td::Status::OK();
+  }
+  TRY_STATUS(kv_->begin_write_batch());
+  for (auto &block : blocks) {
+    td::Slice keys = td::Slice(block.second).substr(4);
+    for (size_t i = 0; i + TX_INDEX_KEY_SIZE <= keys.size(); i += TX_INDEX_KEY_SIZE) {
+      TRY_STATUS(kv_->erase(keys.substr(i, TX_INDEX_KEY_SIZE)));
+    }
+    TRY_STATUS(kv_->erase(block.first));
+  }
+  return kv_->commit_write_batch();
+}
+
+td::Status TxIndex::prune(UnixTime gen_utime) {
+  std::vector<std::pair<std::string, std::string>> blocks;
+  TRY_STATUS(kv_->for_each_in_range(serialize_block_key_prefix(0), serialize_block_key_prefix(gen_utime),
+                                    [&](td::Slice key, td::Slice value) {
+                                      if (key.size() == TX_INDEX_BLOCK_KEY_SIZE && value.size() >= 4) {
+                                        blocks.emplace_back(key.str(), value.str());
+                                      }
+                                      return td::Status::OK();
+                                    }));
+  return erase_blocks(blocks);
+}
+
+td::Status TxIndex::truncate(BlockSeqno mc_seqno) {
+  std::vector<std::pair<std::string, std::string>> blocks;
+  TRY_STATUS(kv_->for_each_in_range("b", "c", [&](td::Slice key, td::Slice value) {
+    if (key.size() == TX_INDEX_BLOCK_KEY_SIZE && value.size() >= 4 &&
+        static_cast<BlockSeqno>(td::TlParser(value).fetch_int()) > mc_seqno) {
+      blocks.emplace_back(key.str(), value.str());
+    }
+    return td::Status::OK();
+  }));
+  return erase_blocks(blocks);
+}
+
+TxIndexDb::TxIndexDb(td::actor::ActorId<RootDb> root_db, std::string db_path)
+    : root_db_(root_db), db_path_(std::move(db_path)) {
+}
+
+void TxIndexDb::start_up() {
+  index_ = TxIndex{std::make_shared<td::RocksDb>(td::RocksDb::open(db_path_).move_as_ok())};
+}
+
+void TxIndexDb::add_block(ConstBlockHandle handle) {
+  if (!handle->received()) {
+    return;
+  }
+  td::actor::send_closure(root_db_, &RootDb::get_block_data, handle,
+                          [SelfId = actor_id(this), handle](td::Result<td::Ref<BlockData>> R) {
+                            td::actor::send_closure(SelfId, &TxIndexDb::got_block_data, handle, std::move(R));
+                          });
+}
+
+void TxIndexDb::got_block_data(ConstBlockHandle handle, td::Result<td::Ref<BlockData>> R) {
+  auto S = [&]() -> td::Status {
+    TRY_RESULT(block, std::move(R));
+    UnixTime gen_utime = 0;
+    TRY_RESULT(transactions, TxIndex::extract_transactions(handle->id(), block->root_cell(), gen_utime));
+    BlockSeqno mc_seqno = handle->inited_masterchain_ref_block() ? handle->masterchain_ref_block() : 0;
+    return index_.value().add_block(handle->id(), gen_utime, mc_seqno, transactions);
+  }();
+  if (S.is_error()) {
+    VLOG(VALIDATOR_WARNING) << "cannot index transactions of block " << handle->id().to_str() << ": " << S;
+  }
+}
+
+void TxIndexDb::get_account_transactions(WorkchainId workchain, StdSmcAddress addr, LogicalTime lt, Bits256 hash,
+                                         td::uint32 count, td::Promise<std::vector<AccountTransactionRef>> promise) {
+  TRY_RESULT_PROMISE(promise, result, index_.value().get_account_transactions(workchain, addr, lt, hash, count));
+  if (result.empty()) {
+    promise.set_error(td::Status::Error(ErrorCode::notready, "transaction is not in the index"));
+    return;
+  }
+  promise.set_value(std::move(result));
+}
+
+void TxIndexDb::prune(UnixTime gen_utime) {
+  auto S = index_.value().prune(gen_utime);
+  if (S.is_error()) {
+    VLOG(VALIDATOR_WARNING) << "cannot prune transaction index: " << S;
+  }
+}
+
+void TxIndexDb::truncate(BlockSeqno seqno, td::Promise<td::Unit> promise) {
+  TRY_STATUS_PROMISE(promise, index_.value().truncate(seqno));
+  promise.set_value(td::Unit());
+}
+
+}  // namespace validator
+
+}  // namespace ton
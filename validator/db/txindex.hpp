@@ -0,0 +1,97 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#pragma once
+
+#include "td/actor/actor.h"
+#include "td/db/KeyValue.h"
+#include "td/utils/optional.h"
+#include "ton/ton-types.h"
+
+#include "validator/interfaces/db.h"
+
+namespace ton {
+
+namespace validator {
+
+class RootDb;
+
+// Optional index of account transactions of applied blocks: (account, lt) -> (block id, tx hash, previous tx).
+// Allows getTransactions to locate a chain of transactions without looking up a block by lt for every step.
+// Every block also gets a record keyed by its generation time, which lists the keys of its transactions,
+// so that the index can follow archive GC and truncation.
+class TxIndex {
+ public:
+  explicit TxIndex(std::shared_ptr<td::KeyValue> kv) : kv_(std::move(kv)) {
+  }
+
+  struct Transaction {
+    StdSmcAddress addr;
+    AccountTransactionRef tx;
+  };
+  static td::Result<std::vector<Transaction>> extract_transactions(const BlockIdExt &block_id, td::Ref<vm::Cell> root,
+                                                                   UnixTime &gen_utime);
+
+  // mc_seqno is the masterchain block which refers the block, it is used by truncate
+  td::Status add_block(const BlockIdExt &block_id, UnixTime gen_utime, BlockSeqno mc_seqno,
+                       const std::vector<Transaction> &transactions);
+  // Chain of at most count transactions starting at (lt, hash). Stops at the first entry which is missing
+  // or doesn't match the expected hash (e.g. the block is not in the chain anymore)
+  td::Result<std::vector<AccountTransactionRef>> get_account_transactions(WorkchainId workchain,
+                                                                         const StdSmcAddress &addr, LogicalTime lt,
+                                                                         Bits256 hash, td::uint32 count);
+  // Removes blocks generated before gen_utime
+  td::Status prune(UnixTime gen_utime);
+  // Removes blocks referred by masterchain blocks after mc_seqno
+  td::Status truncate(BlockSeqno mc_seqno);
+
+ private:
+  std::shared_ptr<td::KeyValue> kv_;
+
+  static std::string serialize_key(WorkchainId workchain, const StdSmcAddress &addr, LogicalTime lt);
+  static std::string serialize_block_key_prefix(UnixTime gen_utime);
+  static std::string serialize_block_key(UnixTime gen_utime, const BlockIdExt &block_id);
+  static std::string serialize_value(const AccountTransactionRef &tx);
+  static td::Result<AccountTransactionRef> parse_value(td::Slice data);
+  td::Status erase_blocks(const std::vector<std::pair<std::string, std::string>> &blocks);
+};
+
+class TxIndexDb : public td::actor::Actor {
+ public:
+  TxIndexDb(td::actor::ActorId<RootDb> root_db, std::string path);
+
+  void start_up() override;
+
+  void add_block(ConstBlockHandle handle);
+  void get_account_transactions(WorkchainId workchain, StdSmcAddress addr, LogicalTime lt, Bits256 hash,
+                                td::uint32 count, td::Promise<std::vector<AccountTransactionRef>> promise);
+  void prune(UnixTime gen_utime);
+  void truncate(BlockSeqno seqno, td::Promise<td::Unit> promise);
+
+ private:
+  td::optional<TxIndex> index_;
+
+  td::actor::ActorId<RootDb> root_db_;
+  std::string db_path_;
+
+  void got_block_data(ConstBlockHandle handle, td::Result<td::Ref<BlockData>> R);
+};
+
+}  // namespace validator
+
+}  // namespace ton
@@ -30,6 +30,7 @@
 #include "block/output-queue-merger.h"
 #include "vm/cells/MerkleProof.h"
 #include "vm/cells/MerkleUpdate.h"
+#include "vm/cells/CellArena.h"
 #include <map>
 #include <queue>
 #include "common/global-version.h"
@@ -374,6 +375,11 @@ class Collator final : public td::actor::Actor {
   td::Timer work_timer_{true};
   td::ThreadCpuTimer cpu_work_timer_{true};
   CollationStats stats_;
+  // cells created by do_collate(); the memory of short-lived ones is freed together when the collator is destroyed
+  vm::CellArena cell_arena_;
+  // totals of vm::DataCell::get_lazy_hash_stats() when do_collate() started; they are per thread, and
+  // do_collate() runs on one thread from start to create_block_candidate()
+  vm::DataCell::LazyHashStats lazy_hash_stats_;
 };
 
 }  // namespace validator
@@ -2116,6 +2116,10 @@ bool Collator::init_value_create() {
 bool Collator::do_collate() {
   // After do_collate started it will not be interrupted by timeout
   alarm_timestamp() = td::Timestamp::never();
+  vm::CellArena::Guard cell_arena_guard{cell_arena_};
+  // most cells built during collation are temporary, so their hashes are computed only when needed
+  vm::DataCell::LazyHashGuard lazy_hash_guard;
+  lazy_hash_stats_ = vm::DataCell::get_lazy_hash_stats();
 
   LOG(WARNING) << "do_collate() : start";
   if (!fetch_config_params()) {
@@ -2512,6 +2516,8 @@ td::Result<block::Account*> Collator::make_account(td::ConstBitPtr addr, bool fo
  */
 bool Collator::combine_account_transactions() {
   vm::AugmentedDictionary dict{256, block::tlb::aug_ShardAccountBlocks};
+  // accounts are ordered by address, so both dictionaries are updated by one batch each
+  std::vector<vm::DictionaryFixed::BatchOp> account_blocks, account_updates;
   for (auto& z : accounts) {
     block::Account& acc = *(z.second);
     CHECK(acc.addr == z.first);
@@ -2540,10 +2546,7 @@ bool Collator::combine_account_transactions() {
         return fatal_error(std::string{"new AccountBlock for "} + z.first.to_hex() +
                            " failed to pass handwritten validation tests");
       }
-      if (!dict.set(z.first, csr, vm::Dictionary::SetMode::Add)) {
-        return fatal_error(std::string{"new AccountBlock for "} + z.first.to_hex() +
-                           " could not be added to ShardAccountBlocks");
-      }
+      account_blocks.push_back({z.first.cbits(), std::move(csr)});
       // update account_dict
       if (acc.total_state->get_hash() != acc.orig_total_state->get_hash()) {
         // account changed
@@ -2554,19 +2557,21 @@ bool Collator::combine_account_transactions() {
           if (!(cb.store_ref_bool(acc.total_state)             // account_descr$_ account:^Account
                 && cb.store_bits_bool(acc.last_trans_hash_)    // last_trans_hash:bits256
                 && cb.store_long_bool(acc.last_trans_lt_, 64)  // last_trans_lt:uint64
-                && account_dict->set_builder(acc.addr, cb, vm::Dictionary::SetMode::Add))) {
+                && !account_dict->key_exists(acc.addr))) {
             return fatal_error(std::string{"cannot add newly-created account "} + acc.addr.to_hex() +
                                " into ShardAccounts");
           }
+          account_updates.push_back({acc.addr.cbits(), vm::load_cell_slice_ref(cb.finalize())});
         } else if (acc.status == block::Account::acc_nonexist) {
           // account deleted
           if (verbosity > 2) {
             std::cerr << "deleting account " << acc.addr.to_hex() << " with empty new value ";
             block::gen::t_Account.print_ref(std::cerr, acc.total_state);
           }
-          if (account_dict->lookup_delete(acc.addr).is_null()) {
+          if (!account_dict->key_exists(acc.addr)) {
             return fatal_error(std::string{"cannot delete account "} + acc.addr.to_hex() + " from ShardAccounts");
           }
+          account_updates.push_back({acc.addr.cbits(), {}});
         } else {
           // existing account modified
           if (verbosity > 4) {
@@ -2576,10 +2581,11 @@ bool Collator::combine_account_transactions() {
           if (!(cb.store_ref_bool(acc.total_state)             // account_descr$_ account:^Account
                 && cb.store_bits_bool(acc.last_trans_hash_)    // last_trans_hash:bits256
                 && cb.store_long_bool(acc.last_trans_lt_, 64)  // last_trans_lt:uint64
-                && account_dict->set_builder(acc.addr, cb, vm::Dictionary::SetMode::Replace))) {
+                && account_dict->key_exists(acc.addr))) {
             return fatal_error(std::string{"cannot modify existing account "} + acc.addr.to_hex() +
                                " in ShardAccounts");
           }
+          account_updates.push_back({acc.addr.cbits(), vm::load_cell_slice_ref(cb.finalize())});
         }
       }
     } else {
@@ -2589,6 +2595,12 @@ bool Collator::combine_account_transactions() {
       }
     }
   }
+  if (!dict.apply_batch(account_blocks)) {
+    return fatal_error("new AccountBlocks could not be added to ShardAccountBlocks");
+  }
+  if (!account_dict->apply_batch(account_updates)) {
+    return fatal_error("cannot apply account changes to ShardAccounts");
+  }
   vm::CellBuilder cb;
   if (!(cb.append_cellslice_bool(std::move(dict).extract_root()) && cb.finalize_to(shard_account_blocks_))) {
     return fatal_error("cannot serialize ShardAccountBlocks");
@@ -5134,6 +5146,7 @@ bool Collator::create_shard_state() {
     CHECK(block::tlb::t_ShardState.validate_ref(1000000, state_root));
   }
   LOG(INFO) << "creating Merkle update for the ShardState";
+  vm::DataCell::finalize_lazy_hashes(state_root);
   state_update = vm::MerkleUpdate::generate(prev_state_root_, state_root, state_usage_tree_.get());
   if (state_update.is_null()) {
     return fatal_error("cannot create Merkle update for ShardState");
@@ -5550,6 +5563,7 @@ bool Collator::create_collated_data() {
 bool Collator::create_block_candidate() {
   // 1. serialize block
   LOG(INFO) << "serializing new Block";
+  vm::DataCell::finalize_lazy_hashes(new_block);
   vm::BagOfCells boc;
   boc.set_root(new_block);
   auto res = boc.import_cells();
@@ -5627,6 +5641,11 @@ bool Collator::create_block_candidate() {
   double work_time = work_timer_.elapsed();
   double cpu_work_time = cpu_work_timer_.elapsed();
   LOG(WARNING) << "Collate query work time = " << work_time << "s, cpu time = " << cpu_work_time << "s";
+  auto lazy_hash_stats = vm::DataCell::get_lazy_hash_stats();
+  LOG(INFO) << "lazy cell hashes: " << lazy_hash_stats.created - lazy_hash_stats_.created << " cells created, "
+            << lazy_hash_stats.hashed - lazy_hash_stats_.hashed << " hashed on demand, "
+            << lazy_hash_stats.batch_hashed - lazy_hash_stats_.batch_hashed << " hashed in batches, "
+            << lazy_hash_stats.not_hashed() - lazy_hash_stats_.not_hashed() << " not hashed";
   stats_.bytes = block_limit_status_->estimate_block_size();
   stats_.gas = block_limit_status_->gas_used;
   stats_.lt_delta = block_limit_status_->cur_lt - block_limit_status_->limits.start_lt;
@@ -42,7 +42,9 @@ namespace validator {
 
 td::actor::ActorOwn<Db> create_db_actor(td::actor::ActorId<ValidatorManager> manager, std::string db_root_,
                                         td::Ref<ValidatorManagerOptions> opts) {
-  return td::actor::create_actor<RootDb>("db", manager, db_root_, opts);
+  // the db and its children (celldb, archive) stay on db scheduler, e.g. on a separate NUMA node
+  auto options = td::actor::ActorOptions().with_name("db").on_scheduler(opts->get_db_scheduler_id());
+  return td::actor::create_actor<RootDb>(options, manager, db_root_, opts);
 }
 
 td::actor::ActorOwn<LiteServerCache> create_liteserver_cache_actor(td::actor::ActorId<ValidatorManager> manager,
@@ -58,8 +58,10 @@ td::int32 get_tl_tag(td::Slice slice) {
 void LiteQuery::run_query(td::BufferSlice data, td::actor::ActorId<ValidatorManager> manager,
                           td::actor::ActorId<LiteServerCache> cache,
                           td::Promise<td::BufferSlice> promise) {
-  td::actor::create_actor<LiteQuery>("litequery", std::move(data), std::move(manager), std::move(cache),
-                                     std::move(promise))
+  // external queries must not delay consensus and block processing
+  td::actor::create_actor<LiteQuery>(
+      td::actor::ActorOptions().with_name("litequery").with_priority(td::actor::ActorPriority::Background),
+      std::move(data), std::move(manager), std::move(cache), std::move(promise))
       .release();
 }
 
@@ -215,6 +217,10 @@ void LiteQuery::perform() {
             this->perform_getAccountState(ton::create_block_id(q.id_), static_cast<WorkchainId>(q.account_->workchain_),
                                           q.account_->id_, 0x40000000);
           },
+          [&](lite_api::liteServer_getAccountStates& q) {
+            this->perform_getAccountStates(ton::create_block_id(q.id_), static_cast<WorkchainId>(q.workchain_),
+                                           std::move(q.accounts_));
+          },
           [&](lite_api::liteServer_getOneTransaction& q) {
             this->perform_getOneTransaction(ton::create_block_id(q.id_),
                                             static_cast<WorkchainId>(q.account_->workchain_), q.account_->id_,
@@ -1299,6 +1305,13 @@ void LiteQuery::continue_getAccountState() {
     // no shard with requested address found
     LOG(INFO) << "getAccountState(" << acc_workchain_ << ":" << acc_addr_.to_hex()
               << ") query completed (unknown workchain/shard)";
+    if (mode_ & 0x20000) {
+      auto b = ton::create_serialize_tl_object<ton::lite_api::liteServer_accountStates>(
+          ton::create_tl_lite_block_id(base_blk_id_), ton::create_tl_lite_block_id(blkid), proof.move_as_ok(),
+          td::BufferSlice{}, std::vector<td::BufferSlice>(acc_addrs_.size()));
+      finish_query(std::move(b));
+      return;
+    }
     auto b = ton::create_serialize_tl_object<ton::lite_api::liteServer_accountState>(
         ton::create_tl_lite_block_id(base_blk_id_), ton::create_tl_lite_block_id(blkid), proof.move_as_ok(),
         td::BufferSlice{}, td::BufferSlice{});
@@ -1311,6 +1324,10 @@ void LiteQuery::continue_getAccountState() {
 }
 
 void LiteQuery::finish_getAccountState(td::BufferSlice shard_proof) {
+  if (mode_ & 0x20000) {
+    finish_getAccountStates(std::move(shard_proof));
+    return;
+  }
   LOG(INFO) << "completing getAccountState() query";
   Ref<vm::Cell> proof1, proof2;
   if (!make_state_root_proof(proof1)) {
@@ -1401,6 +1418,75 @@ void LiteQuery::finish_getAccountState(td::BufferSlice shard_proof) {
   finish_query(std::move(b));
 }
 
+void LiteQuery::perform_getAccountStates(BlockIdExt blkid, WorkchainId workchain, std::vector<StdSmcAddress> addrs) {
+  LOG(INFO) << "started a getAccountStates(" << blkid.to_str() << ", " << workchain << ", " << addrs.size()
+            << " accounts) liteserver query";
+  if (addrs.empty()) {
+    fatal_error("no accounts specified");
+    return;
+  }
+  if (addrs.size() > max_account_states) {
+    fatal_error(PSTRING() << "cannot fetch more than " << max_account_states << " account states at one time");
+    return;
+  }
+  acc_addrs_ = std::move(addrs);
+  // the shard block is chosen by the first account, the other ones must belong to the same shard
+  perform_getAccountState(blkid, workchain, acc_addrs_[0], 0x20000);
+}
+
+void LiteQuery::finish_getAccountStates(td::BufferSlice shard_proof) {
+  LOG(INFO) << "completing getAccountStates() query";
+  for (const auto& addr : acc_addrs_) {
+    if (!ton::shard_contains(blk_id_.shard_full(), extract_addr_prefix(acc_workchain_, addr))) {
+      fatal_error(PSTRING() << "account " << acc_workchain_ << ":" << addr.to_hex() << " does not belong to shard "
+                            << blk_id_.shard_full().to_str() << " of the first requested account");
+      return;
+    }
+  }
+  Ref<vm::Cell> proof1, proof2;
+  if (!make_state_root_proof(proof1)) {
+    return;
+  }
+  // all lookups go through one MerkleProofBuilder, so the common part of the paths is included into the proof once
+  vm::MerkleProofBuilder pb{state_->root_cell()};
+  block::gen::ShardStateUnsplit::Record sstate;
+  if (!tlb::unpack_cell(pb.root(), sstate)) {
+    fatal_error("cannot unpack state header");
+    return;
+  }
+  vm::AugmentedDictionary accounts_dict{vm::load_cell_slice_ref(sstate.accounts), 256, block::tlb::aug_ShardAccounts};
+  std::vector<td::BufferSlice> states;
+  states.reserve(acc_addrs_.size());
+  for (const auto& addr : acc_addrs_) {
+    auto acc_csr = accounts_dict.lookup(addr);
+    if (acc_csr.is_null()) {
+      states.emplace_back();
+      continue;
+    }
+    auto res = vm::std_boc_serialize(acc_csr->prefetch_ref());
+    if (res.is_error()) {
+      fatal_error(res.move_as_error());
+      return;
+    }
+    states.push_back(res.move_as_ok());
+  }
+  if (!pb.extract_proof_to(proof2)) {
+    fatal_error("unknown error creating Merkle proof");
+    return;
+  }
+  auto proof = vm::std_boc_serialize_multi({std::move(proof1), std::move(proof2)});
+  pb.clear();
+  if (proof.is_error()) {
+    fatal_error(proof.move_as_error());
+    return;
+  }
+  LOG(INFO) << "getAccountStates(" << acc_workchain_ << ", " << acc_addrs_.size() << " accounts) query completed";
+  auto b = ton::create_serialize_tl_object<ton::lite_api::liteServer_accountStates>(
+      ton::create_tl_lite_block_id(base_blk_id_), ton::create_tl_lite_block_id(blk_id_), std::move(shard_proof),
+      proof.move_as_ok(), std::move(states));
+  finish_query(std::move(b));
+}
+
 // same as in lite-client/lite-client-common.cpp
 static td::Ref<vm::Tuple> prepare_vm_c7(ton::UnixTime now, ton::LogicalTime lt, td::Ref<vm::CellSlice> my_addr,
                                         const block::CurrencyCollection& balance,
@@ -1636,7 +1722,80 @@ void LiteQuery::perform_getTransactions(WorkchainId workchain, StdSmcAddress add
   acc_addr_ = addr;
   trans_lt_ = lt;
   trans_hash_ = hash;
-  continue_getTransactions(count, false);
+  td::actor::send_closure_later(
+      manager_, &ValidatorManager::get_account_transactions_for_litequery, workchain, addr, lt, hash, count,
+      [Self = actor_id(this), count](td::Result<std::vector<AccountTransactionRef>> res) {
+        if (res.is_error()) {
+          // no transaction index, or the transaction is not indexed
+          td::actor::send_closure(Self, &LiteQuery::continue_getTransactions, count, false);
+        } else {
+          td::actor::send_closure(Self, &LiteQuery::continue_getTransactions_indexed, res.move_as_ok(), count);
+        }
+      });
+}
+
+void LiteQuery::continue_getTransactions_indexed(std::vector<AccountTransactionRef> trans, unsigned remaining) {
+  LOG(INFO) << "getTransactions() : " << trans.size() << " transactions found in index";
+  indexed_trans_ = std::move(trans);
+  std::set<BlockIdExt> blk_ids;
+  for (const auto& tx : indexed_trans_) {
+    blk_ids.insert(tx.block_id);
+  }
+  // all blocks are loaded at once instead of following the chain of transactions block by block
+  pending_ += (int)blk_ids.size();
+  for (const auto& blkid : blk_ids) {
+    td::actor::send_closure_later(manager_, &ValidatorManager::get_block_data_for_litequery, blkid,
+                                  [Self = actor_id(this), blkid, remaining](td::Result<Ref<BlockData>> res) {
+                                    td::actor::send_closure_later(Self, &LiteQuery::got_getTransactions_indexed_block,
+                                                                  blkid, std::move(res), remaining);
+                                  });
+  }
+}
+
+void LiteQuery::got_getTransactions_indexed_block(BlockIdExt blkid, td::Result<Ref<BlockData>> res,
+                                                  unsigned remaining) {
+  if (res.is_error()) {
+    LOG(DEBUG) << "getTransactions() : cannot load indexed block " << blkid.to_str() << " : " << res.error();
+  } else {
+    indexed_blocks_[blkid] = Ref<BlockQ>(res.move_as_ok());
+  }
+  if (!--pending_) {
+    finish_getTransactions_indexed(remaining);
+  }
+}
+
+void LiteQuery::finish_getTransactions_indexed(unsigned remaining) {
+  for (const auto& tx : indexed_trans_) {
+    if (!remaining || tx.lt != trans_lt_ || tx.hash != trans_hash_) {
+      break;
+    }
+    auto it = indexed_blocks_.find(tx.block_id);
+    if (it == indexed_blocks_.end() ||
+        !ton::shard_contains(tx.block_id.shard_full(), ton::extract_addr_prefix(acc_workchain_, acc_addr_))) {
+      break;
+    }
+    auto res = block::get_block_transaction_try(it->second->root_cell(), acc_workchain_, acc_addr_, trans_lt_);
+    if (res.is_error() || res.ok().is_null() || res.ok()->get_hash().bits() != trans_hash_) {
+      break;
+    }
+    auto root = res.move_as_ok();
+    block::gen::Transaction::Record trans;
+    if (!tlb::unpack_cell(root, trans) || trans.prev_trans_lt >= trans_lt_) {
+      break;
+    }
+    roots_.push_back(std::move(root));
+    aux_objs_.push_back(it->second);
+    blk_ids_.push_back(tx.block_id);
+    block_ = it->second;
+    blk_id_ = tx.block_id;
+    trans_lt_ = trans.prev_trans_lt;
+    trans_hash_ = trans.prev_trans_hash;
+    --remaining;
+  }
+  indexed_trans_.clear();
+  indexed_blocks_.clear();
+  // the rest of the chain (if any) is not indexed, continue the usual way
+  continue_getTransactions(remaining, false);
 }
 
 void LiteQuery::continue_getTransactions(unsigned remaining, bool exact) {
@@ -51,6 +51,7 @@ class LiteQuery : public td::actor::Actor {
   int mode_{0};
   WorkchainId acc_workchain_;
   StdSmcAddress acc_addr_;
+  std::vector<StdSmcAddress> acc_addrs_;
   LogicalTime trans_lt_;
   Bits256 trans_hash_;
   BlockIdExt base_blk_id_, base_blk_id_alt_, blk_id_;
@@ -66,6 +67,8 @@ class LiteQuery : public td::actor::Actor {
   std::vector<Ref<vm::Cell>> roots_;
   std::vector<Ref<td::CntObject>> aux_objs_;
   std::vector<ton::BlockIdExt> blk_ids_;
+  std::vector<AccountTransactionRef> indexed_trans_;
+  std::map<BlockIdExt, Ref<BlockQ>> indexed_blocks_;
   std::unique_ptr<block::BlockProofChain> chain_;
   Ref<vm::Stack> stack_;
 
@@ -76,6 +79,7 @@ class LiteQuery : public td::actor::Actor {
   enum {
     default_timeout_msec = 4500,      // 4.5 seconds
     max_transaction_count = 16,       // fetch at most 16 transactions in one query
+    max_account_states = 1024,        // fetch at most 1024 account states in one getAccountStates query
     client_method_gas_limit = 300000  // gas limit for liteServer.runSmcMethod
   };
   enum {
@@ -120,6 +124,8 @@ class LiteQuery : public td::actor::Actor {
   void continue_getAccountState_0(Ref<MasterchainState> mc_state, BlockIdExt blkid);
   void continue_getAccountState();
   void finish_getAccountState(td::BufferSlice shard_proof);
+  void perform_getAccountStates(BlockIdExt blkid, WorkchainId workchain, std::vector<StdSmcAddress> addrs);
+  void finish_getAccountStates(td::BufferSlice shard_proof);
   void perform_fetchAccountState();
   void perform_runSmcMethod(BlockIdExt blkid, WorkchainId workchain, StdSmcAddress addr, int mode, td::int64 method_id,
                             td::BufferSlice params);
@@ -133,6 +139,9 @@ class LiteQuery : public td::actor::Actor {
   void continue_getOneTransaction();
   void perform_getTransactions(WorkchainId workchain, StdSmcAddress addr, LogicalTime lt, Bits256 hash, unsigned count);
   void continue_getTransactions(unsigned remaining, bool exact);
+  void continue_getTransactions_indexed(std::vector<AccountTransactionRef> trans, unsigned remaining);
+  void got_getTransactions_indexed_block(BlockIdExt blkid, td::Result<Ref<BlockData>> res, unsigned remaining);
+  void finish_getTransactions_indexed(unsigned remaining);
   void continue_getTransactions_2(BlockIdExt blkid, Ref<BlockData> block, unsigned remaining);
   void abort_getTransactions(td::Status error, ton::BlockIdExt blkid);
   void finish_getTransactions();
@@ -2814,7 +2814,8 @@ bool ValidateQuery::precheck_account_updates() {
   LOG(INFO) << "pre-checking all Account updates between the old and the new state";
   try {
     CHECK(ps_.account_dict_ && ns_.account_dict_);
-    if (!ps_.account_dict_->scan_diff(
+    // changed subtrees are loaded and checked concurrently, precheck_one_account_update() runs on this thread
+    if (!ps_.account_dict_->scan_diff_parallel(
             *ns_.account_dict_,
             [this](td::ConstBitPtr key, int key_len, Ref<vm::CellSlice> old_val_extra,
                    Ref<vm::CellSlice> new_val_extra) {
@@ -3263,7 +3264,7 @@ bool ValidateQuery::precheck_message_queue_update() {
     CHECK(ps_.out_msg_queue_ && ns_.out_msg_queue_);
     CHECK(out_msg_dict_);
     new_out_msg_queue_size_ = old_out_msg_queue_size_;
-    if (!ps_.out_msg_queue_->scan_diff(
+    if (!ps_.out_msg_queue_->scan_diff_parallel(
             *ns_.out_msg_queue_,
             [this](td::ConstBitPtr key, int key_len, Ref<vm::CellSlice> old_val_extra,
                    Ref<vm::CellSlice> new_val_extra) {
@@ -6769,6 +6770,7 @@ bool ValidateQuery::try_validate() {
     work_timer_.pause();
     cpu_work_timer_.pause();
   };
+  vm::CellArena::Guard cell_arena_guard{cell_arena_};
   try {
     if (!stage_) {
       LOG(WARNING) << "try_validate stage 0";
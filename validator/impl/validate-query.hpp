@@ -21,6 +21,7 @@
 #include "interfaces/validator-manager.h"
 #include "vm/cells.h"
 #include "vm/dict.h"
+#include "vm/cells/CellArena.h"
 #include "block/mc-config.h"
 #include "block/transaction.h"
 #include "shard.hpp"
@@ -399,6 +400,8 @@ class ValidateQuery : public td::actor::Actor {
 
   td::Timer work_timer_{true};
   td::ThreadCpuTimer cpu_work_timer_{true};
+  // cells created by try_validate(); the memory of short-lived ones is freed together when the query is destroyed
+  vm::CellArena cell_arena_;
   void record_stats();
 };
 
@@ -50,6 +50,8 @@ class Db : public td::actor::Actor {
 
   virtual void store_block_state(BlockHandle handle, td::Ref<ShardState> state,
                                  td::Promise<td::Ref<ShardState>> promise) = 0;
+  virtual void import_block_state(BlockHandle handle, td::Ref<ShardState> state,
+                                  td::Promise<td::Ref<ShardState>> promise) = 0;
   virtual void get_block_state(ConstBlockHandle handle, td::Promise<td::Ref<ShardState>> promise) = 0;
   virtual void get_cell_db_reader(td::Promise<std::shared_ptr<vm::CellDbReader>> promise) = 0;
 
@@ -84,6 +86,8 @@ class Db : public td::actor::Actor {
                                       td::Promise<ConstBlockHandle> promise) = 0;
   virtual void get_block_by_seqno(AccountIdPrefixFull account, BlockSeqno seqno,
                                   td::Promise<ConstBlockHandle> promise) = 0;
+  virtual void get_account_transactions(WorkchainId workchain, StdSmcAddress addr, LogicalTime lt, Bits256 hash,
+                                        td::uint32 count, td::Promise<std::vector<AccountTransactionRef>> promise) = 0;
 
   virtual void update_init_masterchain_block(BlockIdExt block, td::Promise<td::Unit> promise) = 0;
   virtual void get_init_masterchain_block(td::Promise<BlockIdExt> promise) = 0;
@@ -119,7 +123,7 @@ class Db : public td::actor::Actor {
 
   virtual void get_archive_id(BlockSeqno masterchain_seqno, ShardIdFull shard_prefix,
                               td::Promise<td::uint64> promise) = 0;
-  virtual void get_archive_slice(td::uint64 archive_id, td::uint64 offset, td::uint32 limit,
+  virtual void get_archive_slice(td::uint64 archive_id, td::uint64 offset, td::uint32 limit, bool compressed,
                                  td::Promise<td::BufferSlice> promise) = 0;
   virtual void set_async_mode(bool mode, td::Promise<td::Unit> promise) = 0;
 
@@ -52,6 +52,15 @@ struct AsyncSerializerState {
   UnixTime last_written_block_ts;
 };
 
+// Entry of the optional account transaction index: (account, lt) -> location of the transaction
+struct AccountTransactionRef {
+  BlockIdExt block_id;
+  LogicalTime lt;
+  Bits256 hash;
+  LogicalTime prev_lt;
+  Bits256 prev_hash;
+};
+
 struct CollationStats {
   td::uint32 bytes, gas, lt_delta;
   int cat_bytes, cat_gas, cat_lt_delta;
@@ -70,6 +79,11 @@ class ValidatorManager : public ValidatorManagerInterface {
   }
   virtual void set_block_state(BlockHandle handle, td::Ref<ShardState> state,
                                td::Promise<td::Ref<ShardState>> promise) = 0;
+  // Same as set_block_state, for large states that are not derived from the ones already in db (downloaded states)
+  virtual void import_block_state(BlockHandle handle, td::Ref<ShardState> state,
+                                  td::Promise<td::Ref<ShardState>> promise) {
+    set_block_state(std::move(handle), std::move(state), std::move(promise));
+  }
   virtual void get_cell_db_reader(td::Promise<std::shared_ptr<vm::CellDbReader>> promise) = 0;
   virtual void store_persistent_state_file(BlockIdExt block_id, BlockIdExt masterchain_block_id, td::BufferSlice state,
                                            td::Promise<td::Unit> promise) = 0;
@@ -207,6 +221,11 @@ class ValidatorManager : public ValidatorManagerInterface {
 
   virtual void add_lite_query_stats(int lite_query_id) {
   }
+  virtual void get_account_transactions_for_litequery(WorkchainId workchain, StdSmcAddress addr, LogicalTime lt,
+                                                      Bits256 hash, td::uint32 count,
+                                                      td::Promise<std::vector<AccountTransactionRef>> promise) {
+    promise.set_error(td::Status::Error(ErrorCode::notready, "transaction index is disabled"));
+  }
 
   virtual void record_collate_query_stats(BlockIdExt block_id, double work_time, double cpu_work_time,
                                           CollationStats stats) {
@@ -296,7 +296,7 @@ class ValidatorManagerImpl : public ValidatorManager {
                       td::Promise<td::uint64> promise) override {
     UNREACHABLE();
   }
-  void get_archive_slice(td::uint64 archive_id, td::uint64 offset, td::uint32 limit,
+  void get_archive_slice(td::uint64 archive_id, td::uint64 offset, td::uint32 limit, bool compressed,
                          td::Promise<td::BufferSlice> promise) override {
     UNREACHABLE();
   }
@@ -385,6 +385,9 @@ class ValidatorManagerImpl : public ValidatorManager {
   void prepare_actor_stats(td::Promise<std::string> promise) override {
     UNREACHABLE();
   }
+  void prepare_actor_stats_json(td::Promise<std::string> promise) override {
+    UNREACHABLE();
+  }
 
   void prepare_perf_timer_stats(td::Promise<std::vector<PerfTimerStats>> promise) override {
     UNREACHABLE();
@@ -1209,6 +1209,20 @@ void ValidatorManagerImpl::set_block_state(BlockHandle handle, td::Ref<ShardStat
   td::actor::send_closure(db_, &Db::store_block_state, handle, state, std::move(P));
 }
 
+void ValidatorManagerImpl::import_block_state(BlockHandle handle, td::Ref<ShardState> state,
+                                              td::Promise<td::Ref<ShardState>> promise) {
+  auto P = td::PromiseCreator::lambda(
+      [SelfId = actor_id(this), handle, promise = std::move(promise)](td::Result<td::Ref<ShardState>> R) mutable {
+        if (R.is_error()) {
+          promise.set_error(R.move_as_error());
+        } else {
+          promise.set_value(R.move_as_ok());
+          td::actor::send_closure(SelfId, &ValidatorManagerImpl::written_handle, std::move(handle), [](td::Unit) {});
+        }
+      });
+  td::actor::send_closure(db_, &Db::import_block_state, handle, state, std::move(P));
+}
+
 void ValidatorManagerImpl::get_cell_db_reader(td::Promise<std::shared_ptr<vm::CellDbReader>> promise) {
   td::actor::send_closure(db_, &Db::get_cell_db_reader, std::move(promise));
 }
@@ -1798,8 +1812,9 @@ void ValidatorManagerImpl::read_gc_list(std::vector<ValidatorSessionId> list) {
 
   new_masterchain_block();
 
-  serializer_ =
-      td::actor::create_actor<AsyncStateSerializer>("serializer", last_key_block_handle_->id(), opts_, actor_id(this));
+  serializer_ = td::actor::create_actor<AsyncStateSerializer>(
+      td::actor::ActorOptions().with_name("serializer").with_priority(td::actor::ActorPriority::Background),
+      last_key_block_handle_->id(), opts_, actor_id(this));
   td::actor::send_closure(serializer_, &AsyncStateSerializer::update_last_known_key_block_ts,
                           last_key_block_handle_->unix_time());
 
@@ -2759,8 +2774,8 @@ void ValidatorManagerImpl::get_archive_id(BlockSeqno masterchain_seqno, ShardIdF
 }
 
 void ValidatorManagerImpl::get_archive_slice(td::uint64 archive_id, td::uint64 offset, td::uint32 limit,
-                                             td::Promise<td::BufferSlice> promise) {
-  td::actor::send_closure(db_, &Db::get_archive_slice, archive_id, offset, limit, std::move(promise));
+                                             bool compressed, td::Promise<td::BufferSlice> promise) {
+  td::actor::send_closure(db_, &Db::get_archive_slice, archive_id, offset, limit, compressed, std::move(promise));
 }
 
 bool ValidatorManagerImpl::is_validator() {
@@ -2832,6 +2847,10 @@ void ValidatorManagerImpl::prepare_actor_stats(td::Promise<std::string> promise)
   send_closure(actor_stats_, &td::actor::ActorStats::prepare_stats, std::move(promise));
 }
 
+void ValidatorManagerImpl::prepare_actor_stats_json(td::Promise<std::string> promise) {
+  send_closure(actor_stats_, &td::actor::ActorStats::prepare_stats_json, std::move(promise));
+}
+
 void ValidatorManagerImpl::prepare_stats(td::Promise<std::vector<std::pair<std::string, std::string>>> promise) {
   auto merger = StatsMerger::create(std::move(promise));
 
@@ -3096,6 +3115,12 @@ void ValidatorManagerImpl::get_block_by_lt_for_litequery(AccountIdPrefixFull acc
       });
 }
 
+void ValidatorManagerImpl::get_account_transactions_for_litequery(
+    WorkchainId workchain, StdSmcAddress addr, LogicalTime lt, Bits256 hash, td::uint32 count,
+    td::Promise<std::vector<AccountTransactionRef>> promise) {
+  td::actor::send_closure(db_, &Db::get_account_transactions, workchain, addr, lt, hash, count, std::move(promise));
+}
+
 void ValidatorManagerImpl::get_block_by_unix_time_for_litequery(AccountIdPrefixFull account, UnixTime ts,
                                                                 td::Promise<ConstBlockHandle> promise) {
   get_block_by_unix_time_from_db(
@@ -407,6 +407,8 @@ class ValidatorManagerImpl : public ValidatorManager {
 
   void set_block_state(BlockHandle handle, td::Ref<ShardState> state,
                        td::Promise<td::Ref<ShardState>> promise) override;
+  void import_block_state(BlockHandle handle, td::Ref<ShardState> state,
+                          td::Promise<td::Ref<ShardState>> promise) override;
   void get_cell_db_reader(td::Promise<std::shared_ptr<vm::CellDbReader>> promise) override;
   void store_persistent_state_file(BlockIdExt block_id, BlockIdExt masterchain_block_id, td::BufferSlice state,
                                    td::Promise<td::Unit> promise) override;
@@ -533,7 +535,7 @@ class ValidatorManagerImpl : public ValidatorManager {
   }
 
   void get_archive_id(BlockSeqno masterchain_seqno, ShardIdFull shard_prefix, td::Promise<td::uint64> promise) override;
-  void get_archive_slice(td::uint64 archive_id, td::uint64 offset, td::uint32 limit,
+  void get_archive_slice(td::uint64 archive_id, td::uint64 offset, td::uint32 limit, bool compressed,
                          td::Promise<td::BufferSlice> promise) override;
 
   void check_is_hardfork(BlockIdExt block_id, td::Promise<bool> promise) override {
@@ -603,6 +605,7 @@ class ValidatorManagerImpl : public ValidatorManager {
   void prepare_stats(td::Promise<std::vector<std::pair<std::string, std::string>>> promise) override;
 
   void prepare_actor_stats(td::Promise<std::string> promise) override;
+  void prepare_actor_stats_json(td::Promise<std::string> promise) override;
 
   void prepare_perf_timer_stats(td::Promise<std::vector<PerfTimerStats>> promise) override;
   void add_perf_timer_stat(std::string name, double duration) override;
@@ -642,6 +645,9 @@ class ValidatorManagerImpl : public ValidatorManager {
                                              td::Promise<ConstBlockHandle> promise) override;
   void get_block_by_unix_time_for_litequery(AccountIdPrefixFull account, UnixTime ts,
                                                     td::Promise<ConstBlockHandle> promise) override;
+  void get_account_transactions_for_litequery(WorkchainId workchain, StdSmcAddress addr, LogicalTime lt, Bits256 hash,
+                                              td::uint32 count,
+                                              td::Promise<std::vector<AccountTransactionRef>> promise) override;
   void get_block_by_seqno_for_litequery(AccountIdPrefixFull account, BlockSeqno seqno,
                                                 td::Promise<ConstBlockHandle> promise) override;
   void process_block_handle_for_litequery_error(BlockIdExt block_id, td::Result<BlockHandle> r_handle,
@@ -162,13 +162,18 @@ void DownloadArchiveSlice::got_archive_info(td::BufferSlice data) {
 void DownloadArchiveSlice::get_archive_slice() {
   auto P = td::PromiseCreator::lambda([SelfId = actor_id(this)](td::Result<td::BufferSlice> R) {
     if (R.is_error()) {
-      td::actor::send_closure(SelfId, &DownloadArchiveSlice::abort_query, R.move_as_error());
+      td::actor::send_closure(SelfId, &DownloadArchiveSlice::failed_archive_slice, R.move_as_error());
     } else {
       td::actor::send_closure(SelfId, &DownloadArchiveSlice::got_archive_slice, R.move_as_ok());
     }
   });
 
-  auto q = create_serialize_tl_object<ton_api::tonNode_getArchiveSlice>(archive_id_, offset_, slice_size());
+  td::BufferSlice q;
+  if (compressed_) {
+    q = create_serialize_tl_object<ton_api::tonNode_getArchiveSliceCompressed>(archive_id_, offset_, slice_size());
+  } else {
+    q = create_serialize_tl_object<ton_api::tonNode_getArchiveSlice>(archive_id_, offset_, slice_size());
+  }
   if (client_.empty()) {
     td::actor::send_closure(overlays_, &overlay::Overlays::send_query_via, download_from_, local_id_, overlay_id_,
                             "get_archive_slice", std::move(P), td::Timestamp::in(15.0), std::move(q),
@@ -180,6 +185,18 @@ void DownloadArchiveSlice::get_archive_slice() {
   }
 }
 
+void DownloadArchiveSlice::failed_archive_slice(td::Status error) {
+  if (compressed_ && offset_ == 0) {
+    // the peer may not know getArchiveSliceCompressed, its packages are downloaded in the original format then
+    LOG(DEBUG) << "failed to download compressed archive slice #" << masterchain_seqno_ << " "
+               << shard_prefix_.to_str() << ", retrying uncompressed: " << error;
+    compressed_ = false;
+    get_archive_slice();
+    return;
+  }
+  abort_query(std::move(error));
+}
+
 void DownloadArchiveSlice::got_archive_slice(td::BufferSlice data) {
   auto R = fd_.write(data.as_slice());
   if (R.is_error()) {
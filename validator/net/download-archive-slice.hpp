@@ -48,6 +48,7 @@ class DownloadArchiveSlice : public td::actor::Actor {
   void got_node_to_download(adnl::AdnlNodeIdShort node);
   void got_archive_info(td::BufferSlice data);
   void get_archive_slice();
+  void failed_archive_slice(td::Status error);
   void got_archive_slice(td::BufferSlice data);
 
   static constexpr td::uint32 slice_size() {
@@ -64,6 +65,8 @@ class DownloadArchiveSlice : public td::actor::Actor {
   overlay::OverlayIdShort overlay_id_;
   td::uint64 offset_ = 0;
   td::uint64 archive_id_;
+  // packages are requested as stored, which may be compressed, unless the peer doesn't support it
+  bool compressed_ = true;
 
   adnl::AdnlNodeIdShort download_from_ = adnl::AdnlNodeIdShort::zero();
 
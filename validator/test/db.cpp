@@ -0,0 +1,249 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#include "td/utils/tests.h"
+
+#include "td/db/RocksDb.h"
+#include "td/utils/filesystem.h"
+#include "td/utils/port/path.h"
+
+#include "vm/cells/CellBuilder.h"
+#include "vm/db/CellStorage.h"
+#include "vm/db/DynamicBagOfCellsDb.h"
+
+#include "validator/db/celldb.hpp"
+#include "validator/db/package.hpp"
+#include "validator/db/txindex.hpp"
+
+namespace {
+
+ton::Bits256 make_hash(int x) {
+  ton::Bits256 hash = ton::Bits256::zero();
+  hash.as_slice()[0] = static_cast<char>(x);
+  hash.as_slice()[1] = 1;
+  return hash;
+}
+
+ton::BlockIdExt make_block_id(ton::BlockSeqno seqno, int variant = 0) {
+  return ton::BlockIdExt{ton::basechainId, ton::shardIdAll, seqno, make_hash(100 + variant), make_hash(200 + variant)};
+}
+
+}  // namespace
+
+TEST(TxIndex, Chain) {
+  using ton::validator::TxIndex;
+  td::Slice db_name = "test-txindex";
+  td::RocksDb::destroy(db_name).ignore();
+  TxIndex index{std::make_shared<td::RocksDb>(td::RocksDb::open(db_name.str()).move_as_ok())};
+
+  ton::StdSmcAddress a = make_hash(1), b = make_hash(2);
+  auto tx = [&](ton::BlockIdExt block_id, ton::LogicalTime lt, int hash, ton::LogicalTime prev_lt, int prev_hash) {
+    return ton::validator::AccountTransactionRef{block_id, lt, make_hash(hash), prev_lt,
+                                                 prev_lt == 0 ? ton::Bits256::zero() : make_hash(prev_hash)};
+  };
+  // blocks generated at 100, 200, 300 and referred by masterchain blocks 10, 20, 30
+  auto block1 = make_block_id(1), block2 = make_block_id(2), block3 = make_block_id(3);
+  index.add_block(block1, 100, 10, {{a, tx(block1, 10, 11, 0, 0)}}).ensure();
+  index.add_block(block2, 200, 20, {{a, tx(block2, 20, 12, 10, 11)}, {b, tx(block2, 21, 21, 0, 0)}}).ensure();
+  index.add_block(block3, 300, 30, {{a, tx(block3, 30, 13, 20, 12)}, {b, tx(block3, 31, 22, 21, 21)}}).ensure();
+
+  auto get = [&](const ton::StdSmcAddress &addr, ton::LogicalTime lt, int hash, td::uint32 count) {
+    return index.get_account_transactions(ton::basechainId, addr, lt, make_hash(hash), count).move_as_ok();
+  };
+
+  auto chain = get(a, 30, 13, 10);
+  ASSERT_EQ(3u, chain.size());
+  ASSERT_EQ(30u, chain[0].lt);
+  ASSERT_TRUE(chain[0].block_id == block3);
+  ASSERT_TRUE(chain[0].hash == make_hash(13));
+  ASSERT_EQ(20u, chain[1].lt);
+  ASSERT_TRUE(chain[1].block_id == block2);
+  ASSERT_EQ(10u, chain[2].lt);
+  ASSERT_TRUE(chain[2].block_id == block1);
+  ASSERT_EQ(0u, chain[2].prev_lt);
+  ASSERT_EQ(2u, get(a, 30, 13, 2).size());
+  ASSERT_EQ(2u, get(b, 31, 22, 10).size());
+  ASSERT_EQ(0u, get(a, 25, 13, 10).size());
+
+  // hash mismatch: the caller falls back to loading blocks from this point
+  ASSERT_EQ(0u, get(a, 30, 14, 10).size());
+  auto block2_fork = make_block_id(2, 1);
+  index.add_block(block2_fork, 200, 20, {{a, tx(block2_fork, 20, 15, 10, 11)}}).ensure();
+  ASSERT_EQ(1u, get(a, 30, 13, 10).size());
+  ASSERT_EQ(2u, get(a, 20, 15, 10).size());
+
+  // archive GC: blocks generated before 250 are removed
+  index.prune(250).ensure();
+  ASSERT_EQ(1u, get(a, 30, 13, 10).size());
+  ASSERT_EQ(0u, get(a, 20, 15, 10).size());
+  ASSERT_EQ(0u, get(a, 10, 11, 10).size());
+  ASSERT_EQ(0u, get(b, 21, 21, 10).size());
+  ASSERT_EQ(1u, get(b, 31, 22, 10).size());
+
+  // truncation: blocks after masterchain block 25 are removed
+  auto block4 = make_block_id(4);
+  index.add_block(block4, 290, 25, {{a, tx(block4, 40, 16, 30, 13)}}).ensure();
+  index.truncate(25).ensure();
+  ASSERT_EQ(0u, get(a, 30, 13, 10).size());
+  ASSERT_EQ(0u, get(b, 31, 22, 10).size());
+  ASSERT_EQ(1u, get(a, 40, 16, 10).size());
+
+  index.prune(1000).ensure();
+  ASSERT_EQ(0u, get(a, 40, 16, 10).size());
+}
+
+TEST(CellDb, Import) {
+  using ton::validator::CellDbIn;
+  td::Slice db_name = "test-celldb-import";
+  td::RocksDb::destroy(db_name).ignore();
+  auto kv = std::make_shared<td::RocksDb>(td::RocksDb::open(db_name.str()).move_as_ok());
+
+  auto leaf = [](td::uint32 x) { return vm::CellBuilder().store_long(x, 32).finalize(); };
+  auto node = [](std::vector<td::Ref<vm::Cell>> refs, td::uint32 x) {
+    vm::CellBuilder cb;
+    cb.store_long(x, 32);
+    for (auto &ref : refs) {
+      cb.store_ref(std::move(ref));
+    }
+    return cb.finalize();
+  };
+
+  // old state, already in db
+  auto old_root = node({leaf(1), node({leaf(2), leaf(3)}, 4)}, 5);
+  auto boc = vm::DynamicBagOfCellsDb::create();
+  boc->set_loader(std::make_unique<vm::CellLoader>(kv->snapshot())).ensure();
+  boc->inc(old_root);
+  boc->prepare_commit().ensure();
+  vm::CellStorer stor{*kv};
+  kv->begin_write_batch().ensure();
+  boc->commit(stor).ensure();
+  kv->commit_write_batch().ensure();
+  boc->set_loader(std::make_unique<vm::CellLoader>(kv->snapshot())).ensure();
+
+  // new state shares a subtree with the old one and has a subtree referenced twice
+  std::vector<td::Ref<vm::Cell>> leaves;
+  for (td::uint32 i = 0; i < 13; i++) {
+    leaves.push_back(leaf(100 + i));
+  }
+  auto shared = node({node({leaves[0], leaves[1], leaves[2]}, 6), node({leaves[3], leaves[4]}, 7)}, 8);
+  auto left = node({shared, old_root, node({leaves[5], leaves[6], leaves[7], leaves[8]}, 9)}, 10);
+  auto right = node({shared, node({leaves[9], leaves[10], leaves[11]}, 11), leaves[12]}, 12);
+  auto root = node({left, right, old_root}, 13);
+
+  td::rmrf("test-celldb-import-sst").ignore();
+  auto imported = CellDbIn::write_import_files(*kv->snapshot(), root, "test-celldb-import-sst/", 0, false, 100)
+                      .move_as_ok();
+  ASSERT_EQ(21u, imported.cells_count);
+  ASSERT_TRUE(imported.batches_count > 1);
+  ASSERT_EQ(2u, imported.existing_refs.size());
+  for (auto &c : imported.existing_refs) {
+    boc->inc(c);
+  }
+  boc->prepare_commit().ensure();
+  kv->begin_write_batch().ensure();
+  boc->commit(stor).ensure();
+  kv->commit_write_batch().ensure();
+  kv->ingest_external_files(std::move(imported.sst_files)).ensure();
+  td::rmrf("test-celldb-import-sst").ignore();
+
+  vm::CellLoader loader{kv->snapshot()};
+  auto refcnt = [&](const td::Ref<vm::Cell> &cell) {
+    return loader.load_refcnt(cell->get_hash().as_slice()).move_as_ok().refcnt();
+  };
+  ASSERT_EQ(1, refcnt(root));
+  ASSERT_EQ(1, refcnt(left));
+  ASSERT_EQ(2, refcnt(shared));
+  ASSERT_EQ(1, refcnt(leaves[0]));
+  ASSERT_EQ(1, refcnt(leaves[12]));
+  ASSERT_EQ(3, refcnt(old_root));
+
+  auto new_boc = vm::DynamicBagOfCellsDb::create();
+  new_boc->set_loader(std::make_unique<vm::CellLoader>(kv->snapshot())).ensure();
+  auto loaded = new_boc->load_cell(root->get_hash().as_slice()).move_as_ok();
+  std::vector<td::Ref<vm::Cell>> stack{loaded}, expected{root};
+  while (!stack.empty()) {
+    auto cell = stack.back(), cell_expected = expected.back();
+    stack.pop_back();
+    expected.pop_back();
+    auto data = cell->load_cell().move_as_ok().data_cell;
+    auto data_expected = cell_expected->load_cell().move_as_ok().data_cell;
+    ASSERT_TRUE(data->get_hash() == data_expected->get_hash());
+    ASSERT_EQ(data_expected->size_refs(), data->size_refs());
+    for (unsigned i = 0; i < data->size_refs(); i++) {
+      stack.push_back(data->get_ref(i));
+      expected.push_back(data_expected->get_ref(i));
+    }
+  }
+}
+
+TEST(Package, UncompressedReader) {
+  td::CSlice path = "test-package.pack", served_path = "test-package-served.pack";
+  td::unlink(path).ignore();
+  ton::Package::Compression compression{std::string(100, 'x')};
+  auto package =
+      std::make_shared<ton::Package>(ton::Package::open(path.str(), false, true, &compression).move_as_ok());
+  ASSERT_TRUE(package->is_compressed());
+
+  std::vector<std::pair<std::string, std::string>> entries;
+  auto add = [&](size_t count) {
+    for (size_t i = 0; i < count; i++) {
+      auto id = entries.size();
+      std::string data = PSTRING() << std::string(id * 100, static_cast<char>('a' + id % 26)) << "data " << id;
+      entries.emplace_back(PSTRING() << "entry" << id, data);
+      package->append(entries.back().first, data, false);
+    }
+  };
+
+  // a peer downloads the package in slices of varying size while it grows
+  ton::UncompressedPackageReader reader(package);
+  std::string served;
+  auto download = [&](td::uint32 limit) {
+    while (true) {
+      auto slice = reader.read(served.size(), limit).move_as_ok();
+      served += slice.as_slice().str();
+      if (slice.size() < limit) {
+        break;
+      }
+    }
+  };
+  add(10);
+  download(3);
+  add(5);
+  download(1000);
+  download(17);
+  ASSERT_TRUE(reader.read(served.size(), 100).move_as_ok().empty());
+  ASSERT_TRUE(reader.read(served.size() + 100, 100).move_as_ok().empty());
+  ASSERT_EQ(served.substr(100, 500), reader.read(100, 500).move_as_ok().as_slice().str());
+
+  ASSERT_EQ(0x01u, static_cast<td::uint8>(served[0]));
+  td::write_file(served_path, served).ensure();
+  auto parsed = ton::Package::open(served_path.str(), true, false).move_as_ok();
+  ASSERT_TRUE(!parsed.is_compressed());
+  size_t i = 0;
+  parsed.iterate([&](std::string filename, td::BufferSlice data, td::uint64) {
+    CHECK(i < entries.size());
+    CHECK(filename == entries[i].first);
+    CHECK(data.as_slice() == entries[i].second);
+    i++;
+    return true;
+  });
+  ASSERT_EQ(entries.size(), i);
+
+  td::unlink(path).ignore();
+  td::unlink(served_path).ignore();
+}
@@ -282,7 +282,8 @@ BlockId ValidatorGroup::create_next_block_id_simple() const {
 std::unique_ptr<validatorsession::ValidatorSession::Callback> ValidatorGroup::make_validator_session_callback() {
   class Callback : public validatorsession::ValidatorSession::Callback {
    public:
-    Callback(td::actor::ActorId<ValidatorGroup> id) : id_(id) {
+    Callback(td::actor::ActorId<ValidatorGroup> id, td::actor::ActorId<ValidatorManager> manager)
+        : id_(id), manager_(manager) {
     }
     void on_candidate(validatorsession::BlockSourceInfo source_info,
                       validatorsession::ValidatorSessionRootHash root_hash, td::BufferSlice data,
@@ -341,12 +342,16 @@ std::unique_ptr<validatorsession::ValidatorSession::Callback> ValidatorGroup::ma
       td::actor::send_closure(id_, &ValidatorGroup::get_approved_candidate, source, root_hash, file_hash,
                               collated_data_file_hash, std::move(promise));
     }
+    void get_cell_db_reader(td::Promise<std::shared_ptr<vm::CellDbReader>> promise) override {
+      td::actor::send_closure(manager_, &ValidatorManager::get_cell_db_reader, std::move(promise));
+    }
 
    private:
     td::actor::ActorId<ValidatorGroup> id_;
+    td::actor::ActorId<ValidatorManager> manager_;
   };
 
-  return std::make_unique<Callback>(actor_id(this));
+  return std::make_unique<Callback>(actor_id(this), manager_);
 }
 
 void ValidatorGroup::create_session() {
@@ -121,6 +121,18 @@ struct ValidatorManagerOptionsImpl : public ValidatorManagerOptions {
   double get_archive_preload_period() const override {
     return archive_preload_period_;
   }
+  bool get_archive_compression_enabled() const override {
+    return archive_compression_enabled_;
+  }
+  std::string get_archive_compression_dictionary() const override {
+    return archive_compression_dictionary_;
+  }
+  td::actor::SchedulerId get_db_scheduler_id() const override {
+    return db_scheduler_id_;
+  }
+  bool get_async_file_io_enabled() const override {
+    return async_file_io_enabled_;
+  }
   bool get_disable_rocksdb_stats() const override {
     return disable_rocksdb_stats_;
   }
@@ -133,6 +145,9 @@ struct ValidatorManagerOptionsImpl : public ValidatorManagerOptions {
   bool get_celldb_direct_io() const override {
     return celldb_direct_io_;
   }
+  bool get_celldb_compact_cells() const override {
+    return celldb_compact_cells_;
+  }
   bool get_celldb_preload_all() const override {
     return celldb_preload_all_;
   }
@@ -154,6 +169,9 @@ struct ValidatorManagerOptionsImpl : public ValidatorManagerOptions {
   bool get_fast_state_serializer_enabled() const override {
     return fast_state_serializer_enabled_;
   }
+  bool get_tx_index_enabled() const override {
+    return tx_index_enabled_;
+  }
 
   void set_zero_block_id(BlockIdExt block_id) override {
     zero_block_id_ = block_id;
@@ -216,6 +234,18 @@ struct ValidatorManagerOptionsImpl : public ValidatorManagerOptions {
   void set_archive_preload_period(double value) override {
     archive_preload_period_ = value;
   }
+  void set_archive_compression_enabled(bool value) override {
+    archive_compression_enabled_ = value;
+  }
+  void set_archive_compression_dictionary(std::string value) override {
+    archive_compression_dictionary_ = std::move(value);
+  }
+  void set_db_scheduler_id(td::actor::SchedulerId value) override {
+    db_scheduler_id_ = value;
+  }
+  void set_async_file_io_enabled(bool value) override {
+    async_file_io_enabled_ = value;
+  }
   void set_disable_rocksdb_stats(bool value) override {
     disable_rocksdb_stats_ = value;
   }
@@ -228,6 +258,9 @@ struct ValidatorManagerOptionsImpl : public ValidatorManagerOptions {
   void set_celldb_direct_io(bool value) override {
     celldb_direct_io_ = value;
   }
+  void set_celldb_compact_cells(bool value) override {
+    celldb_compact_cells_ = value;
+  }
   void set_celldb_preload_all(bool value) override {
     celldb_preload_all_ = value;
   }
@@ -249,6 +282,9 @@ struct ValidatorManagerOptionsImpl : public ValidatorManagerOptions {
   void set_fast_state_serializer_enabled(bool value) override {
     fast_state_serializer_enabled_ = value;
   }
+  void set_tx_index_enabled(bool value) override {
+    tx_index_enabled_ = value;
+  }
 
   ValidatorManagerOptionsImpl *make_copy() const override {
     return new ValidatorManagerOptionsImpl(*this);
@@ -292,16 +328,22 @@ struct ValidatorManagerOptionsImpl : public ValidatorManagerOptions {
   td::uint32 celldb_compress_depth_{0};
   size_t max_open_archive_files_ = 0;
   double archive_preload_period_ = 0.0;
+  bool archive_compression_enabled_ = false;
+  std::string archive_compression_dictionary_;
+  td::actor::SchedulerId db_scheduler_id_;
+  bool async_file_io_enabled_ = false;
   bool disable_rocksdb_stats_;
   bool nonfinal_ls_queries_enabled_ = false;
   td::optional<td::uint64> celldb_cache_size_;
   bool celldb_direct_io_ = false;
+  bool celldb_compact_cells_ = false;
   bool celldb_preload_all_ = false;
   bool celldb_in_memory_ = false;
   td::optional<double> catchain_max_block_delay_, catchain_max_block_delay_slow_;
   bool state_serializer_enabled_ = true;
   td::Ref<CollatorOptions> collator_options_{true};
   bool fast_state_serializer_enabled_ = false;
+  bool tx_index_enabled_ = false;
 };
 
 }  // namespace validator
@@ -105,16 +105,22 @@ struct ValidatorManagerOptions : public td::CntObject {
   virtual bool get_celldb_in_memory() const = 0;
   virtual size_t get_max_open_archive_files() const = 0;
   virtual double get_archive_preload_period() const = 0;
+  virtual bool get_archive_compression_enabled() const = 0;
+  virtual std::string get_archive_compression_dictionary() const = 0;
+  virtual td::actor::SchedulerId get_db_scheduler_id() const = 0;
+  virtual bool get_async_file_io_enabled() const = 0;
   virtual bool get_disable_rocksdb_stats() const = 0;
   virtual bool nonfinal_ls_queries_enabled() const = 0;
   virtual td::optional<td::uint64> get_celldb_cache_size() const = 0;
   virtual bool get_celldb_direct_io() const = 0;
+  virtual bool get_celldb_compact_cells() const = 0;
   virtual bool get_celldb_preload_all() const = 0;
   virtual td::optional<double> get_catchain_max_block_delay() const = 0;
   virtual td::optional<double> get_catchain_max_block_delay_slow() const = 0;
   virtual bool get_state_serializer_enabled() const = 0;
   virtual td::Ref<CollatorOptions> get_collator_options() const = 0;
   virtual bool get_fast_state_serializer_enabled() const = 0;
+  virtual bool get_tx_index_enabled() const = 0;
 
   virtual void set_zero_block_id(BlockIdExt block_id) = 0;
   virtual void set_init_block_id(BlockIdExt block_id) = 0;
@@ -136,10 +142,15 @@ struct ValidatorManagerOptions : public td::CntObject {
   virtual void set_celldb_compress_depth(td::uint32 value) = 0;
   virtual void set_max_open_archive_files(size_t value) = 0;
   virtual void set_archive_preload_period(double value) = 0;
+  virtual void set_archive_compression_enabled(bool value) = 0;
+  virtual void set_archive_compression_dictionary(std::string value) = 0;
+  virtual void set_db_scheduler_id(td::actor::SchedulerId value) = 0;
+  virtual void set_async_file_io_enabled(bool value) = 0;
   virtual void set_disable_rocksdb_stats(bool value) = 0;
   virtual void set_nonfinal_ls_queries_enabled(bool value) = 0;
   virtual void set_celldb_cache_size(td::uint64 value) = 0;
   virtual void set_celldb_direct_io(bool value) = 0;
+  virtual void set_celldb_compact_cells(bool value) = 0;
   virtual void set_celldb_preload_all(bool value) = 0;
   virtual void set_celldb_in_memory(bool value) = 0;
   virtual void set_catchain_max_block_delay(double value) = 0;
@@ -147,6 +158,7 @@ struct ValidatorManagerOptions : public td::CntObject {
   virtual void set_state_serializer_enabled(bool value) = 0;
   virtual void set_collator_options(td::Ref<CollatorOptions> value) = 0;
   virtual void set_fast_state_serializer_enabled(bool value) = 0;
+  virtual void set_tx_index_enabled(bool value) = 0;
 
   static td::Ref<ValidatorManagerOptions> create(
       BlockIdExt zero_block_id, BlockIdExt init_block_id,
@@ -280,12 +292,13 @@ class ValidatorManagerInterface : public td::actor::Actor {
 
   virtual void get_archive_id(BlockSeqno masterchain_seqno, ShardIdFull shard_prefix,
                               td::Promise<td::uint64> promise) = 0;
-  virtual void get_archive_slice(td::uint64 archive_id, td::uint64 offset, td::uint32 limit,
+  virtual void get_archive_slice(td::uint64 archive_id, td::uint64 offset, td::uint32 limit, bool compressed,
                                  td::Promise<td::BufferSlice> promise) = 0;
 
   virtual void run_ext_query(td::BufferSlice data, td::Promise<td::BufferSlice> promise) = 0;
   virtual void prepare_stats(td::Promise<std::vector<std::pair<std::string, std::string>>> promise) = 0;
   virtual void prepare_actor_stats(td::Promise<std::string> promise) = 0;
+  virtual void prepare_actor_stats_json(td::Promise<std::string> promise) = 0;
 
   virtual void prepare_perf_timer_stats(td::Promise<std::vector<PerfTimerStats>> promise) = 0;
   virtual void add_perf_timer_stat(std::string name, double duration) = 0;